@@ -7,6 +7,7 @@ import cv2 as cv
 import numpy as np
 import time
 import csv
+import json
 
 
 # -------------------- Konfiguration --------------------
@@ -18,6 +19,17 @@ SAVE_OVERLAY = True
 OUT_DIR = Path("out")
 OUT_DIR.mkdir(parents=True, exist_ok=True)
 
+# Referenzprofil: Geometrie des Referenzbildes wird einmal bestimmt und als JSON
+# abgelegt; Folgeläufe mit demselben Referenzbild laden es ohne neue Detektion
+REFERENCE_PROFILE_PATH = OUT_DIR / "referenzprofil.json"
+REBUILD_REFERENCE_PROFILE = False  # True = Profil immer neu aus Referenzbild
+
+# SPC (laufende Drift-Überwachung für Abstand & Rotation)
+SPC_WARMUP = 20        # Bilder zur Schätzung von Sigma (Phase I), danach eingefroren
+SPC_EWMA_LAMBDA = 0.2  # Gewicht des neuen Werts im EWMA (0 < lambda <= 1)
+SPC_EWMA_L = 3.0       # Breite der EWMA-Eingriffsgrenzen in Sigma
+SPC_SHEWHART_L = 3.0   # Einzelwert-Grenze in Sigma
+
 # -------------------- Hilfsfunktionen --------------------
 
 
@@ -78,8 +90,9 @@ def _fit_top_edge_line(gray_roi: np.ndarray):
         return ptL, ptR, angle
 
     pts = np.vstack([xs, ys]).T.astype(np.float32).reshape(-1, 1, 2)
-    [vx, vy, x0, y0] = cv.fitLine(pts, cv.DIST_L2, 0, 0.01, 0.01)
-    vx, vy, x0, y0 = float(vx), float(vy), float(x0), float(y0)
+    # fitLine liefert ein 4x1-Array; float() auf 1-Element-Arrays ist in
+    # neueren numpy-Versionen ein Fehler
+    vx, vy, x0, y0 = (float(v) for v in cv.fitLine(pts, cv.DIST_L2, 0, 0.01, 0.01).ravel())
 
     def y_at(x):
         if abs(vx) < 1e-6:
@@ -163,46 +176,109 @@ def detect_reference_line(image_bgr: np.ndarray):
         "overlay": overlay,
     }
 
-# -------------------- Vergleich & Ausgabe (unverändert seit letzter Version) --------------------
+# -------------------- Referenzprofil --------------------
 
 
-def compare_two_images(img_path_ref: Path, img_path_cur: Path):
+def _normal_up(tl: np.ndarray, tr: np.ndarray):
+    u = tr - tl
+    u = u / np.linalg.norm(u)
+    n_candidate = np.array([-u[1], u[0]], dtype=np.float32)
+    up_dir = np.array([0.0, -1.0], dtype=np.float32)
+    n = n_candidate if np.dot(n_candidate, up_dir) >= 0 else -n_candidate
+    return u.astype(np.float32), n.astype(np.float32)
+
+
+def build_reference_profile(img_path_ref: Path):
+    """
+    Referenzgeometrie (tl, tr, Winkel, Skala, Normale) genau einmal bestimmen.
+    Das Overlay des Referenzbildes wird dabei ebenfalls nur einmal geschrieben.
+    """
     ref_img = cv.imread(str(img_path_ref), cv.IMREAD_COLOR)
+    if ref_img is None:
+        raise FileNotFoundError(f"Referenzbild nicht gefunden: {img_path_ref}")
+    res_ref = detect_reference_line(ref_img)
+    u, n = _normal_up(res_ref["tl"], res_ref["tr"])
+
+    if SAVE_OVERLAY:
+        cv.imwrite(
+            str(OUT_DIR / f"analyse_{img_path_ref.name}"), res_ref["overlay"])
+
+    return {
+        "source": img_path_ref.name,
+        "label_top_length_cm": LABEL_TOP_LENGTH_CM,
+        "tl": res_ref["tl"],
+        "tr": res_ref["tr"],
+        "center": res_ref["center"],
+        "angle_deg": res_ref["angle_deg"],
+        "px_per_cm": res_ref["px_per_cm"],
+        "u": u,
+        "n": n,
+    }
+
+
+def save_reference_profile(profile: dict, path: Path = REFERENCE_PROFILE_PATH):
+    data = {k: (v.tolist() if isinstance(v, np.ndarray) else v)
+            for k, v in profile.items()}
+    with open(path, "w", encoding="utf-8") as f:
+        json.dump(data, f, indent=2)
+
+
+def load_reference_profile(path: Path = REFERENCE_PROFILE_PATH):
+    with open(path, "r", encoding="utf-8") as f:
+        data = json.load(f)
+    for k in ("tl", "tr", "center", "u", "n"):
+        data[k] = np.array(data[k], dtype=np.float32)
+    return data
+
+
+def get_reference_profile(img_path_ref: Path, path: Path = REFERENCE_PROFILE_PATH):
+    """
+    Gespeichertes Profil wiederverwenden, solange es zum selben Referenzbild und
+    zur selben Kantenlänge gehört; sonst neu bestimmen und ablegen.
+    """
+    if not REBUILD_REFERENCE_PROFILE and path.exists():
+        try:
+            profile = load_reference_profile(path)
+            if (profile.get("source") == img_path_ref.name and
+                    profile.get("label_top_length_cm") == LABEL_TOP_LENGTH_CM):
+                return profile
+        except (OSError, ValueError, KeyError):
+            pass  # defektes/altes Profil -> neu erzeugen
+    profile = build_reference_profile(img_path_ref)
+    save_reference_profile(profile, path)
+    return profile
+
+# -------------------- Vergleich & Ausgabe --------------------
+
+
+def compare_to_reference(profile: dict, img_path_cur: Path):
+    """Vergleich eines Bildes gegen das Referenzprofil (genau eine Detektion)."""
     cur_img = cv.imread(str(img_path_cur), cv.IMREAD_COLOR)
-    if ref_img is None or cur_img is None:
+    if cur_img is None:
         raise FileNotFoundError("Bilddatei(en) nicht gefunden.")
 
-    res_ref = detect_reference_line(ref_img)
     res_cur = detect_reference_line(cur_img)
 
-    cm_per_px = 1.0 / res_ref["px_per_cm"]
+    cm_per_px = 1.0 / profile["px_per_cm"]
     mm_per_px = 10.0 * cm_per_px
+    n = profile["n"]
 
-    u = res_ref["tr"] - res_ref["tl"]
-    u = u / np.linalg.norm(u)
-
-    n_candidate = np.array([-u[1], u[0]], dtype=np.float32)
-    up_dir = np.array([0.0, -1.0], dtype=np.float32)
-    n = n_candidate if np.dot(n_candidate, up_dir) >= 0 else -n_candidate
-
-    d_center_px = float(np.dot(res_cur["center"] - res_ref["center"], n))
+    d_center_px = float(np.dot(res_cur["center"] - profile["center"], n))
     d_center_mm = d_center_px * mm_per_px
 
-    delta_angle = float(res_cur["angle_deg"] - res_ref["angle_deg"])
+    delta_angle = float(res_cur["angle_deg"] - profile["angle_deg"])
     while delta_angle >= 180.0:
         delta_angle -= 360.0
     while delta_angle < -180.0:
         delta_angle += 360.0
 
-    d_left_px = float(np.dot(res_cur["tl"] - res_ref["tl"], n))
-    d_right_px = float(np.dot(res_cur["tr"] - res_ref["tr"], n))
+    d_left_px = float(np.dot(res_cur["tl"] - profile["tl"], n))
+    d_right_px = float(np.dot(res_cur["tr"] - profile["tr"], n))
     d_left_mm = d_left_px * mm_per_px
     d_right_mm = d_right_px * mm_per_px
 
-    # Analysebilder mit Präfix "analyse_" und Originalnamen speichern
+    # Analysebild mit Präfix "analyse_" und Originalnamen speichern
     if SAVE_OVERLAY:
-        cv.imwrite(
-            str(OUT_DIR / f"analyse_{img_path_ref.name}"), res_ref["overlay"])
         cv.imwrite(
             str(OUT_DIR / f"analyse_{img_path_cur.name}"), res_cur["overlay"])
 
@@ -222,6 +298,57 @@ def compare_two_images(img_path_ref: Path, img_path_cur: Path):
     }
 
 
+def compare_two_images(img_path_ref: Path, img_path_cur: Path):
+    """Einzelvergleich A -> B (Referenzprofil wird aus dem Cache geladen)."""
+    return compare_to_reference(get_reference_profile(img_path_ref), img_path_cur)
+
+# -------------------- SPC / Drift-Überwachung --------------------
+
+
+class DriftMonitor:
+    """
+    Laufende SPC-Statistik einer Messgröße in O(1) pro Bild:
+    Mittelwert/Sigma nach Welford, EWMA mit Eingriffsgrenzen.
+    Sigma für die Grenzen wird nach SPC_WARMUP Werten eingefroren (Phase I),
+    damit eine schleichende Drift die eigenen Grenzen nicht mitzieht.
+    """
+
+    def __init__(self, name: str, target: float = 0.0):
+        self.name = name
+        self.target = target
+        self.count = 0
+        self.mean = 0.0
+        self._m2 = 0.0
+        self.ewma = target
+        self.sigma_ref = None
+
+    @property
+    def sigma(self) -> float:
+        return math.sqrt(self._m2 / (self.count - 1)) if self.count > 1 else 0.0
+
+    def update(self, x: float):
+        """Neuen Wert aufnehmen; liefert Alarmtext oder None."""
+        self.count += 1
+        delta = x - self.mean
+        self.mean += delta / self.count
+        self._m2 += delta * (x - self.mean)
+        self.ewma = SPC_EWMA_LAMBDA * x + (1.0 - SPC_EWMA_LAMBDA) * self.ewma
+
+        if self.sigma_ref is None:
+            if self.count >= SPC_WARMUP and self.sigma > 0.0:
+                self.sigma_ref = self.sigma
+            return None
+
+        lam = SPC_EWMA_LAMBDA
+        ewma_lim = SPC_EWMA_L * self.sigma_ref * math.sqrt(
+            lam / (2.0 - lam) * (1.0 - (1.0 - lam) ** (2 * self.count)))
+        if abs(x - self.target) > SPC_SHEWHART_L * self.sigma_ref:
+            return f"{self.name}: Einzelwert {x:+.4f} ausserhalb ±{SPC_SHEWHART_L * self.sigma_ref:.4f}"
+        if abs(self.ewma - self.target) > ewma_lim:
+            return f"{self.name}: EWMA {self.ewma:+.4f} ausserhalb ±{ewma_lim:.4f}"
+        return None
+
+
 # --- CSV-Ausgabe auf Semikolon umgestellt (nur diesen Teil ersetzen) ---
 
 if __name__ == "__main__":
@@ -240,12 +367,19 @@ if __name__ == "__main__":
         "linker eckpunkt absolut",
         "rechter eckpunkt absolut",
         "1px in cm",
+        "EWMA Abstand",
+        "EWMA Rotation",
+        "SPC Alarm",
     ]
     rows = []
 
     # Alle Bilder mit dem ersten Bild vergleichen (statt fortlaufend Bild i zu Bild i+1)
     if len(files) >= 2:
         ref = files[0]
+        # Referenz nur einmal detektieren (bzw. aus referenzprofil.json laden)
+        profile = get_reference_profile(ref)
+        spc_offset = DriftMonitor("Abstand [mm]")
+        spc_rotation = DriftMonitor("Rotation [°]")
 
         def pair(a, b):
             return f"{a.name}  ->  {b.name}"
@@ -277,7 +411,12 @@ if __name__ == "__main__":
 
         for i in range(1, len(files)):
             img_a, img_b = ref, files[i]
-            stats = compare_two_images(img_a, img_b)
+            stats = compare_to_reference(profile, img_b)
+            alarms = [a for a in (
+                spc_offset.update(stats["offset_center_mm"]),
+                spc_rotation.update(stats["rotation_delta_deg"])) if a]
+            for a in alarms:
+                print(f"DRIFT-ALARM {img_b.name}: {a}")
             rows.append([
                 pair(img_a, img_b),
                 fmt_mm_px(stats.get("offset_center_mm"),
@@ -290,6 +429,9 @@ if __name__ == "__main__":
                 fmt_pt(stats.get("cur_tl_abs")),
                 fmt_pt(stats.get("cur_tr_abs")),
                 fmt_factor(stats.get("cm_per_px")),
+                fmt_factor(spc_offset.ewma),
+                fmt_factor(spc_rotation.ewma),
+                " / ".join(alarms) if alarms else "-",
             ])
 
     csv_path = OUT_DIR / "vergleichsergebnisse.csv"
@@ -302,3 +444,7 @@ if __name__ == "__main__":
     elapsed = time.time() - start
     print(f"Anzahl Bilder: {len(files)}")
     print(f"Gesamtdauer [s]: {elapsed:.3f}")
+    if len(files) >= 2:
+        for m in (spc_offset, spc_rotation):
+            print(f"{m.name}: Mittel {m.mean:+.4f}, Sigma {m.sigma:.4f}, "
+                  f"EWMA {m.ewma:+.4f}")
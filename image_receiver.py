@@ -1,53 +1,632 @@
 import serial
 import struct
 import os
+import sys
 from datetime import datetime
 import time
 
 
-def receive_images():
-    # COM7 mit 5000000 Baud öffnen
-    ser = serial.Serial('COM7', 5000000, timeout=5)
+# ========================== CamLink-Protokoll ==========================
+# Kopf: uint32 LSB-first, Bits 31..24 = Typ, Bits 23..0 = Nutzlastlänge
+# (siehe lib/CamLink/CamLink.h). Typ 0 entspricht dem alten [Länge][JPEG].
+REC_JPEG = 0
+REC_MEASUREMENT = 1
+REC_JPEG_CROP = 2
+REC_QUALITY = 3
+REC_STROBE = 4
+REC_RING_STATS = 5
+REC_PIPELINE = 6
+REC_POOL_STATS = 7
+REC_TRACE = 8
+REC_TELEMETRY = 9
+REC_SD_STATS = 10
+REC_REPLAY = 11
+REC_PROFILE = 12
+REC_BOOT = 13
+REC_VIBRATION = 14
+MAX_PAYLOAD_LEN = 0xFFFFFF
 
-    print("Warte auf Bilder von COM7...")
+# MeasurementRecord: seq, t_ms, flags, scale, status, 10 x int32 (Q16.16)
+MEASUREMENT_FORMAT = '<IIHBB10i'
+MEASUREMENT_SIZE = struct.calcsize(MEASUREMENT_FORMAT)  # 52
+
+MEAS_VALID = 0x0001
+MEAS_JPEG_FOLLOWS = 0x0002
+MEAS_ANOMALY = 0x0004
+MEAS_REFERENCE = 0x0008
+MEAS_EMPTY = 0x0040
+MEAS_PARTIAL = 0x0080
+MEAS_VIBRATION = 0x0100
+
+# CropInfo vor einem JPEG-Ausschnitt: x0, y0, Breite/Höhe des Vollbilds
+CROP_INFO_FORMAT = '<HHHH'
+CROP_INFO_SIZE = struct.calcsize(CROP_INFO_FORMAT)  # 8
+
+# QualityRecord: seq, t_ms, quality, prev_quality, reserviert, avg, target, link
+QUALITY_FORMAT = '<IIBBHIII'
+QUALITY_SIZE = struct.calcsize(QUALITY_FORMAT)  # 24
+QUALITY_CSV_HEADER = "seq;t_ms;quality;prev_quality;avg_bytes;target_bytes;link_bytes_per_s"
+
+# StrobeRecord: seq, t_ms, an/aus [µs ab VSYNC], Belichtung, Auslesen,
+# Frameabstand, VSYNC-Fehler, Modus, im Fenster, reserviert
+STROBE_FORMAT = '<IIiiIIIiBBH'
+STROBE_SIZE = struct.calcsize(STROBE_FORMAT)  # 36
+STROBE_CSV_HEADER = ("seq;t_ms;on_us;off_us;exposure_us;readout_us;period_us;"
+                     "vsync_error_us;mode;aligned")
+
+# RingStatsRecord: seq, t_ms, Arena/belegt/Höchststand, Frames, max. Frames,
+# reserviert, gespeichert, überschrieben, zu groß, Lücken, Treffer, Fehlschläge,
+# Frameabstand, Auswahlfehler [µs]
+RING_STATS_FORMAT = '<IIIIIBBHIIIIIIIi'
+RING_STATS_SIZE = struct.calcsize(RING_STATS_FORMAT)  # 56
+RING_CSV_HEADER = ("seq;t_ms;capacity_bytes;used_bytes;high_water_bytes;frames;max_frames;"
+                   "pushed;overwritten;oversize;sensor_gaps;hits;misses;period_us;last_error_us")
+
+# PipelineRecord: seq, t_ms, Intervall, je Stufe (Aufnahme, Analyse, Senden)
+# Frames/busy/stall [µs], je Ring (frei, Analyse, Senden) Plätze/Tiefe/
+# Höchststand/reserviert/voll
+PIPELINE_FORMAT = '<III9I' + 'BBBBI' * 3
+PIPELINE_SIZE = struct.calcsize(PIPELINE_FORMAT)  # 72
+PIPELINE_STAGES = ("aufnahme", "analyse", "senden")
+PIPELINE_QUEUES = ("frei", "zur_analyse", "zum_senden")
+PIPELINE_CSV_HEADER = ("seq;t_ms;interval_us;"
+                       + ";".join(f"{s}_frames;{s}_busy_us;{s}_stall_us" for s in PIPELINE_STAGES) + ";"
+                       + ";".join(f"{q}_capacity;{q}_depth;{q}_high_water;{q}_full"
+                                  for q in PIPELINE_QUEUES))
+
+# PoolStatsRecord: seq, t_ms, je Pool (intern, PSRAM) Arena/belegt/Höchststand/
+# größter freier Bereich, Anforderungen, Fehlschläge, Ebenen, Fragmentierung [%],
+# reserviert
+POOL_STATS_FORMAT = '<II' + 'IIIIIIHBB' * 2
+POOL_STATS_SIZE = struct.calcsize(POOL_STATS_FORMAT)  # 64
+POOL_NAMES = ("intern", "psram")
+POOL_CSV_HEADER = ("seq;t_ms;"
+                   + ";".join(f"{p}_capacity;{p}_used;{p}_high_water;{p}_largest_free;"
+                              f"{p}_allocs;{p}_failures;{p}_planes;{p}_fragmentation_pct"
+                              for p in POOL_NAMES))
+
+# SdStatsRecord: seq, t_ms, Bilder, Fehlschläge, KiB, Schreibzeit [ms], letztes/
+# längstes Bild [µs], längstes Vorbelegen [µs], nächste Nummer, Ersatzdateien,
+# SPI-Takt [MHz], letzter Fehler, reserviert
+SD_STATS_FORMAT = '<10IBBBB'
+SD_STATS_SIZE = struct.calcsize(SD_STATS_FORMAT)  # 44
+SD_CSV_HEADER = ("seq;t_ms;files;failures;kbytes;busy_ms;last_write_us;max_write_us;"
+                 "max_prealloc_us;next_index;spare;sck_mhz;last_error")
+SD_ERRORS = ("OK", "NOT_READY", "BAD_CONFIG", "NO_DIR", "NO_SPARE", "TOO_LARGE",
+             "WRITE_FAILED", "VERIFY_FAILED")
+
+# ReplayRecord: seq, t_ms, Länge der folgenden Datensätze, Rest im Journal [KiB],
+# ins Journal gelegt, nachgeholt, verworfen, beschädigt
+REPLAY_FORMAT = '<8I'
+REPLAY_SIZE = struct.calcsize(REPLAY_FORMAT)  # 32
+REPLAY_CSV_HEADER = "seq;t_ms;len;backlog_kbytes;spilled;drained;dropped;corrupt"
+
+# ProfileRecord: seq, t_ms, Dauer [µs], Profil, geschriebene/fehlgeschlagene
+# Felder, Flags (1 = Auflösung geändert, 2 = aus dem Flash geladen)
+PROFILE_FORMAT = '<IIIBBBB'
+PROFILE_SIZE = struct.calcsize(PROFILE_FORMAT)  # 16
+PROFILE_NAMES = ("preview", "action", "calib")
+PROFILE_CSV_HEADER = "seq;t_ms;switch_us;profile;writes;failed;flags"
+
+# BootRecord: seq, Zeitpunkte seit dem Reset [µs] (setup, Kamera, Ende setup,
+# erster gültiger Frame, zurückgestellte Teile fertig), Reset-Grund, Flags
+# (1 = schneller Start, 2 = zurückgestellte Teile fehlgeschlagen), Teile
+# sofort/zurückgestellt (1 = I2C-Scan, 2 = Display, 4 = SD, 8 = Beschleunigung)
+BOOT_FORMAT = '<6I4B'
+BOOT_SIZE = struct.calcsize(BOOT_FORMAT)  # 28
+BOOT_CSV_HEADER = ("seq;setup_us;camera_us;ready_us;first_frame_us;deferred_us;"
+                   "reset_reason;flags;parts;deferred")
+RESET_REASONS = ("unbekannt", "Einschalten", "Reset-Pin", "Software", "Absturz",
+                 "Interrupt-Watchdog", "Task-Watchdog", "Watchdog", "Tiefschlaf",
+                 "Brownout", "SDIO")
+
+# VibrationRecord: seq, t_ms, RMS/Spitze/Grenze [mg], Verschiebung [ms], Alter
+# der Werte [ms], Samples im Fenster, Flags (1 = Erschütterung, 2 = verschoben,
+# 4 = keine frischen Werte, 8 = FIFO übergelaufen)
+VIBRATION_FORMAT = '<IIHHHHHBB'
+VIBRATION_SIZE = struct.calcsize(VIBRATION_FORMAT)  # 20
+VIBRATION_CSV_HEADER = "seq;t_ms;rms_mg;peak_mg;limit_mg;delay_ms;age_ms;window;flags"
+
+# REC_TRACE: Kopf (seq, Kern, Anzahl, reserviert, verworfen) + Anzahl Marken
+# à 8 Byte; unverändert samt CamLink-Kopf nach trace.bin (trace_export)
+TRACE_HEADER_FORMAT = '<IBBHI'
+TRACE_HEADER_SIZE = struct.calcsize(TRACE_HEADER_FORMAT)  # 12
+TRACE_EVENT_SIZE = 8
+
+# REC_TELEMETRY: Kopf (seq, t_ms, Intervall, Kamera, Tiefe max/Mittel x16,
+# Anzahl Messgrößen, 6 Zähler) + je Messgröße max, belegte Fächer und
+# (Fach, Anzahl); unverändert samt CamLink-Kopf nach telemetry.bin
+# (telemetry_report)
+TELEMETRY_HEADER_FORMAT = '<IIIBBBB6I'
+TELEMETRY_HEADER_SIZE = struct.calcsize(TELEMETRY_HEADER_FORMAT)  # 40
+TELEMETRY_METRICS = ("trigger_belichtung", "belichtung_fb", "fb_erstes_byte", "senden",
+                     "jpeg_bytes", "i2c_warten")
+
+
+def _bucket_upper(b):
+    """Obergrenze eines Telemetrie-Fachs (wie telemetry::Histogram)."""
+    b += 1
+    if b < 4:
+        return b - 1
+    return ((4 + b % 4) << (b // 4 - 1)) - 1
+
+
+# Gleiche Spalten wie das Host-Werkzeug label_measure (--check liest diese Datei)
+CSV_HEADER = ("seq;t_ms;flags;scale;status;tl_x;tl_y;tr_x;tr_y;angle_deg;px_per_cm;"
+              "offset_center_px;rotation_delta_deg;left_offset_px;right_offset_px;"
+              "offset_center_mm;rotation_deg;datei;crop_x;crop_y")
+
+
+def _day_folder():
+    # Ordner mit aktuellem Datum erstellen falls nicht vorhanden
+    folder_path = datetime.now().strftime("%Y-%m-%d")
+    if not os.path.exists(folder_path):
+        os.makedirs(folder_path)
+    return folder_path
+
+
+def _write_measurement(rec, filename, crop=None):
+    """Messdatensatz an <Tagesordner>/messungen.csv anhängen.
+
+    crop = (x0, y0) des JPEG-Ausschnitts im Vollbild, None = Vollbild.
+    """
+    (seq, t_ms, flags, scale, status,
+     tl_x, tl_y, tr_x, tr_y, angle_deg, px_per_cm,
+     off_c, rot, off_l, off_r) = rec
+
+    # Lesbare Werte: Q16.16 -> mm / Grad (wie labelgeom::pxToMm)
+    off_mm = 0.0
+    if px_per_cm:
+        off_mm = (off_c / 65536.0) / (px_per_cm / 65536.0) * 10.0
+    rot_deg = rot / 65536.0
+
+    csv_path = os.path.join(_day_folder(), "messungen.csv")
+    new_file = not os.path.exists(csv_path)
+    with open(csv_path, 'a', encoding='utf-8') as f:
+        if new_file:
+            f.write(CSV_HEADER + "\n")
+        f.write(";".join(str(v) for v in rec))
+        crop_cols = f"{crop[0]};{crop[1]}" if crop else ";"
+        f.write(f";{off_mm:.4f};{rot_deg:.4f};{filename};{crop_cols}\n")
+
+    if flags & MEAS_PARTIAL:
+        print(f"Label angeschnitten seq {seq}")
+    if flags & MEAS_VIBRATION:
+        print(f"Bei Erschütterung gemessen seq {seq}")
+    if flags & MEAS_ANOMALY:
+        print(f"ANOMALIE seq {seq}: Status {status}, Abstand {off_mm:.3f} mm, "
+              f"Rotation {rot_deg:.3f}°")
+
+
+def _write_quality(rec):
+    """Qualitätsänderung der Ratenregelung an <Tagesordner>/qualitaet.csv anhängen."""
+    seq, t_ms, quality, prev_quality, _, avg, target, link = rec
+    csv_path = os.path.join(_day_folder(), "qualitaet.csv")
+    new_file = not os.path.exists(csv_path)
+    with open(csv_path, 'a', encoding='utf-8') as f:
+        if new_file:
+            f.write(QUALITY_CSV_HEADER + "\n")
+        f.write(f"{seq};{t_ms};{quality};{prev_quality};{avg};{target};{link}\n")
+    print(f"JPEG-Qualität ab Frame {seq}: {prev_quality} -> {quality} "
+          f"(Mittel {avg} Bytes, Ziel {target} Bytes)")
+
+
+def _write_strobe(rec):
+    """Lage des Blitzes zum Frame an <Tagesordner>/blitz.csv anhängen."""
+    seq, t_ms, on_us, off_us, exp_us, readout_us, period_us, vs_err, mode, aligned, _ = rec
+    csv_path = os.path.join(_day_folder(), "blitz.csv")
+    new_file = not os.path.exists(csv_path)
+    with open(csv_path, 'a', encoding='utf-8') as f:
+        if new_file:
+            f.write(STROBE_CSV_HEADER + "\n")
+        f.write(f"{seq};{t_ms};{on_us};{off_us};{exp_us};{readout_us};{period_us};"
+                f"{vs_err};{mode};{aligned}\n")
+    if not aligned:
+        print(f"Blitz außerhalb des Belichtungsfensters seq {seq}: "
+              f"{on_us}..{off_us} µs, Fenster {readout_us - exp_us}..0 µs, "
+              f"VSYNC-Fehler {vs_err} µs")
+
+
+def _write_ring_stats(rec):
+    """Zustand des Vorlauf-Rings an <Tagesordner>/ring.csv anhängen."""
+    (seq, t_ms, cap, used, high, frames, max_frames, _, pushed, overwritten,
+     oversize, gaps, hits, misses, period_us, err_us) = rec
+    csv_path = os.path.join(_day_folder(), "ring.csv")
+    new_file = not os.path.exists(csv_path)
+    with open(csv_path, 'a', encoding='utf-8') as f:
+        if new_file:
+            f.write(RING_CSV_HEADER + "\n")
+        f.write(f"{seq};{t_ms};{cap};{used};{high};{frames};{max_frames};{pushed};"
+                f"{overwritten};{oversize};{gaps};{hits};{misses};{period_us};{err_us}\n")
+    print(f"Ring: {frames}/{max_frames} Frames, {used // 1024}/{cap // 1024} KB "
+          f"(max {high // 1024} KB), Lücken {gaps}, verfehlt {misses}, "
+          f"Auswahlfehler {err_us} µs")
+
+
+def _write_pipeline(rec):
+    """Auslastung der Task-Pipeline an <Tagesordner>/pipeline.csv anhängen."""
+    seq, t_ms, interval_us = rec[:3]
+    stages = [rec[3 + 3 * i:6 + 3 * i] for i in range(3)]
+    queues = [rec[12 + 5 * i:17 + 5 * i] for i in range(3)]
+    csv_path = os.path.join(_day_folder(), "pipeline.csv")
+    new_file = not os.path.exists(csv_path)
+    with open(csv_path, 'a', encoding='utf-8') as f:
+        if new_file:
+            f.write(PIPELINE_CSV_HEADER + "\n")
+        cols = [seq, t_ms, interval_us]
+        for st in stages:
+            cols += list(st)
+        for cap, depth, high, _, full in queues:
+            cols += [cap, depth, high, full]
+        f.write(";".join(str(c) for c in cols) + "\n")
+    # Engpass = Stufe mit dem höchsten Arbeitsanteil
+    load = [busy / interval_us if interval_us else 0.0 for _, busy, _ in stages]
+    worst = max(range(3), key=lambda i: load[i])
+    print("Pipeline: " + ", ".join(f"{PIPELINE_STAGES[i]} {load[i] * 100:.0f} %" for i in range(3))
+          + f" -> Engpass {PIPELINE_STAGES[worst]}")
+
+
+def _write_pool_stats(rec):
+    """Belegung der Bildspeicher-Pools an <Tagesordner>/speicher.csv anhängen."""
+    seq, t_ms = rec[:2]
+    pools = [rec[2 + 9 * i:11 + 9 * i] for i in range(2)]
+    csv_path = os.path.join(_day_folder(), "speicher.csv")
+    new_file = not os.path.exists(csv_path)
+    with open(csv_path, 'a', encoding='utf-8') as f:
+        if new_file:
+            f.write(POOL_CSV_HEADER + "\n")
+        cols = [seq, t_ms]
+        for pool in pools:
+            cols += list(pool[:8])
+        f.write(";".join(str(c) for c in cols) + "\n")
+    print("Speicher: " + ", ".join(
+        f"{POOL_NAMES[i]} {used // 1024}/{cap // 1024} KB (max {high // 1024} KB, "
+        f"frag {frag} %, Fehlschläge {fail})"
+        for i, (cap, used, high, _, _, fail, _, frag, _) in enumerate(pools)))
+
+
+def _write_sd_stats(rec):
+    """Zustand der SD-Serie an <Tagesordner>/sdkarte.csv anhängen."""
+    (seq, t_ms, files, failures, kbytes, busy_ms, last_us, max_us, prealloc_us,
+     next_index, spare, mhz, last_error, _) = rec
+    csv_path = os.path.join(_day_folder(), "sdkarte.csv")
+    new_file = not os.path.exists(csv_path)
+    with open(csv_path, 'a', encoding='utf-8') as f:
+        if new_file:
+            f.write(SD_CSV_HEADER + "\n")
+        f.write(";".join(str(c) for c in rec[:13]) + "\n")
+    rate = kbytes / busy_ms if busy_ms else 0.0  # KiB/ms ~ MB/s
+    error = SD_ERRORS[last_error] if last_error < len(SD_ERRORS) else str(last_error)
+    print(f"SD: {files} Bilder, {rate:.2f} MB/s beim Schreiben, {mhz} MHz, "
+          f"letztes {last_us / 1000:.1f} ms (max {max_us / 1000:.1f} ms), "
+          f"Ersatz {spare}, Fehlschläge {failures}" + (f" ({error})" if failures else ""))
+
+
+def _write_trace(hdr_data, data):
+    """Zeitmarken-Datensatz roh an <Tagesordner>/trace.bin anhängen."""
+    with open(os.path.join(_day_folder(), "trace.bin"), 'ab') as f:
+        f.write(hdr_data + data)
+    _, core, _, _, dropped = struct.unpack_from(TRACE_HEADER_FORMAT, data)
+    if dropped:
+        print(f"Trace: Kern {core} hat {dropped} Marken verworfen")
+
+
+def _write_telemetry(hdr_data, data):
+    """Telemetrie-Datensatz roh an <Tagesordner>/telemetry.bin anhängen und p99 ausgeben."""
+    hdr = struct.unpack_from(TELEMETRY_HEADER_FORMAT, data)
+    camera, n_metrics = hdr[3], hdr[6]
+    frames, failures, empty, misses, full = hdr[7:12]
+    pos = TELEMETRY_HEADER_SIZE
+    summary = []
+    for m in range(n_metrics):
+        if pos + 5 > len(data):
+            return
+        hist_max, used = struct.unpack_from('<IB', data, pos)
+        pos += 5
+        buckets = [struct.unpack_from('<BH', data, pos + 3 * i) for i in range(used)]
+        pos += 3 * used
+        total = sum(n for _, n in buckets)
+        if not total or m >= len(TELEMETRY_METRICS):
+            continue
+        rank, seen = (total * 99 + 99) // 100, 0
+        for b, n in buckets:
+            seen += n
+            if seen >= rank:
+                summary.append(f"{TELEMETRY_METRICS[m]} p99 {min(_bucket_upper(b), hist_max)}")
+                break
+    if pos != len(data):
+        return
+    with open(os.path.join(_day_folder(), "telemetry.bin"), 'ab') as f:
+        f.write(hdr_data + data)
+    print(f"Telemetrie Kamera {camera}: " + ", ".join(summary)
+          + f" | Frames {frames}, Fehlaufnahmen {failures}, leer {empty}, "
+          f"Ring verfehlt {misses}, Ringe voll {full}")
+
+
+class _Stream:
+    """Serielle Eingabe mit Zurücklegen: nach einem falschen Kopf wird ein Byte
+    weiter gesucht (wie camlink::nextRecord), etwa hinter den Textmeldungen
+    beim Start der Firmware."""
+
+    def __init__(self, ser):
+        self.ser = ser
+        self.back = b''
+
+    def read(self, n):
+        data, self.back = self.back[:n], self.back[n:]
+        if len(data) < n:
+            data += self.ser.read(n - len(data))
+        return data
+
+    def unread(self, data):
+        self.back = data + self.back
+
+
+def _write_replay(rec):
+    """Nachgeholten Frame an <Tagesordner>/nachgeholt.csv anhängen."""
+    seq, t_ms, _, backlog_kb, spilled, drained, dropped, corrupt = rec
+    csv_path = os.path.join(_day_folder(), "nachgeholt.csv")
+    new_file = not os.path.exists(csv_path)
+    with open(csv_path, 'a', encoding='utf-8') as f:
+        if new_file:
+            f.write(REPLAY_CSV_HEADER + "\n")
+        f.write(";".join(str(c) for c in rec) + "\n")
+    print(f"Nachgeholt: Frame {seq} (t={t_ms} ms), noch {backlog_kb} KiB im Journal, "
+          f"{drained + 1}/{spilled} zwischengelagert"
+          + (f", verworfen {dropped}" if dropped else "")
+          + (f", beschädigt {corrupt}" if corrupt else ""))
+
+
+def _write_profile(rec):
+    """Wechsel des Sensorprofils an <Tagesordner>/sensorprofil.csv anhängen.
+
+    Mit Vorschau zwischen den Labels kommen zwei Wechsel je Label; ausgegeben
+    werden nur die bis zum ersten Frame und fehlgeschlagene.
+    """
+    seq, _, switch_us, profile, writes, failed, flags = rec
+    csv_path = os.path.join(_day_folder(), "sensorprofil.csv")
+    new_file = not os.path.exists(csv_path)
+    with open(csv_path, 'a', encoding='utf-8') as f:
+        if new_file:
+            f.write(PROFILE_CSV_HEADER + "\n")
+        f.write(";".join(str(c) for c in rec) + "\n")
+    if seq and not failed:
+        return
+    name = PROFILE_NAMES[profile] if profile < len(PROFILE_NAMES) else str(profile)
+    print(f"Sensorprofil ab Frame {seq}: {name}, {writes} Werte in {switch_us / 1000:.1f} ms"
+          + (", Auflösung geändert" if flags & 1 else "")
+          + (", aus dem Flash" if flags & 2 else "")
+          + (f", {failed} fehlgeschlagen" if failed else ""))
+
+
+def _write_boot(rec):
+    """Startzeiten an <Tagesordner>/start.csv anhängen."""
+    (seq, setup_us, camera_us, ready_us, first_frame_us, deferred_us,
+     reason, flags, _, deferred) = rec
+    csv_path = os.path.join(_day_folder(), "start.csv")
+    new_file = not os.path.exists(csv_path)
+    with open(csv_path, 'a', encoding='utf-8') as f:
+        if new_file:
+            f.write(BOOT_CSV_HEADER + "\n")
+        f.write(";".join(str(c) for c in rec) + "\n")
+    reason = RESET_REASONS[reason] if reason < len(RESET_REASONS) else str(reason)
+    print(f"Start nach {reason}: erster Frame nach {first_frame_us / 1000:.0f} ms "
+          f"(Kamera {camera_us / 1000:.0f} ms, setup fertig {ready_us / 1000:.0f} ms"
+          + (", schnell" if flags & 1 else "")
+          + (f", Rest nach {deferred_us / 1000:.0f} ms" if deferred and deferred_us else "")
+          + (", Rest fehlgeschlagen" if flags & 2 else "") + ")")
+
+
+def _write_vibration(rec):
+    """Erschütterung bei der Aufnahme an <Tagesordner>/erschuetterung.csv anhängen."""
+    seq, _, rms, peak, limit, delay_ms, _, _, flags = rec
+    csv_path = os.path.join(_day_folder(), "erschuetterung.csv")
+    new_file = not os.path.exists(csv_path)
+    with open(csv_path, 'a', encoding='utf-8') as f:
+        if new_file:
+            f.write(VIBRATION_CSV_HEADER + "\n")
+        f.write(";".join(str(c) for c in rec) + "\n")
+    if flags & 1:
+        print(f"Erschütterung bei Frame {seq}: RMS {rms} mg (Grenze {limit} mg), "
+              f"Spitze {peak} mg" + (f", {delay_ms} ms gewartet" if delay_ms else ""))
+    elif flags & 2:
+        print(f"Frame {seq} wegen Erschütterung {delay_ms} ms später aufgenommen")
+
+
+def receive_images(port='COM7', on_image=None, stop=None):
+    """Datensätze von port empfangen und ablegen.
+
+    on_image(dateiname, jpeg, crop, t_kopf, t_daten): nach jedem gespeicherten
+    Bild, Zeiten aus time.time() (Kopf gelesen, Bild vollständig);
+    stop(): True beendet den Empfang (sonst endlos).
+    """
+    # Port (Standard COM7, Host-Simulation: pty) mit 5000000 Baud öffnen
+    ser = serial.Serial(port, 5000000, timeout=5)
+    stream = _Stream(ser)
+
+    print(f"Warte auf Bilder von {port}...")
 
     # Performance-Tracking
     start_time = time.time()
     image_count = 0
+    measurement_count = 0
+
+    # Messdatensatz, dessen JPEG noch aussteht (MEAS_JPEG_FOLLOWS)
+    pending = None
+    # Nachgeholter Frame (REC_REPLAY): seq und noch ausstehende Bytes
+    replay_seq = None
+    replay_left = 0
 
-    while True:
+    while stop is None or not stop():
         try:
-            # 4 Bytes für die Länge lesen
-            len_data = ser.read(4)
-            if len(len_data) != 4:
+            # 4 Bytes Kopf lesen
+            hdr_data = stream.read(4)
+            if len(hdr_data) != 4:
+                stream.unread(hdr_data)
                 continue
+            t_header = time.time()
 
-            # Länge als uint32 (LSB-first) interpretieren
-            img_len = struct.unpack('<I', len_data)[0]
+            # Kopf als uint32 (LSB-first) interpretieren
+            word = struct.unpack('<I', hdr_data)[0]
+            rec_type = word >> 24
+            rec_len = word & MAX_PAYLOAD_LEN
 
-            if img_len > 0 and img_len < 10000000:  # Sinnvolle Bildgröße
+            # Gehört der Datensatz zu einem nachgeholten Frame?
+            replayed = None
+            if replay_left > 0 and rec_type != REC_REPLAY:
+                replayed = replay_seq
+                replay_left = max(0, replay_left - 4 - rec_len)
+
+            if rec_type == REC_MEASUREMENT and rec_len == MEASUREMENT_SIZE:
+                data = stream.read(rec_len)
+                if len(data) != rec_len:
+                    continue
+                # Vorheriger Datensatz wartete vergeblich auf sein JPEG
+                if pending is not None:
+                    _write_measurement(pending, "")
+                    pending = None
+
+                rec = struct.unpack(MEASUREMENT_FORMAT, data)
+                measurement_count += 1
+                if rec[2] & MEAS_JPEG_FOLLOWS:
+                    pending = rec
+                else:
+                    _write_measurement(rec, "")
+
+                # Performance-Ausgabe alle 100 Messungen
+                if measurement_count % 100 == 0:
+                    elapsed = time.time() - start_time
+                    print(f"Messung {measurement_count}: "
+                          f"{measurement_count / elapsed:.1f} Messungen/s")
+                continue
+
+            if rec_type == REC_QUALITY and rec_len == QUALITY_SIZE:
+                data = stream.read(rec_len)
+                if len(data) == rec_len:
+                    _write_quality(struct.unpack(QUALITY_FORMAT, data))
+                continue
+
+            if rec_type == REC_STROBE and rec_len == STROBE_SIZE:
+                data = stream.read(rec_len)
+                if len(data) == rec_len:
+                    _write_strobe(struct.unpack(STROBE_FORMAT, data))
+                continue
+
+            if rec_type == REC_RING_STATS and rec_len == RING_STATS_SIZE:
+                data = stream.read(rec_len)
+                if len(data) == rec_len:
+                    _write_ring_stats(struct.unpack(RING_STATS_FORMAT, data))
+                continue
+
+            if rec_type == REC_PIPELINE and rec_len == PIPELINE_SIZE:
+                data = stream.read(rec_len)
+                if len(data) == rec_len:
+                    _write_pipeline(struct.unpack(PIPELINE_FORMAT, data))
+                continue
+
+            if rec_type == REC_POOL_STATS and rec_len == POOL_STATS_SIZE:
+                data = stream.read(rec_len)
+                if len(data) == rec_len:
+                    _write_pool_stats(struct.unpack(POOL_STATS_FORMAT, data))
+                continue
+
+            if rec_type == REC_SD_STATS and rec_len == SD_STATS_SIZE:
+                data = stream.read(rec_len)
+                if len(data) == rec_len:
+                    _write_sd_stats(struct.unpack(SD_STATS_FORMAT, data))
+                continue
+
+            if rec_type == REC_PROFILE and rec_len == PROFILE_SIZE:
+                data = stream.read(rec_len)
+                if len(data) == rec_len:
+                    _write_profile(struct.unpack(PROFILE_FORMAT, data))
+                continue
+
+            if rec_type == REC_BOOT and rec_len == BOOT_SIZE:
+                data = stream.read(rec_len)
+                if len(data) == rec_len:
+                    _write_boot(struct.unpack(BOOT_FORMAT, data))
+                continue
+
+            if rec_type == REC_VIBRATION and rec_len == VIBRATION_SIZE:
+                data = stream.read(rec_len)
+                if len(data) == rec_len:
+                    _write_vibration(struct.unpack(VIBRATION_FORMAT, data))
+                continue
+
+            if rec_type == REC_REPLAY and rec_len == REPLAY_SIZE:
+                data = stream.read(rec_len)
+                if len(data) == rec_len:
+                    rec = struct.unpack(REPLAY_FORMAT, data)
+                    replay_seq, replay_left = rec[0], rec[2]
+                    _write_replay(rec)
+                continue
+
+            if rec_type == REC_TRACE and rec_len >= TRACE_HEADER_SIZE:
+                data = stream.read(rec_len)
+                if len(data) == rec_len and \
+                        rec_len == TRACE_HEADER_SIZE + data[5] * TRACE_EVENT_SIZE:
+                    _write_trace(hdr_data, data)
+                continue
+
+            if rec_type == REC_TELEMETRY and rec_len >= TELEMETRY_HEADER_SIZE:
+                data = stream.read(rec_len)
+                if len(data) == rec_len:
+                    _write_telemetry(hdr_data, data)
+                continue
+
+            # JPEG-Kopf nur, wenn die Daten mit SOI beginnen
+            soi_at = CROP_INFO_SIZE if rec_type == REC_JPEG_CROP else 0
+            if rec_type in (REC_JPEG, REC_JPEG_CROP) and rec_len > soi_at + 2:
+                start = stream.read(soi_at + 2)
+                stream.unread(start)
+                if start[soi_at:] != b'\xff\xd8':
+                    rec_type = None
+
+            if rec_type not in (REC_JPEG, REC_JPEG_CROP):
+                # Unbekannter Typ oder Synchronisationsfehler: ein Byte weiter
+                stream.unread(hdr_data[1:])
+                continue
+
+            img_len = rec_len
+            if img_len > 0:  # Sinnvolle Bildgröße
                 # Bilddaten lesen
-                img_data = ser.read(img_len)
+                img_data = stream.read(img_len)
+                t_data = time.time()
+
+                crop = None
+                if rec_type == REC_JPEG_CROP and len(img_data) == img_len:
+                    if img_len <= CROP_INFO_SIZE:
+                        continue
+                    x0, y0, full_w, full_h = struct.unpack(
+                        CROP_INFO_FORMAT, img_data[:CROP_INFO_SIZE])
+                    crop = (x0, y0)
+                    print(f"Ausschnitt bei ({x0}, {y0}) aus {full_w}x{full_h}")
+                    img_data = img_data[CROP_INFO_SIZE:]
+                    img_len -= CROP_INFO_SIZE
 
                 if len(img_data) == img_len:
                     print(f"Empfange Bild der Größe {img_len} Bytes")
-                    # Ordner mit aktuellem Datum erstellen
-                    current_date = datetime.now().strftime("%Y-%m-%d")
-                    folder_path = current_date
-
-                    # Ordner erstellen falls nicht vorhanden
-                    if not os.path.exists(folder_path):
-                        os.makedirs(folder_path)
+                    folder_path = _day_folder()
 
                     # Bild speichern mit Mikrosekunden für eindeutige Namen
                     timestamp = datetime.now().strftime("%Y%m%d_%H%M%S_%f")
-                    filename = os.path.join(
-                        folder_path, f"image_{timestamp}.jpg")
+                    prefix = "crop" if crop else "image"
+                    if replayed is not None:
+                        prefix += f"_nachgeholt_{replayed:07d}"
+                    basename = f"{prefix}_{timestamp}.jpg"
+                    filename = os.path.join(folder_path, basename)
 
                     with open(filename, 'wb') as f:
                         f.write(img_data)
 
+                    if pending is not None:
+                        _write_measurement(pending, basename, crop)
+                        pending = None
+
                     image_count += 1
+                    if on_image is not None:
+                        on_image(filename, img_data, crop, t_header, t_data)
 
                     # Performance-Ausgabe alle 10 Bilder
                     if image_count % 10 == 0:
@@ -60,6 +639,8 @@ def receive_images():
             print(f"Fehler: {e}")
             continue
 
+    ser.close()
+
 
 if __name__ == "__main__":
-    receive_images()
+    receive_images(sys.argv[1] if len(sys.argv) > 1 else 'COM7')
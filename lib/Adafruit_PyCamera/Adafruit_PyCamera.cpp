@@ -65,7 +65,75 @@ Adafruit_PyCamera::Adafruit_PyCamera(void)
  */
 /**************************************************************************/
 bool Adafruit_PyCamera::begin() {
+  if (!begin(PYCAM_ALL, FRAMESIZE_UXGA))
+    return false;
+  return setFramesize(FRAMESIZE_240X240);
+}
+
+/**************************************************************************/
+/**
+ * @brief Initializes only the parts of the PyCamera a mode needs.
+ *
+ * @details Fast-boot variant of begin(): pins, expander and camera always,
+ * everything else only if set in parts. The camera starts directly at
+ * framesize instead of UXGA followed by a switch; its frame buffers are sized
+ * for framesize, so the session cannot switch to a larger one later. Parts
+ * not requested are remembered for beginDeferred().
+ *
+ * @param parts Parts (PyCameraPart) to initialize now.
+ * @param framesize Frame size the camera starts with.
+ * @return true if initialization is successful, false otherwise.
+ */
+/**************************************************************************/
+bool Adafruit_PyCamera::begin(uint8_t parts, framesize_t framesize) {
   Serial.println("Init PyCamera obj");
+  initPins();
+
+  if (parts & PYCAM_I2C_SCAN)
+    I2Cscan();
+
+  if ((parts & PYCAM_DISPLAY) && !initDisplay())
+    return false;
+  if (!initExpander())
+    return false;
+  if (!initCamera(true, framesize))
+    return false;
+  _deferred = PYCAM_ALL & ~PYCAM_I2C_SCAN & ~parts;
+  if (!initParts(parts & (PYCAM_SD | PYCAM_ACCEL)))
+    return false;
+  if (parts & PYCAM_DISPLAY)
+    fb = new PyCameraFB(240, 240);
+
+  _timestamp = millis();
+
+  return true;
+}
+
+/**************************************************************************/
+/**
+ * @brief Initializes the parts begin(parts, framesize) left out.
+ *
+ * @details Meant for a background task after the camera is running. The SD
+ * card shares the SPI bus with the display and initSD() restarts it; leave it
+ * out here if the sketch has already set the card up by itself.
+ *
+ * @param parts Deferred parts (PyCameraPart) to initialize now; the others
+ * stay deferred.
+ * @return true if all of them came up, false otherwise.
+ */
+/**************************************************************************/
+bool Adafruit_PyCamera::beginDeferred(uint8_t parts) {
+  parts &= _deferred;
+  _deferred &= ~parts;
+  return initParts(parts);
+}
+
+/**************************************************************************/
+/**
+ * @brief Sets up speaker, Neopixel, Neopixel Ring and shutter button.
+ */
+/**************************************************************************/
+void Adafruit_PyCamera::initPins(void) {
   // Setup and turn off speaker
   pinMode(SPEAKER, OUTPUT);
   digitalWrite(SPEAKER, LOW);
@@ -87,26 +155,27 @@ bool Adafruit_PyCamera::begin() {
 
   // boot button is also shutter
   pinMode(SHUTTER_BUTTON, INPUT_PULLUP);
+}
 
-  I2Cscan();
-
-  if (!initDisplay())
-    return false;
-  if (!initExpander())
-    return false;
-  if (!initCamera(true))
-    return false;
-  if (!setFramesize(FRAMESIZE_240X240))
-    return false;
-  if (SDdetected())
+/**************************************************************************/
+/**
+ * @brief Initializes display, SD card and accelerometer as selected.
+ *
+ * @param parts Parts (PyCameraPart) to initialize; the I2C scan is ignored.
+ * @return true if all selected parts came up, false otherwise. A missing SD
+ * card is not an error.
+ */
+/**************************************************************************/
+bool Adafruit_PyCamera::initParts(uint8_t parts) {
+  if (parts & PYCAM_DISPLAY) {
+    if (!initDisplay())
+      return false;
+    fb = new PyCameraFB(240, 240);
+  }
+  if ((parts & PYCAM_SD) && SDdetected())
     initSD();
-  if (!initAccel())
+  if ((parts & PYCAM_ACCEL) && !initAccel())
     return false;
-
-  fb = new PyCameraFB(240, 240);
-
-  _timestamp = millis();
-
   return true;
 }
 
@@ -116,13 +185,14 @@ bool Adafruit_PyCamera::begin() {
  *
  * @details Checks for SD card presence and attempts initialization. Performs a
  * power reset, reinitializes SPI for SD card communication, and checks for
- * errors during SD card initialization. Also lists files on the SD card if
- * initialization is successful.
+ * errors during SD card initialization. The file listing was dropped: with a
+ * burst directory on the card it walked thousands of entries on every init.
  *
+ * @param sck_mhz SPI clock after the card identification, in MHz.
  * @return true if SD card is successfully initialized, false otherwise.
  */
 /**************************************************************************/
-bool Adafruit_PyCamera::initSD(void) {
+bool Adafruit_PyCamera::initSD(uint8_t sck_mhz) {
 
   if (!SDdetected()) {
     Serial.println("No SD card inserted");
@@ -132,8 +202,11 @@ bool Adafruit_PyCamera::initSD(void) {
   Serial.println("SD card inserted, trying to init");
 
   // power reset
-  aw.pinMode(AWEXP_SD_PWR, OUTPUT);
-  aw.digitalWrite(AWEXP_SD_PWR, HIGH); // turn off
+  {
+    i2cbus::Guard bus(_bus, i2cbus::PRIO_UI);
+    aw.pinMode(AWEXP_SD_PWR, OUTPUT);
+    aw.digitalWrite(AWEXP_SD_PWR, HIGH); // turn off
+  }
 
   pinMode(SD_CS, OUTPUT);
   digitalWrite(SD_CS, LOW);
@@ -152,10 +225,13 @@ bool Adafruit_PyCamera::initSD(void) {
   Serial.println("Re-init SPI");
   digitalWrite(SD_CS, HIGH);
   SPI.begin();
-  aw.digitalWrite(AWEXP_SD_PWR, LOW); // turn on
+  {
+    i2cbus::Guard bus(_bus, i2cbus::PRIO_UI);
+    aw.digitalWrite(AWEXP_SD_PWR, LOW); // turn on
+  }
   delay(100);
 
-  if (!sd.begin(SD_CS, SD_SCK_MHZ(4))) {
+  if (!sd.begin(SD_CS, SD_SCK_MHZ(sck_mhz))) {
     if (sd.card()->errorCode()) {
       Serial.printf("SD card init failure with code 0x%x data %d\n",
                     sd.card()->errorCode(), (int)sd.card()->errorData());
@@ -164,11 +240,12 @@ bool Adafruit_PyCamera::initSD(void) {
     } else {
       Serial.println("SD begin failed, can't determine error type");
     }
+    i2cbus::Guard bus(_bus, i2cbus::PRIO_UI);
     aw.digitalWrite(AWEXP_SD_PWR, HIGH); // turn off power
     return false;
   }
 
-  Serial.println("Card successfully initialized");
+  Serial.printf("Card successfully initialized at %d MHz\n", (int)sck_mhz);
   uint32_t size = sd.card()->cardSize();
   if (size == 0) {
     Serial.println("Can't determine the card size");
@@ -176,8 +253,6 @@ bool Adafruit_PyCamera::initSD(void) {
     uint32_t sizeMB = 0.000512 * size + 0.5;
     Serial.printf("Card size: %d MB FAT%d\n", (int)sizeMB, sd.vol()->fatType());
   }
-  Serial.println("Files found (date time size name):");
-  sd.ls(LS_R | LS_DATE | LS_SIZE);
   return true;
 }
 
@@ -257,6 +332,7 @@ bool Adafruit_PyCamera::initDisplay(void) {
  */
 /**************************************************************************/
 bool Adafruit_PyCamera::setFramesize(framesize_t framesize) {
+  i2cbus::Guard bus(_bus, i2cbus::PRIO_CAMERA);
   uint8_t ret = camera->set_framesize(camera, framesize);
   if (ret != 0) {
     Serial.printf("Could not set resolution: error 0x%x\n", ret);
@@ -278,6 +354,7 @@ bool Adafruit_PyCamera::setFramesize(framesize_t framesize) {
  */
 /**************************************************************************/
 bool Adafruit_PyCamera::setSpecialEffect(uint8_t effect) {
+  i2cbus::Guard bus(_bus, i2cbus::PRIO_CAMERA);
   uint8_t ret = camera->set_special_effect(camera, effect);
   if (ret != 0) {
     Serial.printf("Could not set effect: error 0x%x\n", ret);
@@ -299,11 +376,13 @@ bool Adafruit_PyCamera::setSpecialEffect(uint8_t effect) {
  * mirror and vertical flip settings.
  *
  * @param hwreset Flag to determine if a hardware reset is needed.
+ * @param framesize Frame size to start with. The driver sizes its frame
+ * buffers for it, so only this size and smaller ones work afterwards.
  * @return true if the camera is successfully initialized, false if there is an
  * error.
  */
 /**************************************************************************/
-bool Adafruit_PyCamera::initCamera(bool hwreset) {
+bool Adafruit_PyCamera::initCamera(bool hwreset, framesize_t framesize) {
   Serial.print("Config camera...");
   Wire.begin(PYCAM_SDA, PYCAM_SCL);
 
@@ -342,9 +421,9 @@ bool Adafruit_PyCamera::initCamera(bool hwreset) {
      camera_config.fb_count = 1;
    */
   camera_config.pixel_format = PIXFORMAT_JPEG;
-  camera_config.frame_size =
-      FRAMESIZE_UXGA; // start with biggest possible image supported!!! do not
-                      // change this
+  // buffers are sized for this: later switches may only go smaller (UXGA,
+  // the default, allows every size)
+  camera_config.frame_size = framesize;
   camera_config.jpeg_quality = 4;
   camera_config.fb_count = 2;
 
@@ -385,13 +464,14 @@ float Adafruit_PyCamera::readBatteryVoltage(void) {
  * @brief Checks if an SD card is detected.
  *
  * @details Reads the state of the SD card detection pin using the AW9523
- * expander. A high state indicates that an SD card is present.
+ * expander (cached after beginInputCache()). A high state indicates that an SD
+ * card is present.
  *
  * @return true if an SD card is detected, false otherwise.
  */
 /**************************************************************************/
 bool Adafruit_PyCamera::SDdetected(void) {
-  return aw.digitalRead(AWEXP_SD_DET);
+  return (readInputs() >> AWEXP_SD_DET) & 1;
 }
 
 /**************************************************************************/
@@ -399,15 +479,16 @@ bool Adafruit_PyCamera::SDdetected(void) {
  * @brief Reads the current state of the buttons.
  *
  * @details Retrieves the state of all buttons connected to the AW9523 expander
- * and the shutter button. The state is updated and stored in the button_state
- * variable. The previous state is stored in last_button_state.
+ * (cached after beginInputCache()) and the shutter button. The state is
+ * updated and stored in the button_state variable. The previous state is
+ * stored in last_button_state.
  *
  * @return The current state of the buttons as a 32-bit unsigned integer.
  */
 /**************************************************************************/
 uint32_t Adafruit_PyCamera::readButtons(void) {
   last_button_state = button_state;
-  button_state = aw.inputGPIO() & AW_INPUTS_MASK;
+  button_state = readInputs() & AW_INPUTS_MASK;
   button_state |= (bool)digitalRead(SHUTTER_BUTTON);
   return button_state;
 }
@@ -460,9 +541,13 @@ bool Adafruit_PyCamera::justReleased(uint8_t button_pin) {
  */
 /**************************************************************************/
 void Adafruit_PyCamera::speaker_tone(uint32_t tonefreq, uint32_t tonetime) {
-  aw.digitalWrite(AWEXP_SPKR_SD, HIGH); // un-mute
-  tone(SPEAKER, tonefreq, tonetime);    // tone1 - B5
+  {
+    i2cbus::Guard bus(_bus, i2cbus::PRIO_UI);
+    aw.digitalWrite(AWEXP_SPKR_SD, HIGH); // un-mute
+  }
+  tone(SPEAKER, tonefreq, tonetime); // tone1 - B5
   delay(tonetime);
+  i2cbus::Guard bus(_bus, i2cbus::PRIO_UI);
   aw.digitalWrite(AWEXP_SPKR_SD, LOW); // mute
 }
 
@@ -476,6 +561,10 @@ void Adafruit_PyCamera::speaker_tone(uint32_t tonefreq, uint32_t tonetime) {
  * The function also manages camera frame buffer acquisition and release, and
  * sets the camera resolution.
  *
+ * @note Single shots only: it discards two frames, probes file names with
+ * sd.exists and lists the card after saving. Series at capture resolution go
+ * through lib/SdBurst (SD_BURST in main.cpp).
+ *
  * @param filename_base Base name for the file to be saved. The function appends
  * a numerical suffix to create a unique filename.
  * @param framesize The resolution at which the photo should be captured.
@@ -579,18 +668,306 @@ uint32_t Adafruit_PyCamera::timestamp(void) {
 
 /**************************************************************************/
 /**
- * @brief Prints a timestamped message to the Serial output.
+ * @brief Records a trace mark instead of printing a timestamp.
  *
- * @details This function prints a message to the Serial output, prefixed with a
- * timestamp. The timestamp represents the time elapsed in milliseconds since
- * the last call to `timestamp()` function. It is useful for debugging and
- * performance measurement.
+ * @details Printing on Serial would take milliseconds and interleave text
+ * with the binary record stream, so this only drops an EV_MARK instant into
+ * the trace ring (microsecond clock). The argument of the mark is the time
+ * elapsed since the last call to `timestamp()` in milliseconds; the message
+ * itself is not recorded.
  *
- * @param msg The message to be printed along with the timestamp.
+ * @param msg Unused, kept for source compatibility.
  */
 /**************************************************************************/
 void Adafruit_PyCamera::timestampPrint(const char *msg) {
-  Serial.printf("%s: %d ms elapsed\n\r", msg, (int)timestamp());
+  (void)msg;
+  trace::instant(trace::EV_MARK, (uint16_t)timestamp());
+}
+
+/**************************************************************************/
+/**
+ * @brief Takes the JPEG preview canvas from a frame pool.
+ *
+ * @details The 240x240 RGB565 canvases that captureFrame() decodes JPEG frames
+ * into are allocated from this pool on first use instead of the heap. Call
+ * before the first captureFrame() and beginAsyncBlit(); the pool must outlive
+ * the camera.
+ *
+ * @param pool Pool to allocate the canvas from, NULL for the heap.
+ */
+/**************************************************************************/
+void Adafruit_PyCamera::setFramePool(framepool::FramePool *pool) {
+  _pool = pool;
+}
+
+/**************************************************************************/
+/**
+ * @brief Shares an I2C bus arbiter with the sketch.
+ *
+ * @details Camera, AW9523 and LIS3DH sit on the same bus. With an arbiter,
+ * every access of this class takes the bus in its class: camera registers
+ * (setFramesize, setSpecialEffect) before the accelerometer before buttons,
+ * card detect, speaker and SD power. The sketch must take PRIO_CAMERA around
+ * its own sensor_t calls and must not hold the bus while calling in here.
+ *
+ * @param bus Arbiter to use, NULL for none.
+ */
+/**************************************************************************/
+void Adafruit_PyCamera::setBusArbiter(i2cbus::Arbiter *bus) { _bus = bus; }
+
+/**************************************************************************/
+/**
+ * @brief Caches the expander inputs instead of reading them on every call.
+ *
+ * @details readButtons() and SDdetected() otherwise read the AW9523 over I2C
+ * each time. With the cache, the AW9523 interrupt (any input changed) only
+ * marks the cached word stale; the next caller reads the inputs once, which
+ * also clears the interrupt, and publishes them atomically. Without an
+ * interrupt line the cache expires after max_age_ms instead.
+ *
+ * @param int_pin GPIO wired to the AW9523 INT output, -1 if none.
+ * @param max_age_ms Cache lifetime in ms, 0 = until the next interrupt.
+ * @return true if the cache is active, false without interrupt and lifetime.
+ */
+/**************************************************************************/
+bool Adafruit_PyCamera::beginInputCache(int8_t int_pin, uint32_t max_age_ms) {
+  if (int_pin < 0 && max_age_ms == 0)
+    return false;
+  _input_max_age_ms = max_age_ms;
+  if (int_pin >= 0) {
+    i2cbus::Guard bus(_bus, i2cbus::PRIO_UI);
+    aw.interruptEnableGPIO(AW_INPUTS_MASK);
+    pinMode(int_pin, INPUT_PULLUP); // INT is open drain, active low
+    attachInterruptArg(digitalPinToInterrupt(int_pin), inputISR, this,
+                       FALLING);
+  }
+  _inputs_stale = true;
+  _input_cache = true;
+  return true;
+}
+
+/**************************************************************************/
+/**
+ * @brief AW9523 interrupt: marks the cached inputs stale.
+ *
+ * @param arg The Adafruit_PyCamera object.
+ */
+/**************************************************************************/
+void IRAM_ATTR Adafruit_PyCamera::inputISR(void *arg) {
+  ((Adafruit_PyCamera *)arg)->_inputs_stale = true;
+}
+
+/**************************************************************************/
+/**
+ * @brief Reads the expander inputs, from the cache if it is valid.
+ *
+ * @details The stale flag is cleared before the read, so a change during the
+ * read marks the new value stale again. Callers racing for the same refresh
+ * get the previous value rather than a second read.
+ *
+ * @return The 16 input bits of the AW9523.
+ */
+/**************************************************************************/
+uint16_t Adafruit_PyCamera::readInputs(void) {
+  const uint32_t now = millis();
+  if (_input_cache && !_inputs_stale.exchange(false) &&
+      !(_input_max_age_ms && now - _inputs_ms >= _input_max_age_ms))
+    return _inputs;
+  i2cbus::Guard bus(_bus, i2cbus::PRIO_UI);
+  const uint16_t v = aw.inputGPIO();
+  input_reads++;
+  _inputs = v;
+  _inputs_ms = now;
+  return v;
+}
+
+/**************************************************************************/
+/**
+ * @brief Returns a preview canvas, allocating it on first use.
+ *
+ * @param i Canvas index, 0 or 1.
+ * @return The 240x240 RGB565 canvas, NULL if out of memory.
+ */
+/**************************************************************************/
+uint16_t *Adafruit_PyCamera::previewCanvas(uint8_t i) {
+  if (_canvas_buf[i])
+    return _canvas_buf[i];
+  if (_pool) {
+    if (!_canvas[i].valid())
+      _canvas[i] =
+          _pool->alloc<framepool::PLANE_RGB565>(240 * 240 * 2, 240, 240);
+    _canvas_buf[i] = _pool->data(_canvas[i]);
+  } else {
+    _canvas_buf[i] = (uint16_t *)malloc(240 * 240 * 2);
+  }
+  return _canvas_buf[i];
+}
+
+/**************************************************************************/
+/**
+ * @brief Sends JPEG previews to the display from a background task.
+ *
+ * @details Adafruit_SPITFT has no asynchronous pixel transfer on the ESP32,
+ * so a display task pinned to the given core pushes a finished canvas over
+ * SPI while the caller already fetches and decodes the next frame into the
+ * second canvas. blitFrame() then only hands the canvas over and returns the
+ * camera buffer at once; captureFrame() waits only if the display still
+ * sends the canvas it wants to decode into (counted in blit_stalls).
+ *
+ * Afterwards draw on the display only through fb between captureFrame() and
+ * blitFrame(), or call waitBlit() first: the task owns the SPI transaction
+ * while it sends. The SD card on the same bus waits for the running frame.
+ * RGB565 previews are still blitted synchronously.
+ *
+ * @param core Core to pin the display task to (the other one than the
+ * caller's for overlap).
+ * @return true if the display task runs, false without display or memory.
+ */
+/**************************************************************************/
+bool Adafruit_PyCamera::beginAsyncBlit(BaseType_t core) {
+  if (_blit_queue)
+    return true;
+  if (!fb || !previewCanvas(0) || !previewCanvas(1))
+    return false;
+  for (uint8_t i = 0; i < 2; i++) {
+    if (!_canvas_free[i])
+      _canvas_free[i] = xSemaphoreCreateBinary();
+    if (!_canvas_free[i])
+      return false;
+    xSemaphoreGive(_canvas_free[i]);
+  }
+  _blit_queue = xQueueCreate(1, sizeof(uint8_t));
+  if (!_blit_queue)
+    return false;
+  if (xTaskCreatePinnedToCore(blitTask, "blit", 3072, this, 1, NULL, core) !=
+      pdPASS) {
+    _blit_queue = NULL;
+    return false;
+  }
+  return true;
+}
+
+/**************************************************************************/
+/**
+ * @brief Display task: sends each handed-over canvas in one transaction.
+ *
+ * @param arg The Adafruit_PyCamera object.
+ */
+/**************************************************************************/
+void Adafruit_PyCamera::blitTask(void *arg) {
+  Adafruit_PyCamera *cam = (Adafruit_PyCamera *)arg;
+  uint8_t i;
+  for (;;) {
+    if (xQueueReceive(cam->_blit_queue, &i, portMAX_DELAY) != pdTRUE)
+      continue;
+    trace::begin(trace::EV_BLIT);
+    cam->sendCanvas(cam->_canvas_buf[i]);
+    trace::end(trace::EV_BLIT);
+    xSemaphoreGive(cam->_canvas_free[i]);
+  }
+}
+
+/**************************************************************************/
+/**
+ * @brief Sends a preview canvas to the display.
+ *
+ * @details Without the compositor the whole canvas goes out in one
+ * transaction. With it, only the rows of tiles whose camera content or
+ * overlays changed are composed and sent, each run into its own address
+ * window.
+ *
+ * @param canvas The 240x240 RGB565 preview.
+ */
+/**************************************************************************/
+void Adafruit_PyCamera::sendCanvas(const uint16_t *canvas) {
+  startWrite();
+  if (!_span_buf) {
+    setAddrWindow(0, 0, 240, 240);
+    writePixels((uint16_t *)canvas, 240 * 240, true, false);
+    endWrite();
+    return;
+  }
+  tiles_sent += overlays.update(canvas);
+  compositor::Span s;
+  while (overlays.nextSpan(&s)) {
+    overlays.compose(canvas, s, _span_buf);
+    setAddrWindow(s.x, s.y, s.w, s.h);
+    writePixels(_span_buf, (uint32_t)s.w * s.h, true, false);
+  }
+  endWrite();
+}
+
+/**************************************************************************/
+/**
+ * @brief Sends only changed display tiles and blends overlays at blit time.
+ *
+ * @details blitFrame() (and the display task of beginAsyncBlit()) then
+ * compares each preview with what the display already shows, in 16x16
+ * tiles: camera tiles count as changed when a quarter's mean brightness moved
+ * by more than threshold, overlay tiles on any change of the layers added
+ * with addOverlay(). Changed tiles are composed into a row buffer and sent
+ * through setAddrWindow(); a static scene with unchanged overlays costs no
+ * SPI transfer at all. Overlays are not drawn into fb, so status text can be
+ * redrawn every frame without touching the camera image.
+ *
+ * Call overlays.invalidate() after drawing on the display directly.
+ *
+ * @param threshold Brightness change (0..187 scale) that resends a camera
+ * tile; 0 resends on any change.
+ * @return true if the compositor is active, false without memory.
+ */
+/**************************************************************************/
+bool Adafruit_PyCamera::beginCompositor(uint8_t threshold) {
+  if (!_span_buf)
+    _span_buf = (uint16_t *)malloc(compositor::SCREEN * compositor::TILE *
+                                   sizeof(uint16_t));
+  if (!_span_buf)
+    return false;
+  overlays.setThreshold(threshold);
+  overlays.invalidate();
+  return true;
+}
+
+/**************************************************************************/
+/**
+ * @brief Adds a canvas as overlay layer above the camera preview.
+ *
+ * @details The layer is blended over the preview when it is sent; pixels
+ * equal to key stay transparent. Draw into the canvas at any time, a change
+ * shows with the next blitFrame(). With beginAsyncBlit() the display task
+ * may send a half-drawn layer once; the next frame corrects it.
+ *
+ * @param layer Canvas to show, must outlive the camera.
+ * @param x Left edge on the display.
+ * @param y Top edge on the display.
+ * @param key Transparent color.
+ * @return Layer index for overlays.moveLayer()/showLayer(), -1 if full.
+ */
+/**************************************************************************/
+int8_t Adafruit_PyCamera::addOverlay(GFXcanvas16 *layer, int16_t x, int16_t y,
+                                     uint16_t key) {
+  if (!layer)
+    return -1;
+  return overlays.addLayer(layer->getBuffer(), x, y, layer->width(),
+                           layer->height(), key);
+}
+
+/**************************************************************************/
+/**
+ * @brief Waits until the display task has sent every handed-over canvas.
+ *
+ * @details Returns at once without beginAsyncBlit().
+ */
+/**************************************************************************/
+void Adafruit_PyCamera::waitBlit(void) {
+  if (!_blit_queue)
+    return;
+  for (uint8_t i = 0; i < 2; i++) {
+    if (_back_held && i == _back)
+      continue;
+    xSemaphoreTake(_canvas_free[i], portMAX_DELAY);
+    xSemaphoreGive(_canvas_free[i]);
+  }
 }
 
 /**************************************************************************/
@@ -614,7 +991,9 @@ bool Adafruit_PyCamera::captureFrame(void) {
   int64_t fr_start = esp_timer_get_time();
 #endif
 
+  trace::begin(trace::EV_FB_GET);
   frame = esp_camera_fb_get();
+  trace::end(trace::EV_FB_GET);
 
   if (!frame) {
     ESP_LOGE(TAG, "Camera frame capture failed");
@@ -629,10 +1008,21 @@ bool Adafruit_PyCamera::captureFrame(void) {
   */
   if (camera_config.pixel_format == PIXFORMAT_JPEG) {
     // Serial.print("JPEG");
+    // With beginAsyncBlit() the back canvas may still be on its way to the
+    // display; the camera wait above already overlapped with that
+    if (_blit_queue && !_back_held) {
+      if (xSemaphoreTake(_canvas_free[_back], 0) != pdTRUE) {
+        blit_stalls++;
+        xSemaphoreTake(_canvas_free[_back], portMAX_DELAY);
+      }
+      _back_held = true;
+    }
     //  create the framebuffer if we haven't yet
-    if (!fb->getBuffer() || !jpeg_buffer) {
-      jpeg_buffer = (uint16_t *)malloc(240 * 240 * 2);
-      fb->setFB(jpeg_buffer);
+    jpeg_buffer = previewCanvas(_back);
+    if (!jpeg_buffer) {
+      esp_camera_fb_return(frame);
+      frame = NULL;
+      return false;
     }
     uint16_t w = 0, h = 0, scale = 1;
     int xoff = 0, yoff = 0;
@@ -652,7 +1042,9 @@ bool Adafruit_PyCamera::captureFrame(void) {
     // Serial.printf(" size: %d x %d, scale %d\n\r", w, h, scale);
     TJpgDec.setJpgScale(scale);
     TJpgDec.setCallback(buffer_output);
+    trace::begin(trace::EV_DECODE);
     TJpgDec.drawJpg(xoff, yoff, frame->buf, frame->len);
+    trace::end(trace::EV_DECODE);
     fb->setFB(jpeg_buffer);
   } else if (camera_config.pixel_format == PIXFORMAT_RGB565) {
     // flip endians
@@ -675,11 +1067,26 @@ bool Adafruit_PyCamera::captureFrame(void) {
  * @details This function draws the current frame buffer onto the display at the
  * specified coordinates. It is used to update the display with the latest
  * camera frame. After drawing, it returns the frame buffer to the camera for
- * reuse.
+ * reuse. With beginAsyncBlit(), a JPEG preview canvas is handed to the
+ * display task instead and the next captureFrame() decodes into the other
+ * canvas; fb must not be drawn on until then.
  */
 /**************************************************************************/
 void Adafruit_PyCamera::blitFrame(void) {
-  drawRGBBitmap(0, 0, (uint16_t *)fb->getBuffer(), 240, 240);
+  if (_back_held) {
+    xQueueSend(_blit_queue, &_back, portMAX_DELAY);
+    _back_held = false;
+    _back ^= 1;
+    esp_camera_fb_return(frame);
+    return;
+  }
+  waitBlit();
+  trace::begin(trace::EV_BLIT);
+  if (_span_buf)
+    sendCanvas(fb->getBuffer());
+  else
+    drawRGBBitmap(0, 0, (uint16_t *)fb->getBuffer(), 240, 240);
+  trace::end(trace::EV_BLIT);
 
   esp_camera_fb_return(frame);
 }
@@ -698,6 +1105,7 @@ void Adafruit_PyCamera::blitFrame(void) {
  */
 /**************************************************************************/
 bool Adafruit_PyCamera::initAccel(void) {
+  i2cbus::Guard bus(_bus, i2cbus::PRIO_SENSOR);
   lis_dev = new Adafruit_I2CDevice(0x19, &Wire);
   if (!lis_dev->begin()) {
     return false;
@@ -741,14 +1149,12 @@ bool Adafruit_PyCamera::initAccel(void) {
  */
 /**************************************************************************/
 bool Adafruit_PyCamera::readAccelData(int16_t *x, int16_t *y, int16_t *z) {
+  i2cbus::Guard bus(_bus, i2cbus::PRIO_SENSOR);
   uint8_t register_address = LIS3DH_REG_OUT_X_L;
   register_address |= 0x80; // set [7] for auto-increment
 
-  Adafruit_BusIO_Register xl_data =
-      Adafruit_BusIO_Register(lis_dev, register_address, 6);
-
   uint8_t buffer[6];
-  if (!xl_data.read(buffer, 6))
+  if (!lis_dev->write_then_read(&register_address, 1, buffer, 6))
     return false;
 
   *x = buffer[0];
@@ -789,6 +1195,82 @@ bool Adafruit_PyCamera::readAccelData(float *x_g, float *y_g, float *z_g) {
   return true;
 }
 
+/**************************************************************************/
+/**
+ * @brief Switches the accelerometer to FIFO stream mode.
+ *
+ * @details Requires initAccel() (400 Hz, high resolution, ±16 g). The FIFO is
+ * passed through bypass mode first, which empties it and clears an old
+ * overrun, then enabled in stream mode: it keeps the newest 32 samples and
+ * overwrites the oldest when it is not drained in time (80 ms at 400 Hz).
+ *
+ * @return true if the chip answered and all registers were written.
+ */
+/**************************************************************************/
+bool Adafruit_PyCamera::beginAccelFifo(void) {
+  if (!lis_dev)
+    return false;
+  i2cbus::Guard bus(_bus, i2cbus::PRIO_SENSOR);
+  uint8_t reg = LIS3DH_REG_WHOAMI, id = 0;
+  if (!lis_dev->write_then_read(&reg, 1, &id, 1) || id != 0x33)
+    return false;
+  const uint8_t bypass[2] = {LIS3DH_REG_FIFOCTRL, 0x00};
+  const uint8_t fifo_en[2] = {LIS3DH_REG_CTRL5, 0x40};
+  const uint8_t stream[2] = {LIS3DH_REG_FIFOCTRL, 0x80};
+  return lis_dev->write(bypass, 2) && lis_dev->write(fifo_en, 2) &&
+         lis_dev->write(stream, 2);
+}
+
+/**************************************************************************/
+/**
+ * @brief Drains the accelerometer FIFO.
+ *
+ * @details Reads the fill level from FIFO_SRC, then the samples with
+ * auto-increment from OUT_X_L; in FIFO mode the address wraps from OUT_Z_H
+ * back to OUT_X_L, so consecutive samples come in one read. Each read covers
+ * at most LIS3DH_FIFO_CHUNK samples and takes the bus on its own, so camera
+ * register accesses wait for one chunk at most.
+ *
+ * @param[out] xyz Raw left-justified samples, 3 per sample (x, y, z).
+ * @param max_samples Capacity of xyz in samples.
+ * @param[out] overrun Optional: set when the FIFO overflowed since the last
+ * drain (samples were lost).
+ * @return Number of samples read, -1 if the FIFO could not be read.
+ */
+/**************************************************************************/
+int Adafruit_PyCamera::readAccelFifo(int16_t *xyz, uint8_t max_samples,
+                                     bool *overrun) {
+  if (!lis_dev)
+    return -1;
+  uint8_t reg = LIS3DH_REG_FIFOSRC, src = 0;
+  {
+    i2cbus::Guard bus(_bus, i2cbus::PRIO_SENSOR);
+    if (!lis_dev->write_then_read(&reg, 1, &src, 1))
+      return -1;
+  }
+  if (overrun)
+    *overrun = src & 0x40;
+  uint8_t n = (src & 0x40) ? LIS3DH_FIFO_DEPTH : (src & 0x1F);
+  if (n > max_samples)
+    n = max_samples;
+
+  reg = LIS3DH_REG_OUT_X_L | 0x80; // auto-increment
+  uint8_t got = 0;
+  while (got < n) {
+    const uint8_t chunk = min((uint8_t)(n - got), (uint8_t)LIS3DH_FIFO_CHUNK);
+    uint8_t buffer[6 * LIS3DH_FIFO_CHUNK];
+    {
+      i2cbus::Guard bus(_bus, i2cbus::PRIO_SENSOR);
+      if (!lis_dev->write_then_read(&reg, 1, buffer, 6 * chunk))
+        return got ? got : -1;
+    }
+    for (uint8_t i = 0; i < 3 * chunk; i++)
+      xyz[3 * got + i] = (int16_t)(buffer[2 * i] | (buffer[2 * i + 1] << 8));
+    got += chunk;
+  }
+  return got;
+}
+
 /**************************************************************************/
 /**
  * @brief Scans the I2C bus and prints the addresses of all connected devices.
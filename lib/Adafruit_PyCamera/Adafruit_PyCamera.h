@@ -1,5 +1,12 @@
+#include "Compositor.h"
+#include "FramePool.h"
+#include "I2cBus.h"
 #include "TJpg_Decoder.h"
+#include "Trace.h"
 #include "esp_camera.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include <Adafruit_AW9523.h>
 #include <Adafruit_NeoPixel.h>
 #include <Adafruit_ST7789.h> // Hardware-specific library for ST7789
@@ -26,6 +33,23 @@
   (AW_DOWN_MASK | AW_LEFT_MASK | AW_UP_MASK | AW_RIGHT_MASK | AW_OK_MASK |     \
    AW_SEL_MASK | AW_CARDDET_MASK)
 
+/**************************************************************************/
+/**
+ * @brief Optional parts of the board for begin(parts, framesize).
+ *
+ * @details The expander and the camera are always initialized. Display, SD
+ * and accelerometer not requested are left for beginDeferred(); the I2C scan
+ * is only a diagnostic and is skipped when not requested.
+ */
+/**************************************************************************/
+enum PyCameraPart : uint8_t {
+  PYCAM_I2C_SCAN = 0x01, /**< Print the addresses on the I2C bus */
+  PYCAM_DISPLAY = 0x02,  /**< ST7789 display and preview framebuffer */
+  PYCAM_SD = 0x04,       /**< SD card, if one is inserted */
+  PYCAM_ACCEL = 0x08,    /**< LIS3DH accelerometer */
+  PYCAM_ALL = 0x0F,      /**< Everything begin(void) initializes */
+};
+
 /**************************************************************************/
 /**
  * @brief Framebuffer class for PyCamera.
@@ -77,17 +101,28 @@ public:
   Adafruit_PyCamera();
 
   bool begin(void);
+  bool begin(uint8_t parts, framesize_t framesize);
+  bool beginDeferred(uint8_t parts = PYCAM_ALL);
+  /** @brief Parts (PyCameraPart) still waiting for beginDeferred(). */
+  uint8_t deferredParts(void) const { return _deferred; }
 
-  bool initCamera(bool hwreset);
+  bool initCamera(bool hwreset, framesize_t framesize = FRAMESIZE_UXGA);
   bool initDisplay(void);
   bool initExpander(void);
   bool initAccel(void);
-  bool initSD(void);
+  bool initSD(uint8_t sck_mhz = 4);
   void endSD(void);
   void I2Cscan(void);
 
+  void setFramePool(framepool::FramePool *pool);
+  void setBusArbiter(i2cbus::Arbiter *bus);
+  bool beginInputCache(int8_t int_pin, uint32_t max_age_ms);
+  bool beginAsyncBlit(BaseType_t core = 0);
   bool captureFrame(void);
   void blitFrame(void);
+  void waitBlit(void);
+  bool beginCompositor(uint8_t threshold = 2);
+  int8_t addOverlay(GFXcanvas16 *layer, int16_t x, int16_t y, uint16_t key);
   bool takePhoto(const char *filename_base, framesize_t framesize);
   bool setFramesize(framesize_t framesize);
   bool setSpecialEffect(uint8_t effect);
@@ -102,6 +137,8 @@ public:
 
   bool readAccelData(int16_t *x, int16_t *y, int16_t *z);
   bool readAccelData(float *x, float *y, float *z);
+  bool beginAccelFifo(void);
+  int readAccelFifo(int16_t *xyz, uint8_t max_samples, bool *overrun = NULL);
 
   void setNeopixel(uint32_t c);
   void setRing(uint32_t c);
@@ -133,6 +170,14 @@ public:
   uint32_t last_button_state = 0xFFFFFFFF;
   /** @brief Current state of the buttons. */
   uint32_t button_state = 0xFFFFFFFF;
+  /** @brief I2C reads of the expander inputs (buttons, card detect). */
+  std::atomic<uint32_t> input_reads{0};
+  /** @brief captureFrame() calls that waited for the display task. */
+  uint32_t blit_stalls = 0;
+  /** @brief Overlay layers and tile state (beginCompositor()). */
+  compositor::Compositor overlays;
+  /** @brief Tiles sent to the display by the compositor. */
+  std::atomic<uint32_t> tiles_sent{0};
 
   /** @brief Current photo size setting. */
   framesize_t photoSize = FRAMESIZE_VGA;
@@ -140,6 +185,47 @@ public:
   int8_t specialEffect = 0;
   /** @brief Configuration structure for the camera. */
   camera_config_t camera_config;
+
+private:
+  void initPins(void);
+  bool initParts(uint8_t parts);
+  uint16_t readInputs(void);
+  static void inputISR(void *arg);
+  uint16_t *previewCanvas(uint8_t i);
+  static void blitTask(void *arg);
+  void sendCanvas(const uint16_t *canvas);
+
+  /** @brief Bus arbiter shared with the sketch (NULL = none). */
+  i2cbus::Arbiter *_bus = NULL;
+  /** @brief Expander inputs are cached (beginInputCache()). */
+  bool _input_cache = false;
+  /** @brief Cache is invalid: set by the AW9523 interrupt. */
+  std::atomic<bool> _inputs_stale{true};
+  /** @brief Cached expander inputs, published as one 32-bit word. */
+  std::atomic<uint32_t> _inputs{0xFFFF};
+  /** @brief millis() of the last expander read. */
+  std::atomic<uint32_t> _inputs_ms{0};
+  /** @brief Cache lifetime without interrupt, in ms (0 = unlimited). */
+  uint32_t _input_max_age_ms = 0;
+
+  /** @brief Parts left for beginDeferred(). */
+  uint8_t _deferred = 0;
+  /** @brief Pool for the preview canvas (NULL = heap). */
+  framepool::FramePool *_pool = NULL;
+  /** @brief Preview canvas planes when taken from _pool. */
+  framepool::Rgb565Handle _canvas[2] = {{0, 0}, {0, 0}};
+  /** @brief Preview canvases; the second one only with beginAsyncBlit(). */
+  uint16_t *_canvas_buf[2] = {NULL, NULL};
+  /** @brief Canvas indices for the display task (NULL = synchronous). */
+  QueueHandle_t _blit_queue = NULL;
+  /** @brief Given by the display task when a canvas has been sent. */
+  SemaphoreHandle_t _canvas_free[2] = {NULL, NULL};
+  /** @brief Canvas captureFrame() decodes into. */
+  uint8_t _back = 0;
+  /** @brief captureFrame() holds _canvas_free[_back]. */
+  bool _back_held = false;
+  /** @brief One composed row of tiles (NULL = compositor off). */
+  uint16_t *_span_buf = NULL;
 };
 
 #define LIS3DH_REG_STATUS1 0x07
@@ -161,4 +247,10 @@ public:
 #define LIS3DH_REG_CTRL6 0x25
 #define LIS3DH_REG_STATUS2 0x27
 #define LIS3DH_REG_OUT_X_L 0x28 /**< X-axis acceleration data. Low value */
+#define LIS3DH_REG_FIFOCTRL 0x2E /**< FIFO_CTRL_REG [FM1, FM0, TR, FTH4:0] */
+#define LIS3DH_REG_FIFOSRC                                                     \
+  0x2F /**< FIFO_SRC_REG [WTM, OVRN_FIFO, EMPTY, FSS4:0] */
+#define LIS3DH_FIFO_DEPTH 32 /**< Samples the FIFO holds */
+#define LIS3DH_FIFO_CHUNK                                                      \
+  5 /**< Samples per bus transaction in readAccelFifo() (~3 ms at 100 kHz) */
 #define LIS3DH_LSB16_TO_KILO_LSB10 6400
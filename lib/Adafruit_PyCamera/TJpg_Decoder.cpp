@@ -118,8 +118,7 @@ void TJpg_Decoder::setCallback(SketchCallback sketchCallback) {
  * @return The actual number of bytes fetched.
  */
 /**************************************************************************/
-unsigned int TJpg_Decoder::jd_input(JDEC *jdec, uint8_t *buf,
-                                    unsigned int len) {
+size_t TJpg_Decoder::jd_input(JDEC *jdec, uint8_t *buf, size_t len) {
   TJpg_Decoder *thisPtr = TJpgDec.thisPtr;
   jdec = jdec; // Supress warning
 
@@ -405,8 +404,7 @@ JRESULT TJpg_Decoder::drawFsJpg(int32_t x, int32_t y, fs::File inFile) {
 
   jpgFile = inFile;
 
-  jresult = jd_prepare(&jdec, jd_input, workspace, TJPGD_WORKSPACE_SIZE,
-                       (unsigned int)0);
+  jresult = jd_prepare(&jdec, jd_input, workspace, TJPGD_WORKSPACE_SIZE, 0);
 
   // Extract image and render
   if (jresult == JDR_OK) {
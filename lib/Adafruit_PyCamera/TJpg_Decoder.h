@@ -56,9 +56,9 @@ public:
   static int
   jd_output(JDEC *jdec, void *bitmap,
             JRECT *jrect); ///< Static callback for outputting JPEG blocks.
-  static unsigned int
+  static size_t
   jd_input(JDEC *jdec, uint8_t *buf,
-           unsigned int len); ///< Static callback for inputting JPEG data.
+           size_t len); ///< Static callback for inputting JPEG data.
 
   void setJpgScale(uint8_t scale); ///< Set the JPEG scaling factor.
   void
@@ -11,6 +11,27 @@ framesize_t validSizes[] = {FRAMESIZE_QQVGA, FRAMESIZE_QVGA, FRAMESIZE_HVGA,
                             FRAMESIZE_HD,    FRAMESIZE_SXGA, FRAMESIZE_UXGA,
                             FRAMESIZE_QXGA,  FRAMESIZE_QSXGA};
 
+// Text goes into overlay canvases instead of the camera framebuffer, so the
+// compositor resends only the tiles whose text actually changed
+const uint16_t OVERLAY_KEY = 0xF81F; // magenta = transparent
+GFXcanvas16 topText(240, 32);        // A0/battery voltage
+GFXcanvas16 bottomText(240, 40);     // frame size, accelerometer
+GFXcanvas16 notice(240, 16);         // SD card and "Snap!" messages
+int8_t noticeLayer = -1;
+uint32_t noticeUntil = 0;
+
+// Shows a message for a second at (x, y)
+void showNotice(int16_t x, int16_t y, uint16_t color, const char *text) {
+  notice.fillScreen(OVERLAY_KEY);
+  notice.setCursor(0, 0);
+  notice.setTextSize(2);
+  notice.setTextColor(color);
+  notice.print(text);
+  pycamera.overlays.moveLayer(noticeLayer, x, y);
+  pycamera.overlays.showLayer(noticeLayer, true);
+  noticeUntil = millis() + 1000;
+}
+
 // A colection of possible ring light colors
 uint32_t ringlightcolors_RGBW[] = {0x00000000, 0x00FF0000, 0x00FFFF00,
                                    0x0000FF00, 0x0000FFFF, 0x000000FF,
@@ -32,6 +53,13 @@ void setup() {
   }
   Serial.println("pyCamera hardware initialized!");
 
+  if (!pycamera.beginCompositor())
+    Serial.println("No memory for the preview overlays");
+  pycamera.addOverlay(&topText, 0, 0, OVERLAY_KEY);
+  pycamera.addOverlay(&bottomText, 0, 200, OVERLAY_KEY);
+  noticeLayer = pycamera.addOverlay(&notice, 0, 32, OVERLAY_KEY);
+  pycamera.overlays.showLayer(noticeLayer, false);
+
   pinMode(IRQ, INPUT_PULLUP);
   attachInterrupt(
       IRQ, [] { Serial.println("IRQ!"); }, FALLING);
@@ -48,24 +76,18 @@ void loop() {
   // pycamera.timestamp();
   pycamera.captureFrame();
 
-  // once the frame is captured we can draw ontot he framebuffer
+  // the overlays are composed over the frame in blitFrame()
   if (pycamera.justPressed(AWEXP_SD_DET)) {
 
     Serial.println(F("SD Card removed"));
     pycamera.endSD();
-    pycamera.fb->setCursor(0, 32);
-    pycamera.fb->setTextSize(2);
-    pycamera.fb->setTextColor(pycamera.color565(255, 0, 0));
-    pycamera.fb->print(F("SD Card removed"));
+    showNotice(0, 32, pycamera.color565(255, 0, 0), "SD Card removed");
     delay(200);
   }
   if (pycamera.justReleased(AWEXP_SD_DET)) {
     Serial.println(F("SD Card inserted!"));
     pycamera.initSD();
-    pycamera.fb->setCursor(0, 32);
-    pycamera.fb->setTextSize(2);
-    pycamera.fb->setTextColor(pycamera.color565(255, 0, 0));
-    pycamera.fb->print(F("SD Card inserted"));
+    showNotice(0, 32, pycamera.color565(255, 0, 0), "SD Card inserted");
     delay(200);
   }
 
@@ -74,71 +96,74 @@ void loop() {
     Serial.printf("A0 = %0.1f V, Battery = %0.1f V\n\r", A0_voltage,
                   pycamera.readBatteryVoltage());
   }
-  pycamera.fb->setCursor(0, 0);
-  pycamera.fb->setTextSize(2);
-  pycamera.fb->setTextColor(pycamera.color565(255, 255, 255));
-  pycamera.fb->print("A0 = ");
-  pycamera.fb->print(A0_voltage, 1);
-  pycamera.fb->print("V\nBattery = ");
-  pycamera.fb->print(pycamera.readBatteryVoltage(), 1);
-  pycamera.fb->print(" V");
+  if ((int32_t)(millis() - noticeUntil) >= 0)
+    pycamera.overlays.showLayer(noticeLayer, false);
+
+  topText.fillScreen(OVERLAY_KEY);
+  topText.setCursor(0, 0);
+  topText.setTextSize(2);
+  topText.setTextColor(pycamera.color565(255, 255, 255));
+  topText.print("A0 = ");
+  topText.print(A0_voltage, 1);
+  topText.print("V\nBattery = ");
+  topText.print(pycamera.readBatteryVoltage(), 1);
+  topText.print(" V");
 
   // print the camera frame size
-  pycamera.fb->setCursor(0, 200);
-  pycamera.fb->setTextSize(2);
-  pycamera.fb->setTextColor(pycamera.color565(255, 255, 255));
-  pycamera.fb->print("Size:");
+  bottomText.fillScreen(OVERLAY_KEY);
+  bottomText.setCursor(0, 0);
+  bottomText.setTextSize(2);
+  bottomText.setTextColor(pycamera.color565(255, 255, 255));
+  bottomText.print("Size:");
   switch (pycamera.photoSize) {
   case FRAMESIZE_QQVGA:
-    pycamera.fb->print("160x120");
+    bottomText.print("160x120");
     break;
   case FRAMESIZE_QVGA:
-    pycamera.fb->print("320x240");
+    bottomText.print("320x240");
     break;
   case FRAMESIZE_HVGA:
-    pycamera.fb->print("480x320");
+    bottomText.print("480x320");
     break;
   case FRAMESIZE_VGA:
-    pycamera.fb->print("640x480");
+    bottomText.print("640x480");
     break;
   case FRAMESIZE_SVGA:
-    pycamera.fb->print("800x600");
+    bottomText.print("800x600");
     break;
   case FRAMESIZE_XGA:
-    pycamera.fb->print("1024x768");
+    bottomText.print("1024x768");
     break;
   case FRAMESIZE_HD:
-    pycamera.fb->print("1280x720");
+    bottomText.print("1280x720");
     break;
   case FRAMESIZE_SXGA:
-    pycamera.fb->print("1280x1024");
+    bottomText.print("1280x1024");
     break;
   case FRAMESIZE_UXGA:
-    pycamera.fb->print("1600x1200");
+    bottomText.print("1600x1200");
     break;
   case FRAMESIZE_QXGA:
-    pycamera.fb->print("2048x1536");
+    bottomText.print("2048x1536");
     break;
   case FRAMESIZE_QSXGA:
-    pycamera.fb->print("2560x1920");
+    bottomText.print("2560x1920");
     break;
   default:
-    pycamera.fb->print("Unknown");
+    bottomText.print("Unknown");
     break;
   }
 
   float x_ms2, y_ms2, z_ms2;
   if (pycamera.readAccelData(&x_ms2, &y_ms2, &z_ms2)) {
     // Serial.printf("X=%0.2f, Y=%0.2f, Z=%0.2f\n\r", x_ms2, y_ms2, z_ms2);
-    pycamera.fb->setCursor(0, 220);
-    pycamera.fb->setTextSize(2);
-    pycamera.fb->setTextColor(pycamera.color565(255, 255, 255));
-    pycamera.fb->print("3D: ");
-    pycamera.fb->print(x_ms2, 1);
-    pycamera.fb->print(", ");
-    pycamera.fb->print(y_ms2, 1);
-    pycamera.fb->print(", ");
-    pycamera.fb->print(z_ms2, 1);
+    bottomText.setCursor(0, 20);
+    bottomText.print("3D: ");
+    bottomText.print(x_ms2, 1);
+    bottomText.print(", ");
+    bottomText.print(y_ms2, 1);
+    bottomText.print(", ");
+    bottomText.print(z_ms2, 1);
   }
 
   pycamera.blitFrame();
@@ -195,10 +220,7 @@ void loop() {
   if (pycamera.justPressed(SHUTTER_BUTTON)) {
     Serial.println("Snap!");
     if (pycamera.takePhoto("IMAGE", pycamera.photoSize)) {
-      pycamera.fb->setCursor(120, 100);
-      pycamera.fb->setTextSize(2);
-      pycamera.fb->setTextColor(pycamera.color565(255, 255, 255));
-      pycamera.fb->print("Snap!");
+      showNotice(120, 100, pycamera.color565(255, 255, 255), "Snap!");
       pycamera.speaker_tone(100, 50); // tone1 - B5
       // pycamera.blitFrame();
     }
@@ -0,0 +1,611 @@
+#include "CamLink.h"
+
+namespace camlink {
+
+static inline void putU16(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void putU32(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+static inline uint16_t getU16(const uint8_t *p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t getU32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+void encodeHeader(uint8_t out[HEADER_SIZE], RecordType type, uint32_t len) {
+  putU32(out, ((uint32_t)type << 24) | (len & MAX_PAYLOAD_LEN));
+}
+
+bool decodeHeader(const uint8_t in[HEADER_SIZE], RecordType *type,
+                  uint32_t *len) {
+  const uint32_t w = getU32(in);
+  const uint8_t t = (uint8_t)(w >> 24);
+  *len = w & MAX_PAYLOAD_LEN;
+  switch (t) {
+  case REC_JPEG:
+  case REC_MEASUREMENT:
+  case REC_JPEG_CROP:
+  case REC_QUALITY:
+  case REC_STROBE:
+  case REC_RING_STATS:
+  case REC_PIPELINE:
+  case REC_POOL_STATS:
+  case REC_TRACE:
+  case REC_TELEMETRY:
+  case REC_SD_STATS:
+  case REC_REPLAY:
+  case REC_PROFILE:
+  case REC_BOOT:
+  case REC_VIBRATION:
+    *type = (RecordType)t;
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool nextRecord(const uint8_t *data, size_t size, size_t *pos,
+                RecordType *type, uint32_t *len, const uint8_t **payload) {
+  for (size_t p = *pos; p + HEADER_SIZE <= size; p++) {
+    if (!decodeHeader(&data[p], type, len) || *len > size - p - HEADER_SIZE)
+      continue;
+    const size_t end = p + HEADER_SIZE + *len;
+    RecordType next_type;
+    uint32_t next_len;
+    if (end + HEADER_SIZE <= size &&
+        (!decodeHeader(&data[end], &next_type, &next_len) ||
+         next_len > size - end - HEADER_SIZE))
+      continue;
+    *payload = &data[p + HEADER_SIZE];
+    *pos = end;
+    return true;
+  }
+  *pos = size;
+  return false;
+}
+
+size_t encodeMeasurement(uint8_t out[MEASUREMENT_SIZE],
+                         const MeasurementRecord &rec) {
+  uint8_t *p = out;
+  putU32(p, rec.seq);                          p += 4;
+  putU32(p, rec.t_ms);                         p += 4;
+  putU16(p, rec.flags);                        p += 2;
+  *p++ = rec.scale;
+  *p++ = rec.status;
+  putU32(p, (uint32_t)rec.tl_x);               p += 4;
+  putU32(p, (uint32_t)rec.tl_y);               p += 4;
+  putU32(p, (uint32_t)rec.tr_x);               p += 4;
+  putU32(p, (uint32_t)rec.tr_y);               p += 4;
+  putU32(p, (uint32_t)rec.angle_deg);          p += 4;
+  putU32(p, (uint32_t)rec.px_per_cm);          p += 4;
+  putU32(p, (uint32_t)rec.offset_center_px);   p += 4;
+  putU32(p, (uint32_t)rec.rotation_delta_deg); p += 4;
+  putU32(p, (uint32_t)rec.left_offset_px);     p += 4;
+  putU32(p, (uint32_t)rec.right_offset_px);    p += 4;
+  return (size_t)(p - out);
+}
+
+bool decodeMeasurement(const uint8_t *in, size_t len, MeasurementRecord *rec) {
+  if (len < MEASUREMENT_SIZE)
+    return false;
+  const uint8_t *p = in;
+  rec->seq = getU32(p);                          p += 4;
+  rec->t_ms = getU32(p);                         p += 4;
+  rec->flags = getU16(p);                        p += 2;
+  rec->scale = *p++;
+  rec->status = *p++;
+  rec->tl_x = (int32_t)getU32(p);                p += 4;
+  rec->tl_y = (int32_t)getU32(p);                p += 4;
+  rec->tr_x = (int32_t)getU32(p);                p += 4;
+  rec->tr_y = (int32_t)getU32(p);                p += 4;
+  rec->angle_deg = (int32_t)getU32(p);           p += 4;
+  rec->px_per_cm = (int32_t)getU32(p);           p += 4;
+  rec->offset_center_px = (int32_t)getU32(p);    p += 4;
+  rec->rotation_delta_deg = (int32_t)getU32(p);  p += 4;
+  rec->left_offset_px = (int32_t)getU32(p);      p += 4;
+  rec->right_offset_px = (int32_t)getU32(p);
+  return true;
+}
+
+size_t encodeQuality(uint8_t out[QUALITY_SIZE], const QualityRecord &rec) {
+  uint8_t *p = out;
+  putU32(p, rec.seq);              p += 4;
+  putU32(p, rec.t_ms);             p += 4;
+  *p++ = rec.quality;
+  *p++ = rec.prev_quality;
+  putU16(p, 0);                    p += 2;  // reserviert
+  putU32(p, rec.avg_bytes);        p += 4;
+  putU32(p, rec.target_bytes);     p += 4;
+  putU32(p, rec.link_bytes_per_s); p += 4;
+  return (size_t)(p - out);
+}
+
+bool decodeQuality(const uint8_t *in, size_t len, QualityRecord *rec) {
+  if (len < QUALITY_SIZE)
+    return false;
+  const uint8_t *p = in;
+  rec->seq = getU32(p);              p += 4;
+  rec->t_ms = getU32(p);             p += 4;
+  rec->quality = *p++;
+  rec->prev_quality = *p++;
+  p += 2;
+  rec->avg_bytes = getU32(p);        p += 4;
+  rec->target_bytes = getU32(p);     p += 4;
+  rec->link_bytes_per_s = getU32(p);
+  return true;
+}
+
+size_t encodeStrobe(uint8_t out[STROBE_SIZE], const StrobeRecord &rec) {
+  uint8_t *p = out;
+  putU32(p, rec.seq);                      p += 4;
+  putU32(p, rec.t_ms);                     p += 4;
+  putU32(p, (uint32_t)rec.on_us);          p += 4;
+  putU32(p, (uint32_t)rec.off_us);         p += 4;
+  putU32(p, rec.exposure_us);              p += 4;
+  putU32(p, rec.readout_us);               p += 4;
+  putU32(p, rec.period_us);                p += 4;
+  putU32(p, (uint32_t)rec.vsync_error_us); p += 4;
+  *p++ = rec.mode;
+  *p++ = rec.aligned;
+  putU16(p, 0);                            p += 2;  // reserviert
+  return (size_t)(p - out);
+}
+
+bool decodeStrobe(const uint8_t *in, size_t len, StrobeRecord *rec) {
+  if (len < STROBE_SIZE)
+    return false;
+  const uint8_t *p = in;
+  rec->seq = getU32(p);                      p += 4;
+  rec->t_ms = getU32(p);                     p += 4;
+  rec->on_us = (int32_t)getU32(p);           p += 4;
+  rec->off_us = (int32_t)getU32(p);          p += 4;
+  rec->exposure_us = getU32(p);              p += 4;
+  rec->readout_us = getU32(p);               p += 4;
+  rec->period_us = getU32(p);                p += 4;
+  rec->vsync_error_us = (int32_t)getU32(p);  p += 4;
+  rec->mode = *p++;
+  rec->aligned = *p;
+  return true;
+}
+
+size_t encodeRingStats(uint8_t out[RING_STATS_SIZE],
+                       const RingStatsRecord &rec) {
+  uint8_t *p = out;
+  putU32(p, rec.seq);                     p += 4;
+  putU32(p, rec.t_ms);                    p += 4;
+  putU32(p, rec.capacity_bytes);          p += 4;
+  putU32(p, rec.used_bytes);              p += 4;
+  putU32(p, rec.high_water_bytes);        p += 4;
+  *p++ = rec.frames;
+  *p++ = rec.max_frames;
+  putU16(p, 0);                           p += 2;  // reserviert
+  putU32(p, rec.pushed);                  p += 4;
+  putU32(p, rec.overwritten);             p += 4;
+  putU32(p, rec.oversize);                p += 4;
+  putU32(p, rec.sensor_gaps);             p += 4;
+  putU32(p, rec.hits);                    p += 4;
+  putU32(p, rec.misses);                  p += 4;
+  putU32(p, rec.period_us);               p += 4;
+  putU32(p, (uint32_t)rec.last_error_us); p += 4;
+  return (size_t)(p - out);
+}
+
+bool decodeRingStats(const uint8_t *in, size_t len, RingStatsRecord *rec) {
+  if (len < RING_STATS_SIZE)
+    return false;
+  const uint8_t *p = in;
+  rec->seq = getU32(p);                     p += 4;
+  rec->t_ms = getU32(p);                    p += 4;
+  rec->capacity_bytes = getU32(p);          p += 4;
+  rec->used_bytes = getU32(p);              p += 4;
+  rec->high_water_bytes = getU32(p);        p += 4;
+  rec->frames = *p++;
+  rec->max_frames = *p++;
+  p += 2;
+  rec->pushed = getU32(p);                  p += 4;
+  rec->overwritten = getU32(p);             p += 4;
+  rec->oversize = getU32(p);                p += 4;
+  rec->sensor_gaps = getU32(p);             p += 4;
+  rec->hits = getU32(p);                    p += 4;
+  rec->misses = getU32(p);                  p += 4;
+  rec->period_us = getU32(p);               p += 4;
+  rec->last_error_us = (int32_t)getU32(p);
+  return true;
+}
+
+size_t encodePipeline(uint8_t out[PIPELINE_SIZE], const PipelineRecord &rec) {
+  uint8_t *p = out;
+  putU32(p, rec.seq);                   p += 4;
+  putU32(p, rec.t_ms);                  p += 4;
+  putU32(p, rec.interval_us);           p += 4;
+  for (uint8_t i = 0; i < PIPELINE_STAGES; i++) {
+    putU32(p, rec.stage[i].frames);     p += 4;
+    putU32(p, rec.stage[i].busy_us);    p += 4;
+    putU32(p, rec.stage[i].stall_us);   p += 4;
+  }
+  for (uint8_t i = 0; i < PIPELINE_STAGES; i++) {
+    *p++ = rec.queue[i].capacity;
+    *p++ = rec.queue[i].depth;
+    *p++ = rec.queue[i].high_water;
+    *p++ = 0;  // reserviert
+    putU32(p, rec.queue[i].full);       p += 4;
+  }
+  return (size_t)(p - out);
+}
+
+bool decodePipeline(const uint8_t *in, size_t len, PipelineRecord *rec) {
+  if (len < PIPELINE_SIZE)
+    return false;
+  const uint8_t *p = in;
+  rec->seq = getU32(p);                   p += 4;
+  rec->t_ms = getU32(p);                  p += 4;
+  rec->interval_us = getU32(p);           p += 4;
+  for (uint8_t i = 0; i < PIPELINE_STAGES; i++) {
+    rec->stage[i].frames = getU32(p);     p += 4;
+    rec->stage[i].busy_us = getU32(p);    p += 4;
+    rec->stage[i].stall_us = getU32(p);   p += 4;
+  }
+  for (uint8_t i = 0; i < PIPELINE_STAGES; i++) {
+    rec->queue[i].capacity = *p++;
+    rec->queue[i].depth = *p++;
+    rec->queue[i].high_water = *p++;
+    p++;
+    rec->queue[i].full = getU32(p);       p += 4;
+  }
+  return true;
+}
+
+size_t encodePoolStats(uint8_t out[POOL_STATS_SIZE],
+                       const PoolStatsRecord &rec) {
+  uint8_t *p = out;
+  putU32(p, rec.seq);                           p += 4;
+  putU32(p, rec.t_ms);                          p += 4;
+  for (uint8_t i = 0; i < POOL_COUNT; i++) {
+    putU32(p, rec.pool[i].capacity_bytes);      p += 4;
+    putU32(p, rec.pool[i].used_bytes);          p += 4;
+    putU32(p, rec.pool[i].high_water_bytes);    p += 4;
+    putU32(p, rec.pool[i].largest_free_bytes);  p += 4;
+    putU32(p, rec.pool[i].allocs);              p += 4;
+    putU32(p, rec.pool[i].failures);            p += 4;
+    putU16(p, rec.pool[i].planes);              p += 2;
+    *p++ = rec.pool[i].fragmentation_pct;
+    *p++ = 0;  // reserviert
+  }
+  return (size_t)(p - out);
+}
+
+bool decodePoolStats(const uint8_t *in, size_t len, PoolStatsRecord *rec) {
+  if (len < POOL_STATS_SIZE)
+    return false;
+  const uint8_t *p = in;
+  rec->seq = getU32(p);                           p += 4;
+  rec->t_ms = getU32(p);                          p += 4;
+  for (uint8_t i = 0; i < POOL_COUNT; i++) {
+    rec->pool[i].capacity_bytes = getU32(p);      p += 4;
+    rec->pool[i].used_bytes = getU32(p);          p += 4;
+    rec->pool[i].high_water_bytes = getU32(p);    p += 4;
+    rec->pool[i].largest_free_bytes = getU32(p);  p += 4;
+    rec->pool[i].allocs = getU32(p);              p += 4;
+    rec->pool[i].failures = getU32(p);            p += 4;
+    rec->pool[i].planes = getU16(p);              p += 2;
+    rec->pool[i].fragmentation_pct = *p++;
+    p++;
+  }
+  return true;
+}
+
+size_t encodeTraceHeader(uint8_t out[TRACE_HEADER_SIZE],
+                         const TraceHeader &hdr) {
+  uint8_t *p = out;
+  putU32(p, hdr.seq);      p += 4;
+  *p++ = hdr.core;
+  *p++ = hdr.count;
+  putU16(p, 0);            p += 2;  // reserviert
+  putU32(p, hdr.dropped);  p += 4;
+  return (size_t)(p - out);
+}
+
+bool decodeTraceHeader(const uint8_t *in, size_t len, TraceHeader *hdr) {
+  if (len < TRACE_HEADER_SIZE)
+    return false;
+  const uint8_t *p = in;
+  hdr->seq = getU32(p);      p += 4;
+  hdr->core = *p++;
+  hdr->count = *p++;
+  p += 2;
+  hdr->dropped = getU32(p);
+  return len >= TRACE_HEADER_SIZE + (size_t)hdr->count * TRACE_EVENT_SIZE;
+}
+
+size_t encodeTraceEvent(uint8_t out[TRACE_EVENT_SIZE], const TraceEvent &ev) {
+  putU32(out + 0, ev.t_us);
+  putU16(out + 4, ev.arg);
+  out[6] = ev.id;
+  out[7] = ev.phase;
+  return TRACE_EVENT_SIZE;
+}
+
+bool decodeTraceEvent(const uint8_t *in, size_t len, TraceEvent *ev) {
+  if (len < TRACE_EVENT_SIZE)
+    return false;
+  ev->t_us = getU32(in + 0);
+  ev->arg = getU16(in + 4);
+  ev->id = in[6];
+  ev->phase = in[7];
+  return true;
+}
+
+const char *telemetryMetricName(TelemetryMetric m) {
+  switch (m) {
+  case TM_TRIGGER_TO_EXPOSURE: return "trigger_belichtung";
+  case TM_EXPOSURE_TO_FB:      return "belichtung_fb";
+  case TM_FB_TO_FIRST_BYTE:    return "fb_erstes_byte";
+  case TM_TRANSMIT:            return "senden";
+  case TM_FRAME_BYTES:         return "jpeg_bytes";
+  case TM_I2C_WAIT:            return "i2c_warten";
+  case TELEMETRY_METRICS:      break;
+  }
+  return "?";
+}
+
+size_t encodeSdStats(uint8_t out[SD_STATS_SIZE], const SdStatsRecord &rec) {
+  uint8_t *p = out;
+  putU32(p, rec.seq);                 p += 4;
+  putU32(p, rec.t_ms);                p += 4;
+  putU32(p, rec.files);               p += 4;
+  putU32(p, rec.failures);            p += 4;
+  putU32(p, rec.kbytes);              p += 4;
+  putU32(p, rec.busy_ms);             p += 4;
+  putU32(p, rec.last_write_us);       p += 4;
+  putU32(p, rec.max_write_us);        p += 4;
+  putU32(p, rec.max_prealloc_us);     p += 4;
+  putU32(p, rec.next_index);          p += 4;
+  *p++ = rec.spare;
+  *p++ = rec.sck_mhz;
+  *p++ = rec.last_error;
+  *p++ = 0;  // reserviert
+  return (size_t)(p - out);
+}
+
+bool decodeSdStats(const uint8_t *in, size_t len, SdStatsRecord *rec) {
+  if (len < SD_STATS_SIZE)
+    return false;
+  const uint8_t *p = in;
+  rec->seq = getU32(p);                 p += 4;
+  rec->t_ms = getU32(p);                p += 4;
+  rec->files = getU32(p);               p += 4;
+  rec->failures = getU32(p);            p += 4;
+  rec->kbytes = getU32(p);              p += 4;
+  rec->busy_ms = getU32(p);             p += 4;
+  rec->last_write_us = getU32(p);       p += 4;
+  rec->max_write_us = getU32(p);        p += 4;
+  rec->max_prealloc_us = getU32(p);     p += 4;
+  rec->next_index = getU32(p);          p += 4;
+  rec->spare = *p++;
+  rec->sck_mhz = *p++;
+  rec->last_error = *p;
+  return true;
+}
+
+size_t encodeReplay(uint8_t out[REPLAY_SIZE], const ReplayRecord &rec) {
+  uint8_t *p = out;
+  putU32(p, rec.seq);                 p += 4;
+  putU32(p, rec.t_ms);                p += 4;
+  putU32(p, rec.len);                 p += 4;
+  putU32(p, rec.backlog_kbytes);      p += 4;
+  putU32(p, rec.spilled);             p += 4;
+  putU32(p, rec.drained);             p += 4;
+  putU32(p, rec.dropped);             p += 4;
+  putU32(p, rec.corrupt);             p += 4;
+  return (size_t)(p - out);
+}
+
+bool decodeReplay(const uint8_t *in, size_t len, ReplayRecord *rec) {
+  if (len < REPLAY_SIZE)
+    return false;
+  const uint8_t *p = in;
+  rec->seq = getU32(p);                 p += 4;
+  rec->t_ms = getU32(p);                p += 4;
+  rec->len = getU32(p);                 p += 4;
+  rec->backlog_kbytes = getU32(p);      p += 4;
+  rec->spilled = getU32(p);             p += 4;
+  rec->drained = getU32(p);             p += 4;
+  rec->dropped = getU32(p);             p += 4;
+  rec->corrupt = getU32(p);
+  return true;
+}
+
+size_t encodeProfile(uint8_t out[PROFILE_SIZE], const ProfileRecord &rec) {
+  uint8_t *p = out;
+  putU32(p, rec.seq);                 p += 4;
+  putU32(p, rec.t_ms);                p += 4;
+  putU32(p, rec.switch_us);           p += 4;
+  *p++ = rec.profile;
+  *p++ = rec.writes;
+  *p++ = rec.failed;
+  *p++ = rec.flags;
+  return (size_t)(p - out);
+}
+
+bool decodeProfile(const uint8_t *in, size_t len, ProfileRecord *rec) {
+  if (len < PROFILE_SIZE)
+    return false;
+  const uint8_t *p = in;
+  rec->seq = getU32(p);                 p += 4;
+  rec->t_ms = getU32(p);                p += 4;
+  rec->switch_us = getU32(p);           p += 4;
+  rec->profile = *p++;
+  rec->writes = *p++;
+  rec->failed = *p++;
+  rec->flags = *p;
+  return true;
+}
+
+size_t encodeBoot(uint8_t out[BOOT_SIZE], const BootRecord &rec) {
+  uint8_t *p = out;
+  putU32(p, rec.seq);                 p += 4;
+  putU32(p, rec.setup_us);            p += 4;
+  putU32(p, rec.camera_us);           p += 4;
+  putU32(p, rec.ready_us);            p += 4;
+  putU32(p, rec.first_frame_us);      p += 4;
+  putU32(p, rec.deferred_us);         p += 4;
+  *p++ = rec.reset_reason;
+  *p++ = rec.flags;
+  *p++ = rec.parts;
+  *p++ = rec.deferred;
+  return (size_t)(p - out);
+}
+
+bool decodeBoot(const uint8_t *in, size_t len, BootRecord *rec) {
+  if (len < BOOT_SIZE)
+    return false;
+  const uint8_t *p = in;
+  rec->seq = getU32(p);                 p += 4;
+  rec->setup_us = getU32(p);            p += 4;
+  rec->camera_us = getU32(p);           p += 4;
+  rec->ready_us = getU32(p);            p += 4;
+  rec->first_frame_us = getU32(p);      p += 4;
+  rec->deferred_us = getU32(p);         p += 4;
+  rec->reset_reason = *p++;
+  rec->flags = *p++;
+  rec->parts = *p++;
+  rec->deferred = *p;
+  return true;
+}
+
+size_t encodeVibration(uint8_t out[VIBRATION_SIZE], const VibrationRecord &rec) {
+  uint8_t *p = out;
+  putU32(p, rec.seq);                 p += 4;
+  putU32(p, rec.t_ms);                p += 4;
+  putU16(p, rec.rms_mg);              p += 2;
+  putU16(p, rec.peak_mg);             p += 2;
+  putU16(p, rec.limit_mg);            p += 2;
+  putU16(p, rec.delay_ms);            p += 2;
+  putU16(p, rec.age_ms);              p += 2;
+  *p++ = rec.window;
+  *p++ = rec.flags;
+  return (size_t)(p - out);
+}
+
+bool decodeVibration(const uint8_t *in, size_t len, VibrationRecord *rec) {
+  if (len < VIBRATION_SIZE)
+    return false;
+  const uint8_t *p = in;
+  rec->seq = getU32(p);                 p += 4;
+  rec->t_ms = getU32(p);                p += 4;
+  rec->rms_mg = getU16(p);              p += 2;
+  rec->peak_mg = getU16(p);             p += 2;
+  rec->limit_mg = getU16(p);            p += 2;
+  rec->delay_ms = getU16(p);            p += 2;
+  rec->age_ms = getU16(p);              p += 2;
+  rec->window = *p++;
+  rec->flags = *p;
+  return true;
+}
+
+size_t encodeTelemetry(uint8_t *out, size_t cap, const TelemetryRecord &rec) {
+  size_t need = TELEMETRY_HEADER_SIZE;
+  for (uint8_t m = 0; m < TELEMETRY_METRICS; m++)
+    need += 5 + 3 * (size_t)rec.hist[m].used;
+  if (cap < need)
+    return 0;
+  uint8_t *p = out;
+  putU32(p, rec.seq);               p += 4;
+  putU32(p, rec.t_ms);              p += 4;
+  putU32(p, rec.interval_ms);       p += 4;
+  *p++ = rec.camera;
+  *p++ = rec.depth_max;
+  *p++ = rec.depth_mean_x16;
+  *p++ = TELEMETRY_METRICS;
+  putU32(p, rec.frames);            p += 4;
+  putU32(p, rec.capture_failures);  p += 4;
+  putU32(p, rec.empty_frames);      p += 4;
+  putU32(p, rec.ring_misses);       p += 4;
+  putU32(p, rec.queue_full);        p += 4;
+  putU32(p, rec.bytes_sent);        p += 4;
+  for (uint8_t m = 0; m < TELEMETRY_METRICS; m++) {
+    const TelemetryHistogram &h = rec.hist[m];
+    putU32(p, h.max);               p += 4;
+    *p++ = h.used;
+    for (uint8_t i = 0; i < h.used; i++) {
+      *p++ = h.index[i];
+      putU16(p, h.count[i]);        p += 2;
+    }
+  }
+  return (size_t)(p - out);
+}
+
+bool decodeTelemetry(const uint8_t *in, size_t len, TelemetryRecord *rec) {
+  if (len < TELEMETRY_HEADER_SIZE)
+    return false;
+  const uint8_t *p = in;
+  const uint8_t *end = in + len;
+  rec->seq = getU32(p);               p += 4;
+  rec->t_ms = getU32(p);              p += 4;
+  rec->interval_ms = getU32(p);       p += 4;
+  rec->camera = *p++;
+  rec->depth_max = *p++;
+  rec->depth_mean_x16 = *p++;
+  // Ältere Aufzeichnungen mit weniger Messgrößen: Rest bleibt leer
+  const uint8_t metrics = *p++;
+  if (metrics > TELEMETRY_METRICS)
+    return false;
+  rec->frames = getU32(p);            p += 4;
+  rec->capture_failures = getU32(p);  p += 4;
+  rec->empty_frames = getU32(p);      p += 4;
+  rec->ring_misses = getU32(p);       p += 4;
+  rec->queue_full = getU32(p);        p += 4;
+  rec->bytes_sent = getU32(p);        p += 4;
+  for (uint8_t m = 0; m < TELEMETRY_METRICS; m++) {
+    TelemetryHistogram &h = rec->hist[m];
+    if (m >= metrics) {
+      h.max = 0;
+      h.used = 0;
+      continue;
+    }
+    if (end - p < 5)
+      return false;
+    h.max = getU32(p);                p += 4;
+    h.used = *p++;
+    if (h.used > TELEMETRY_BUCKETS || end - p < 3 * (ptrdiff_t)h.used)
+      return false;
+    for (uint8_t i = 0; i < h.used; i++) {
+      h.index[i] = *p++;
+      h.count[i] = getU16(p);         p += 2;
+      if (h.index[i] >= TELEMETRY_BUCKETS)
+        return false;
+    }
+  }
+  return true;
+}
+
+size_t encodeCropInfo(uint8_t out[CROP_INFO_SIZE], const CropInfo &info) {
+  putU16(out + 0, info.x0);
+  putU16(out + 2, info.y0);
+  putU16(out + 4, info.full_w);
+  putU16(out + 6, info.full_h);
+  return CROP_INFO_SIZE;
+}
+
+bool decodeCropInfo(const uint8_t *in, size_t len, CropInfo *info) {
+  if (len < CROP_INFO_SIZE)
+    return false;
+  info->x0 = getU16(in + 0);
+  info->y0 = getU16(in + 2);
+  info->full_w = getU16(in + 4);
+  info->full_h = getU16(in + 6);
+  return true;
+}
+
+} // namespace camlink
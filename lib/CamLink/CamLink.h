@@ -0,0 +1,400 @@
+#pragma once
+// CamLink: Datensätze auf der seriellen Verbindung Kamera -> PC
+//
+// Jeder Datensatz beginnt mit einem 32-Bit-Wort (little-endian):
+//   Bit 31..24 = Datensatztyp, Bit 23..0 = Nutzlast-Länge in Bytes
+// Typ 0 ist das bisherige JPEG-Format ([u32 Länge][JPEG]), d. h. ältere
+// Empfänger bleiben für reine Bildströme kompatibel.
+//
+// Keine Arduino-Abhängigkeit: wird von Firmware und Host-Werkzeugen genutzt.
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace camlink {
+
+enum RecordType : uint8_t {
+  REC_JPEG        = 0x00,  // komplettes JPEG-Bild
+  REC_MEASUREMENT = 0x01,  // MeasurementRecord (Messwerte eines Labels)
+  REC_JPEG_CROP   = 0x02,  // CropInfo + verlustfreier JPEG-Ausschnitt
+  REC_QUALITY     = 0x03,  // QualityRecord (JPEG-Qualität geändert)
+  REC_STROBE      = 0x04,  // StrobeRecord (Lage des Blitzes zum Frame)
+  REC_RING_STATS  = 0x05,  // RingStatsRecord (Vorlauf-Ringpuffer)
+  REC_PIPELINE    = 0x06,  // PipelineRecord (Auslastung der Task-Pipeline)
+  REC_POOL_STATS  = 0x07,  // PoolStatsRecord (Bildspeicher-Pools)
+  REC_TRACE       = 0x08,  // TraceHeader + TraceEvent[] (Zeitmarken eines Kerns)
+  REC_TELEMETRY   = 0x09,  // TelemetryRecord (Latenz-Histogramme, Zähler)
+  REC_SD_STATS    = 0x0A,  // SdStatsRecord (Bildserie auf SD-Karte)
+  REC_REPLAY      = 0x0B,  // ReplayRecord + nachgeholte Datensätze (SD-Journal)
+  REC_PROFILE     = 0x0C,  // ProfileRecord (Sensorprofil gewechselt)
+  REC_BOOT        = 0x0D,  // BootRecord (Start bis zum ersten gültigen Frame)
+  REC_VIBRATION   = 0x0E,  // VibrationRecord (Erschütterung bei der Aufnahme)
+};
+
+static const uint32_t HEADER_SIZE     = 4;
+static const uint32_t MAX_PAYLOAD_LEN = 0x00FFFFFFu;
+
+// Flags im MeasurementRecord
+enum MeasurementFlags : uint16_t {
+  MEAS_VALID        = 1u << 0,  // Kante erkannt, Messwerte gültig
+  MEAS_JPEG_FOLLOWS = 1u << 1,  // direkt danach folgt das JPEG dieses Frames
+  MEAS_ANOMALY      = 1u << 2,  // Grenzwert verletzt oder Erkennung fehlgeschlagen
+  MEAS_REFERENCE    = 1u << 3,  // dieser Frame ist das Referenzbild
+  MEAS_STREAMED     = 1u << 4,  // volle Auflösung im Durchlauf gemessen (LabelMeter)
+  MEAS_TRACKED      = 1u << 5,  // Kante im vorhergesagten Fenster gefunden (RoiTracker)
+  MEAS_EMPTY        = 1u << 6,  // kein Label im Bild (PresenceDetector), nicht gemessen
+  MEAS_PARTIAL      = 1u << 7,  // Label ragt aus dem Bild (PresenceDetector)
+  MEAS_VIBRATION    = 1u << 8,  // bei Erschütterung aufgenommen (VibrationRecord)
+};
+
+// Alle Geometriewerte als Q16.16-Festkomma, Koordinaten in Pixeln des
+// vollen Sensorbildes (unabhängig von der Dekodier-Skalierung).
+struct MeasurementRecord {
+  uint32_t seq;               // fortlaufende Framenummer
+  uint32_t t_ms;              // millis() bei Aufnahme
+  uint16_t flags;             // MeasurementFlags
+  uint8_t  scale;             // Dekodier-Skalierung (0..3 = 1/1..1/8)
+  uint8_t  status;            // labelgeom::Result der Erkennung
+  int32_t  tl_x, tl_y;        // linker Endpunkt der oberen Kante [px]
+  int32_t  tr_x, tr_y;        // rechter Endpunkt der oberen Kante [px]
+  int32_t  angle_deg;         // Kantenwinkel [°]
+  int32_t  px_per_cm;         // Skala aus der Referenz [px/cm]
+  int32_t  offset_center_px;  // orthogonaler Abstand Mittelpunkt [px]
+  int32_t  rotation_delta_deg;// Rotationsdifferenz zur Referenz [°]
+  int32_t  left_offset_px;    // Versatz linke Ecke [px]
+  int32_t  right_offset_px;   // Versatz rechte Ecke [px]
+};
+
+static const uint32_t MEASUREMENT_SIZE = 52;  // serialisierte Größe
+
+// Lage eines JPEG-Ausschnitts (REC_JPEG_CROP) im vollen Sensorbild; die
+// JPEG-Daten folgen direkt auf diese 8 Byte
+struct CropInfo {
+  uint16_t x0, y0;            // linke obere Ecke des Ausschnitts [px]
+  uint16_t full_w, full_h;    // Größe des Quellbildes [px]
+};
+
+static const uint32_t CROP_INFO_SIZE = 8;
+
+// Änderung der JPEG-Qualität durch die Ratenregelung (RateControl); gilt ab
+// Frame seq
+struct QualityRecord {
+  uint32_t seq;               // erster Frame mit neuer Qualität
+  uint32_t t_ms;              // millis() der Änderung
+  uint8_t  quality;           // neue Sensorqualität (0..63, kleiner = besser)
+  uint8_t  prev_quality;      // bisherige Qualität
+  uint32_t avg_bytes;         // gleitendes Mittel der JPEG-Größe
+  uint32_t target_bytes;      // Ziel der Regelung
+  uint32_t link_bytes_per_s;  // gemessener Durchsatz (0 = noch unbekannt)
+};
+
+static const uint32_t QUALITY_SIZE = 24;  // serialisierte Größe
+
+// Blitz eines Frames im Strobe-Betrieb (Strobe); Zeiten in µs relativ zum
+// VSYNC des Frames. Gemeinsames Belichtungsfenster aller Zeilen:
+// [readout_us - exposure_us, 0]
+struct StrobeRecord {
+  uint32_t seq;               // Frame, zu dem der Blitz gehört
+  uint32_t t_ms;              // millis() bei Aufnahme
+  int32_t  on_us, off_us;     // Licht an / aus
+  uint32_t exposure_us;       // eingestellte Belichtungszeit
+  uint32_t readout_us;        // Auslesedauer aller Zeilen
+  uint32_t period_us;         // gemessener Frameabstand
+  int32_t  vsync_error_us;    // tatsächlicher - vorhergesagter VSYNC
+  uint8_t  mode;              // strobe::LightMode
+  uint8_t  aligned;           // 1 = Blitz vollständig im Fenster
+};
+
+static const uint32_t STROBE_SIZE = 36;  // serialisierte Größe
+
+// Zustand des Vorlauf-Ringpuffers (FrameRing), periodisch gesendet
+struct RingStatsRecord {
+  uint32_t seq;               // nächster Frame
+  uint32_t t_ms;              // millis()
+  uint32_t capacity_bytes;    // Arena
+  uint32_t used_bytes;        // belegt
+  uint32_t high_water_bytes;  // höchste Belegung
+  uint8_t  frames;            // Frames im Ring
+  uint8_t  max_frames;        // höchstens
+  uint32_t pushed;            // gespeicherte Frames
+  uint32_t overwritten;       // verdrängt, ohne ausgewählt zu werden
+  uint32_t oversize;          // zu groß, verworfen
+  uint32_t sensor_gaps;       // ausgelassene Sensorframes
+  uint32_t hits;              // Anfragen mit Frame
+  uint32_t misses;            // Anfragen ohne Frame
+  uint32_t period_us;         // geschätzter Frameabstand
+  int32_t  last_error_us;     // gewählter - angefragter Zeitpunkt
+};
+
+static const uint32_t RING_STATS_SIZE = 56;  // serialisierte Größe
+
+// Auslastung der Task-Pipeline (Aufnahme -> Analyse -> Senden) über ein
+// Meldeintervall; Zeiten summiert je Stufe
+static const uint8_t PIPELINE_STAGES = 3;
+
+struct PipelineStageInfo {
+  uint32_t frames;            // bearbeitete Frames
+  uint32_t busy_us;           // Arbeit
+  uint32_t stall_us;          // Ausgabe blockiert (nächste Stufe voll)
+};
+
+struct PipelineQueueInfo {
+  uint8_t  capacity;          // Plätze
+  uint8_t  depth;             // belegt beim Melden
+  uint8_t  high_water;        // höchste Belegung
+  uint32_t full;              // abgewiesene Einträge (Ring voll)
+};
+
+struct PipelineRecord {
+  uint32_t seq;               // nächster Frame
+  uint32_t t_ms;              // millis()
+  uint32_t interval_us;       // Länge des Meldeintervalls
+  PipelineStageInfo stage[PIPELINE_STAGES];  // Aufnahme, Analyse, Senden
+  PipelineQueueInfo queue[PIPELINE_STAGES];  // frei, zur Analyse, zum Senden
+};
+
+static const uint32_t PIPELINE_SIZE = 72;  // serialisierte Größe
+
+// Belegung der Bildspeicher-Pools (FramePool), periodisch gesendet
+static const uint8_t POOL_COUNT = 2;
+
+struct PoolInfo {
+  uint32_t capacity_bytes;    // Arena
+  uint32_t used_bytes;        // belegte Blöcke
+  uint32_t high_water_bytes;  // höchste Belegung
+  uint32_t largest_free_bytes; // größter freier Bereich am Stück
+  uint32_t allocs;            // erfolgreiche Anforderungen
+  uint32_t failures;          // abgelehnte Anforderungen
+  uint16_t planes;            // lebende Ebenen
+  uint8_t  fragmentation_pct; // 100 - größter freier / frei gesamt
+};
+
+struct PoolStatsRecord {
+  uint32_t seq;               // nächster Frame
+  uint32_t t_ms;              // millis()
+  PoolInfo pool[POOL_COUNT];  // intern, PSRAM
+};
+
+static const uint32_t POOL_STATS_SIZE = 64;  // serialisierte Größe
+
+// Zeitmarken eines Kerns (Trace), abgeholt zwischen den Frames: Kopf, danach
+// count Marken. Zeiten in µs (untere 32 Bit der Geräteuhr)
+struct TraceHeader {
+  uint32_t seq;               // laufender Frame beim Abholen
+  uint8_t  core;              // Kern, auf dem die Marken entstanden
+  uint8_t  count;             // folgende Marken
+  uint32_t dropped;           // seit dem letzten Datensatz verworfen (Ring voll)
+};
+
+struct TraceEvent {
+  uint32_t t_us;              // Zeitpunkt
+  uint16_t arg;               // meist Frame-Nummer (untere 16 Bit)
+  uint8_t  id;                // trace::EventId
+  uint8_t  phase;             // 'B' Beginn, 'E' Ende, 'i' Zeitpunkt
+};
+
+static const uint32_t TRACE_HEADER_SIZE = 12;  // serialisierte Größe
+static const uint32_t TRACE_EVENT_SIZE = 8;    // je Marke
+static const uint32_t TRACE_MAX_EVENTS = 128;  // je Datensatz
+
+// Laufende Telemetrie über ein Meldeintervall: Histogramme der Latenzen und
+// JPEG-Größen (logarithmische Fächer, 4 je Oktave, nur belegte übertragen)
+// plus seit dem Start aufsummierte Zähler (Empfänger bildet Differenzen)
+enum TelemetryMetric : uint8_t {
+  TM_TRIGGER_TO_EXPOSURE = 0,  // Trigger -> Belichtungsmitte [µs]
+  TM_EXPOSURE_TO_FB,           // Belichtungsmitte -> Puffer beim Programm [µs]
+  TM_FB_TO_FIRST_BYTE,         // Puffer -> erstes Byte auf der Leitung [µs]
+  TM_TRANSMIT,                 // erstes Byte -> Daten draußen [µs]
+  TM_FRAME_BYTES,              // JPEG-Größe [Byte]
+  TM_I2C_WAIT,                 // längstes Warten der Kamera auf den I2C-Bus je Frame [µs]
+  TELEMETRY_METRICS
+};
+
+static const uint8_t TELEMETRY_BUCKETS = 124;  // 4 je Oktave über 32 bit
+
+struct TelemetryHistogram {
+  uint32_t max;                          // größter Wert
+  uint8_t  used;                         // belegte Fächer
+  uint8_t  index[TELEMETRY_BUCKETS];     // Fachnummer
+  uint16_t count[TELEMETRY_BUCKETS];     // Werte darin (sättigt)
+};
+
+struct TelemetryRecord {
+  uint32_t seq;               // nächster Frame
+  uint32_t t_ms;              // millis()
+  uint32_t interval_ms;       // Länge des Meldeintervalls
+  uint8_t  camera;            // Kamera-Nummer (mehrere Geräte)
+  uint8_t  depth_max;         // Frames in Arbeit, höchstens
+  uint8_t  depth_mean_x16;    // Frames in Arbeit, Mittel × 16
+  uint32_t frames;            // gesendete Frames (seit Start)
+  uint32_t capture_failures;  // Aufnahme ohne Frame (seit Start)
+  uint32_t empty_frames;      // leere Frames (seit Start)
+  uint32_t ring_misses;       // Vorlauf-Ring ohne passenden Frame (seit Start)
+  uint32_t queue_full;        // abgewiesene Einträge der Pipeline (seit Start)
+  uint32_t bytes_sent;        // gesendete Bytes inkl. Köpfe (seit Start)
+  TelemetryHistogram hist[TELEMETRY_METRICS];
+};
+
+static const uint32_t TELEMETRY_HEADER_SIZE = 40;  // vor den Histogrammen
+static const uint32_t TELEMETRY_MAX_SIZE =
+    TELEMETRY_HEADER_SIZE + TELEMETRY_METRICS * (5 + 3 * TELEMETRY_BUCKETS);
+
+const char *telemetryMetricName(TelemetryMetric m);
+
+// Bildserie auf der SD-Karte (SdBurst), periodisch gesendet; Zähler seit Start
+struct SdStatsRecord {
+  uint32_t seq;               // nächster Frame
+  uint32_t t_ms;              // millis()
+  uint32_t files;             // geschriebene Bilder
+  uint32_t failures;          // abgelehnte/fehlgeschlagene Bilder
+  uint32_t kbytes;            // geschriebene Nutzdaten [KiB]
+  uint32_t busy_ms;           // Summe der Schreibdauern
+  uint32_t last_write_us;     // letztes Bild
+  uint32_t max_write_us;      // längstes Bild
+  uint32_t max_prealloc_us;   // längstes Anlegen einer Ersatzdatei
+  uint32_t next_index;        // Nummer des nächsten Bildes
+  uint8_t  spare;             // bereitliegende Ersatzdateien
+  uint8_t  sck_mhz;           // SPI-Takt nach dem Einmessen
+  uint8_t  last_error;        // sdburst::Result des letzten Fehlers
+};
+
+static const uint32_t SD_STATS_SIZE = 44;  // serialisierte Größe
+
+// Vor jedem aus dem SD-Journal nachgeholten Frame; dahinter folgen len Byte
+// mit den ursprünglichen Datensätzen (Kopf + Nutzdaten, wie live gesendet).
+// Zähler seit Start
+struct ReplayRecord {
+  uint32_t seq;               // Frame-Nummer bei der Aufnahme
+  uint32_t t_ms;              // millis() beim Zwischenlagern
+  uint32_t len;               // folgende Bytes dieses Frames
+  uint32_t backlog_kbytes;    // danach noch im Journal [KiB]
+  uint32_t spilled;           // ins Journal geschriebene Frames
+  uint32_t drained;           // nachgeholte Frames (ohne diesen)
+  uint32_t dropped;           // nicht ins Journal passende Frames
+  uint32_t corrupt;           // beim Lesen verworfene Einträge
+};
+
+static const uint32_t REPLAY_SIZE = 32;  // serialisierte Größe
+
+// Wechsel des Sensorprofils (SensorProfile): nur abweichende Felder geschrieben
+enum ProfileFlags : uint8_t {
+  PROFILE_RESIZED = 1,  // Format/Auflösung geändert
+  PROFILE_STORED  = 2,  // Profil aus dem Flash geladen (gelernte Werte)
+};
+
+struct ProfileRecord {
+  uint32_t seq;               // nächster Frame
+  uint32_t t_ms;              // millis()
+  uint32_t switch_us;         // Dauer des Wechsels
+  uint8_t  profile;           // Nummer des Profils (Firmware)
+  uint8_t  writes;            // aufgerufene Setter
+  uint8_t  failed;            // davon fehlgeschlagen
+  uint8_t  flags;             // ProfileFlags
+};
+
+static const uint32_t PROFILE_SIZE = 16;  // serialisierte Größe
+
+// Einmal je Start: Zeitpunkte seit dem Reset (esp_timer_get_time, µs)
+enum BootFlags : uint8_t {
+  BOOT_FAST            = 1,  // nur benötigte Teile, Kamera direkt in Arbeitsauflösung
+  BOOT_DEFERRED_FAILED = 2,  // zurückgestellte Teile nicht hochgekommen
+};
+
+struct BootRecord {
+  uint32_t seq;               // erster gültiger Frame
+  uint32_t setup_us;          // Eintritt in setup()
+  uint32_t camera_us;         // Kamera läuft
+  uint32_t ready_us;          // Ende von setup()
+  uint32_t first_frame_us;    // erster gültiger Frame beim Programm
+  uint32_t deferred_us;       // zurückgestellte Teile fertig (0 = noch nicht/keine)
+  uint8_t  reset_reason;      // esp_reset_reason()
+  uint8_t  flags;             // BootFlags
+  uint8_t  parts;             // beim Start initialisiert (PyCameraPart)
+  uint8_t  deferred;          // zurückgestellt (PyCameraPart)
+};
+
+static const uint32_t BOOT_SIZE = 28;  // serialisierte Größe
+
+// Erschütterung des Kamerahalters bei der Aufnahme (LIS3DH-FIFO, Vibration);
+// geht vor den übrigen Datensätzen des Frames
+enum VibrationFlags : uint8_t {
+  VIB_SPIKE   = 1,  // RMS über der Grenze, trotzdem aufgenommen
+  VIB_DELAYED = 2,  // Aufnahme wegen Erschütterung verschoben
+  VIB_STALE   = 4,  // keine frischen Samples (Sensor fehlt oder Task hängt)
+  VIB_OVERRUN = 8,  // FIFO seit dem letzten Frame übergelaufen, Samples fehlen
+};
+
+struct VibrationRecord {
+  uint32_t seq;               // Frame
+  uint32_t t_ms;              // millis() bei Aufnahme
+  uint16_t rms_mg;            // Effektivwert ohne Schwerkraft über das Fenster [mg]
+  uint16_t peak_mg;           // größter Betrag im Fenster [mg]
+  uint16_t limit_mg;          // Grenze für VIB_SPIKE
+  uint16_t delay_ms;          // Aufnahme so lange verschoben
+  uint16_t age_ms;            // Alter der Werte bei der Aufnahme
+  uint8_t  window;            // Samples im Fenster
+  uint8_t  flags;             // VibrationFlags
+};
+
+static const uint32_t VIBRATION_SIZE = 20;  // serialisierte Größe
+
+// Kopf schreiben/lesen; decodeHeader liefert false bei unbekanntem Typ
+void encodeHeader(uint8_t out[HEADER_SIZE], RecordType type, uint32_t len);
+bool decodeHeader(const uint8_t in[HEADER_SIZE], RecordType *type,
+                  uint32_t *len);
+
+// Nächsten Datensatz in einem aufgezeichneten Strom ab *pos suchen
+// (Host-Werkzeuge). Ein Kopf zählt nur, wenn dahinter das Ende oder wieder ein
+// gültiger Kopf steht; so fallen Textausgaben zwischen den Datensätzen heraus.
+// Danach zeigt *pos hinter den Datensatz, *payload auf seine Nutzdaten.
+bool nextRecord(const uint8_t *data, size_t size, size_t *pos,
+                RecordType *type, uint32_t *len, const uint8_t **payload);
+
+// Feste little-endian-Serialisierung (unabhängig von Padding/Endianness)
+size_t encodeMeasurement(uint8_t out[MEASUREMENT_SIZE],
+                         const MeasurementRecord &rec);
+bool decodeMeasurement(const uint8_t *in, size_t len, MeasurementRecord *rec);
+
+size_t encodeQuality(uint8_t out[QUALITY_SIZE], const QualityRecord &rec);
+bool decodeQuality(const uint8_t *in, size_t len, QualityRecord *rec);
+
+size_t encodeStrobe(uint8_t out[STROBE_SIZE], const StrobeRecord &rec);
+bool decodeStrobe(const uint8_t *in, size_t len, StrobeRecord *rec);
+
+size_t encodeRingStats(uint8_t out[RING_STATS_SIZE], const RingStatsRecord &rec);
+bool decodeRingStats(const uint8_t *in, size_t len, RingStatsRecord *rec);
+
+size_t encodePipeline(uint8_t out[PIPELINE_SIZE], const PipelineRecord &rec);
+bool decodePipeline(const uint8_t *in, size_t len, PipelineRecord *rec);
+
+size_t encodePoolStats(uint8_t out[POOL_STATS_SIZE], const PoolStatsRecord &rec);
+bool decodePoolStats(const uint8_t *in, size_t len, PoolStatsRecord *rec);
+
+size_t encodeTraceHeader(uint8_t out[TRACE_HEADER_SIZE], const TraceHeader &hdr);
+bool decodeTraceHeader(const uint8_t *in, size_t len, TraceHeader *hdr);
+size_t encodeTraceEvent(uint8_t out[TRACE_EVENT_SIZE], const TraceEvent &ev);
+bool decodeTraceEvent(const uint8_t *in, size_t len, TraceEvent *ev);
+
+size_t encodeSdStats(uint8_t out[SD_STATS_SIZE], const SdStatsRecord &rec);
+bool decodeSdStats(const uint8_t *in, size_t len, SdStatsRecord *rec);
+
+size_t encodeReplay(uint8_t out[REPLAY_SIZE], const ReplayRecord &rec);
+bool decodeReplay(const uint8_t *in, size_t len, ReplayRecord *rec);
+
+size_t encodeProfile(uint8_t out[PROFILE_SIZE], const ProfileRecord &rec);
+bool decodeProfile(const uint8_t *in, size_t len, ProfileRecord *rec);
+
+size_t encodeBoot(uint8_t out[BOOT_SIZE], const BootRecord &rec);
+bool decodeBoot(const uint8_t *in, size_t len, BootRecord *rec);
+
+size_t encodeVibration(uint8_t out[VIBRATION_SIZE], const VibrationRecord &rec);
+bool decodeVibration(const uint8_t *in, size_t len, VibrationRecord *rec);
+
+// Variable Länge (belegte Fächer); 0 = out zu klein
+size_t encodeTelemetry(uint8_t *out, size_t cap, const TelemetryRecord &rec);
+bool decodeTelemetry(const uint8_t *in, size_t len, TelemetryRecord *rec);
+
+size_t encodeCropInfo(uint8_t out[CROP_INFO_SIZE], const CropInfo &info);
+bool decodeCropInfo(const uint8_t *in, size_t len, CropInfo *info);
+
+} // namespace camlink
@@ -0,0 +1,156 @@
+#include "Compositor.h"
+
+#include <string.h>
+
+namespace compositor {
+
+// Schnittfläche einer Ebene mit [x0, x1) × [y0, y1), false wenn leer
+struct Clip {
+  int16_t x0, y0, x1, y1;
+};
+
+static bool clip(int16_t lx, int16_t ly, uint16_t lw, uint16_t lh, int16_t x0, int16_t y0,
+                 int16_t x1, int16_t y1, Clip *c) {
+  c->x0 = lx > x0 ? lx : x0;
+  c->y0 = ly > y0 ? ly : y0;
+  c->x1 = lx + lw < x1 ? lx + lw : x1;
+  c->y1 = ly + lh < y1 ? ly + lh : y1;
+  return c->x0 < c->x1 && c->y0 < c->y1;
+}
+
+static inline uint8_t luma(uint16_t c) {
+  return ((c >> 10) & 0x3E) + ((c >> 5) & 0x3F) + ((c << 1) & 0x3E);
+}
+
+static inline uint32_t fnv(uint32_t h, uint32_t v) { return (h ^ v) * 16777619u; }
+
+int8_t Compositor::addLayer(const uint16_t *pixels, int16_t x, int16_t y, uint16_t w,
+                            uint16_t h, uint16_t key) {
+  if (_layer_count >= MAX_LAYERS || !pixels)
+    return -1;
+  _layers[_layer_count] = {pixels, x, y, w, h, key, true};
+  return (int8_t)_layer_count++;
+}
+
+void Compositor::moveLayer(uint8_t layer, int16_t x, int16_t y) {
+  if (layer >= _layer_count)
+    return;
+  _layers[layer].x = x;
+  _layers[layer].y = y;
+}
+
+void Compositor::showLayer(uint8_t layer, bool visible) {
+  if (layer < _layer_count)
+    _layers[layer].visible = visible;
+}
+
+uint32_t Compositor::cameraSig(const uint16_t *camera, uint16_t tx, uint16_t ty) const {
+  // Je Viertel 4×4 Stichproben, Mittelwert passt in ein Byte
+  uint32_t sig = 0;
+  for (uint8_t q = 0; q < 4; q++) {
+    const uint16_t x0 = tx * TILE + (q & 1) * (TILE / 2);
+    const uint16_t y0 = ty * TILE + (q >> 1) * (TILE / 2);
+    uint16_t sum = 0;
+    for (uint16_t y = y0; y < y0 + TILE / 2; y += 2) {
+      const uint16_t *row = camera + (uint32_t)y * SCREEN;
+      for (uint16_t x = x0; x < x0 + TILE / 2; x += 2)
+        sum += luma(row[x]);
+    }
+    sig |= (uint32_t)(sum / 16) << (8 * q);
+  }
+  return sig;
+}
+
+bool Compositor::cameraChanged(uint32_t now, uint32_t sent) const {
+  for (uint8_t q = 0; q < 4; q++) {
+    const int16_t d = (int16_t)((now >> (8 * q)) & 0xFF) - (int16_t)((sent >> (8 * q)) & 0xFF);
+    if (d > _threshold || d < -_threshold)
+      return true;
+  }
+  return false;
+}
+
+uint32_t Compositor::overlaySig(uint16_t tx, uint16_t ty) const {
+  const int16_t x0 = tx * TILE, y0 = ty * TILE;
+  uint32_t h = 2166136261u;
+  bool any = false;
+  for (uint8_t i = 0; i < _layer_count; i++) {
+    const Layer &l = _layers[i];
+    Clip c;
+    if (!l.visible || !clip(l.x, l.y, l.w, l.h, x0, y0, x0 + TILE, y0 + TILE, &c))
+      continue;
+    any = true;
+    h = fnv(h, i);
+    // Lage der Ebene in der Kachel: Verschieben ändert den Hash
+    h = fnv(h, (uint32_t)(uint16_t)(l.x - x0) << 16 | (uint16_t)(l.y - y0));
+    for (int16_t y = c.y0; y < c.y1; y++) {
+      const uint16_t *row = l.pixels + (uint32_t)(y - l.y) * l.w + (c.x0 - l.x);
+      for (int16_t x = c.x0; x < c.x1; x++)
+        h = fnv(h, *row++);
+    }
+  }
+  if (!any)
+    return 0;
+  return h ? h : 1;
+}
+
+uint16_t Compositor::update(const uint16_t *camera) {
+  uint16_t n = 0;
+  _cam_tiles = _ovl_tiles = 0;
+  for (uint16_t t = 0; t < TILE_COUNT; t++) {
+    const uint16_t tx = t % TILES, ty = t / TILES;
+    const uint32_t cs = cameraSig(camera, tx, ty), os = overlaySig(tx, ty);
+    const bool cam = _full || cameraChanged(cs, _cam_sig[t]);
+    const bool ovl = _full || os != _ovl_sig[t];
+    _cam_tiles += cam;
+    _ovl_tiles += ovl;
+    if (cam || ovl) {
+      // Die Kachel geht ganz raus: beide Stände gelten als gesendet
+      _cam_sig[t] = cs;
+      _ovl_sig[t] = os;
+      _dirty[t >> 3] |= 1 << (t & 7);
+      n++;
+    } else {
+      _dirty[t >> 3] &= ~(1 << (t & 7));
+    }
+  }
+  _full = false;
+  _next = 0;
+  return n;
+}
+
+bool Compositor::nextSpan(Span *span) {
+  while (_next < TILE_COUNT && !dirty(_next))
+    _next++;
+  if (_next >= TILE_COUNT)
+    return false;
+  const uint16_t ty = _next / TILES, tx0 = _next % TILES;
+  uint16_t tx = tx0;
+  while (tx < TILES && dirty(ty * TILES + tx))
+    tx++;
+  _next = ty * TILES + tx;
+  *span = {(uint16_t)(tx0 * TILE), (uint16_t)(ty * TILE), (uint16_t)((tx - tx0) * TILE), TILE};
+  return true;
+}
+
+void Compositor::compose(const uint16_t *camera, const Span &span, uint16_t *out) const {
+  for (uint16_t y = 0; y < span.h; y++)
+    memcpy(out + (uint32_t)y * span.w, camera + (uint32_t)(span.y + y) * SCREEN + span.x,
+           span.w * sizeof(uint16_t));
+  for (uint8_t i = 0; i < _layer_count; i++) {
+    const Layer &l = _layers[i];
+    Clip c;
+    if (!l.visible || !clip(l.x, l.y, l.w, l.h, span.x, span.y, span.x + span.w,
+                            span.y + span.h, &c))
+      continue;
+    for (int16_t y = c.y0; y < c.y1; y++) {
+      const uint16_t *src = l.pixels + (uint32_t)(y - l.y) * l.w + (c.x0 - l.x);
+      uint16_t *dst = out + (uint32_t)(y - span.y) * span.w + (c.x0 - span.x);
+      for (int16_t x = c.x0; x < c.x1; x++, src++, dst++)
+        if (*src != l.key)
+          *dst = *src;
+    }
+  }
+}
+
+} // namespace compositor
@@ -0,0 +1,87 @@
+#pragma once
+// Compositor: Display-Vorschau kachelweise statt ganzer Bilder senden.
+//
+// Das 240×240-Bild zerfällt in 15×15 Kacheln zu 16×16 Pixeln. Je Kachel merkt
+// sich der Compositor getrennt nach Ebenen, was zuletzt gesendet wurde: für
+// das Kamerabild die mittlere Helligkeit der vier Kachelviertel (aus jedem
+// zweiten Pixel jeder zweiten Zeile), für die Overlays einen Hash über deren
+// Pixel und Lage in der Kachel. update() vergleicht ein neues Kamerabild
+// damit: eine Kamerakachel gilt als geändert, wenn ein Viertel um mehr als die
+// Schwelle abweicht (Rauschen auf ruhigem Band bleibt darunter), eine
+// Overlay-Kachel bei jeder Änderung, auch durch Verschieben oder Ausblenden.
+// nextSpan() fasst die geänderten Kacheln einer Kachelzeile zu Streifen
+// zusammen, compose() mischt dafür Kamerabild und Overlays (Schlüsselfarbe =
+// durchsichtig) in einen Puffer, den der Aufrufer in ein Adressfenster sendet.
+// Overlays werden so nie ins Kamerabild gezeichnet.
+//
+// Langsame Änderungen unter der Schwelle sammeln sich gegen den zuletzt
+// gesendeten Stand, bis die Kachel doch gesendet wird.
+//
+// Keine Arduino-Abhängigkeit; die Ebenen zeichnet der Aufrufer (GFXcanvas16).
+
+#include <stdint.h>
+
+namespace compositor {
+
+static const uint16_t SCREEN = 240;  // Pixel je Seite
+static const uint16_t TILE = 16;
+static const uint16_t TILES = SCREEN / TILE;  // Kacheln je Zeile und Spalte
+static const uint16_t TILE_COUNT = TILES * TILES;
+static const uint8_t MAX_LAYERS = 4;
+
+// Streifen nebeneinanderliegender geänderter Kacheln [Pixel]
+struct Span {
+  uint16_t x, y, w, h;
+};
+
+class Compositor {
+public:
+  // Overlay w×h an (x, y), Pixel zeilenweise; Pixel mit key sind durchsichtig.
+  // Rückgabe: Ebene (über den Vorgängern), -1 wenn alle belegt
+  int8_t addLayer(const uint16_t *pixels, int16_t x, int16_t y, uint16_t w, uint16_t h,
+                  uint16_t key);
+  void moveLayer(uint8_t layer, int16_t x, int16_t y);
+  void showLayer(uint8_t layer, bool visible);
+  // Abweichung eines Kachelviertels, ab der die Kamerakachel gesendet wird
+  // (Helligkeit 0..187 aus 2×R5 + G6 + 2×B5)
+  void setThreshold(uint8_t threshold) { _threshold = threshold; }
+  // Nächstes update() sendet alles (erstes Bild, direkt aufs Display gezeichnet)
+  void invalidate() { _full = true; }
+
+  // Neues Kamerabild (SCREEN×SCREEN): geänderte Kacheln bestimmen und als
+  // gesendet vermerken. Rückgabe: Zahl der Kacheln
+  uint16_t update(const uint16_t *camera);
+  // Streifen aus dem letzten update() der Reihe nach, false am Ende
+  bool nextSpan(Span *span);
+  // Kamerabild und Overlays im Streifen nach out (span.w × span.h)
+  void compose(const uint16_t *camera, const Span &span, uint16_t *out) const;
+
+  // Kacheln des letzten update() wegen Kamerabild bzw. Overlays (beides möglich)
+  uint16_t cameraTiles() const { return _cam_tiles; }
+  uint16_t overlayTiles() const { return _ovl_tiles; }
+
+private:
+  struct Layer {
+    const uint16_t *pixels;
+    int16_t x, y;
+    uint16_t w, h, key;
+    bool visible;
+  };
+
+  uint32_t cameraSig(const uint16_t *camera, uint16_t tx, uint16_t ty) const;
+  uint32_t overlaySig(uint16_t tx, uint16_t ty) const;
+  bool cameraChanged(uint32_t now, uint32_t sent) const;
+  bool dirty(uint16_t t) const { return _dirty[t >> 3] & (1 << (t & 7)); }
+
+  Layer _layers[MAX_LAYERS] = {};
+  uint8_t _layer_count = 0;
+  uint8_t _threshold = 2;
+  bool _full = true;
+  uint32_t _cam_sig[TILE_COUNT] = {};  // zuletzt gesendet
+  uint32_t _ovl_sig[TILE_COUNT] = {};  // 0 = kein Overlay
+  uint8_t _dirty[(TILE_COUNT + 7) / 8] = {};
+  uint16_t _next = 0;  // nextSpan(): nächste Kachel
+  uint16_t _cam_tiles = 0, _ovl_tiles = 0;
+};
+
+} // namespace compositor
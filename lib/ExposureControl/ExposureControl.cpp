@@ -0,0 +1,100 @@
+#include "ExposureControl.h"
+
+namespace expoctl {
+
+// Ab hier gilt das Perzentil als übersteuert (echte Helligkeit unbekannt)
+static const uint8_t SATURATED = 250;
+
+void ExposureController::begin(const ExposureConfig &cfg, uint16_t aec,
+                               uint8_t gain) {
+  _cfg = cfg;
+  if (_cfg.aec_min < 1)
+    _cfg.aec_min = 1;
+  _cap = _cfg.aec_max;
+  _aec = aec < _cfg.aec_min ? _cfg.aec_min : (aec > _cap ? _cap : aec);
+  _gain = gain < _cfg.gain_min ? _cfg.gain_min
+                               : (gain > _cfg.gain_max ? _cfg.gain_max : gain);
+  _level = 0;
+  _settle = 0;
+}
+
+void ExposureController::applyCap() {
+  // Zu lange belichtet: kürzen, je Halbierung eine Gain-Stufe mehr
+  while (_aec > _cap) {
+    if (_gain < _cfg.gain_max && _aec / 2 >= _cfg.aec_min) {
+      _gain++;
+      _aec /= 2;
+    } else {
+      _aec = _cap;
+    }
+  }
+}
+
+void ExposureController::setExposureCap(uint16_t aec_cap) {
+  if (aec_cap < _cfg.aec_min)
+    aec_cap = _cfg.aec_min;
+  _cap = aec_cap < _cfg.aec_max ? aec_cap : _cfg.aec_max;
+  applyCap();
+}
+
+bool ExposureController::update(const uint32_t hist[256], bool label) {
+  uint32_t total = 0;
+  for (uint16_t i = 0; i < 256; i++)
+    total += hist[i];
+  if (!total)
+    return false;
+  const uint64_t want = (uint64_t)total * _cfg.percentile / 100;
+  uint32_t sum = 0;
+  uint16_t v = 0;
+  for (; v < 255; v++) {
+    sum += hist[v];
+    if (sum > want)
+      break;
+  }
+  _level = (uint8_t)v;
+
+  if (_settle) {
+    _settle--;
+    return false;
+  }
+  // Leeres Band richtig belichtet: kein Maßstab für das Label
+  if (!label && _level >= _cfg.dark_level)
+    return false;
+
+  // Verhältnis Soll/Ist (Q8), übersteuert -> halbieren
+  const uint32_t lvl = _level ? _level : 1;
+  uint32_t r = _level >= SATURATED ? 128 : ((uint32_t)_cfg.target_level << 8) / lvl;
+  const uint32_t db = 256u * _cfg.deadband_pct / 100;
+  if (r + db >= 256 && r <= 256 + db)
+    return false;
+  r = (r * r) >> 8;  // Gamma ≈ 2: Helligkeit ~ sqrt(Belichtung)
+  r = r < 128 ? 128 : (r > 512 ? 512 : r);
+
+  const uint16_t oldAec = _aec;
+  const uint8_t oldGain = _gain;
+  uint32_t aec = ((uint32_t)_aec * r + 128) >> 8;
+  if (aec == _aec)
+    aec = r > 256 ? _aec + 1 : _aec - 1;
+
+  if (r > 256) {
+    // Heller: erst Belichtung bis zur Grenze, dann Gain
+    if (aec > _cap && _gain < _cfg.gain_max) {
+      _gain++;
+      aec /= 2;
+    }
+  } else if (_gain > _cfg.gain_min && aec * 2 <= _cap) {
+    // Dunkler: Gain zurücknehmen, solange die Belichtung das ausgleichen kann
+    _gain--;
+    aec *= 2;
+  }
+  if (aec < _cfg.aec_min)
+    aec = _cfg.aec_min;
+  _aec = (uint16_t)(aec > _cap ? _cap : aec);
+
+  if (_aec == oldAec && _gain == oldGain)
+    return false;
+  _settle = _cfg.settle_frames;
+  return true;
+}
+
+} // namespace expoctl
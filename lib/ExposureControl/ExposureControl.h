@@ -0,0 +1,60 @@
+#pragma once
+// ExposureControl: manuelle Belichtung (AEC-Wert + Gain-Stufe) aus einem
+// Luma-Histogramm nachführen.
+//
+// Das Histogramm fällt ohnehin an (DC-Vorschau des PresenceDetector), es
+// gibt also keine zusätzliche Dekodierung. Geregelt wird ein hohes Perzentil
+// (das weiße Label) auf einen Sollwert. Die Belichtungszeit darf die
+// Bewegungsunschärfe-Grenze (aus Bandgeschwindigkeit und px/mm, setExposureCap)
+// nie überschreiten; reicht sie nicht, wird die Gain-Stufe erhöht. Sinkt der
+// Lichtbedarf, wird zuerst Gain zurückgenommen.
+//
+// Korrektur je Frame multiplikativ (Gamma ≈ 2), begrenzt auf ×0,5 .. ×2;
+// nach einer Änderung ruht die Regelung, bis der Sensor sie übernommen hat.
+// Keine Arduino-Abhängigkeit; set_aec_value/Gain setzt der Aufrufer.
+
+#include <stdint.h>
+
+namespace expoctl {
+
+struct ExposureConfig {
+  uint8_t  target_level;   // Sollwert des Perzentils (0..255)
+  uint8_t  percentile;     // geregeltes Perzentil [%], z. B. 98
+  uint8_t  deadband_pct;   // Abweichung bis hierhin -> keine Änderung
+  uint8_t  dark_level;     // Frames ohne Label nur regeln, wenn Perzentil darunter
+  uint16_t aec_min;        // Registerbereich set_aec_value
+  uint16_t aec_max;
+  uint8_t  gain_min;       // Gain-Stufen, jede Stufe verdoppelt (z. B. gainceiling_t)
+  uint8_t  gain_max;
+  uint8_t  settle_frames;  // Frames Ruhe nach einer Änderung
+};
+
+class ExposureController {
+public:
+  void begin(const ExposureConfig &cfg, uint16_t aec, uint8_t gain);
+
+  // Obergrenze des AEC-Werts aus der Bewegungsunschärfe; ein kleinerer Wert
+  // als der aktuelle wird sofort übernommen (Ausgleich über Gain)
+  void setExposureCap(uint16_t aec_cap);
+
+  // Ein Frame: Histogramm der Luma-Vorschau, label = Label im Bild.
+  // true = aec()/gain() geändert
+  bool update(const uint32_t hist[256], bool label);
+
+  uint16_t aec() const { return _aec; }
+  uint8_t gain() const { return _gain; }
+  uint16_t exposureCap() const { return _cap; }
+  uint8_t level() const { return _level; }  // zuletzt gemessenes Perzentil
+
+private:
+  void applyCap();
+
+  ExposureConfig _cfg = {};
+  uint16_t _aec = 0;
+  uint16_t _cap = 0;
+  uint8_t _gain = 0;
+  uint8_t _level = 0;
+  uint8_t _settle = 0;
+};
+
+} // namespace expoctl
@@ -0,0 +1,179 @@
+#include "FramePool.h"
+
+namespace framepool {
+
+bool FramePool::begin(uint8_t *arena, size_t bytes, uint32_t block_bytes) {
+  if (!arena || block_bytes < 4 || (block_bytes & 3))
+    return false;
+  size_t blocks = bytes / block_bytes;
+  if (blocks > MAX_BLOCKS)
+    blocks = MAX_BLOCKS;
+  if (!blocks)
+    return false;
+  _arena = arena;
+  _block = block_bytes;
+  _nBlocks = (uint16_t)blocks;
+  for (uint16_t i = 0; i < MAX_BLOCKS; i++)
+    _owner[i] = 0;
+  for (uint8_t i = 0; i < MAX_PLANES; i++) {
+    _p[i].gen = 0;
+    _p[i].refs.store(0, std::memory_order_relaxed);
+  }
+  _used = _high = 0;
+  _planes = 0;
+  _allocs = _failures = 0;
+  return true;
+}
+
+void FramePool::setLock(void (*lock)(void *), void (*unlock)(void *),
+                        void *ctx) {
+  _lock = lock;
+  _unlock = unlock;
+  _lockCtx = ctx;
+}
+
+void FramePool::lock() const {
+  if (_lock)
+    _lock(_lockCtx);
+}
+
+void FramePool::unlock() const {
+  if (_unlock)
+    _unlock(_lockCtx);
+}
+
+void FramePool::markBlocks(uint16_t first, uint16_t count, uint8_t owner) {
+  for (uint16_t i = 0; i < count; i++)
+    _owner[first + i] = owner;
+}
+
+uint8_t FramePool::allocSlot(PlaneType type, uint32_t bytes, uint16_t w,
+                             uint16_t h) {
+  if (!_arena || !bytes) {
+    _failures++;
+    return NO_SLOT;
+  }
+  const uint32_t need = (bytes + _block - 1) / _block;
+  lock();
+  uint8_t slot = NO_SLOT;
+  for (uint8_t i = 0; i < MAX_PLANES; i++)
+    if (!_p[i].gen) {
+      slot = i;
+      break;
+    }
+  // Erster freier Bereich mit need Blöcken
+  uint16_t first = 0, run = 0;
+  bool found = false;
+  if (slot != NO_SLOT && need <= _nBlocks) {
+    for (uint16_t b = 0; b < _nBlocks; b++) {
+      if (_owner[b]) {
+        run = 0;
+        continue;
+      }
+      if (!run)
+        first = b;
+      if (++run == need) {
+        found = true;
+        break;
+      }
+    }
+  }
+  if (!found) {
+    _failures++;
+    unlock();
+    return NO_SLOT;
+  }
+
+  Plane &p = _p[slot];
+  p.block = first;
+  p.blocks = (uint16_t)need;
+  p.bytes = bytes;
+  p.width = w;
+  p.height = h;
+  p.type = type;
+  p.gen = _nextGen++;
+  if (!_nextGen)
+    _nextGen = 1;
+  p.refs.store(1, std::memory_order_relaxed);
+  markBlocks(first, (uint16_t)need, slot + 1);
+  _used += need * _block;
+  if (_used > _high)
+    _high = _used;
+  _planes++;
+  _allocs++;
+  unlock();
+  return slot;
+}
+
+const FramePool::Plane *FramePool::lookup(uint8_t slot, uint16_t gen,
+                                          PlaneType type) const {
+  if (slot >= MAX_PLANES || !gen)
+    return nullptr;
+  const Plane &p = _p[slot];
+  return p.gen == gen && p.type == type ? &p : nullptr;
+}
+
+bool FramePool::retainSlot(uint8_t slot, uint16_t gen, PlaneType type) {
+  Plane *p = (Plane *)lookup(slot, gen, type);
+  if (!p)
+    return false;
+  p->refs.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void FramePool::releaseSlot(uint8_t slot, uint16_t gen, PlaneType type) {
+  Plane *p = (Plane *)lookup(slot, gen, type);
+  if (!p || p->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+    return;
+  lock();
+  markBlocks(p->block, p->blocks, 0);
+  _used -= p->blocks * _block;
+  _planes--;
+  p->gen = 0;
+  unlock();
+}
+
+bool FramePool::trimSlot(uint8_t slot, uint16_t gen, PlaneType type,
+                         uint32_t bytes) {
+  Plane *p = (Plane *)lookup(slot, gen, type);
+  if (!p || !bytes || bytes > p->bytes)
+    return false;
+  const uint16_t keep = (uint16_t)((bytes + _block - 1) / _block);
+  lock();
+  markBlocks(p->block + keep, p->blocks - keep, 0);
+  _used -= (uint32_t)(p->blocks - keep) * _block;
+  p->blocks = keep;
+  p->bytes = bytes;
+  unlock();
+  return true;
+}
+
+PoolStats FramePool::stats() const {
+  PoolStats s = {};
+  lock();
+  s.capacity_bytes = (uint32_t)_nBlocks * _block;
+  s.used_bytes = _used;
+  s.high_water_bytes = _high;
+  uint16_t run = 0, best = 0;
+  for (uint16_t b = 0; b < _nBlocks; b++) {
+    run = _owner[b] ? 0 : run + 1;
+    if (run > best)
+      best = run;
+  }
+  s.largest_free_bytes = (uint32_t)best * _block;
+  s.planes = _planes;
+  s.allocs = _allocs;
+  s.failures = _failures;
+  unlock();
+  return s;
+}
+
+uint8_t FramePool::fragmentationPct() const {
+  const PoolStats s = stats();
+  const uint32_t free_bytes = s.capacity_bytes - s.used_bytes;
+  if (!free_bytes)
+    return 0;
+  return (uint8_t)(100 - (uint64_t)s.largest_free_bytes * 100 / free_bytes);
+}
+
+} // namespace framepool
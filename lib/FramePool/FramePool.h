@@ -0,0 +1,135 @@
+#pragma once
+// FramePool: Arena für Bildebenen mit typisierten Handles und Referenzzählern.
+//
+// Eine Arena (interner RAM oder PSRAM, Speicher vom Aufrufer) ist in Blöcke
+// gleicher Größe geteilt; eine Ebene belegt zusammenhängende Blöcke (erster
+// passender Bereich). Statt Zeigern gehen Handles mit Generationszähler
+// zwischen den Stufen hin und her: ein veraltetes Handle liefert nullptr statt
+// fremder Daten. retain()/release() zählen die Besitzer, die letzte Freigabe
+// gibt die Blöcke zurück; so wandert ein Ausschnitt ohne Kopie von der
+// Analyse zum Senden. trim() gibt nach dem Füllen ungenutzte Endblöcke frei.
+//
+// Statistik: Belegung, Höchststand, größter freier Bereich (Fragmentierung),
+// lebende Ebenen, Fehlschläge.
+//
+// Keine Arduino-Abhängigkeit. Aus mehreren Tasks nur mit setLock() benutzen.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+namespace framepool {
+
+enum PlaneType : uint8_t {
+  PLANE_BYTES = 0,  // JPEG, Ausschnitt, sonstige Bytes
+  PLANE_GRAY8,      // 8 bit je Pixel (Luma, Vorschau)
+  PLANE_RGB565,     // 16 bit je Pixel (Display)
+};
+
+template <PlaneType T> struct PlaneTraits { typedef uint8_t pixel; };
+template <> struct PlaneTraits<PLANE_RGB565> { typedef uint16_t pixel; };
+
+// Handle einer Ebene vom Typ T; gen 0 = ungültig
+template <PlaneType T> struct Handle {
+  uint8_t slot;
+  uint16_t gen;
+  bool valid() const { return gen != 0; }
+};
+
+typedef Handle<PLANE_BYTES> BytesHandle;
+typedef Handle<PLANE_GRAY8> GrayHandle;
+typedef Handle<PLANE_RGB565> Rgb565Handle;
+
+struct PoolStats {
+  uint32_t capacity_bytes;
+  uint32_t used_bytes;          // belegte Blöcke
+  uint32_t high_water_bytes;    // höchste Belegung seit begin()
+  uint32_t largest_free_bytes;  // größter zusammenhängender freier Bereich
+  uint16_t planes;              // lebende Ebenen
+  uint32_t allocs;              // erfolgreiche Anforderungen
+  uint32_t failures;            // abgelehnte Anforderungen (kein Platz/Slot)
+};
+
+class FramePool {
+public:
+  static const uint8_t MAX_PLANES = 32;
+  static const uint16_t MAX_BLOCKS = 1024;
+
+  // block_bytes: Granularität (Vielfaches von 4); bytes wird abgerundet
+  bool begin(uint8_t *arena, size_t bytes, uint32_t block_bytes);
+
+  // Sperre für alloc/release/trim, wenn mehrere Tasks den Pool benutzen
+  void setLock(void (*lock)(void *), void (*unlock)(void *), void *ctx);
+
+  template <PlaneType T>
+  Handle<T> alloc(uint32_t bytes, uint16_t width = 0, uint16_t height = 0) {
+    const uint8_t s = allocSlot(T, bytes, width, height);
+    return s == NO_SLOT ? Handle<T>{0, 0} : Handle<T>{s, _p[s].gen};
+  }
+
+  template <PlaneType T> typename PlaneTraits<T>::pixel *data(Handle<T> h) const {
+    const Plane *p = lookup(h.slot, h.gen, T);
+    return p ? (typename PlaneTraits<T>::pixel *)(_arena + p->block * _block)
+             : nullptr;
+  }
+
+  template <PlaneType T> uint32_t size(Handle<T> h) const {
+    const Plane *p = lookup(h.slot, h.gen, T);
+    return p ? p->bytes : 0;
+  }
+
+  template <PlaneType T> bool retain(Handle<T> h) {
+    return retainSlot(h.slot, h.gen, T);
+  }
+
+  // Letzte Freigabe gibt die Blöcke zurück; h danach nicht mehr benutzen
+  template <PlaneType T> void release(Handle<T> h) {
+    releaseSlot(h.slot, h.gen, T);
+  }
+
+  // Ebene auf bytes kürzen (nur kleiner); freie Endblöcke zurück in den Pool
+  template <PlaneType T> bool trim(Handle<T> h, uint32_t bytes) {
+    return trimSlot(h.slot, h.gen, T, bytes);
+  }
+
+  PoolStats stats() const;
+  uint8_t fragmentationPct() const;  // 100 - größter freier / frei gesamt
+
+private:
+  static const uint8_t NO_SLOT = 0xFF;
+
+  struct Plane {
+    uint16_t block, blocks;  // erster Block, Anzahl
+    uint32_t bytes;
+    uint16_t width, height;
+    uint16_t gen;            // 0 = Slot frei
+    PlaneType type;
+    std::atomic<uint8_t> refs;
+  };
+
+  uint8_t allocSlot(PlaneType type, uint32_t bytes, uint16_t w, uint16_t h);
+  const Plane *lookup(uint8_t slot, uint16_t gen, PlaneType type) const;
+  bool retainSlot(uint8_t slot, uint16_t gen, PlaneType type);
+  void releaseSlot(uint8_t slot, uint16_t gen, PlaneType type);
+  bool trimSlot(uint8_t slot, uint16_t gen, PlaneType type, uint32_t bytes);
+  void markBlocks(uint16_t first, uint16_t count, uint8_t owner);
+  void lock() const;
+  void unlock() const;
+
+  uint8_t *_arena = nullptr;
+  uint32_t _block = 0;
+  uint16_t _nBlocks = 0;
+  uint8_t _owner[MAX_BLOCKS] = {};  // Slot + 1 je Block, 0 = frei
+  Plane _p[MAX_PLANES] = {};
+  uint16_t _nextGen = 1;
+  uint32_t _used = 0, _high = 0;
+  uint16_t _planes = 0;
+  uint32_t _allocs = 0, _failures = 0;
+
+  void (*_lock)(void *) = nullptr;
+  void (*_unlock)(void *) = nullptr;
+  void *_lockCtx = nullptr;
+};
+
+} // namespace framepool
@@ -0,0 +1,130 @@
+#include "FrameRing.h"
+
+#include <string.h>
+
+namespace framering {
+
+// Frames beginnen auf 4-Byte-Grenzen (schneller kopieren/lesen)
+static inline uint32_t align4(uint32_t v) { return (v + 3) & ~3u; }
+
+bool FrameRing::begin(uint8_t *arena, size_t bytes, uint8_t max_frames) {
+  if (!arena || !bytes || !max_frames)
+    return false;
+  _arena = arena;
+  _cap = bytes > 0xFFFFFFFFu ? 0xFFFFFFFFu : (uint32_t)bytes;
+  _max = max_frames > MAX_FRAMES ? MAX_FRAMES : max_frames;
+  _head = _count = 0;
+  _next = 0;
+  _period = 0;
+  _stats = {};
+  _stats.capacity_bytes = _cap;
+  _stats.max_frames = _max;
+  return true;
+}
+
+int64_t FrameRing::oldestUs() const { return _count ? at(0).t_us : 0; }
+
+int64_t FrameRing::newestUs() const {
+  return _count ? at(_count - 1).t_us : 0;
+}
+
+bool FrameRing::overlapsLive(uint32_t offset, uint32_t len) const {
+  for (uint8_t i = 0; i < _count; i++) {
+    const Entry &e = at(i);
+    if (offset < e.offset + e.len && e.offset < offset + len)
+      return true;
+  }
+  return false;
+}
+
+void FrameRing::evictOldest() {
+  const Entry &e = _e[_head];
+  if (!e.selected)
+    _stats.overwritten++;
+  _stats.used_bytes -= e.len;
+  _head = (_head + 1) % _max;
+  _count--;
+}
+
+bool FrameRing::push(const uint8_t *jpg, size_t len, int64_t t_us) {
+  if (!_arena || !len || len > _cap) {
+    _stats.oversize++;
+    return false;
+  }
+  // Frameabstand schätzen; deutlich längere Abstände = ausgelassene Frames
+  if (_count) {
+    const int64_t d = t_us - newestUs();
+    if (d > 0) {
+      if (_period && d > (int64_t)_period * 3 / 2) {
+        _stats.sensor_gaps += (uint32_t)((d + _period / 2) / _period) - 1;
+      } else {
+        const uint32_t du = (uint32_t)d;
+        _period = _period ? _period - (_period >> 3) + (du >> 3) : du;
+      }
+    }
+  }
+
+  uint32_t pos = _count ? _next : 0;
+  if (pos + len > _cap)
+    pos = 0;  // Rest am Ende bleibt frei
+  while (_count && (_count == _max || overlapsLive(pos, (uint32_t)len)))
+    evictOldest();
+
+  memcpy(_arena + pos, jpg, len);
+  Entry &e = _e[(_head + _count) % _max];
+  e.offset = pos;
+  e.len = (uint32_t)len;
+  e.t_us = t_us;
+  e.index = _stats.pushed++;
+  e.selected = false;
+  _count++;
+  _next = align4(pos + (uint32_t)len);
+
+  _stats.frames = _count;
+  _stats.used_bytes += e.len;
+  if (_stats.used_bytes > _stats.high_water_bytes)
+    _stats.high_water_bytes = _stats.used_bytes;
+  return true;
+}
+
+bool FrameRing::ready(int64_t t_us, uint8_t neighbours) const {
+  if (!_count)
+    return false;
+  // Erst wenn ein Frame mehr als eine halbe Periode nach t_us (bzw. dem
+  // letzten Nachbarn) liegt, kann kein späterer näher kommen
+  return newestUs() >= t_us + (int64_t)_period * neighbours +
+                           (int64_t)_period / 2;
+}
+
+uint8_t FrameRing::select(int64_t t_us, uint8_t neighbours, FrameRef *out,
+                          uint8_t max_out, uint8_t *nearest) {
+  if (!_count || !max_out || t_us < oldestUs() - (int64_t)_period / 2) {
+    _stats.misses++;
+    return 0;
+  }
+  uint8_t best = 0;
+  int64_t best_d = 0;
+  for (uint8_t i = 0; i < _count; i++) {
+    const int64_t d = at(i).t_us - t_us;
+    if (i == 0 || (d < 0 ? -d : d) < (best_d < 0 ? -best_d : best_d)) {
+      best = i;
+      best_d = d;
+    }
+  }
+  _stats.hits++;
+  _stats.last_error_us = (int32_t)best_d;
+
+  const uint8_t first = best > neighbours ? best - neighbours : 0;
+  uint8_t n = 0;
+  for (uint8_t i = first; i < _count && i <= best + neighbours && n < max_out;
+       i++, n++) {
+    Entry &e = _e[(_head + i) % _max];
+    e.selected = true;
+    out[n] = {_arena + e.offset, e.len, e.t_us, e.index};
+    if (i == best && nearest)
+      *nearest = n;
+  }
+  return n;
+}
+
+} // namespace framering
@@ -0,0 +1,91 @@
+#pragma once
+// FrameRing: Vorlauf-Ringpuffer für JPEG-Frames mit Zeitstempel.
+//
+// Die Kamera läuft durch, jeder Frame wird mit seinem Belichtungszeitpunkt
+// in eine Arena (PSRAM) kopiert; der älteste Frame wird überschrieben, wenn
+// Platz oder Einträge fehlen. Eine Aufnahme-Anfrage wählt dann den Frame,
+// dessen Belichtung dem berechneten Ankunftszeitpunkt des Labels am nächsten
+// liegt (optional mit Nachbarn). Damit hängt die Genauigkeit nicht mehr an
+// der Latenz von esp_camera_fb_get, und mehrere Labels gleichzeitig auf dem
+// Band werden aus demselben Strom bedient.
+//
+// Die Frames liegen unterschiedlich lang hintereinander in der Arena; am
+// Ende wird nach vorne umgebrochen (der Rest bleibt ungenutzt).
+//
+// Keine Arduino-Abhängigkeit; Zeiten in µs einer beliebigen, monotonen Uhr.
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace framering {
+
+// Frame im Ring; data bleibt bis zum nächsten push() gültig
+struct FrameRef {
+  const uint8_t *data;
+  uint32_t len;
+  int64_t  t_us;   // Belichtungszeitpunkt
+  uint32_t index;  // fortlaufende Nummer im Ring (push-Zähler)
+};
+
+struct RingStats {
+  uint32_t capacity_bytes;
+  uint32_t used_bytes;        // belegt durch gespeicherte Frames
+  uint32_t high_water_bytes;  // höchste Belegung seit begin()
+  uint8_t  frames, max_frames;
+  uint32_t pushed;            // gespeicherte Frames
+  uint32_t overwritten;       // verdrängt, ohne je ausgewählt zu werden
+  uint32_t oversize;          // größer als die Arena, verworfen
+  uint32_t sensor_gaps;       // ausgelassene Sensorframes (Lücken > 1,5 Perioden)
+  uint32_t hits;              // Anfragen mit Frame
+  uint32_t misses;            // Anfragen ohne Frame (zu alt / Ring leer)
+  int32_t  last_error_us;     // gewählter - angefragter Zeitpunkt (letzte Anfrage)
+};
+
+class FrameRing {
+public:
+  static const uint8_t MAX_FRAMES = 32;
+
+  bool begin(uint8_t *arena, size_t bytes, uint8_t max_frames = MAX_FRAMES);
+
+  // Frame kopieren; false, wenn er größer als die Arena ist
+  bool push(const uint8_t *jpg, size_t len, int64_t t_us);
+
+  // Liegt für t_us samt neighbours Nachfolgern schon alles im Ring? (sonst
+  // könnte ein späterer Frame näher liegen)
+  bool ready(int64_t t_us, uint8_t neighbours = 0) const;
+
+  // Nächsten Frame zu t_us und bis zu neighbours Frames je Seite nach out
+  // (zeitlich sortiert); Rückgabe = Anzahl, *nearest = Position des nächsten
+  // Frames in out. 0 = Frame schon überschrieben oder Ring leer.
+  uint8_t select(int64_t t_us, uint8_t neighbours, FrameRef *out,
+                 uint8_t max_out, uint8_t *nearest = nullptr);
+
+  uint8_t frames() const { return _count; }
+  int64_t oldestUs() const;
+  int64_t newestUs() const;
+  uint32_t periodUs() const { return _period; }  // geschätzter Frameabstand
+  const RingStats &stats() const { return _stats; }
+
+private:
+  struct Entry {
+    uint32_t offset, len;
+    int64_t t_us;
+    uint32_t index;
+    bool selected;
+  };
+
+  const Entry &at(uint8_t i) const { return _e[(_head + i) % _max]; }
+  bool overlapsLive(uint32_t offset, uint32_t len) const;
+  void evictOldest();
+
+  uint8_t *_arena = nullptr;
+  uint32_t _cap = 0;
+  uint8_t _max = 0;
+  Entry _e[MAX_FRAMES] = {};
+  uint8_t _head = 0, _count = 0;  // ältester Eintrag, Anzahl
+  uint32_t _next = 0;             // Schreibposition (Ende des neuesten Frames)
+  uint32_t _period = 0;           // gleitendes Mittel (1/8) der Frameabstände
+  RingStats _stats = {};
+};
+
+} // namespace framering
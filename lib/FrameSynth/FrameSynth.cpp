@@ -0,0 +1,716 @@
+#include "FrameSynth.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace framesynth {
+
+const Config FrameSynth::DEFAULT_CONFIG = {
+    1280, 1024,       // SXGA wie FRAMESIZE_SXGA
+    15,               // JPEG_QUALITY
+    2.0,              // noise
+    {215, 128, 128},  // Label: weiß
+    {59, 174, 104},   // Band: RGB ~(25, 60, 140)
+};
+
+const char *resultName(Result r) {
+  switch (r) {
+  case OK: return "OK";
+  case BAD_PARAM: return "BAD_PARAM";
+  case BAD_JPEG: return "BAD_JPEG";
+  case UNSUPPORTED: return "UNSUPPORTED";
+  case OUT_OF_SPACE: return "OUT_OF_SPACE";
+  }
+  return "?";
+}
+
+// Zickzack-Position -> natürliche Reihenfolge
+static const uint8_t ZIGZAG[64] = {
+    0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6,  7,  14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63};
+
+// Quantisierung und Huffman-Tabellen nach JPEG Annex K
+static const uint8_t BASE_QT[2][64] = {
+    {16, 11, 10, 16, 24,  40,  51,  61,  12, 12, 14, 19, 26,  58,  60,  55,
+     14, 13, 16, 24, 40,  57,  69,  56,  14, 17, 22, 29, 51,  87,  80,  62,
+     18, 22, 37, 56, 68,  109, 103, 77,  24, 35, 55, 64, 81,  104, 113, 92,
+     49, 64, 78, 87, 103, 121, 120, 101, 72, 92, 95, 98, 112, 100, 103, 99},
+    {17, 18, 24, 47, 99, 99, 99, 99, 18, 21, 26, 66, 99, 99, 99, 99,
+     24, 26, 56, 99, 99, 99, 99, 99, 47, 66, 99, 99, 99, 99, 99, 99,
+     99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+     99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99}};
+
+static const uint8_t DC_BITS[2][16] = {
+    {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0},
+    {0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0}};
+static const uint8_t DC_VALS[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+
+static const uint8_t AC_BITS[2][16] = {
+    {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d},
+    {0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77}};
+static const uint8_t AC_VALS[2][162] = {
+    {0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06,
+     0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08,
+     0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0, 0x24, 0x33, 0x62, 0x72,
+     0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+     0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45,
+     0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+     0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75,
+     0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+     0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3,
+     0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6,
+     0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9,
+     0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+     0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4,
+     0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa},
+    {0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41,
+     0x51, 0x07, 0x61, 0x71, 0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91,
+     0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0, 0x15, 0x62, 0x72, 0xd1,
+     0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+     0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44,
+     0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58,
+     0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74,
+     0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+     0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a,
+     0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4,
+     0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7,
+     0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+     0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+     0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa}};
+
+// Skalierung der AAN-DCT: 1, sqrt(2) * cos(kπ/16)
+static const float AAN_SCALE[8] = {1.0f,         1.387039845f, 1.306562965f,
+                                   1.175875602f, 1.0f,         0.785694958f,
+                                   0.541196100f, 0.275899379f};
+
+static inline uint16_t getU16BE(const uint8_t *p) {
+  return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+// Anzahl signifikanter Bits von |v| (JPEG-Kategorie SSSS)
+static inline uint8_t category(int32_t v) {
+  uint32_t a = (uint32_t)(v < 0 ? -v : v);
+  uint8_t n = 0;
+  while (a) {
+    n++;
+    a >>= 1;
+  }
+  return n;
+}
+
+static inline float clampPixel(float v) {
+  return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+// Vorwärts-DCT nach Arai/Agui/Nakajima (wie jfdctflt.c der IJG), an Ort und
+// Stelle; Ergebnis um 8 * AAN_SCALE[v] * AAN_SCALE[u] zu groß
+static void fdct(float *d) {
+  for (uint8_t pass = 0; pass < 2; pass++) {
+    const uint8_t step = pass ? 8 : 1, next = pass ? 1 : 8;
+    for (uint8_t k = 0; k < 8; k++) {
+      float *p = d + k * next;
+      const float t0 = p[0] + p[7 * step], t7 = p[0] - p[7 * step];
+      const float t1 = p[step] + p[6 * step], t6 = p[step] - p[6 * step];
+      const float t2 = p[2 * step] + p[5 * step], t5 = p[2 * step] - p[5 * step];
+      const float t3 = p[3 * step] + p[4 * step], t4 = p[3 * step] - p[4 * step];
+
+      float t10 = t0 + t3, t13 = t0 - t3, t11 = t1 + t2, t12 = t1 - t2;
+      p[0] = t10 + t11;
+      p[4 * step] = t10 - t11;
+      const float z1 = (t12 + t13) * 0.707106781f;
+      p[2 * step] = t13 + z1;
+      p[6 * step] = t13 - z1;
+
+      t10 = t4 + t5;
+      t11 = t5 + t6;
+      t12 = t6 + t7;
+      const float z5 = (t10 - t12) * 0.382683433f;
+      const float z2 = 0.541196100f * t10 + z5;
+      const float z4 = 1.306562965f * t12 + z5;
+      const float z3 = t11 * 0.707106781f;
+      const float z11 = t7 + z3, z13 = t7 - z3;
+      p[5 * step] = z13 + z2;
+      p[3 * step] = z13 - z2;
+      p[step] = z11 + z4;
+      p[7 * step] = z11 - z4;
+    }
+  }
+}
+
+Result FrameSynth::begin(const Config &cfg) {
+  if (!cfg.width || !cfg.height || cfg.noise < 0)
+    return BAD_PARAM;
+  _cfg = cfg;
+  _hs = _vs = 2;
+  _tq[0] = 0;
+  _tq[1] = _tq[2] = 1;
+
+  for (uint8_t i = 0; i < 2; i++) {
+    buildHuffman(&_dc[i], DC_BITS[i], DC_VALS);
+    buildHuffman(&_ac[i], AC_BITS[i], AC_VALS[i]);
+  }
+  // Φ auf [-5, 5]
+  for (uint16_t i = 0; i <= PHI_STEPS; i++) {
+    const double t = -5.0 + 10.0 * i / PHI_STEPS;
+    _phi[i] = (float)(0.5 * erfc(-t / sqrt(2.0)));
+  }
+  // Normalverteilte Werte (Box-Muller, fester Startwert), auf ±4 begrenzt
+  _rng = 0x9E3779B9u;
+  for (uint16_t i = 0; i < GAUSS_STEPS; i += 2) {
+    const double u1 = (rand32() + 1.0) / 4294967297.0;
+    const double u2 = rand32() / 4294967296.0;
+    const double r = sqrt(-2.0 * log(u1));
+    const double g[2] = {r * cos(2 * M_PI * u2), r * sin(2 * M_PI * u2)};
+    for (uint8_t j = 0; j < 2; j++)
+      _gauss[i + j] = (float)(g[j] < -4 ? -4 : (g[j] > 4 ? 4 : g[j]));
+  }
+  buildQuant(cfg.quality);
+  buildPools();
+  return OK;
+}
+
+// Näherung für OV-Sensoren: Annex-K-Tabellen, linear mit der Qualität
+// skaliert (16 entspricht den unskalierten Tabellen)
+void FrameSynth::buildQuant(uint8_t quality) {
+  const uint32_t q = quality ? quality : 1;
+  for (uint8_t t = 0; t < 2; t++)
+    for (uint8_t i = 0; i < 64; i++) {
+      const uint32_t v = (BASE_QT[t][i] * q + 8) / 16;
+      _qt[t][i] = (uint16_t)(v < 1 ? 1 : (v > 255 ? 255 : v));
+    }
+}
+
+Result FrameSynth::useTablesFrom(const uint8_t *jpg, size_t len) {
+  if (len < 4 || jpg[0] != 0xFF || jpg[1] != 0xD8)
+    return BAD_JPEG;
+  uint16_t qt[2][64];
+  memcpy(qt, _qt, sizeof(qt));
+  bool has_qt[2] = {};
+  uint8_t hs = 0, vs = 0, tq[3] = {};
+  size_t pos = 2;
+  while (pos + 4 <= len) {
+    if (jpg[pos] != 0xFF)
+      return BAD_JPEG;
+    const uint8_t m = jpg[pos + 1];
+    if (m == 0xFF) {  // Füllbyte
+      pos++;
+      continue;
+    }
+    const size_t seg = 2 + (size_t)getU16BE(jpg + pos + 2);
+    if (pos + seg > len)
+      return BAD_JPEG;
+    const uint8_t *p = jpg + pos + 4;
+    const uint8_t *end = jpg + pos + seg;
+    switch (m) {
+    case 0xDB:  // DQT
+      while (p < end) {
+        const uint8_t pq = p[0] >> 4, id = p[0] & 0x0F;
+        if (pq || id > 1)
+          return UNSUPPORTED;
+        if (end - p < 65)
+          return BAD_JPEG;
+        for (uint8_t i = 0; i < 64; i++)
+          qt[id][ZIGZAG[i]] = p[1 + i] ? p[1 + i] : 1;
+        has_qt[id] = true;
+        p += 65;
+      }
+      break;
+    case 0xC0:  // SOF0
+      if (seg < 2 + 15 || p[0] != 8 || p[5] != 3)
+        return UNSUPPORTED;
+      for (uint8_t c = 0; c < 3; c++) {
+        const uint8_t h = p[7 + 3 * c] >> 4, v = p[7 + 3 * c] & 0x0F;
+        tq[c] = p[8 + 3 * c];
+        if (tq[c] > 1 || (c == 0 && (h < 1 || h > 2 || v < 1 || v > 2)) ||
+            (c && (h != 1 || v != 1)))
+          return UNSUPPORTED;
+        if (c == 0) {
+          hs = h;
+          vs = v;
+        }
+      }
+      break;
+    case 0xC1: case 0xC2: case 0xC3: case 0xC5: case 0xC6: case 0xC7:
+    case 0xC9: case 0xCA: case 0xCB: case 0xCD: case 0xCE: case 0xCF:
+      return UNSUPPORTED;  // progressiv, arithmetisch, verlustfrei ...
+    case 0xDA:  // SOS: Ende des Kopfes
+      if (!hs)
+        return BAD_JPEG;
+      for (uint8_t c = 0; c < 3; c++)
+        if (!has_qt[tq[c]])
+          return BAD_JPEG;
+      memcpy(_qt, qt, sizeof(_qt));
+      memcpy(_tq, tq, sizeof(_tq));
+      _hs = hs;
+      _vs = vs;
+      buildPools();
+      return OK;
+    default:
+      break;
+    }
+    pos += seg;
+  }
+  return BAD_JPEG;
+}
+
+// Kanonische Kodes wie in JPEG Annex C aus BITS/HUFFVAL erzeugen
+void FrameSynth::buildHuffman(HuffEnc *t, const uint8_t *bits,
+                              const uint8_t *vals) {
+  memset(t->size, 0, sizeof(t->size));
+  uint32_t code = 0;
+  size_t k = 0;
+  for (uint8_t l = 1; l <= 16; l++, code <<= 1) {
+    for (uint8_t i = 0; i < bits[l - 1]; i++, k++, code++) {
+      t->code[vals[k]] = (uint16_t)code;
+      t->size[vals[k]] = l;
+    }
+  }
+}
+
+// Divisoren der AAN-DCT und Vorrat an Rauschblöcken je Komponente; beides
+// hängt an den Quantisierungstabellen. Rauschen (gerundet wie ein Pixel)
+// transformieren, AC quantisieren und kodieren. Der DC-Anteil bleibt
+// unquantisiert, weil er erst mit dem Grundwert der MCU zusammenkommt.
+void FrameSynth::buildPools() {
+  for (uint8_t t = 0; t < 2; t++)
+    for (uint8_t i = 0; i < 64; i++)
+      _fdiv[t][i] = 1.0f / (_qt[t][i] * AAN_SCALE[i / 8] * AAN_SCALE[i % 8] * 8);
+
+  uint32_t next = 0;
+  _rng = 0x2545F491u;
+  for (uint8_t cmp = 0; cmp < 3; cmp++) {
+    const float sigma = (float)(cmp ? _cfg.noise / 2 : _cfg.noise);
+    const float *div = _fdiv[_tq[cmp]];
+    for (uint16_t b = 0; b < POOL_BLOCKS; b++) {
+      float coef[64];
+      for (uint8_t i = 0; i < 64; i++)
+        coef[i] = roundf(sigma * gauss());
+      fdct(coef);
+      int16_t q[64];
+      for (uint8_t i = 0; i < 64; i++)
+        q[i] = (int16_t)lrintf(coef[i] * div[i]);
+      NoiseBlock &nb = _pool[cmp][b];
+      nb.dc = coef[0] / 8;
+      nb.first = (uint16_t)next;
+      nb.count = acSymbols(cmp, q, _poolBits + next, _poolLen + next);
+      next += nb.count;
+    }
+  }
+}
+
+size_t FrameSynth::maxJpegSize() const {
+  const size_t mcus = (size_t)((_cfg.width + mcuWidth() - 1) / mcuWidth()) *
+                      ((_cfg.height + mcuHeight() - 1) / mcuHeight());
+  // je Block höchstens 64 Symbole zu 27 Bit, jedes Byte ggf. gestopft
+  return mcus * (_hs * _vs + 2) * 2 * (64 * 27 / 8 + 1) + 1024 + 65536;
+}
+
+uint32_t FrameSynth::rand32() {
+  _rng ^= _rng << 13;
+  _rng ^= _rng >> 17;
+  _rng ^= _rng << 5;
+  return _rng;
+}
+
+float FrameSynth::gauss() { return _gauss[rand32() >> 20]; }
+
+double FrameSynth::phi(double t) const {
+  if (t <= -5)
+    return 0;
+  if (t >= 5)
+    return 1;
+  const double f = (t + 5) * (PHI_STEPS / 10.0);
+  const int i = (int)f;
+  return _phi[i] + (f - i) * (_phi[i + 1] - _phi[i]);
+}
+
+// Fläche w × h ab Pixel (x0, y0): 0 = Kante/Glanzpunkt (Pixel rechnen),
+// 1 = nur Band, 2 = nur Label
+uint8_t FrameSynth::areaClass(uint32_t x0, uint32_t y0, uint8_t w,
+                              uint8_t h) const {
+  const double x = x0 + (w - 1) / 2.0, y = y0 + (h - 1) / 2.0;
+  const double r = sqrt((w - 1) * (w - 1) + (h - 1) * (h - 1)) / 2;
+  if (_glareReach > 0) {
+    const double gx = x - _scene.glare_x, gy = y - _scene.glare_y;
+    if (sqrt(gx * gx + gy * gy) < r + _glareReach)
+      return 0;
+  }
+  const double dx = x - _scene.cx, dy = y - _scene.cy;
+  const double u = fabs(dx * _cos + dy * _sin);
+  const double v = fabs(-dx * _sin + dy * _cos);
+  // Φ(-4) * 255 < 0,01 Graustufen
+  const double m = r + 4 * _sigma;
+  if (u >= _scene.w / 2 + m || v >= _scene.h / 2 + m)
+    return 1;
+  if (u <= _scene.w / 2 - m && v <= _scene.h / 2 - m)
+    return 2;
+  return 0;
+}
+
+// MCU an der Kante: nur Y-Blöcke, die selbst die Kante berühren, Pixel für
+// Pixel; die übrigen sind einfarbig und füllen nur die Chroma-Mittelung
+void FrameSynth::renderMcu(uint16_t mx, uint16_t my) {
+  const uint8_t mw = mcuWidth(), mh = mcuHeight();
+  const uint8_t *lab = _cfg.label_ycc, *belt = _cfg.belt_ycc;
+  const double r2 = 2 * _scene.glare_r * _scene.glare_r;
+  const double hw = _scene.w / 2, hh = _scene.h / 2, k = 1 / _sigma;
+  uint8_t cls[4];
+  for (uint8_t by = 0; by < _vs; by++)
+    for (uint8_t bx = 0; bx < _hs; bx++) {
+      const uint32_t x0 = mx * mw + bx * 8, y0 = my * mh + by * 8;
+      uint8_t &c = cls[by * _hs + bx];
+      c = areaClass(x0, y0, 8, 8);
+      if (c) {
+        const uint8_t *ycc = c == 2 ? lab : belt;
+        for (uint8_t j = 0; j < 8; j++)
+          for (uint8_t i = 0; i < 8; i++) {
+            const uint16_t n = (by * 8 + j) * mw + bx * 8 + i;
+            _y[n] = ycc[0];
+            _cb[n] = ycc[1];
+            _cr[n] = ycc[2];
+          }
+        continue;
+      }
+      for (uint8_t j = 0; j < 8; j++) {
+        const double y = y0 + j;
+        const double dx = x0 - _scene.cx, dy = y - _scene.cy;
+        // Labelkoordinaten wachsen je Pixel linear
+        double u = dx * _cos + dy * _sin, v = -dx * _sin + dy * _cos;
+        for (uint8_t i = 0; i < 8; i++, u += _cos, v -= _sin) {
+          const double a = phi((hw - fabs(u)) * k) * phi((hh - fabs(v)) * k);
+          double Y = belt[0] + a * (lab[0] - belt[0]);
+          double cb = belt[1] + a * (lab[1] - belt[1]);
+          double cr = belt[2] + a * (lab[2] - belt[2]);
+          if (_glareReach > 0) {
+            // Glanz: heller und entsättigt
+            const double gx = x0 + i - _scene.glare_x, gy = y - _scene.glare_y;
+            const double g = _scene.glare * exp(-(gx * gx + gy * gy) / r2);
+            const double keep = g >= 255 ? 0 : 1 - g / 255;
+            Y += g;
+            cb = 128 + (cb - 128) * keep;
+            cr = 128 + (cr - 128) * keep;
+          }
+          const uint16_t n = (by * 8 + j) * mw + bx * 8 + i;
+          _y[n] = (float)Y;
+          _cb[n] = (float)cb;
+          _cr[n] = (float)cr;
+        }
+      }
+    }
+
+  const float sigma_y = (float)_cfg.noise, sigma_c = sigma_y / 2;
+  float px[64];
+  for (uint8_t by = 0; by < _vs; by++)
+    for (uint8_t bx = 0; bx < _hs; bx++) {
+      const uint8_t c = cls[by * _hs + bx];
+      if (c) {
+        encodeFlat(0, (c == 2 ? lab : belt)[0]);
+        continue;
+      }
+      for (uint8_t j = 0; j < 8; j++)
+        for (uint8_t i = 0; i < 8; i++)
+          px[j * 8 + i] = clampPixel(
+              roundf(_y[(by * 8 + j) * mw + bx * 8 + i] + sigma_y * gauss()));
+      encodeBlock(0, px);
+    }
+  // Chroma: Mittel über _hs × _vs Pixel
+  const float *planes[2] = {_cb, _cr};
+  for (uint8_t c = 0; c < 2; c++) {
+    for (uint8_t j = 0; j < 8; j++)
+      for (uint8_t i = 0; i < 8; i++) {
+        float s = 0;
+        for (uint8_t dy = 0; dy < _vs; dy++)
+          for (uint8_t dx = 0; dx < _hs; dx++)
+            s += planes[c][(j * _vs + dy) * mw + i * _hs + dx];
+        px[j * 8 + i] =
+            clampPixel(roundf(s / (_hs * _vs) + sigma_c * gauss()));
+      }
+    encodeBlock(1 + c, px);
+  }
+}
+
+// Einfarbiger Block: DC aus Grundwert + Rauschblock, AC fertig aus dem Vorrat
+void FrameSynth::encodeFlat(uint8_t cmp, uint8_t value) {
+  const float sigma = (float)(cmp ? _cfg.noise / 2 : _cfg.noise);
+  if (value < 4 * sigma || value + 4 * sigma > 255) {
+    // Rauschen würde abgeschnitten: Pixel rechnen
+    float px[64];
+    for (uint8_t i = 0; i < 64; i++)
+      px[i] = clampPixel(roundf(value + sigma * gauss()));
+    encodeBlock(cmp, px);
+    return;
+  }
+  const uint16_t q0 = _qt[_tq[cmp]][0];
+  const NoiseBlock &nb = _pool[cmp][rand32() >> 24];
+  encodeDc(cmp, (int16_t)lrintf((8.0f * (value - 128) + nb.dc) / q0));
+  for (uint8_t i = 0; i < nb.count; i++)
+    putBits(_poolBits[nb.first + i], _poolLen[nb.first + i]);
+}
+
+void FrameSynth::encodeBlock(uint8_t cmp, const float *px) {
+  float coef[64];
+  for (uint8_t i = 0; i < 64; i++)
+    coef[i] = px[i] - 128;
+  fdct(coef);
+  const float *div = _fdiv[_tq[cmp]];
+  int16_t q[64];
+  for (uint8_t i = 0; i < 64; i++)
+    q[i] = (int16_t)lrintf(coef[i] * div[i]);
+  encodeDc(cmp, q[0]);
+  uint32_t bits[64];
+  uint8_t len[64];
+  const uint8_t n = acSymbols(cmp, q, bits, len);
+  for (uint8_t i = 0; i < n; i++)
+    putBits(bits[i], len[i]);
+}
+
+void FrameSynth::encodeDc(uint8_t cmp, int16_t dc) {
+  const HuffEnc &t = _dc[cmp ? 1 : 0];
+  const int32_t diff = dc - _pred[cmp];
+  _pred[cmp] = dc;
+  const uint8_t s = category(diff);
+  putBits(t.code[s], t.size[s]);
+  if (s)
+    putBits((uint32_t)(diff < 0 ? diff - 1 : diff), s);
+}
+
+// AC-Koeffizienten (natürliche Reihenfolge) als Lauflängen-Symbole, je
+// Eintrag Huffman-Kode und Zusatzbits zusammen; Rückgabe = Anzahl
+uint8_t FrameSynth::acSymbols(uint8_t cmp, const int16_t *q, uint32_t *bits,
+                              uint8_t *len) const {
+  const HuffEnc &t = _ac[cmp ? 1 : 0];
+  uint8_t n = 0, run = 0;
+  for (uint8_t z = 1; z < 64; z++) {
+    const int32_t v = q[ZIGZAG[z]];
+    if (!v) {
+      run++;
+      continue;
+    }
+    for (; run > 15; run -= 16) {  // ZRL: 16 Nullen
+      bits[n] = t.code[0xF0];
+      len[n++] = t.size[0xF0];
+    }
+    const uint8_t s = category(v);
+    const uint8_t sym = (uint8_t)((run << 4) | s);
+    bits[n] = ((uint32_t)t.code[sym] << s) |
+              ((uint32_t)(v < 0 ? v - 1 : v) & ((1u << s) - 1));
+    len[n++] = (uint8_t)(t.size[sym] + s);
+    run = 0;
+  }
+  if (run) {  // EOB
+    bits[n] = t.code[0x00];
+    len[n++] = t.size[0x00];
+  }
+  return n;
+}
+
+void FrameSynth::putByte(uint8_t b) {
+  if (_pos < _cap)
+    _out[_pos++] = b;
+  else
+    _err = OUT_OF_SPACE;
+}
+
+void FrameSynth::putBytes(const uint8_t *p, size_t n) {
+  if (_pos + n > _cap) {
+    _err = OUT_OF_SPACE;
+    return;
+  }
+  memcpy(_out + _pos, p, n);
+  _pos += n;
+}
+
+void FrameSynth::putU16(uint16_t v) {
+  putByte((uint8_t)(v >> 8));
+  putByte((uint8_t)v);
+}
+
+// Bits MSB zuerst; nach 0xFF folgt ein Stopfbyte 0x00
+void FrameSynth::putBits(uint32_t bits, uint8_t n) {
+  _acc = (_acc << n) | (bits & ((1ull << n) - 1));
+  _nbits += n;
+  while (_nbits >= 8) {
+    const uint8_t b = (uint8_t)(_acc >> (_nbits - 8));
+    putByte(b);
+    if (b == 0xFF)
+      putByte(0x00);
+    _nbits -= 8;
+  }
+  _acc &= (1u << _nbits) - 1;
+}
+
+// Letztes Byte mit 1-Bits auffüllen
+void FrameSynth::flushBits() {
+  if (_nbits)
+    putBits(0x7F, 8 - _nbits);
+}
+
+// SOI, COM, DQT, SOF0, DHT, SOS
+void FrameSynth::writeHeader(const char *comment) {
+  putU16(0xFFD8);
+  if (comment && *comment) {
+    const size_t n = strlen(comment) > 65000 ? 65000 : strlen(comment);
+    putU16(0xFFFE);
+    putU16((uint16_t)(2 + n));
+    putBytes((const uint8_t *)comment, n);
+  }
+  const uint8_t tables = (_tq[0] | _tq[1] | _tq[2]) ? 2 : 1;
+  putU16(0xFFDB);
+  putU16((uint16_t)(2 + 65 * tables));
+  for (uint8_t t = 0; t < tables; t++) {
+    putByte(t);
+    for (uint8_t i = 0; i < 64; i++)
+      putByte((uint8_t)_qt[t][ZIGZAG[i]]);
+  }
+  putU16(0xFFC0);
+  putU16(17);
+  putByte(8);
+  putU16(_cfg.height);
+  putU16(_cfg.width);
+  putByte(3);
+  for (uint8_t c = 0; c < 3; c++) {
+    putByte((uint8_t)(c + 1));
+    putByte(c ? 0x11 : (uint8_t)((_hs << 4) | _vs));
+    putByte(_tq[c]);
+  }
+  putU16(0xFFC4);
+  putU16(2 + 2 * (17 + 12) + 2 * (17 + 162));
+  for (uint8_t i = 0; i < 2; i++) {
+    putByte(i);  // DC
+    putBytes(DC_BITS[i], 16);
+    putBytes(DC_VALS, 12);
+    putByte((uint8_t)(0x10 | i));  // AC
+    putBytes(AC_BITS[i], 16);
+    putBytes(AC_VALS[i], 162);
+  }
+  putU16(0xFFDA);
+  putU16(12);
+  putByte(3);
+  for (uint8_t c = 0; c < 3; c++) {
+    putByte((uint8_t)(c + 1));
+    putByte(c ? 0x11 : 0x00);
+  }
+  putByte(0);
+  putByte(63);
+  putByte(0);
+}
+
+Result FrameSynth::render(const Scene &scene, const char *comment,
+                          uint8_t *out, size_t cap, size_t *out_len) {
+  if (scene.blur_px < 0 || scene.w <= 0 || scene.h <= 0 ||
+      (scene.glare > 0 && scene.glare_r <= 0))
+    return BAD_PARAM;
+  _scene = scene;
+  const double rad = scene.angle_deg * M_PI / 180;
+  _cos = cos(rad);
+  _sin = sin(rad);
+  _sigma = sqrt(scene.blur_px * scene.blur_px + 0.09);
+  // Glanz unter 0,25 Graustufen zählt nicht mehr
+  _glareReach = scene.glare > 0.25
+                    ? scene.glare_r * sqrt(2 * log(scene.glare / 0.25))
+                    : 0;
+  _rng = scene.seed * 2654435761u ^ 0xA5A5A5A5u;
+  if (!_rng)
+    _rng = 1;
+  _pred[0] = _pred[1] = _pred[2] = 0;
+  _out = out;
+  _cap = cap;
+  _pos = 0;
+  _acc = 0;
+  _nbits = 0;
+  _err = OK;
+
+  writeHeader(comment);
+  const uint16_t mcus_x = (_cfg.width + mcuWidth() - 1) / mcuWidth();
+  const uint16_t mcus_y = (_cfg.height + mcuHeight() - 1) / mcuHeight();
+  const uint8_t ny = _hs * _vs;
+  for (uint16_t my = 0; my < mcus_y && _err == OK; my++)
+    for (uint16_t mx = 0; mx < mcus_x; mx++) {
+      const uint8_t cls = areaClass(mx * mcuWidth(), my * mcuHeight(),
+                                    mcuWidth(), mcuHeight());
+      if (!cls) {
+        renderMcu(mx, my);
+        continue;
+      }
+      const uint8_t *ycc = cls == 2 ? _cfg.label_ycc : _cfg.belt_ycc;
+      for (uint8_t b = 0; b < ny; b++)
+        encodeFlat(0, ycc[0]);
+      encodeFlat(1, ycc[1]);
+      encodeFlat(2, ycc[2]);
+    }
+  flushBits();
+  putU16(0xFFD9);
+  *out_len = _pos;
+  return _err;
+}
+
+// Sichtbare Fläche: Labelviereck an [0, Breite-1] × [0, Höhe-1] (Pixelmitten)
+// abschneiden (Sutherland-Hodgman), daraus erste und letzte Spalte
+Truth FrameSynth::truth(const Scene &scene) const {
+  Truth t = {};
+  const double rad = scene.angle_deg * M_PI / 180;
+  const double c = cos(rad), s = sin(rad);
+  const double hw = scene.w / 2, hh = scene.h / 2;
+  // Ecken im Uhrzeigersinn ab oben links; oben = -v
+  double px[8][2], tmp[8][2];
+  const double corner[4][2] = {{-hw, -hh}, {hw, -hh}, {hw, hh}, {-hw, hh}};
+  for (uint8_t i = 0; i < 4; i++) {
+    px[i][0] = scene.cx + corner[i][0] * c - corner[i][1] * s;
+    px[i][1] = scene.cy + corner[i][0] * s + corner[i][1] * c;
+  }
+  uint8_t n = 4;
+  const double xmax = _cfg.width - 1, ymax = _cfg.height - 1;
+  for (uint8_t i = 0; i < 4; i++)
+    if (px[i][0] < 0 || px[i][0] > xmax || px[i][1] < 0 || px[i][1] > ymax)
+      t.partial = true;
+
+  // Halbebenen: x >= 0, x <= xmax, y >= 0, y <= ymax
+  for (uint8_t e = 0; e < 4 && n; e++) {
+    const uint8_t axis = e / 2;
+    const double lim = e == 0 || e == 2 ? 0 : (axis ? ymax : xmax);
+    const double sign = e % 2 ? -1 : 1;
+    uint8_t m = 0;
+    for (uint8_t i = 0; i < n; i++) {
+      const double *a = px[i], *b = px[(i + 1) % n];
+      const double da = sign * (a[axis] - lim), db = sign * (b[axis] - lim);
+      if (da >= 0) {
+        tmp[m][0] = a[0];
+        tmp[m++][1] = a[1];
+      }
+      if ((da >= 0) != (db >= 0)) {
+        const double k = da / (da - db);
+        tmp[m][0] = a[0] + k * (b[0] - a[0]);
+        tmp[m++][1] = a[1] + k * (b[1] - a[1]);
+      }
+    }
+    n = m;
+    memcpy(px, tmp, sizeof(px));
+  }
+  if (n < 3)
+    return t;
+
+  double lo = px[0][0], hi = px[0][0];
+  for (uint8_t i = 1; i < n; i++) {
+    lo = px[i][0] < lo ? px[i][0] : lo;
+    hi = px[i][0] > hi ? px[i][0] : hi;
+  }
+  const double x0 = ceil(lo), last = floor(hi);
+  if (last < x0)
+    return t;
+  t.visible = true;
+  const double x1 = last + 1 < xmax ? last + 1 : xmax;
+
+  // Obere Kante durch ihre Mitte, Steigung tan(Winkel)
+  const double mx = scene.cx + hh * s, my = scene.cy - hh * c;
+  const double slope = s / c;
+  t.tl_x = x0;
+  t.tl_y = my + (x0 - mx) * slope;
+  t.tr_x = x1;
+  t.tr_y = my + (x1 - mx) * slope;
+  t.angle_deg = scene.angle_deg;
+  return t;
+}
+
+} // namespace framesynth
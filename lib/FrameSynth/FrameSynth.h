@@ -0,0 +1,163 @@
+#pragma once
+// FrameSynth: synthetische Bandbilder mit bekannter Geometrie
+//
+// Ein weißes Label (gedrehtes Rechteck) auf blauem Band wird analytisch
+// gerendert: Kante als Gauß-Unschärfe (Φ je Achse im Labelsystem, die
+// Pixelfläche ist als σ = 0,3 px eingerechnet), dazu Sensorrauschen und ein
+// Glanzpunkt. Das Bild entsteht direkt als Baseline-JPEG wie vom Sensor:
+// YCbCr mit Y-Abtastung 2×2 (4:2:0), Standard-Huffman-Tabellen, Quantisierung
+// aus der Sensorqualität (0..63, Näherung) oder bitgleich aus einer echten
+// Aufnahme (useTablesFrom).
+//
+// Schnell, weil nur MCUs nahe Labelkante oder Glanzpunkt Pixel für Pixel
+// gerechnet werden. Einfarbige MCUs brauchen keine DCT: ihre
+// AC-Koeffizienten stammen nur vom Rauschen und werden aus einem Vorrat
+// vorab quantisierter und Huffman-kodierter Rauschblöcke übernommen.
+//
+// Sollgeometrie (truth) wie image_compare.py / LabelGeometry: obere Kante
+// ausgewertet am linken und rechten Rand der sichtbaren Labelfläche
+// (x0 = erste Spalte, x1 = letzte Spalte + 1, höchstens Breite - 1).
+// Koordinaten in Pixeln, Pixelmitten ganzzahlig; die Kante liegt auf dem
+// Hell-Dunkel-Übergang.
+//
+// Keine Arduino-Abhängigkeit, nur für Host-Werkzeuge gedacht (double,
+// ~300 KB je Objekt: nicht auf den Stack legen).
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace framesynth {
+
+enum Result : uint8_t {
+  OK = 0,
+  BAD_PARAM,     // Bildgröße 0 oder über 65535, Sigma negativ
+  BAD_JPEG,      // Aufnahme für useTablesFrom nicht lesbar
+  UNSUPPORTED,   // Aufnahme nicht Baseline / 16-Bit-DQT / andere Abtastung
+  OUT_OF_SPACE,  // Ausgabepuffer zu klein
+};
+
+const char *resultName(Result r);
+
+struct Config {
+  uint16_t width, height;  // Bildgröße [px]
+  uint8_t quality;         // Sensorqualität 0..63 (kleiner = besser)
+  double noise;            // Sigma des Luma-Rauschens [Graustufen], Chroma halb
+  uint8_t label_ycc[3];    // Labelfarbe Y, Cb, Cr
+  uint8_t belt_ycc[3];     // Bandfarbe Y, Cb, Cr
+};
+
+// Ein Frame
+struct Scene {
+  double cx, cy;          // Labelmitte [px]
+  double w, h;            // Labelbreite (obere Kante) und -höhe [px]
+  double angle_deg;       // Drehung, positiv = im Uhrzeigersinn (y nach unten)
+  double blur_px;         // Sigma der Unschärfe [px], 0 = scharf
+  double glare;           // Glanzpunkt: Spitze in Graustufen, 0 = keiner
+  double glare_x, glare_y;// Lage des Glanzpunkts [px]
+  double glare_r;         // Sigma des Glanzpunkts [px]
+  uint32_t seed;          // Rauschmuster
+};
+
+// Sollwerte der oberen Kante
+struct Truth {
+  bool visible;           // Label zumindest teilweise im Bild
+  bool partial;           // Label ragt über den Bildrand
+  double tl_x, tl_y;      // linker Endpunkt [px]
+  double tr_x, tr_y;      // rechter Endpunkt [px]
+  double angle_deg;       // Kantenwinkel [°]
+};
+
+class FrameSynth {
+public:
+  // SXGA, JPEG_QUALITY aus main.cpp, leichtes Rauschen, Weiß auf Blau
+  static const Config DEFAULT_CONFIG;
+
+  Result begin(const Config &cfg);
+  // DQT und Abtastung einer echten Aufnahme übernehmen (nach begin)
+  Result useTablesFrom(const uint8_t *jpg, size_t len);
+
+  // Frame kodieren; comment (optional) wird als COM-Segment eingebettet
+  Result render(const Scene &scene, const char *comment, uint8_t *out,
+                size_t cap, size_t *out_len);
+  // Sollgeometrie zum Frame (hängt nicht von Rauschen/Unschärfe ab)
+  Truth truth(const Scene &scene) const;
+
+  // Puffergröße, die für jedes Bild reicht
+  size_t maxJpegSize() const;
+  uint8_t mcuWidth() const { return (uint8_t)(8 * _hs); }
+  uint8_t mcuHeight() const { return (uint8_t)(8 * _vs); }
+
+private:
+  struct HuffEnc {
+    uint16_t code[256];
+    uint8_t size[256];
+  };
+
+  // Rauschblock im Vorrat: DC-Anteil (unquantisiert) und fertig kodierte
+  // AC-Symbole (Huffman-Kode + Zusatzbits, höchstens 26 Bit je Eintrag)
+  struct NoiseBlock {
+    float dc;
+    uint16_t first;
+    uint8_t count;
+  };
+
+  static const uint16_t POOL_BLOCKS = 256;
+  static const uint16_t GAUSS_STEPS = 4096;
+  static const uint16_t PHI_STEPS = 2048;
+
+  void buildQuant(uint8_t quality);
+  void buildPools();
+  void buildHuffman(HuffEnc *t, const uint8_t *bits, const uint8_t *vals);
+
+  // Pixel
+  double phi(double t) const;
+  uint8_t areaClass(uint32_t x0, uint32_t y0, uint8_t w, uint8_t h) const;
+  void renderMcu(uint16_t mx, uint16_t my);
+  void encodeFlat(uint8_t cmp, uint8_t value);
+  void encodeBlock(uint8_t cmp, const float *px);
+  void encodeDc(uint8_t cmp, int16_t dc);
+  uint8_t acSymbols(uint8_t cmp, const int16_t *q, uint32_t *bits,
+                    uint8_t *len) const;
+
+  // Ausgabe
+  void writeHeader(const char *comment);
+  void putBits(uint32_t bits, uint8_t n);
+  void putByte(uint8_t b);
+  void putBytes(const uint8_t *p, size_t n);
+  void putU16(uint16_t v);
+  void flushBits();
+  uint32_t rand32();
+  float gauss();
+
+  Config _cfg = {};
+  uint8_t _hs = 2, _vs = 2;      // Y-Abtastung (Blöcke je MCU)
+  uint8_t _tq[3] = {0, 1, 1};    // Quantisierungstabelle je Komponente
+  uint16_t _qt[2][64] = {};      // natürliche Reihenfolge
+  float _fdiv[2][64] = {};       // 1 / (Quantisierer * AAN-Skalierung)
+  HuffEnc _dc[2], _ac[2];        // [0] Luma, [1] Chroma
+
+  NoiseBlock _pool[3][POOL_BLOCKS] = {};
+  uint32_t _poolBits[3 * POOL_BLOCKS * 64];
+  uint8_t _poolLen[3 * POOL_BLOCKS * 64];
+  float _gauss[GAUSS_STEPS];
+  float _phi[PHI_STEPS + 1];
+
+  // Aktueller Frame
+  Scene _scene = {};
+  double _cos = 1, _sin = 0;     // Drehung
+  double _sigma = 0.3;           // wirksame Kantenunschärfe
+  double _glareReach = 0;        // Radius, ab dem der Glanz verschwindet
+  uint32_t _rng = 1;
+  int16_t _pred[3] = {};
+  float _y[16 * 16];             // Luma der MCU
+  float _cb[16 * 16], _cr[16 * 16];
+
+  uint8_t *_out = nullptr;
+  size_t _cap = 0;
+  size_t _pos = 0;
+  uint64_t _acc = 0;
+  uint8_t _nbits = 0;
+  Result _err = OK;
+};
+
+} // namespace framesynth
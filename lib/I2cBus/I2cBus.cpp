@@ -0,0 +1,50 @@
+#include "I2cBus.h"
+
+#include "esp_timer.h"
+#include "freertos/task.h"
+
+namespace i2cbus {
+
+bool Arbiter::begin() {
+  if (!_mutex)
+    _mutex = xSemaphoreCreateMutex();
+  return _mutex != nullptr;
+}
+
+bool Arbiter::higherWaiting(Priority p) const {
+  for (uint8_t q = 0; q < p; q++)
+    if (_waiting[q].load())
+      return true;
+  return false;
+}
+
+void Arbiter::acquire(Priority p) {
+  if (!_mutex)
+    return;
+  const int64_t t0 = esp_timer_get_time();
+  _waiting[p]++;
+  for (;;) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    if (!higherWaiting(p))
+      break;
+    // Höhere Klasse wartet: abgeben, sie kommt beim Mutex als Nächste dran
+    // oder spätestens, wenn wir schlafen
+    xSemaphoreGive(_mutex);
+    _yielded[p]++;
+    vTaskDelay(1);
+  }
+  _waiting[p]--;
+  _acquired[p]++;
+  // Unter der Sperre: nur takeMaxWaitUs() schreibt sonst
+  const uint32_t wait_us = (uint32_t)(esp_timer_get_time() - t0);
+  if (wait_us > _max_wait_us[p].load())
+    _max_wait_us[p].store(wait_us);
+}
+
+// Klasse nur für die Symmetrie zu acquire(); der Mutex gehört dem Task
+void Arbiter::release(Priority) {
+  if (_mutex)
+    xSemaphoreGive(_mutex);
+}
+
+} // namespace i2cbus
@@ -0,0 +1,73 @@
+#pragma once
+// I2cBus: Vergabe des gemeinsamen I2C-Busses nach Klassen.
+//
+// Auf dem Memento hängen Kamera (SCCB über Wire, sccb_i2c_port 0), AW9523
+// (Tasten, Kartenerkennung, Lautsprecher, SD-Strom) und LIS3DH am selben Bus.
+// Die Treiber sperren nur je Transaktion; wer zuerst kommt, fährt. Der
+// Arbiter ordnet ganze Zugriffe (eine oder mehrere Transaktionen) in Klassen:
+// Kameraregister vor Beschleunigungssensor vor Bedienung. Wer den Bus
+// bekommt, während eine höhere Klasse wartet, gibt ihn sofort wieder ab und
+// versucht es einen Tick später; die höhere Klasse wartet so höchstens auf
+// den einen Zugriff, der schon läuft. Die Sperre ist ein FreeRTOS-Mutex
+// (Prioritätsvererbung), nicht rekursiv.
+//
+// Vor begin() sind acquire()/release() wirkungslos (Start, ein Task).
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+namespace i2cbus {
+
+enum Priority : uint8_t {
+  PRIO_CAMERA = 0,  // Sensorregister: Profile, Belichtung, Qualität
+  PRIO_SENSOR,      // Beschleunigungssensor
+  PRIO_UI,          // Tasten, Kartenerkennung, Lautsprecher, SD-Strom
+  PRIO_COUNT
+};
+
+class Arbiter {
+public:
+  bool begin();
+  void acquire(Priority p);
+  void release(Priority p);
+
+  // Längste Wartezeit der Klasse seit dem letzten Aufruf [µs]
+  uint32_t takeMaxWaitUs(Priority p) { return _max_wait_us[p].exchange(0); }
+  // Zugriffe der Klasse und Rückzüge zugunsten höherer Klassen seit begin()
+  uint32_t acquired(Priority p) const { return _acquired[p].load(); }
+  uint32_t yielded(Priority p) const { return _yielded[p].load(); }
+
+private:
+  bool higherWaiting(Priority p) const;
+
+  SemaphoreHandle_t _mutex = nullptr;
+  std::atomic<uint8_t> _waiting[PRIO_COUNT] = {};
+  std::atomic<uint32_t> _max_wait_us[PRIO_COUNT] = {};
+  std::atomic<uint32_t> _acquired[PRIO_COUNT] = {};
+  std::atomic<uint32_t> _yielded[PRIO_COUNT] = {};
+};
+
+// Bus für die Dauer eines Blocks; bus == nullptr: ohne Arbiter
+class Guard {
+public:
+  Guard(Arbiter *bus, Priority p) : _bus(bus), _p(p) {
+    if (_bus)
+      _bus->acquire(_p);
+  }
+  ~Guard() {
+    if (_bus)
+      _bus->release(_p);
+  }
+  Guard(const Guard &) = delete;
+  Guard &operator=(const Guard &) = delete;
+
+private:
+  Arbiter *_bus;
+  Priority _p;
+};
+
+} // namespace i2cbus
@@ -0,0 +1,322 @@
+#include "JpegCrop.h"
+
+#include <string.h>
+
+namespace jpegcrop {
+
+// JFIF-APP0 (Version 1.01, ohne Vorschaubild) für Betrachter, die ihn erwarten
+static const uint8_t JFIF_APP0[] = {0xFF, 0xE0, 0x00, 0x10, 'J',  'F',
+                                    'I',  'F',  0x00, 0x01, 0x01, 0x00,
+                                    0x00, 0x01, 0x00, 0x01, 0x00, 0x00};
+
+static inline uint16_t getU16BE(const uint8_t *p) {
+  return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+// Anzahl signifikanter Bits von |v| (JPEG-Kategorie SSSS)
+static inline uint8_t category(int32_t v) {
+  uint32_t a = (uint32_t)(v < 0 ? -v : v);
+  uint8_t n = 0;
+  while (a) {
+    n++;
+    a >>= 1;
+  }
+  return n;
+}
+
+size_t JpegCropper::jpegInput(JDEC *jd, uint8_t *buf, size_t len) {
+  JpegCropper *self = (JpegCropper *)jd->device;
+  if (self->_srcPos + len > self->_srcLen)
+    len = self->_srcLen - self->_srcPos;
+  if (buf)
+    memcpy(buf, self->_src + self->_srcPos, len);
+  self->_srcPos += len;
+  return len;
+}
+
+// Marker bis einschließlich SOS einsammeln (Zeiger in die Quelle)
+Result JpegCropper::parseHeader(const uint8_t *jpg, size_t len) {
+  _nDqt = _nDht = 0;
+  _sof = {};
+  _sos = {};
+  if (len < 4 || jpg[0] != 0xFF || jpg[1] != 0xD8)
+    return BAD_JPEG;
+
+  size_t pos = 2;
+  while (pos + 4 <= len) {
+    if (jpg[pos] != 0xFF)
+      return BAD_JPEG;
+    const uint8_t m = jpg[pos + 1];
+    if (m == 0xFF) {  // Füllbyte
+      pos++;
+      continue;
+    }
+    const size_t seg = 2 + (size_t)getU16BE(jpg + pos + 2);
+    if (pos + seg > len)
+      return BAD_JPEG;
+    const Segment s = {jpg + pos, seg};
+    switch (m) {
+    case 0xDB:  // DQT
+      if (_nDqt == MAX_SEGMENTS)
+        return UNSUPPORTED;
+      _dqt[_nDqt++] = s;
+      break;
+    case 0xC4:  // DHT
+      if (_nDht == MAX_SEGMENTS)
+        return UNSUPPORTED;
+      _dht[_nDht++] = s;
+      break;
+    case 0xC0:  // SOF0 (Baseline)
+      _sof = s;
+      break;
+    case 0xC1: case 0xC2: case 0xC3: case 0xC5: case 0xC6: case 0xC7:
+    case 0xC9: case 0xCA: case 0xCB: case 0xCD: case 0xCE: case 0xCF:
+      return UNSUPPORTED;  // progressiv, arithmetisch, verlustfrei ...
+    case 0xDA:  // SOS: Ende des Kopfes
+      _sos = s;
+      return _sof.p && _nDqt && _nDht ? OK : BAD_JPEG;
+    default:    // APPn, COM, DRI, ...: nicht übernommen
+      break;
+    }
+    pos += seg;
+  }
+  return BAD_JPEG;
+}
+
+// Kanonische Kodes wie in JPEG Annex C aus BITS/HUFFVAL erzeugen
+bool JpegCropper::buildTables(const uint8_t *seg, size_t len) {
+  const uint8_t *p = seg + 4;
+  const uint8_t *end = seg + len;
+  while (p < end) {
+    if (end - p < 17)
+      return false;
+    const uint8_t cls = p[0] >> 4, id = p[0] & 0x0F;
+    if (cls > 1 || id > 1)
+      return false;
+    const uint8_t *bits = p + 1;
+    const uint8_t *vals = p + 17;
+    size_t n = 0;
+    for (uint8_t i = 0; i < 16; i++)
+      n += bits[i];
+    if (n > 256 || (size_t)(end - vals) < n)
+      return false;
+
+    HuffEnc &t = _enc[id][cls];
+    memset(t.size, 0, sizeof(t.size));
+    uint32_t code = 0;
+    size_t k = 0;
+    for (uint8_t l = 1; l <= 16; l++, code <<= 1) {
+      for (uint8_t i = 0; i < bits[l - 1]; i++, k++, code++) {
+        t.code[vals[k]] = (uint16_t)code;
+        t.size[vals[k]] = l;
+      }
+    }
+    _hasEnc[id][cls] = true;
+    p = vals + n;
+  }
+  return true;
+}
+
+void JpegCropper::putByte(uint8_t b) {
+  if (_pos < _cap)
+    _out[_pos++] = b;
+  else
+    _err = OUT_OF_SPACE;
+}
+
+void JpegCropper::putBytes(const uint8_t *p, size_t n) {
+  if (_pos + n > _cap) {
+    _err = OUT_OF_SPACE;
+    return;
+  }
+  memcpy(_out + _pos, p, n);
+  _pos += n;
+}
+
+// Bits MSB zuerst; nach 0xFF folgt ein Stopfbyte 0x00
+void JpegCropper::putBits(uint32_t bits, uint8_t n) {
+  _acc = (_acc << n) | (bits & ((1u << n) - 1));
+  _nbits += n;
+  while (_nbits >= 8) {
+    const uint8_t b = (uint8_t)(_acc >> (_nbits - 8));
+    putByte(b);
+    if (b == 0xFF)
+      putByte(0x00);
+    _nbits -= 8;
+  }
+  _acc &= (1u << _nbits) - 1;
+}
+
+// Letztes Byte mit 1-Bits auffüllen
+void JpegCropper::flushBits() {
+  if (_nbits)
+    putBits(0x7F, 8 - _nbits);
+}
+
+bool JpegCropper::putSymbol(const HuffEnc &t, uint8_t sym) {
+  if (!t.size[sym]) {
+    _err = UNSUPPORTED;
+    return false;
+  }
+  putBits(t.code[sym], t.size[sym]);
+  return true;
+}
+
+void JpegCropper::encodeBlock(const int16_t *blk, uint8_t cmp) {
+  const uint8_t id = cmp ? 1 : 0;  // Tabellenwahl wie in tjpgd
+  const HuffEnc &dc = _enc[id][0];
+  const HuffEnc &ac = _enc[id][1];
+
+  const int32_t diff = blk[0] - _pred[cmp];
+  _pred[cmp] = blk[0];
+  uint8_t s = category(diff);
+  if (s > 11 || !putSymbol(dc, s)) {
+    _err = UNSUPPORTED;
+    return;
+  }
+  if (s)
+    putBits((uint32_t)(diff < 0 ? diff - 1 : diff), s);
+
+  uint8_t run = 0;
+  for (uint8_t z = 1; z < 64; z++) {
+    const int32_t v = blk[z];
+    if (!v) {
+      run++;
+      continue;
+    }
+    for (; run > 15; run -= 16)
+      if (!putSymbol(ac, 0xF0))  // ZRL: 16 Nullen
+        return;
+    s = category(v);
+    if (s > 10 || !putSymbol(ac, (uint8_t)((run << 4) | s))) {
+      _err = UNSUPPORTED;
+      return;
+    }
+    putBits((uint32_t)(v < 0 ? v - 1 : v), s);
+    run = 0;
+  }
+  if (run)
+    putSymbol(ac, 0x00);  // EOB
+}
+
+int JpegCropper::coefOutput(JDEC *jd, const int16_t *coef, unsigned int x,
+                            unsigned int y) {
+  JpegCropper *self = (JpegCropper *)jd->device;
+  const Rect &m = self->_mcu;
+  if (y < m.y0 || x < m.x0 || x > m.x1)
+    return 1;  // MCU außerhalb des Ausschnitts: nur weiterlesen
+
+  for (uint8_t b = 0; b < self->_nBlocks; b++)
+    self->encodeBlock(coef + b * 64, b < self->_nY ? 0 : b - self->_nY + 1);
+  if (self->_err != OK)
+    return 0;
+  // Letzte MCU des Ausschnitts: Rest des Bildes nicht mehr lesen
+  const unsigned int mx = jd->msx * 8, my = jd->msy * 8;
+  return !(x + mx > m.x1 && y + my > m.y1);
+}
+
+void JpegCropper::writeHeader(uint16_t w, uint16_t h) {
+  putByte(0xFF);
+  putByte(0xD8);
+  putBytes(JFIF_APP0, sizeof(JFIF_APP0));
+  for (uint8_t i = 0; i < _nDqt; i++)
+    putBytes(_dqt[i].p, _dqt[i].len);
+  // SOF0: FF C0 Lh Ll P Yh Yl Xh Xl ...
+  const size_t sof = _pos;
+  putBytes(_sof.p, _sof.len);
+  if (_err == OK) {
+    _out[sof + 5] = (uint8_t)(h >> 8);
+    _out[sof + 6] = (uint8_t)h;
+    _out[sof + 7] = (uint8_t)(w >> 8);
+    _out[sof + 8] = (uint8_t)w;
+  }
+  for (uint8_t i = 0; i < _nDht; i++)
+    putBytes(_dht[i].p, _dht[i].len);
+  putBytes(_sos.p, _sos.len);
+}
+
+Result JpegCropper::crop(const uint8_t *jpg, size_t len, const Rect &want,
+                         uint8_t *out, size_t cap, size_t *out_len, Rect *got,
+                         uint16_t *full_w, uint16_t *full_h) {
+  *out_len = 0;
+  Result r = parseHeader(jpg, len);
+  if (r != OK)
+    return r;
+
+  memset(_hasEnc, 0, sizeof(_hasEnc));
+  for (uint8_t i = 0; i < _nDht; i++)
+    if (!buildTables(_dht[i].p, _dht[i].len))
+      return BAD_JPEG;
+
+  JDEC jd;
+  jd.swap = 0;
+  _src = jpg;
+  _srcLen = len;
+  _srcPos = 0;
+  _jres = jd_prepare(&jd, jpegInput, _work, sizeof(_work), this);
+  if (_jres == JDR_FMT3)
+    return UNSUPPORTED;
+  if (_jres != JDR_OK)
+    return BAD_JPEG;
+  if (full_w)
+    *full_w = jd.width;
+  if (full_h)
+    *full_h = jd.height;
+
+  // SOS muss die Tabellen benutzen, die tjpgd annimmt (Y: 0/0, C: 1/1)
+  const uint8_t *sos = _sos.p + 4;
+  if (sos[0] != jd.ncomp)
+    return UNSUPPORTED;
+  for (uint8_t c = 0; c < jd.ncomp; c++) {
+    const uint8_t sel = sos[2 + 2 * c];
+    if (sel != (c ? 0x11 : 0x00) || !_hasEnc[c ? 1 : 0][0] ||
+        !_hasEnc[c ? 1 : 0][1])
+      return UNSUPPORTED;
+  }
+
+  if (want.x0 > want.x1 || want.y0 > want.y1 || want.x0 >= jd.width ||
+      want.y0 >= jd.height)
+    return EMPTY_RECT;
+  const uint16_t mx = jd.msx * 8, my = jd.msy * 8;
+  const uint16_t x1 = want.x1 < jd.width ? want.x1 : jd.width - 1;
+  const uint16_t y1 = want.y1 < jd.height ? want.y1 : jd.height - 1;
+  _mcu.x0 = want.x0 / mx * mx;
+  _mcu.y0 = want.y0 / my * my;
+  _mcu.x1 = x1 / mx * mx;  // Ursprung der letzten MCU
+  _mcu.y1 = y1 / my * my;
+  got->x0 = _mcu.x0;
+  got->y0 = _mcu.y0;
+  got->x1 = _mcu.x1 + mx - 1 < jd.width ? _mcu.x1 + mx - 1 : jd.width - 1;
+  got->y1 = _mcu.y1 + my - 1 < jd.height ? _mcu.y1 + my - 1 : jd.height - 1;
+
+  _nY = jd.msx * jd.msy;
+  _nBlocks = jd.ncomp == 3 ? _nY + 2 : _nY;
+  _pred[0] = _pred[1] = _pred[2] = 0;
+  _err = OK;
+  _out = out;
+  _cap = cap;
+  _pos = 0;
+  _acc = 0;
+  _nbits = 0;
+
+  writeHeader(got->x1 + 1 - got->x0, got->y1 + 1 - got->y0);
+  if (_err != OK)
+    return _err;
+
+  jd.window.bottom = got->y1;
+  _jres = jd_scan(&jd, coefOutput, _coef);
+  if (_err != OK)
+    return _err;
+  if (_jres != JDR_OK && _jres != JDR_INTR)
+    return BAD_JPEG;
+
+  flushBits();
+  putByte(0xFF);
+  putByte(0xD9);
+  if (_err != OK)
+    return _err;
+  *out_len = _pos;
+  return OK;
+}
+
+} // namespace jpegcrop
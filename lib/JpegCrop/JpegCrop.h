@@ -0,0 +1,101 @@
+#pragma once
+// JpegCrop: verlustfreier Zuschnitt eines Baseline-JPEGs im DCT-Bereich.
+//
+// tjpgd liest nur die Huffman-Daten (jd_scan, keine IDCT); die quantisierten
+// Koeffizienten der MCUs im Zielrechteck werden unverändert neu
+// Huffman-kodiert. Das Rechteck wird dazu auf MCU-Grenzen erweitert, die
+// DC-Prädiktoren beginnen im Ausschnitt neu bei 0. DQT, DHT und SOS werden
+// übernommen, SOF0 erhält die neue Bildgröße, Restart-Marker entfallen.
+// Das Ergebnis ist ein gültiges Baseline-JPEG ohne Generationsverlust.
+//
+// Keine Arduino-Abhängigkeit; Ein- und Ausgabe liegen beim Aufrufer.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tjpgd.h"
+
+namespace jpegcrop {
+
+enum Result : uint8_t {
+  OK = 0,
+  BAD_JPEG,      // Kopf oder Huffman-Daten fehlerhaft
+  UNSUPPORTED,   // kein Baseline-JPEG im tjpgd-Format / Symbol fehlt in DHT
+  OUT_OF_SPACE,  // Ausgabepuffer zu klein
+  EMPTY_RECT,    // Rechteck liegt außerhalb des Bildes
+};
+
+// Rechteck in Vollbild-Pixeln, Grenzen inklusive
+struct Rect {
+  uint16_t x0, y0, x1, y1;
+};
+
+class JpegCropper {
+public:
+  // Ausschnitt want (auf MCUs erweitert) von jpg nach out schreiben.
+  // got = tatsächlicher Ausschnitt im Quellbild, full_w/full_h = Quellgröße
+  Result crop(const uint8_t *jpg, size_t len, const Rect &want, uint8_t *out,
+              size_t cap, size_t *out_len, Rect *got,
+              uint16_t *full_w = nullptr, uint16_t *full_h = nullptr);
+
+  JRESULT lastJpegResult() const { return _jres; }
+
+private:
+  // Kanonische Huffman-Kodes einer DHT-Tabelle (size 0 = Symbol fehlt)
+  struct HuffEnc {
+    uint16_t code[256];
+    uint8_t size[256];
+  };
+
+  struct Segment {
+    const uint8_t *p;  // ab 0xFF des Markers
+    size_t len;        // inkl. Marker
+  };
+
+  static const uint8_t MAX_SEGMENTS = 4;
+
+  static size_t jpegInput(JDEC *jd, uint8_t *buf, size_t len);
+  static int coefOutput(JDEC *jd, const int16_t *coef, unsigned int x,
+                        unsigned int y);
+
+  Result parseHeader(const uint8_t *jpg, size_t len);
+  bool buildTables(const uint8_t *seg, size_t len);
+  void writeHeader(uint16_t w, uint16_t h);
+  void encodeBlock(const int16_t *blk, uint8_t cmp);
+  bool putSymbol(const HuffEnc &t, uint8_t sym);
+  void putBits(uint32_t bits, uint8_t n);
+  void putByte(uint8_t b);
+  void putBytes(const uint8_t *p, size_t n);
+  void flushBits();
+
+  // Quelle
+  const uint8_t *_src = nullptr;
+  size_t _srcLen = 0;
+  size_t _srcPos = 0;
+  Segment _dqt[MAX_SEGMENTS] = {}, _dht[MAX_SEGMENTS] = {};
+  uint8_t _nDqt = 0, _nDht = 0;
+  Segment _sof = {}, _sos = {};
+
+  // Ausschnitt in MCU-Pixeln des Quellbilds (inklusive)
+  Rect _mcu = {};
+  uint8_t _nBlocks = 0;       // Blöcke pro MCU (Y + ggf. Cb, Cr)
+  uint8_t _nY = 0;            // davon Y-Blöcke
+  int16_t _pred[3] = {};      // DC-Prädiktoren Y, Cb, Cr
+  Result _err = OK;
+
+  // Ziel
+  uint8_t *_out = nullptr;
+  size_t _cap = 0;
+  size_t _pos = 0;
+  uint32_t _acc = 0;
+  uint8_t _nbits = 0;
+
+  HuffEnc _enc[2][2];         // [Tabellen-ID][0: DC, 1: AC]
+  bool _hasEnc[2][2] = {};
+  JRESULT _jres = JDR_OK;
+
+  int16_t _coef[6 * 64] __attribute__((aligned(4)));
+  uint8_t _work[TJPGD_WORKSPACE_SIZE] __attribute__((aligned(4)));
+};
+
+} // namespace jpegcrop
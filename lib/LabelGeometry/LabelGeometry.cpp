@@ -0,0 +1,468 @@
+#include "LabelGeometry.h"
+
+#include <algorithm>
+#include <string.h>
+
+namespace labelgeom {
+
+// ========================== Festkomma-Hilfen ==========================
+
+// atan(2^-i) in Grad, Q22 (CORDIC-Winkeltabelle)
+static const int32_t kAtanDegQ22[24] = {
+    188743680, 111421900, 58872272, 29884485, 15000234, 7507429,
+    3754631,   1877430,   938729,   469366,   234683,   117342,
+    58671,     29335,     14668,    7334,     3667,     1833,
+    917,       458,       229,      115,      57,       29};
+
+static const int32_t kDeg180Q22 = 180 * (1 << 22);
+
+const char *resultName(Result r) {
+  switch (r) {
+  case OK:              return "OK";
+  case NO_LABEL:        return "Kein Label gefunden";
+  case EDGE_FIT_FAILED: return "Kantenfit fehlgeschlagen";
+  case DEGENERATE:      return "Obere Kante degeneriert";
+  case BAD_PARAM:       return "Ungueltige Parameter";
+  case DECODE_FAILED:   return "JPEG-Dekodierung fehlgeschlagen";
+  }
+  return "?";
+}
+
+uint32_t isqrt64(uint64_t v) {
+  uint64_t res = 0;
+  uint64_t bit = (uint64_t)1 << 62;
+  while (bit > v)
+    bit >>= 2;
+  while (bit) {
+    if (v >= res + bit) {
+      v -= res + bit;
+      res = (res >> 1) + bit;
+    } else {
+      res >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint32_t)res;
+}
+
+q16_t atan2Deg(int32_t y, int32_t x) {
+  if (x == 0 && y == 0)
+    return 0;
+  int32_t base = 0;
+  if (x < 0) {  // in rechte Halbebene drehen
+    base = (y >= 0) ? kDeg180Q22 : -kDeg180Q22;
+    x = -x;
+    y = -y;
+  }
+  // Vorskalieren, damit die CORDIC-Verstärkung (1,647) nicht überläuft
+  while (x > (1 << 29) || y > (1 << 29) || y < -(1 << 29)) {
+    x >>= 1;
+    y >>= 1;
+  }
+  int32_t z = 0;
+  for (int i = 0; i < 24; i++) {
+    const int32_t xs = x >> i;
+    const int32_t ys = y >> i;
+    if (y > 0) {
+      x += ys;
+      y -= xs;
+      z += kAtanDegQ22[i];
+    } else {
+      x -= ys;
+      y += xs;
+      z -= kAtanDegQ22[i];
+    }
+  }
+  return (base + z + 32) >> 6;  // Q22 -> Q16
+}
+
+q16_t normalizeDeg(q16_t deg) {
+  const q16_t full = 360 * Q16_ONE;
+  while (deg >= 180 * Q16_ONE)
+    deg -= full;
+  while (deg < -180 * Q16_ONE)
+    deg += full;
+  return deg;
+}
+
+q16_t pxToMm(q16_t px, q16_t px_per_cm) {
+  if (px_per_cm <= 0)
+    return 0;
+  return (q16_t)(((int64_t)px * 10 * Q16_ONE) / px_per_cm);
+}
+
+// ========================== Grobsegmentierung ==========================
+
+uint8_t otsuThreshold(const uint32_t hist[256]) {
+  uint64_t total = 0, sumT = 0;
+  for (int i = 0; i < 256; i++) {
+    total += hist[i];
+    sumT += (uint64_t)i * hist[i];
+  }
+  if (!total)
+    return 0;
+
+  uint64_t w0 = 0, sum0 = 0, bestVar = 0;
+  uint8_t bestT = 0;
+  for (int t = 0; t < 255; t++) {
+    w0 += hist[t];
+    sum0 += (uint64_t)t * hist[t];
+    const uint64_t w1 = total - w0;
+    if (!w0 || !w1)
+      continue;
+    // Zwischenklassenvarianz w0*w1*(m1-m0)^2 mit Gewichten in Q12 und
+    // Mittelwerten in Q8 – passt ohne Überlauf in 64 Bit
+    const int64_t m0 = (int64_t)((sum0 << 8) / w0);
+    const int64_t m1 = (int64_t)(((sumT - sum0) << 8) / w1);
+    const uint64_t f0 = (w0 << 12) / total;
+    const uint64_t f1 = (w1 << 12) / total;
+    const uint64_t d = (uint64_t)((m1 - m0) * (m1 - m0));
+    const uint64_t var = f0 * f1 * d;
+    if (var > bestVar) {
+      bestVar = var;
+      bestT = (uint8_t)t;
+    }
+  }
+  return bestT;
+}
+
+// Längster zusammenhängender Bereich mit count >= thr, der das Maximum enthält
+static void peakRun(const uint16_t *count, uint16_t n, uint16_t *lo,
+                    uint16_t *hi) {
+  uint16_t peak = 0;
+  for (uint16_t i = 1; i < n; i++)
+    if (count[i] > count[peak])
+      peak = i;
+  const uint16_t thr = std::max<uint16_t>(1, count[peak] / 4);
+  uint16_t a = peak, b = peak;
+  while (a > 0 && count[a - 1] >= thr)
+    a--;
+  while (b + 1 < n && count[b + 1] >= thr)
+    b++;
+  *lo = a;
+  *hi = b;
+}
+
+Result findLabelBox(const GrayPlane &img, Scratch &s, Box *box) {
+  if (!img.data || img.width > MAX_WIDTH || img.height > MAX_HEIGHT ||
+      img.width < 8 || img.height < 8)
+    return BAD_PARAM;
+
+  memset(s.hist, 0, sizeof(s.hist));
+  for (uint16_t y = 0; y < img.height; y++) {
+    const uint8_t *row = img.data + (size_t)y * img.stride;
+    for (uint16_t x = 0; x < img.width; x++)
+      s.hist[row[x]]++;
+  }
+  const uint8_t t = otsuThreshold(s.hist);
+
+  // Polarität wie in _largest_label_mask: Label = kleinere Klasse
+  uint32_t bright = 0;
+  for (int i = t + 1; i < 256; i++)
+    bright += s.hist[i];
+  const uint32_t total = (uint32_t)img.width * img.height;
+  const bool labelBright = bright < total / 2;
+
+  memset(s.rowCount, 0, sizeof(uint16_t) * img.height);
+  for (uint16_t y = 0; y < img.height; y++) {
+    const uint8_t *row = img.data + (size_t)y * img.stride;
+    uint16_t c = 0;
+    for (uint16_t x = 0; x < img.width; x++)
+      c += ((row[x] > t) == labelBright);
+    s.rowCount[y] = c;
+  }
+  uint16_t y0, y1;
+  peakRun(s.rowCount, img.height, &y0, &y1);
+  if (!s.rowCount[y0])
+    return NO_LABEL;
+
+  // Spalten nur innerhalb der Label-Zeilen zählen (Glanzlichter außerhalb
+  // sollen die Box nicht verbreitern)
+  memset(s.colCount, 0, sizeof(uint16_t) * img.width);
+  for (uint16_t y = y0; y <= y1; y++) {
+    const uint8_t *row = img.data + (size_t)y * img.stride;
+    for (uint16_t x = 0; x < img.width; x++)
+      s.colCount[x] += ((row[x] > t) == labelBright);
+  }
+  uint16_t x0, x1;
+  peakRun(s.colCount, img.width, &x0, &x1);
+
+  if (x1 - x0 < 8 || y1 - y0 < 4)
+    return NO_LABEL;
+  box->x0 = x0;
+  box->y0 = y0;
+  box->x1 = x1;
+  box->y1 = y1;
+  return OK;
+}
+
+// ========================== Präzise obere Kante ==========================
+
+// Horizontaler Teil von Gauß(3x3) ∘ Sobel-y(3x3): [1 4 6 4 1], Rand repliziert
+static void filterRow(const uint8_t *row, uint16_t x0, uint16_t x1,
+                      int16_t *out) {
+  for (uint16_t x = x0; x <= x1; x++) {
+    const uint8_t l2 = row[x >= x0 + 2 ? x - 2 : x0];
+    const uint8_t l1 = row[x >= x0 + 1 ? x - 1 : x0];
+    const uint8_t r1 = row[x + 1 <= x1 ? x + 1 : x1];
+    const uint8_t r2 = row[x + 2 <= x1 ? x + 2 : x1];
+    out[x - x0] = (int16_t)(l2 + 4 * l1 + 6 * row[x] + 4 * r1 + r2);
+  }
+}
+
+Result EdgeScanner::begin(const Box &roi, Scratch &s) {
+  _s = nullptr;
+  if (roi.x1 <= roi.x0 || roi.y1 <= roi.y0)
+    return BAD_PARAM;
+  const uint16_t roiH = roi.y1 - roi.y0 + 1;
+  uint16_t bandH = std::max<uint16_t>(10, (uint16_t)((uint32_t)roiH * 3 / 10));
+  if (bandH > roiH)
+    bandH = roiH;
+  Box band = roi;
+  band.y1 = roi.y0 + bandH - 1;
+  return beginBand(band, s);
+}
+
+Result EdgeScanner::beginBand(const Box &band, Scratch &s) {
+  _s = nullptr;
+  if (band.x1 >= MAX_WIDTH || band.x1 <= band.x0 || band.y1 <= band.y0)
+    return BAD_PARAM;
+  _band = band;
+  _w = band.x1 - band.x0 + 1;
+  _bandH = band.y1 - band.y0 + 1;
+  _top = band.y0;
+  _bot = band.y1;
+  _next = _top;
+  _filled = -1;
+
+  memset(s.best, 0, sizeof(uint16_t) * _w);
+  memset(s.bestRow, 0, sizeof(uint16_t) * _w);
+  memset(s.prevDy, 0, sizeof(int16_t) * _w);
+  _s = &s;
+  return OK;
+}
+
+// Vertikaler Teil [-1 -2 0 2 1] für Bandzeile r über den Ring aus 5 Zeilen
+void EdgeScanner::evalRow(uint16_t r) {
+  Scratch &s = *_s;
+  const int16_t *m2 = s.hrow[(r >= _top + 2 ? r - 2 : _top) % 5];
+  const int16_t *m1 = s.hrow[(r >= _top + 1 ? r - 1 : _top) % 5];
+  const int16_t *p1 = s.hrow[(r + 1 <= _bot ? r + 1 : _bot) % 5];
+  const int16_t *p2 = s.hrow[(r + 2 <= _bot ? r + 2 : _bot) % 5];
+  const uint16_t rel = r - _top;
+  for (uint16_t x = 0; x < _w; x++) {
+    int32_t dy = -m2[x] - 2 * m1[x] + 2 * p1[x] + p2[x];
+    if (dy < 0)
+      dy = 0;  // nur dunkel -> hell (Label unterhalb der Kante)
+    if (rel > 0 && s.bestRow[x] == rel - 1)
+      s.bestNext[x] = (int16_t)dy;
+    if ((uint16_t)dy > s.best[x]) {
+      s.best[x] = (uint16_t)dy;
+      s.bestRow[x] = rel;
+      s.bestPrev[x] = s.prevDy[x];
+      s.bestNext[x] = (int16_t)dy;
+    }
+    s.prevDy[x] = (int16_t)dy;
+  }
+}
+
+bool EdgeScanner::pushRow(uint16_t y, const uint8_t *row) {
+  if (!_s || done())
+    return done();
+  // Nur die jeweils nächste Bandzeile annehmen (Zeilen über dem Band,
+  // doppelte oder übersprungene Zeilen werden ignoriert)
+  if (y != (_filled < 0 ? _top : _filled + 1))
+    return false;
+  filterRow(row, _band.x0, _band.x1, _s->hrow[y % 5]);
+  _filled = y;
+  // Zeile r braucht r+2 (am Bandende repliziert)
+  while (_next <= _bot && (_next + 2 <= y || y == _bot))
+    evalRow(_next++);
+  return done();
+}
+
+// Längstes Stück starker Spalten (Lücken bis EXTENT_GAP erlaubt)
+static const uint16_t EXTENT_GAP = 4;
+
+static bool strongExtent(const uint16_t *best, uint16_t w, uint32_t thr,
+                         uint16_t *lo, uint16_t *hi) {
+  bool found = false;
+  uint16_t runLo = 0, last = 0;
+  for (uint16_t x = 0; x < w; x++) {
+    if (best[x] <= thr)
+      continue;
+    if (!found || x - last > EXTENT_GAP + 1)
+      runLo = x;  // neues Stück
+    last = x;
+    if (!found || last - runLo > *hi - *lo) {
+      *lo = runLo;
+      *hi = last;
+    }
+    found = true;
+  }
+  return found;
+}
+
+Result EdgeScanner::finish(EdgeLine *line, bool fit_extent) {
+  if (!done())
+    return BAD_PARAM;
+  Scratch &s = *_s;
+
+  // Robuste Amplitudenschwelle: 0,3 × 95. Perzentil der Spaltenmaxima
+  memcpy(s.sortBuf, s.best, sizeof(uint16_t) * _w);
+  const uint16_t k = (uint16_t)(((uint32_t)(_w - 1) * 95) / 100);
+  std::nth_element(s.sortBuf, s.sortBuf + k, s.sortBuf + _w);
+  const uint32_t thr = (uint32_t)s.sortBuf[k] * 3 / 10;
+
+  uint16_t xa = 0, xb = _w - 1;
+  if (fit_extent && !strongExtent(s.best, _w, thr, &xa, &xb))
+    return EDGE_FIT_FAILED;
+  const uint16_t w = xb - xa + 1;
+
+  // Geradenfit y = a + b·x (y in Q8 mit Subpixel-Parabel), x relativ zu xa
+  const uint16_t *best = s.best + xa;
+  const uint16_t *bestRow = s.bestRow + xa;
+  const int16_t *bestPrev = s.bestPrev + xa;
+  const int16_t *bestNext = s.bestNext + xa;
+  int64_t n = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+  for (uint16_t x = 0; x < w; x++) {
+    if (best[x] <= thr)
+      continue;
+    int32_t yq8 = (int32_t)bestRow[x] << 8;
+    if (bestRow[x] > 0 && bestRow[x] + 1 < _bandH) {
+      const int32_t p = bestPrev[x], c = best[x], q = bestNext[x];
+      const int32_t den = p - 2 * c + q;
+      if (den < 0) {
+        int32_t off = ((p - q) * 128) / den;
+        off = std::max<int32_t>(-128, std::min<int32_t>(128, off));
+        yq8 += off;
+      }
+    }
+    n++;
+    sx += x;
+    sy += yq8;
+    sxx += (int64_t)x * x;
+    sxy += (int64_t)x * yq8;
+  }
+  if (n < 20 || n * 10 < (int64_t)w * 3)
+    return EDGE_FIT_FAILED;
+  const int64_t den = n * sxx - sx * sx;
+  if (den <= 0)
+    return EDGE_FIT_FAILED;
+  const int64_t b = ((n * sxy - sx * sy) * 256) / den;  // Steigung Q16
+  const int64_t a = (sy * 256 - b * sx) / n;            // Achsenabschnitt Q16
+
+  line->tl_x = toQ16(_band.x0 + xa);
+  line->tl_y = (q16_t)(toQ16(_top) + a);
+  line->tr_x = toQ16(_band.x0 + xb);
+  line->tr_y = (q16_t)(toQ16(_top) + a + b * (w - 1));
+  line->center_x = (line->tl_x + line->tr_x) / 2;
+  line->center_y = (line->tl_y + line->tr_y) / 2;
+  line->angle_deg =
+      atan2Deg(line->tr_y - line->tl_y, line->tr_x - line->tl_x);
+  line->support = (uint16_t)n;
+  return OK;
+}
+
+Result fitTopEdge(const GrayPlane &img, const Box &roi, Scratch &s,
+                  EdgeLine *line, bool fit_extent) {
+  if (roi.x1 >= img.width || roi.y1 >= img.height)
+    return BAD_PARAM;
+  EdgeScanner scan;
+  const Result r = scan.begin(roi, s);
+  if (r != OK)
+    return r;
+  for (uint16_t y = scan.firstRow(); !scan.done(); y++)
+    scan.pushRow(y, img.data + (size_t)y * img.stride);
+  return scan.finish(line, fit_extent);
+}
+
+Box topBandRoi(const Box &box, uint16_t width, uint16_t height,
+               uint8_t box_scale) {
+  const uint16_t step = 1u << box_scale;
+  const uint16_t x0 = box.x0 << box_scale;
+  const uint16_t y0 = box.y0 << box_scale;
+  const uint16_t x1 = ((box.x1 + 1) << box_scale) - 1;
+  const uint16_t y1 = ((box.y1 + 1) << box_scale) - 1;
+
+  // Oberes Analyseband wie in detect_reference_line
+  const uint16_t h = y1 - y0 + 1;
+  const uint16_t marginTop = 6 + step - 1;
+  const uint16_t bandExtra =
+      std::min<uint16_t>((uint16_t)((uint32_t)h * 4 / 10 + 20), h);
+  Box roi;
+  roi.y0 = y0 > marginTop ? y0 - marginTop : 0;
+  roi.y1 = std::min<uint16_t>(height - 1, y0 + bandExtra);
+  roi.x0 = std::min<uint16_t>(width - 1, x0);
+  roi.x1 = std::min<uint16_t>(width - 1, x1 + 1);
+  return roi;
+}
+
+Result detectTopEdge(const GrayPlane &img, Scratch &s, EdgeLine *line,
+                     Box *roi_out, bool fit_extent) {
+  Box box;
+  Result r = findLabelBox(img, s, &box);
+  if (r != OK)
+    return r;
+
+  const Box roi = topBandRoi(box, img.width, img.height);
+  if (roi_out)
+    *roi_out = roi;
+  return fitTopEdge(img, roi, s, line, fit_extent);
+}
+
+void scaleLine(EdgeLine *line, uint8_t scale) {
+  if (!scale)
+    return;
+  // Pixelmitte eines skalierten Pixels liegt bei (2^s - 1) / 2 im Vollbild
+  const q16_t half = ((1 << scale) - 1) * (Q16_ONE / 2);
+  line->tl_x = line->tl_x * (1 << scale) + half;
+  line->tl_y = line->tl_y * (1 << scale) + half;
+  line->tr_x = line->tr_x * (1 << scale) + half;
+  line->tr_y = line->tr_y * (1 << scale) + half;
+  line->center_x = (line->tl_x + line->tr_x) / 2;
+  line->center_y = (line->tl_y + line->tr_y) / 2;
+}
+
+// ========================== Vergleich ==========================
+
+Result makeReference(const EdgeLine &line, q16_t label_top_length_cm,
+                     Reference *ref) {
+  const int64_t dx = (int64_t)line.tr_x - line.tl_x;
+  const int64_t dy = (int64_t)line.tr_y - line.tl_y;
+  const int64_t len = isqrt64((uint64_t)(dx * dx + dy * dy));  // Q16
+  if (len <= Q16_ONE || label_top_length_cm <= 0)
+    return DEGENERATE;
+
+  ref->line = line;
+  ref->px_per_cm = (q16_t)((len * Q16_ONE) / label_top_length_cm);
+
+  // Tangente u, Normale n so gewählt, dass n·(0,-1) >= 0 ("nach oben")
+  const q16_t ux = (q16_t)((dx * Q16_ONE) / len);
+  const q16_t uy = (q16_t)((dy * Q16_ONE) / len);
+  if (ux <= 0) {
+    ref->n_x = -uy;
+    ref->n_y = ux;
+  } else {
+    ref->n_x = uy;
+    ref->n_y = -ux;
+  }
+  return OK;
+}
+
+static inline q16_t project(q16_t dx, q16_t dy, q16_t nx, q16_t ny) {
+  return (q16_t)(((int64_t)dx * nx + (int64_t)dy * ny) >> 16);
+}
+
+void compare(const Reference &ref, const EdgeLine &cur, Comparison *out) {
+  const EdgeLine &r = ref.line;
+  out->offset_center_px = project(cur.center_x - r.center_x,
+                                  cur.center_y - r.center_y, ref.n_x, ref.n_y);
+  out->rotation_delta_deg = normalizeDeg(cur.angle_deg - r.angle_deg);
+  out->left_offset_px =
+      project(cur.tl_x - r.tl_x, cur.tl_y - r.tl_y, ref.n_x, ref.n_y);
+  out->right_offset_px =
+      project(cur.tr_x - r.tr_x, cur.tr_y - r.tr_y, ref.n_x, ref.n_y);
+}
+
+} // namespace labelgeom
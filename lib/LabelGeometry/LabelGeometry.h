@@ -0,0 +1,163 @@
+#pragma once
+// LabelGeometry: Erkennung der oberen Labelkante und Vergleich mit einer
+// Referenz – Portierung von image_compare.py für ESP32-S3 und Host.
+//
+// Alle Rechnungen sind reine Ganzzahl-/Festkomma-Arithmetik (Q16.16).
+// Dadurch liefern Firmware und Host-Build aus denselben Pixeln bitgleiche
+// Ergebnisse; es gibt bewusst keinen Float-Pfad in der Messkette.
+// Keine Arduino-Abhängigkeit.
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace labelgeom {
+
+typedef int32_t q16_t;  // Festkomma Q16.16
+
+static const q16_t    Q16_ONE    = 65536;
+static const uint16_t MAX_WIDTH  = 1280;  // SXGA
+static const uint16_t MAX_HEIGHT = 1024;
+
+inline q16_t toQ16(int32_t v) { return v * Q16_ONE; }
+inline float toFloat(q16_t v) { return (float)v / 65536.0f; }
+
+// Ergebnis-/Fehlercodes (entsprechen den RuntimeErrors in image_compare.py)
+enum Result : uint8_t {
+  OK = 0,
+  NO_LABEL,         // "Kein Label gefunden."
+  EDGE_FIT_FAILED,  // "Kantenfit fehlgeschlagen." (kein Hough-Fallback auf der MCU)
+  DEGENERATE,       // "Obere Kante degeneriert."
+  BAD_PARAM,        // Bild größer als MAX_WIDTH/MAX_HEIGHT oder Puffer zu klein
+  DECODE_FAILED,    // JPEG nicht dekodierbar
+};
+
+const char *resultName(Result r);
+
+// 8-Bit-Graubild (Luma), zeilenweise mit stride Bytes pro Zeile
+struct GrayPlane {
+  const uint8_t *data;
+  uint16_t width;
+  uint16_t height;
+  uint16_t stride;
+};
+
+// Achsparalleles Rechteck, Grenzen inklusive
+struct Box {
+  uint16_t x0, y0, x1, y1;
+};
+
+// Obere Kante, Endpunkte auf linkem/rechtem ROI-Rand (wie _fit_top_edge_line)
+// oder mit fit_extent am Ende des Kantenstücks
+struct EdgeLine {
+  q16_t tl_x, tl_y;
+  q16_t tr_x, tr_y;
+  q16_t center_x, center_y;
+  q16_t angle_deg;
+  uint16_t support;  // Anzahl gültiger Kantenspalten im Fit
+};
+
+// Referenzgeometrie (entspricht referenzprofil.json)
+struct Reference {
+  EdgeLine line;
+  q16_t px_per_cm;
+  q16_t n_x, n_y;  // Einheitsnormale (Q16), positiv = nach oben im Bild
+};
+
+// Vergleich aktuelles Bild gegen Referenz (Pixel/Grad, Q16)
+struct Comparison {
+  q16_t offset_center_px;
+  q16_t rotation_delta_deg;
+  q16_t left_offset_px;
+  q16_t right_offset_px;
+};
+
+// Arbeitsspeicher der Erkennung (~34 KB). Einmal statisch anlegen, nicht auf
+// den Stack legen (Loop-Task hat nur 8 KB).
+struct Scratch {
+  uint32_t hist[256];
+  uint16_t rowCount[MAX_HEIGHT];
+  uint16_t colCount[MAX_WIDTH];
+  int16_t  hrow[5][MAX_WIDTH];  // horizontal gefilterte Zeilen (Ringpuffer)
+  int16_t  prevDy[MAX_WIDTH];
+  uint16_t best[MAX_WIDTH];     // stärkster positiver Gradient je Spalte
+  uint16_t bestRow[MAX_WIDTH];
+  int16_t  bestPrev[MAX_WIDTH]; // Gradient eine Zeile über/unter dem Maximum
+  int16_t  bestNext[MAX_WIDTH]; // (für Subpixel-Parabel)
+  uint16_t sortBuf[MAX_WIDTH];
+};
+
+// --- Festkomma-Hilfen ---
+uint32_t isqrt64(uint64_t v);
+q16_t atan2Deg(int32_t y, int32_t x);   // CORDIC, Ergebnis in Grad (Q16)
+q16_t normalizeDeg(q16_t deg);          // auf [-180°, 180°)
+q16_t pxToMm(q16_t px, q16_t px_per_cm);
+
+// --- Erkennung ---
+uint8_t otsuThreshold(const uint32_t hist[256]);
+
+// Grobe Label-Box: Otsu + Zeilen-/Spaltenprojektion der hellen Komponente
+Result findLabelBox(const GrayPlane &img, Scratch &s, Box *box);
+
+// Präzise obere Kante im ROI: Sobel-y im oberen Band, Spaltenmaxima mit
+// Subpixel-Parabel, Schwelle 0,3 × P95, Geradenfit (kleinste Quadrate).
+// fit_extent wie EdgeScanner::finish
+Result fitTopEdge(const GrayPlane &img, const Box &roi, Scratch &s,
+                  EdgeLine *line, bool fit_extent = false);
+
+// Analyse-ROI (detect_reference_line) zu einer Label-Box. Stammt die Box aus
+// einer auf 1/2^box_scale verkleinerten Ebene, wird sie ins volle Bild
+// umgerechnet und der obere Rand um die Quantisierung erweitert.
+Box topBandRoi(const Box &box, uint16_t width, uint16_t height,
+               uint8_t box_scale = 0);
+
+// Komplett: findLabelBox -> ROI-Band -> fitTopEdge (detect_reference_line)
+Result detectTopEdge(const GrayPlane &img, Scratch &s, EdgeLine *line,
+                     Box *roi_out = nullptr, bool fit_extent = false);
+
+// Inkrementeller Kern von fitTopEdge: nimmt Bildzeilen in aufsteigender
+// Reihenfolge entgegen (z. B. direkt aus dem JPEG-Decoder) und hält nur den
+// Ring aus 5 gefilterten Zeilen plus die Spaltenmaxima. fitTopEdge ist
+// begin() + pushRow() über das Band + finish(), daher identische Ergebnisse.
+class EdgeScanner {
+public:
+  // Band = obere 30 % des ROI (wie fitTopEdge)
+  Result begin(const Box &roi, Scratch &s);
+
+  // Band direkt vorgeben, z. B. ein vorhergesagtes Fenster (RoiTracker)
+  Result beginBand(const Box &band, Scratch &s);
+
+  // Zeile y (absolut, row[x] für x im ROI). Zeilen außerhalb des Bands werden
+  // ignoriert. Liefert true, sobald das Band vollständig ist.
+  bool pushRow(uint16_t y, const uint8_t *row);
+
+  // Schwelle + Geradenfit; erst nach done() sinnvoll. fit_extent: Endpunkte
+  // nicht an den Bandrändern, sondern am zusammenhängenden Kantenstück
+  // (Fenster ist breiter als das Label)
+  Result finish(EdgeLine *line, bool fit_extent = false);
+
+  bool done() const { return _s && _next > _bot; }
+  uint16_t firstRow() const { return _top; }
+  uint16_t lastRow() const { return _bot; }
+  const Box &band() const { return _band; }
+
+private:
+  void evalRow(uint16_t r);
+
+  Scratch *_s = nullptr;
+  Box _band = {};
+  uint16_t _w = 0;
+  uint16_t _bandH = 0;
+  uint16_t _top = 0, _bot = 0;
+  uint16_t _next = 0;    // nächste auszuwertende Bandzeile
+  int32_t _filled = -1;  // letzte horizontal gefilterte Zeile
+};
+
+// Koordinaten einer auf 1/2^scale dekodierten Ebene ins volle Sensorbild
+void scaleLine(EdgeLine *line, uint8_t scale);
+
+// --- Vergleich ---
+Result makeReference(const EdgeLine &line, q16_t label_top_length_cm,
+                     Reference *ref);
+void compare(const Reference &ref, const EdgeLine &cur, Comparison *out);
+
+} // namespace labelgeom
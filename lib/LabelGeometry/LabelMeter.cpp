@@ -0,0 +1,326 @@
+#include "LabelMeter.h"
+
+#include <algorithm>
+#include <string.h>
+
+namespace labelgeom {
+
+// Größte MCU-Höhe bei 4:2:0-Unterabtastung
+static const uint16_t MAX_MCU_HEIGHT = 16;
+
+size_t LabelMeter::planeBytes(uint16_t w, uint16_t h, uint8_t scale) {
+  const uint32_t m = (1u << scale) - 1;
+  return (size_t)((w + m) >> scale) * ((h + m) >> scale);
+}
+
+size_t LabelMeter::streamBytes(uint16_t w, uint16_t h) {
+  return planeBytes(w, h, 3) + (size_t)w * MAX_MCU_HEIGHT;
+}
+
+bool LabelMeter::begin(uint8_t *plane_buf, size_t plane_size,
+                       const MeterConfig &cfg) {
+  if (!plane_buf || cfg.scale > 3)
+    return false;
+  _buf = plane_buf;
+  _bufSize = plane_size;
+  _cfg = cfg;
+  _hasRef = false;
+  _tracker.reset();
+  return true;
+}
+
+size_t LabelMeter::jpegInput(JDEC *jd, uint8_t *buf, size_t len) {
+  LabelMeter *self = (LabelMeter *)jd->device;
+  if (self->_srcPos + len > self->_srcLen)
+    len = self->_srcLen - self->_srcPos;
+  if (buf)
+    memcpy(buf, self->_src + self->_srcPos, len);
+  self->_srcPos += len;
+  return len;
+}
+
+// RGB565-Block (w×h) -> Luma (BT.601, Ganzzahl)
+static void storeLuma(const uint16_t *px, uint16_t w, uint16_t h,
+                      uint8_t *dst, size_t stride) {
+  for (uint16_t y = 0; y < h; y++, dst += stride) {
+    for (uint16_t x = 0; x < w; x++) {
+      const uint16_t c = *px++;
+      const uint32_t r = (((c >> 11) & 0x1F) * 527 + 23) >> 6;
+      const uint32_t g = (((c >> 5) & 0x3F) * 259 + 33) >> 6;
+      const uint32_t b = ((c & 0x1F) * 527 + 23) >> 6;
+      dst[x] = (uint8_t)((77 * r + 150 * g + 29 * b + 128) >> 8);
+    }
+  }
+}
+
+int LabelMeter::jpegOutput(JDEC *jd, void *bitmap, JRECT *rect) {
+  LabelMeter *self = (LabelMeter *)jd->device;
+  const GrayPlane &p = self->_plane;
+  storeLuma((const uint16_t *)bitmap, rect->right + 1 - rect->left,
+            rect->bottom + 1 - rect->top,
+            self->_dst + (size_t)rect->top * p.stride + rect->left, p.stride);
+  return 1;
+}
+
+// Streaming: MCUs einer Zeile sammeln, vollständige MCU-Zeile an den
+// EdgeScanner geben; 0 bricht jd_decomp ab (JDR_INTR), sobald das Band fertig ist
+int LabelMeter::streamOutput(JDEC *jd, void *bitmap, JRECT *rect) {
+  LabelMeter *self = (LabelMeter *)jd->device;
+  EdgeScanner &scan = self->_scanner;
+  if (rect->bottom < scan.firstRow())
+    return 1;  // oberhalb des Bands
+
+  const Box &band = scan.band();
+  if (rect->right >= band.x0 && rect->left <= band.x1)
+    storeLuma((const uint16_t *)bitmap, rect->right + 1 - rect->left,
+              rect->bottom + 1 - rect->top, self->_rowBuf + rect->left,
+              self->_rowStride);
+  if (rect->right < jd->window.right)
+    return 1;  // MCU-Zeile (innerhalb des Dekodierfensters) noch nicht fertig
+
+  uint16_t y = rect->top > scan.firstRow() ? rect->top : scan.firstRow();
+  for (; y <= rect->bottom; y++)
+    if (scan.pushRow(y, self->_rowBuf +
+                            (size_t)(y - rect->top) * self->_rowStride))
+      return 0;
+  return 1;
+}
+
+JRESULT LabelMeter::prepare(JDEC *jd, const uint8_t *jpg, size_t len) {
+  jd->swap = 0;
+  _src = jpg;
+  _srcLen = len;
+  _srcPos = 0;
+  _jres = jd_prepare(jd, jpegInput, _work, sizeof(_work), this);
+  _srcW = _jres == JDR_OK ? jd->width : 0;
+  _srcH = _jres == JDR_OK ? jd->height : 0;
+  return _jres;
+}
+
+Result LabelMeter::decodePlane(JDEC *jd, uint8_t scale, uint8_t *buf,
+                               size_t size) {
+  const uint32_t m = (1u << scale) - 1;
+  const uint16_t pw = (uint16_t)((jd->width + m) >> scale);
+  const uint16_t ph = (uint16_t)((jd->height + m) >> scale);
+  if (pw > MAX_WIDTH || ph > MAX_HEIGHT || (size_t)pw * ph > size)
+    return BAD_PARAM;
+  _plane.data = buf;
+  _plane.width = pw;
+  _plane.height = ph;
+  _plane.stride = pw;
+
+  _dst = buf;
+  _jres = jd_decomp(jd, jpegOutput, scale);
+  return _jres == JDR_OK ? OK : DECODE_FAILED;
+}
+
+Result LabelMeter::decode(const uint8_t *jpg, size_t len) {
+  JDEC jd;
+  if (prepare(&jd, jpg, len) != JDR_OK)
+    return DECODE_FAILED;
+  return decodePlane(&jd, _cfg.scale, _buf, _bufSize);
+}
+
+// Kante liegt vollständig im Fenster (nicht an dessen Rändern abgeschnitten)
+static bool insideBand(const EdgeLine &l, const Box &band) {
+  const q16_t yMin = toQ16(band.y0 + 2), yMax = toQ16(band.y1 - 2);
+  return l.tl_x > toQ16(band.x0) && l.tr_x < toQ16(band.x1) &&
+         l.tl_y >= yMin && l.tl_y <= yMax && l.tr_y >= yMin && l.tr_y <= yMax;
+}
+
+// Voll aufgelöstes Band aus dem bereits vorbereiteten Decoder in den
+// (bereits gestarteten) EdgeScanner streamen
+Result LabelMeter::streamBand(JDEC *jd, uint8_t *row_buf, EdgeLine *line,
+                              bool fit_extent) {
+  _rowBuf = row_buf;
+  _rowStride = jd->width;
+  _jres = jd_decomp(jd, streamOutput, 0);
+  if (!_scanner.done())
+    return _jres == JDR_OK ? BAD_PARAM : DECODE_FAILED;
+  return _scanner.finish(line, fit_extent);
+}
+
+Result LabelMeter::detectStreaming(const uint8_t *jpg, size_t len,
+                                   EdgeLine *line, bool *tracked) {
+  JDEC jd;
+  if (prepare(&jd, jpg, len) != JDR_OK)
+    return DECODE_FAILED;
+  const uint16_t width = jd.width;
+  const uint16_t height = jd.height;
+  if (width > MAX_WIDTH || height > MAX_HEIGHT)
+    return BAD_PARAM;
+  const size_t coarse = planeBytes(width, height, 3);
+  if (coarse + (size_t)width * MAX_MCU_HEIGHT > _bufSize)
+    return BAD_PARAM;
+
+  // 0. Vorhergesagtes Fenster: nur dieses dekodieren (tjpgd-Fenster)
+  Box win;
+  if (_cfg.tracking && _tracker.window(width, height, &win) &&
+      _scanner.beginBand(win, _scratch) == OK) {
+    jd.window.left = win.x0;
+    jd.window.right = win.x1;
+    jd.window.top = win.y0;
+    jd.window.bottom = win.y1;
+    if (streamBand(&jd, _buf, line, true) == OK && insideBand(*line, win) &&
+        _tracker.accept(*line)) {
+      if (tracked)
+        *tracked = true;
+      return OK;
+    }
+    if (prepare(&jd, jpg, len) != JDR_OK)
+      return DECODE_FAILED;
+  }
+
+  // 1. Grobe 1/8-Ebene (tjpgd nutzt nur die DC-Koeffizienten) -> Label-Box
+  Result r = decodePlane(&jd, 3, _buf, coarse);
+  if (r != OK)
+    return r;
+  Box box;
+  r = findLabelBox(_plane, _scratch, &box);
+  if (r != OK)
+    return r;
+  r = _scanner.begin(topBandRoi(box, width, height, 3), _scratch);
+  if (r != OK)
+    return r;
+
+  // 2. Volle Auflösung nur im Band (tjpgd-Fenster), danach Abbruch. Mit
+  // Tracking Endpunkte wie im Fenster, sonst springen sie beim Einrasten
+  if (prepare(&jd, jpg, len) != JDR_OK)
+    return DECODE_FAILED;
+  const Box &band = _scanner.band();
+  jd.window.left = band.x0;
+  jd.window.right = band.x1;
+  jd.window.top = band.y0;
+  jd.window.bottom = band.y1;
+  return streamBand(&jd, _buf + coarse, line, _cfg.tracking);
+}
+
+Result LabelMeter::detectPlane(EdgeLine *line, bool *tracked) {
+  // Vorhergesagtes Fenster zuerst, nur bei Fehlschlag das ganze Bild
+  Box win;
+  if (_cfg.tracking && _tracker.window(_srcW, _srcH, &win)) {
+    const uint8_t s = _cfg.scale;
+    Box band;
+    band.x0 = win.x0 >> s;
+    band.y0 = win.y0 >> s;
+    band.x1 = std::min<uint16_t>(win.x1 >> s, _plane.width - 1);
+    band.y1 = std::min<uint16_t>(win.y1 >> s, _plane.height - 1);
+    if (_scanner.beginBand(band, _scratch) == OK) {
+      for (uint16_t y = band.y0; !_scanner.done(); y++)
+        _scanner.pushRow(y, _plane.data + (size_t)y * _plane.stride);
+      if (_scanner.finish(line, true) == OK && insideBand(*line, band)) {
+        scaleLine(line, s);
+        if (_tracker.accept(*line)) {
+          if (tracked)
+            *tracked = true;
+          return OK;
+        }
+      }
+    }
+  }
+  const Result r = detectTopEdge(_plane, _scratch, line, nullptr, _cfg.tracking);
+  if (r == OK)
+    scaleLine(line, _cfg.scale);
+  return r;
+}
+
+// Kante so, wie sie im Messdatensatz steht (Vollbild-Koordinaten)
+static EdgeLine lineFromRecord(const camlink::MeasurementRecord &rec) {
+  EdgeLine l = {};
+  l.tl_x = rec.tl_x;
+  l.tl_y = rec.tl_y;
+  l.tr_x = rec.tr_x;
+  l.tr_y = rec.tr_y;
+  l.center_x = (l.tl_x + l.tr_x) / 2;
+  l.center_y = (l.tl_y + l.tr_y) / 2;
+  l.angle_deg = rec.angle_deg;
+  return l;
+}
+
+// Tracker ausschließlich aus dem Messdatensatz fortschreiben; dadurch kann
+// replay() den Zustand auch für Frames ohne gespeichertes JPEG nachbilden
+void LabelMeter::track(const camlink::MeasurementRecord &rec) {
+  if (!_cfg.tracking)
+    return;
+  const bool hit = (rec.flags & camlink::MEAS_TRACKED) != 0;
+  if (_tracker.locked() && !hit)
+    _tracker.miss();
+  if (rec.flags & camlink::MEAS_VALID)
+    _tracker.update(lineFromRecord(rec), hit);
+}
+
+void LabelMeter::replay(const camlink::MeasurementRecord &rec) {
+  if (_cfg.tracking)
+    _tracker.predict();
+  if ((rec.flags & camlink::MEAS_REFERENCE) && !_hasRef &&
+      makeReference(lineFromRecord(rec), _cfg.label_top_length_cm, &_ref) ==
+          OK)
+    _hasRef = true;
+  track(rec);
+}
+
+void LabelMeter::measure(const uint8_t *jpg, size_t len, uint32_t seq,
+                         uint32_t t_ms, camlink::MeasurementRecord *rec) {
+  memset(rec, 0, sizeof(*rec));
+  rec->seq = seq;
+  rec->t_ms = t_ms;
+  rec->scale = _cfg.scale;
+  if (_cfg.tracking)
+    _tracker.predict();
+
+  Result r;
+  EdgeLine line;
+  bool tracked = false;
+  if (_cfg.streaming) {
+    rec->scale = 0;
+    rec->flags |= camlink::MEAS_STREAMED;
+    r = detectStreaming(jpg, len, &line, &tracked);
+  } else {
+    r = decode(jpg, len);
+    if (r == OK)
+      r = detectPlane(&line, &tracked);
+  }
+  if (tracked)
+    rec->flags |= camlink::MEAS_TRACKED;
+  if (r == OK) {
+    if (!_hasRef) {
+      r = makeReference(line, _cfg.label_top_length_cm, &_ref);
+      if (r == OK) {
+        _hasRef = true;
+        rec->flags |= camlink::MEAS_REFERENCE;
+      }
+    }
+  }
+  rec->status = r;
+  if (r != OK) {
+    rec->flags |= camlink::MEAS_ANOMALY;
+    track(*rec);
+    return;
+  }
+
+  rec->flags |= camlink::MEAS_VALID;
+  rec->tl_x = line.tl_x;
+  rec->tl_y = line.tl_y;
+  rec->tr_x = line.tr_x;
+  rec->tr_y = line.tr_y;
+  rec->angle_deg = line.angle_deg;
+  rec->px_per_cm = _ref.px_per_cm;
+
+  Comparison c;
+  compare(_ref, line, &c);
+  rec->offset_center_px = c.offset_center_px;
+  rec->rotation_delta_deg = c.rotation_delta_deg;
+  rec->left_offset_px = c.left_offset_px;
+  rec->right_offset_px = c.right_offset_px;
+
+  const q16_t off_mm = pxToMm(c.offset_center_px, _ref.px_per_cm);
+  if ((_cfg.anomaly_offset_mm &&
+       (off_mm > _cfg.anomaly_offset_mm || off_mm < -_cfg.anomaly_offset_mm)) ||
+      (_cfg.anomaly_rotation_deg &&
+       (c.rotation_delta_deg > _cfg.anomaly_rotation_deg ||
+        c.rotation_delta_deg < -_cfg.anomaly_rotation_deg)))
+    rec->flags |= camlink::MEAS_ANOMALY;
+  track(*rec);
+}
+
+} // namespace labelgeom
@@ -0,0 +1,105 @@
+#pragma once
+// LabelMeter: JPEG -> Luma -> obere Kante -> Vergleich mit Referenz ->
+// camlink::MeasurementRecord. Dieselbe Klasse läuft auf dem ESP32-S3 (Messmodus
+// in main.cpp) und im Host-Werkzeug src/host/label_measure.cpp; damit sind
+// die Messwerte aus aufgezeichneten Frames bitgleich reproduzierbar.
+//
+// Zwei Betriebsarten:
+//  - Ebene:     ganzes Bild auf 1/2^scale in einen Luma-Puffer dekodieren
+//  - Streaming: 1/8-Vorschau (nur DC, keine IDCT) für die Label-Box, dann
+//               volle Auflösung MCU-Zeile für MCU-Zeile direkt in den
+//               EdgeScanner; Abbruch der Dekodierung nach der letzten
+//               Bandzeile. Speicher: streamBytes() statt Vollbild.
+//
+// Mit tracking sagt ein RoiTracker das Kantenfenster des nächsten Frames
+// voraus. Streaming dekodiert dann nur dieses Fenster (ohne 1/8-Vorschau),
+// die Ebene wird nur im Fenster durchsucht. Wird die Kante dort nicht
+// vollständig gefunden, folgt im selben Frame die normale Suche.
+
+#include "CamLink.h"
+#include "LabelGeometry.h"
+#include "RoiTracker.h"
+#include "tjpgd.h"
+
+namespace labelgeom {
+
+struct MeterConfig {
+  q16_t   label_top_length_cm;   // reale Länge der oberen Kante (LABEL_TOP_LENGTH_CM)
+  uint8_t scale;                 // Dekodier-Skalierung 0..3 (1/1 .. 1/8)
+  q16_t   anomaly_offset_mm;     // |Abstand| darüber -> MEAS_ANOMALY (0 = aus)
+  q16_t   anomaly_rotation_deg;  // |Rotation| darüber -> MEAS_ANOMALY (0 = aus)
+  bool    streaming;             // Streaming-Modus (scale wird ignoriert)
+  bool    tracking;              // Suchfenster aus RoiTracker-Vorhersage
+};
+
+class LabelMeter {
+public:
+  // Benötigte Größe des Luma-Puffers für ein Bild w×h bei gegebener Skalierung
+  static size_t planeBytes(uint16_t w, uint16_t h, uint8_t scale);
+
+  // Benötigte Puffergröße im Streaming-Modus (1/8-Ebene + eine MCU-Zeile)
+  static size_t streamBytes(uint16_t w, uint16_t h);
+
+  // plane_buf gehört dem Aufrufer (auf dem ESP32 typischerweise PSRAM,
+  // im Streaming-Modus reicht interner RAM)
+  bool begin(uint8_t *plane_buf, size_t plane_size, const MeterConfig &cfg);
+
+  // JPEG mit tjpgd in die Luma-Ebene dekodieren (Skalierung aus cfg)
+  Result decode(const uint8_t *jpg, size_t len);
+
+  // Obere Kante im Streaming-Modus in voller Auflösung; tracked = im
+  // vorhergesagten Fenster gefunden
+  Result detectStreaming(const uint8_t *jpg, size_t len, EdgeLine *line,
+                         bool *tracked = nullptr);
+
+  // Ein Frame messen. Der erste gültige Frame wird zur Referenz
+  // (MEAS_REFERENCE); MEAS_JPEG_FOLLOWS setzt der Aufrufer.
+  void measure(const uint8_t *jpg, size_t len, uint32_t seq, uint32_t t_ms,
+               camlink::MeasurementRecord *rec);
+
+  // Zustand (Referenz, Tracker) aus einem aufgezeichneten Datensatz
+  // fortschreiben, ohne zu messen – für Frames ohne gespeichertes JPEG
+  void replay(const camlink::MeasurementRecord &rec);
+
+  bool hasReference() const { return _hasRef; }
+  void clearReference() { _hasRef = false; }
+  const Reference &reference() const { return _ref; }
+  const GrayPlane &plane() const { return _plane; }
+  const MeterConfig &config() const { return _cfg; }
+  const RoiTracker &tracker() const { return _tracker; }
+  JRESULT lastJpegResult() const { return _jres; }
+
+private:
+  static size_t jpegInput(JDEC *jd, uint8_t *buf, size_t len);
+  static int jpegOutput(JDEC *jd, void *bitmap, JRECT *rect);
+  static int streamOutput(JDEC *jd, void *bitmap, JRECT *rect);
+
+  JRESULT prepare(JDEC *jd, const uint8_t *jpg, size_t len);
+  Result decodePlane(JDEC *jd, uint8_t scale, uint8_t *buf, size_t size);
+  Result streamBand(JDEC *jd, uint8_t *row_buf, EdgeLine *line,
+                    bool fit_extent);
+  Result detectPlane(EdgeLine *line, bool *tracked);
+  void track(const camlink::MeasurementRecord &rec);
+
+  MeterConfig _cfg = {};
+  uint8_t *_buf = nullptr;
+  size_t _bufSize = 0;
+  GrayPlane _plane = {};
+  uint8_t *_dst = nullptr;     // Ziel von jpegOutput
+  Scratch _scratch;
+  Reference _ref = {};
+  EdgeScanner _scanner;
+  RoiTracker _tracker;
+  uint8_t *_rowBuf = nullptr;  // eine MCU-Zeile Luma (Streaming)
+  uint16_t _rowStride = 0;
+  bool _hasRef = false;
+  JRESULT _jres = JDR_OK;
+
+  const uint8_t *_src = nullptr;  // Eingabe-Cursor für tjpgd
+  size_t _srcLen = 0;
+  size_t _srcPos = 0;
+  uint16_t _srcW = 0, _srcH = 0;  // Bildgröße laut JPEG-Kopf
+  uint8_t _work[TJPGD_WORKSPACE_SIZE] __attribute__((aligned(4)));
+};
+
+} // namespace labelgeom
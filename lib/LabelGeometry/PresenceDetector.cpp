@@ -0,0 +1,157 @@
+#include "PresenceDetector.h"
+
+#include <string.h>
+
+namespace labelgeom {
+
+const PresenceConfig PresenceDetector::DEFAULT_CONFIG = {
+    150,  // min_luma
+    40,   // max_chroma
+    256,  // min_blocks (~128×128 px)
+    4,    // min_line
+};
+
+const char *presenceName(Presence p) {
+  switch (p) {
+  case LABEL_ABSENT:  return "leer";
+  case LABEL_PRESENT: return "Label";
+  case LABEL_PARTIAL: return "Label angeschnitten";
+  }
+  return "?";
+}
+
+size_t PresenceDetector::thumbBytes(uint16_t w, uint16_t h, uint8_t mcu_px) {
+  const size_t luma = (size_t)((w + 7) / 8) * ((h + 7) / 8);
+  const size_t chroma = (size_t)((w + mcu_px - 1) / mcu_px) *
+                        ((h + mcu_px - 1) / mcu_px);
+  return luma + 2 * chroma;
+}
+
+bool PresenceDetector::begin(uint8_t *thumb_buf, size_t thumb_size,
+                             const PresenceConfig &cfg) {
+  if (!thumb_buf)
+    return false;
+  _buf = thumb_buf;
+  _bufSize = thumb_size;
+  _cfg = cfg;
+  return true;
+}
+
+size_t PresenceDetector::jpegInput(JDEC *jd, uint8_t *buf, size_t len) {
+  PresenceDetector *self = (PresenceDetector *)jd->device;
+  if (self->_srcPos + len > self->_srcLen)
+    len = self->_srcLen - self->_srcPos;
+  if (buf)
+    memcpy(buf, self->_src + self->_srcPos, len);
+  self->_srcPos += len;
+  return len;
+}
+
+// Quantisierter DC -> Blockmittelwert 0..255 (F(0,0) = 8 × Mittel - 1024)
+static inline uint8_t dcLevel(int32_t dc, int32_t q0) {
+  const int32_t v = 128 + ((dc * q0 + 4) >> 3);
+  return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+int PresenceDetector::coefOutput(JDEC *jd, const int16_t *coef,
+                                 unsigned int x, unsigned int y) {
+  PresenceDetector *self = (PresenceDetector *)jd->device;
+  const GrayPlane &yp = self->_y;
+  uint8_t *ydata = (uint8_t *)yp.data;
+  const unsigned int nby = jd->msx * jd->msy;
+  for (unsigned int b = 0; b < nby; b++) {
+    const unsigned int bx = x / 8 + b % jd->msx;
+    const unsigned int by = y / 8 + b / jd->msx;
+    if (bx < yp.width && by < yp.height)
+      ydata[by * yp.stride + bx] = dcLevel(coef[b * 64], self->_q0[0]);
+  }
+  const size_t m = (size_t)(y / (jd->msy * 8)) * self->_cb.stride +
+                   x / (jd->msx * 8);
+  ((uint8_t *)self->_cb.data)[m] =
+      jd->ncomp == 3 ? dcLevel(coef[nby * 64], self->_q0[1]) : 128;
+  ((uint8_t *)self->_cr.data)[m] =
+      jd->ncomp == 3 ? dcLevel(coef[(nby + 1) * 64], self->_q0[2]) : 128;
+  return 1;
+}
+
+Presence PresenceDetector::detect(const uint8_t *jpg, size_t len) {
+  _blocks = 0;
+  _box = {};
+  memset(_hist, 0, sizeof(_hist));
+  JDEC jd;
+  jd.swap = 0;
+  _src = jpg;
+  _srcLen = len;
+  _srcPos = 0;
+  _jres = jd_prepare(&jd, jpegInput, _work, sizeof(_work), this);
+  if (_jres != JDR_OK)
+    return LABEL_PRESENT;  // im Zweifel normal verarbeiten
+
+  const uint16_t mx = jd.msx * 8, my = jd.msy * 8;
+  const uint16_t bw = (jd.width + 7) / 8, bh = (jd.height + 7) / 8;
+  const uint16_t cw = (jd.width + mx - 1) / mx, ch = (jd.height + my - 1) / my;
+  if (bw > MAX_WIDTH / 8 || bh > MAX_HEIGHT / 8 ||
+      (size_t)bw * bh + 2 * (size_t)cw * ch > _bufSize) {
+    _jres = JDR_PAR;
+    return LABEL_PRESENT;
+  }
+  _y = {_buf, bw, bh, bw};
+  _cb = {_buf + (size_t)bw * bh, cw, ch, cw};
+  _cr = {_cb.data + (size_t)cw * ch, cw, ch, cw};
+  // tjpgd hält die Quantisierer mit dem Arai-Faktor (DC: 1.0 · 2^13)
+  for (uint8_t c = 0; c < 3; c++)
+    _q0[c] = c < jd.ncomp ? jd.qttbl[jd.qtid[c]][0] >> 13 : 0;
+
+  _jres = jd_scan(&jd, coefOutput, _coef);
+  if (_jres != JDR_OK)
+    return LABEL_PRESENT;
+
+  // Helle, farbneutrale Blöcke zählen und projizieren
+  memset(_rowCount, 0, bh * sizeof(_rowCount[0]));
+  memset(_colCount, 0, bw * sizeof(_colCount[0]));
+  const uint8_t sx = jd.msx - 1, sy = jd.msy - 1;  // Block -> MCU: >> 0/1
+  for (uint16_t by = 0; by < bh; by++) {
+    const uint8_t *yr = _y.data + (size_t)by * _y.stride;
+    const size_t crow = (size_t)(by >> sy) * _cb.stride;
+    for (uint16_t bx = 0; bx < bw; bx++) {
+      _hist[yr[bx]]++;
+      if (yr[bx] < _cfg.min_luma)
+        continue;
+      const int32_t dcb = _cb.data[crow + (bx >> sx)] - 128;
+      const int32_t dcr = _cr.data[crow + (bx >> sx)] - 128;
+      if ((dcb < 0 ? -dcb : dcb) + (dcr < 0 ? -dcr : dcr) > _cfg.max_chroma)
+        continue;
+      _blocks++;
+      _rowCount[by]++;
+      _colCount[bx]++;
+    }
+  }
+  if (_blocks < _cfg.min_blocks)
+    return LABEL_ABSENT;
+
+  // Hülle aus Zeilen/Spalten mit genügend Labelblöcken
+  int32_t r0 = -1, r1 = -1, c0 = -1, c1 = -1;
+  for (uint16_t i = 0; i < bh; i++)
+    if (_rowCount[i] >= _cfg.min_line) {
+      if (r0 < 0)
+        r0 = i;
+      r1 = i;
+    }
+  for (uint16_t i = 0; i < bw; i++)
+    if (_colCount[i] >= _cfg.min_line) {
+      if (c0 < 0)
+        c0 = i;
+      c1 = i;
+    }
+  if (r0 < 0 || c0 < 0)
+    return LABEL_ABSENT;
+  _box.x0 = (uint16_t)(c0 * 8);
+  _box.y0 = (uint16_t)(r0 * 8);
+  _box.x1 = (uint16_t)(c1 * 8 + 7 < jd.width ? c1 * 8 + 7 : jd.width - 1);
+  _box.y1 = (uint16_t)(r1 * 8 + 7 < jd.height ? r1 * 8 + 7 : jd.height - 1);
+  if (r0 == 0 || c0 == 0 || r1 == bh - 1 || c1 == bw - 1)
+    return LABEL_PARTIAL;
+  return LABEL_PRESENT;
+}
+
+} // namespace labelgeom
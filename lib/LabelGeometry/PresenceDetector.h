@@ -0,0 +1,85 @@
+#pragma once
+// PresenceDetector: Liegt überhaupt ein Label im Bild?
+//
+// Liest mit jd_scan nur die Huffman-Daten und verwendet je 8×8-Block den
+// DC-Koeffizienten (Blockmittelwert, keine IDCT, keine Farbkonvertierung).
+// Daraus entsteht ein Vorschaubild: Luma in 1/8, Cb/Cr in MCU-Auflösung.
+// Ein Block zählt als Label, wenn er hell und farbneutral ist (weißes Label
+// auf blauem Band). Liegen zu wenige solche Blöcke im Bild, ist der Frame
+// leer; berührt ihre Hülle den Bildrand, ragt das Label aus dem Bild.
+//
+// Nebenprodukt: Histogramm der Luma-Vorschau (z. B. für die Belichtung).
+//
+// Wie LabelGeometry reine Ganzzahlrechnung, Firmware und Host entscheiden
+// identisch.
+
+#include "LabelGeometry.h"
+#include "tjpgd.h"
+
+namespace labelgeom {
+
+enum Presence : uint8_t {
+  LABEL_ABSENT = 0,  // leeres Band (Lücke, Fehlauslösung)
+  LABEL_PRESENT,     // Label vollständig im Bild
+  LABEL_PARTIAL,     // Label angeschnitten (berührt den Bildrand)
+};
+
+const char *presenceName(Presence p);
+
+struct PresenceConfig {
+  uint8_t  min_luma;     // Blockmittel Y ab hier "hell"
+  uint8_t  max_chroma;   // |Cb-128| + |Cr-128| bis hier "farbneutral"
+  uint16_t min_blocks;   // so viele Labelblöcke mindestens (8×8 px)
+  uint8_t  min_line;     // Zeilen/Spalten mit weniger Blöcken zählen nicht
+                         // zur Hülle (Glanzpunkte, Rauschen)
+};
+
+class PresenceDetector {
+public:
+  static const PresenceConfig DEFAULT_CONFIG;
+
+  // Puffergröße der Vorschau für ein Bild w×h mit MCU-Kantenlänge mcu_px
+  // (16 bei 4:2:0, 8 bei 4:4:4)
+  static size_t thumbBytes(uint16_t w, uint16_t h, uint8_t mcu_px = 16);
+
+  bool begin(uint8_t *thumb_buf, size_t thumb_size,
+             const PresenceConfig &cfg = DEFAULT_CONFIG);
+
+  // Nicht lesbares JPEG oder zu kleiner Puffer -> LABEL_PRESENT (der Frame
+  // wird normal verarbeitet), Ursache in lastJpegResult()
+  Presence detect(const uint8_t *jpg, size_t len);
+
+  // Ergebnis des letzten detect()
+  uint32_t labelBlocks() const { return _blocks; }
+  const Box &labelBox() const { return _box; }  // Vollbild-Pixel
+  const GrayPlane &luma() const { return _y; }  // 1/8
+  const GrayPlane &cb() const { return _cb; }   // MCU-Auflösung
+  const GrayPlane &cr() const { return _cr; }
+  const uint32_t *histogram() const { return _hist; }  // Luma-Vorschau, 256 Werte
+  JRESULT lastJpegResult() const { return _jres; }
+
+private:
+  static size_t jpegInput(JDEC *jd, uint8_t *buf, size_t len);
+  static int coefOutput(JDEC *jd, const int16_t *coef, unsigned int x,
+                        unsigned int y);
+
+  PresenceConfig _cfg = {};
+  uint8_t *_buf = nullptr;
+  size_t _bufSize = 0;
+  GrayPlane _y = {}, _cb = {}, _cr = {};
+  int32_t _q0[3] = {};  // DC-Quantisierer Y, Cb, Cr
+  uint32_t _blocks = 0;
+  Box _box = {};
+  uint32_t _hist[256] = {};
+  uint16_t _rowCount[MAX_HEIGHT / 8];
+  uint16_t _colCount[MAX_WIDTH / 8];
+  JRESULT _jres = JDR_OK;
+
+  const uint8_t *_src = nullptr;
+  size_t _srcLen = 0;
+  size_t _srcPos = 0;
+  int16_t _coef[6 * 64] __attribute__((aligned(4)));
+  uint8_t _work[TJPGD_WORKSPACE_SIZE] __attribute__((aligned(4)));
+};
+
+} // namespace labelgeom
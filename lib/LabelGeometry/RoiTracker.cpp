@@ -0,0 +1,136 @@
+#include "RoiTracker.h"
+
+#include <algorithm>
+
+namespace labelgeom {
+
+// Startunsicherheit nach (Neu-)Erfassung: (16 px)² bzw. (8 px/Frame)²
+static const int64_t INIT_POS_VAR = (int64_t)256 * Q16_ONE;
+static const int64_t INIT_VEL_VAR = (int64_t)64 * Q16_ONE;
+
+void RoiTracker::Axis::init(q16_t z) {
+  p = z;
+  v = 0;
+  P00 = INIT_POS_VAR;
+  P01 = 0;
+  P11 = INIT_VEL_VAR;
+}
+
+// x' = F x, P' = F P Fᵀ + Q mit F = [1 1; 0 1], Q = q·[1/4 1/2; 1/2 1]
+void RoiTracker::Axis::predict() {
+  p += v;
+  P00 += 2 * P01 + P11 + ACCEL_VAR / 4;
+  P01 += P11 + ACCEL_VAR / 2;
+  P11 += ACCEL_VAR;
+}
+
+void RoiTracker::Axis::update(q16_t z) {
+  const int64_t S = P00 + MEAS_VAR;
+  const int64_t k0 = (P00 << 16) / S;  // Kalman-Gewinne Q16
+  const int64_t k1 = (P01 << 16) / S;
+  const int64_t inn = (int64_t)z - p;
+  p += (k0 * inn) >> 16;
+  v += (k1 * inn) >> 16;
+  P11 -= (k1 * P01) >> 16;
+  P01 -= (k0 * P01) >> 16;
+  P00 -= (k0 * P00) >> 16;
+}
+
+uint32_t RoiTracker::Axis::gate() const {
+  const uint64_t S = (uint64_t)(P00 + MEAS_VAR);
+  return (3 * isqrt64(S << 16) + Q16_ONE - 1) >> 16;  // aufrunden
+}
+
+void RoiTracker::reset() {
+  _locked = false;
+  _misses = 0;
+}
+
+void RoiTracker::predict() {
+  if (!_locked)
+    return;
+  _tlx.predict();
+  _tly.predict();
+  _trx.predict();
+  _try.predict();
+}
+
+static inline int32_t q16Round(int64_t v) {
+  return (int32_t)((v + Q16_ONE / 2) >> 16);
+}
+
+int32_t RoiTracker::gateX() const {
+  return (int32_t)(std::max<uint32_t>(MIN_GATE_X,
+                                      std::max(_tlx.gate(), _trx.gate()))
+                   << _misses);
+}
+
+int32_t RoiTracker::gateY() const {
+  return (int32_t)(std::max<uint32_t>(MIN_GATE_Y,
+                                      std::max(_tly.gate(), _try.gate()))
+                   << _misses);
+}
+
+bool RoiTracker::window(uint16_t width, uint16_t height, Box *win) const {
+  if (!_locked)
+    return false;
+  const int32_t gy = gateY();
+  const int32_t gx = gateX();
+
+  // +2 Zeilen für die vertikale Filterstütze des Sobel-Kerns
+  int32_t y0 = std::min(q16Round(_tly.p), q16Round(_try.p)) - gy - 2;
+  int32_t y1 = std::max(q16Round(_tly.p), q16Round(_try.p)) + gy + 2;
+  int32_t x0 = q16Round(_tlx.p) - gx;
+  int32_t x1 = q16Round(_trx.p) + gx;
+  y0 = std::max<int32_t>(0, y0);
+  x0 = std::max<int32_t>(0, x0);
+  y1 = std::min<int32_t>(height - 1, y1);
+  x1 = std::min<int32_t>(width - 1, x1);
+  if (x1 - x0 < 16 || y1 - y0 < 10)
+    return false;
+  win->x0 = (uint16_t)x0;
+  win->y0 = (uint16_t)y0;
+  win->x1 = (uint16_t)x1;
+  win->y1 = (uint16_t)y1;
+  return true;
+}
+
+static inline bool within(int64_t pred, q16_t z, int32_t gate_px) {
+  const int64_t d = (int64_t)z - pred;
+  const int64_t g = (int64_t)gate_px << 16;
+  return d <= g && d >= -g;
+}
+
+bool RoiTracker::accept(const EdgeLine &line) const {
+  if (!_locked)
+    return false;
+  const int32_t gx = gateX(), gy = gateY();
+  return within(_tlx.p, line.tl_x, gx) && within(_trx.p, line.tr_x, gx) &&
+         within(_tly.p, line.tl_y, gy) && within(_try.p, line.tr_y, gy);
+}
+
+void RoiTracker::update(const EdgeLine &line, bool hit) {
+  if (!_locked || !hit) {
+    // (Neu-)Erfassung; _misses bleibt, bis wieder ein Fenstertreffer kommt
+    _tlx.init(line.tl_x);
+    _tly.init(line.tl_y);
+    _trx.init(line.tr_x);
+    _try.init(line.tr_y);
+    _locked = true;
+    return;
+  }
+  _tlx.update(line.tl_x);
+  _tly.update(line.tl_y);
+  _trx.update(line.tr_x);
+  _try.update(line.tr_y);
+  _misses = 0;
+}
+
+void RoiTracker::miss() {
+  if (!_locked)
+    return;
+  if (++_misses > MAX_MISSES)
+    reset();
+}
+
+} // namespace labelgeom
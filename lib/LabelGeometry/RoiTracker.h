@@ -0,0 +1,64 @@
+#pragma once
+// RoiTracker: Bewegungsmodell der oberen Labelkante über mehrere Frames.
+//
+// Je ein Kalman-Filter mit konstanter Geschwindigkeit für tl_x, tl_y, tr_x,
+// tr_y (Zeitschritt = ein Frame). Aus der Vorhersage entsteht ein enges
+// Suchfenster für den nächsten Frame; jeder Fehlschlag verdoppelt die
+// Fensterreserve. Eine Kante, die nach einem Fehlschlag durch die volle
+// Suche gefunden wurde, setzt das Modell neu auf; nach mehr als MAX_MISSES
+// Fehlschlägen in Folge wird kein Fenster mehr vorhergesagt.
+//
+// Wie LabelGeometry reine Ganzzahlrechnung (Zustand Q16, Kovarianz Q16 px²),
+// damit Host und Firmware dieselben Fenster berechnen.
+
+#include "LabelGeometry.h"
+
+namespace labelgeom {
+
+class RoiTracker {
+public:
+  static constexpr uint8_t  MAX_MISSES = 3;       // danach Neuerfassung
+  static constexpr q16_t    ACCEL_VAR  = 65536;   // Prozessrauschen (1 px/Frame²)²
+  static constexpr q16_t    MEAS_VAR   = 4 * 65536;  // Messrauschen (2 px)²
+  static constexpr uint16_t MIN_GATE_Y = 8;       // minimale Reserve oben/unten [px]
+  static constexpr uint16_t MIN_GATE_X = 16;      // minimale Reserve links/rechts [px]
+
+  void reset();
+  bool locked() const { return _locked; }
+  uint8_t misses() const { return _misses; }
+
+  // Zeitschritt auf den aktuellen Frame; einmal pro Frame vor window()
+  void predict();
+
+  // Suchfenster (Vollbild-Pixel, Grenzen inklusive). false = kein Modell
+  bool window(uint16_t width, uint16_t height, Box *win) const;
+
+  // Validierungstor: alle Eckkoordinaten innerhalb der Fensterreserve
+  bool accept(const EdgeLine &line) const;
+
+  // Gemessene Kante (Vollbild). hit = im vorhergesagten Fenster gefunden und
+  // akzeptiert -> Kalman-Update; sonst Neuaufsetzen an dieser Kante
+  void update(const EdgeLine &line, bool hit);
+
+  // Kante im Fenster nicht gefunden -> Fenster verbreitern / Neuerfassung
+  void miss();
+
+private:
+  struct Axis {
+    int64_t p, v;          // Position [Q16 px], Geschwindigkeit [Q16 px/Frame]
+    int64_t P00, P01, P11; // Kovarianz [Q16]
+    void init(q16_t z);
+    void predict();
+    void update(q16_t z);
+    uint32_t gate() const; // 3·sqrt(P00 + R) [px]
+  };
+
+  int32_t gateX() const;   // Reserve inkl. Verbreiterung [px]
+  int32_t gateY() const;
+
+  Axis _tlx = {}, _tly = {}, _trx = {}, _try = {};
+  bool _locked = false;
+  uint8_t _misses = 0;
+};
+
+} // namespace labelgeom
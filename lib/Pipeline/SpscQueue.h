@@ -0,0 +1,68 @@
+#pragma once
+// SpscQueue: wartefreier Ring für genau einen Erzeuger und einen Verbraucher.
+//
+// Zwischen zwei Pipeline-Stufen (eigene Tasks, ggf. auf verschiedenen
+// Kernen) werden nur kleine Deskriptoren (z. B. Slot-Indizes) übergeben.
+// push()/pop() brauchen keine Sperre: Kopf und Ende gehören je genau einer
+// Seite und werden mit acquire/release veröffentlicht. Das Aufwecken des
+// wartenden Tasks (Task-Notification) übernimmt der Aufrufer.
+//
+// Zähler für die Engpasssuche: aktuelle Tiefe, Höchststand, abgewiesene
+// push() (Ring voll = Verbraucher zu langsam).
+//
+// Keine Arduino-Abhängigkeit; N muss eine Zweierpotenz sein.
+
+#include <stdint.h>
+
+#include <atomic>
+
+namespace pipeline {
+
+template <typename T, uint8_t N> class SpscQueue {
+  static_assert(N && (N & (N - 1)) == 0, "N muss eine Zweierpotenz sein");
+
+public:
+  // Nur Erzeuger
+  bool push(const T &v) {
+    const uint32_t tail = _tail.load(std::memory_order_relaxed);
+    const uint32_t head = _head.load(std::memory_order_acquire);
+    if (tail - head == N) {
+      _full.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    _buf[tail & (N - 1)] = v;
+    _tail.store(tail + 1, std::memory_order_release);
+    const uint8_t depth = (uint8_t)(tail + 1 - head);
+    if (depth > _high.load(std::memory_order_relaxed))
+      _high.store(depth, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Nur Verbraucher
+  bool pop(T *v) {
+    const uint32_t head = _head.load(std::memory_order_relaxed);
+    if (head == _tail.load(std::memory_order_acquire))
+      return false;
+    *v = _buf[head & (N - 1)];
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Von beiden Seiten und von außen lesbar (Momentaufnahme)
+  uint8_t depth() const {
+    return (uint8_t)(_tail.load(std::memory_order_acquire) -
+                     _head.load(std::memory_order_acquire));
+  }
+  uint8_t highWater() const { return _high.load(std::memory_order_relaxed); }
+  uint32_t fullCount() const { return _full.load(std::memory_order_relaxed); }
+  static constexpr uint8_t capacity() { return N; }
+
+private:
+  T _buf[N];
+  std::atomic<uint32_t> _head{0};  // nächster zu lesender Eintrag
+  std::atomic<uint32_t> _tail{0};  // nächster zu schreibender Eintrag
+  std::atomic<uint8_t> _high{0};
+  std::atomic<uint32_t> _full{0};
+};
+
+} // namespace pipeline
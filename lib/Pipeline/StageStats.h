@@ -0,0 +1,45 @@
+#pragma once
+// StageStats: Auslastung einer Pipeline-Stufe.
+//
+// Jede Stufe verbucht ihre Zeit in drei Töpfe: busy (arbeitet), stall (fertig,
+// aber die nächste Stufe nimmt nichts ab bzw. kein freier Slot) und den Rest
+// (wartet auf Eingang). Hohe busy-Anteile markieren den Engpass, stall zeigt
+// dessen Rückstau in den Stufen davor. Geschrieben nur vom eigenen Task,
+// gelesen (und zurückgesetzt) vom meldenden Task.
+//
+// Keine Arduino-Abhängigkeit.
+
+#include <stdint.h>
+
+#include <atomic>
+
+namespace pipeline {
+
+struct StageSnapshot {
+  uint32_t frames;    // bearbeitete Frames
+  uint32_t busy_us;   // Zeit in Arbeit
+  uint32_t stall_us;  // Zeit mit blockierter Ausgabe
+};
+
+class StageStats {
+public:
+  void addBusy(uint32_t us) { _busy.fetch_add(us, std::memory_order_relaxed); }
+  void addStall(uint32_t us) { _stall.fetch_add(us, std::memory_order_relaxed); }
+  void addFrame() { _frames.fetch_add(1, std::memory_order_relaxed); }
+
+  // Werte seit dem letzten Aufruf
+  StageSnapshot take() {
+    StageSnapshot s;
+    s.frames = _frames.exchange(0, std::memory_order_relaxed);
+    s.busy_us = _busy.exchange(0, std::memory_order_relaxed);
+    s.stall_us = _stall.exchange(0, std::memory_order_relaxed);
+    return s;
+  }
+
+private:
+  std::atomic<uint32_t> _frames{0};
+  std::atomic<uint32_t> _busy{0};
+  std::atomic<uint32_t> _stall{0};
+};
+
+} // namespace pipeline
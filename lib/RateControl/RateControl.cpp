@@ -0,0 +1,72 @@
+#include "RateControl.h"
+
+namespace ratectl {
+
+// Nur Übertragungen ab dieser Größe gehen in die Durchsatzmessung ein
+// (kurze Datensätze messen vor allem den Aufruf-Overhead)
+static const uint32_t MIN_LINK_SAMPLE = 4096;
+
+// Reserve der Verbindung für Köpfe und Messdatensätze
+static const uint32_t LINK_HEADROOM_PCT = 90;
+
+void RateController::begin(const RateConfig &cfg, uint8_t quality) {
+  _cfg = cfg;
+  if (_cfg.q_max < _cfg.q_min)
+    _cfg.q_max = _cfg.q_min;
+  _q = _prevQ = quality < _cfg.q_min
+                    ? _cfg.q_min
+                    : (quality > _cfg.q_max ? _cfg.q_max : quality);
+  _hold = 0;
+  _avg = 0;
+  _linkBps = 0;
+}
+
+uint32_t RateController::targetBytes() const {
+  uint32_t t = _cfg.target_bytes;
+  if (_cfg.frame_interval_ms && _linkBps) {
+    const uint64_t fit = (uint64_t)_linkBps * _cfg.frame_interval_ms *
+                         LINK_HEADROOM_PCT / (1000 * 100);
+    if (!t || fit < t)
+      t = (uint32_t)fit;
+  }
+  return t;
+}
+
+bool RateController::update(uint32_t jpeg_bytes, uint32_t sent_bytes,
+                            uint32_t drain_us) {
+  if (sent_bytes >= MIN_LINK_SAMPLE && drain_us) {
+    const uint32_t bps = (uint32_t)((uint64_t)sent_bytes * 1000000 / drain_us);
+    _linkBps = _linkBps ? _linkBps - (_linkBps >> 2) + (bps >> 2) : bps;
+  }
+  _avg = _avg ? _avg - (_avg >> 2) + (jpeg_bytes >> 2) : jpeg_bytes;
+
+  if (_hold) {
+    _hold--;
+    return false;
+  }
+  const uint32_t t = targetBytes();
+  if (!t)
+    return false;
+
+  // Abweichung in Prozent des Ziels; doppelte Bandbreite -> zwei Stufen usw.
+  const uint64_t hi = (uint64_t)t * (100 + _cfg.hyst_up_pct) / 100;
+  const uint64_t lo = (uint64_t)t * (100 - _cfg.hyst_down_pct) / 100;
+  int step = 0;
+  if (_avg > hi)
+    step = _avg > 2 * hi ? 4 : (_avg > hi + hi / 2 ? 2 : 1);
+  else if (_avg < lo)
+    step = -1;  // vorsichtig feiner, um nicht zu schwingen
+  if (!step)
+    return false;
+
+  int q = _q + step;
+  q = q < _cfg.q_min ? _cfg.q_min : (q > _cfg.q_max ? _cfg.q_max : q);
+  if (q == _q)
+    return false;
+  _prevQ = _q;
+  _q = (uint8_t)q;
+  _hold = _cfg.hold_frames;
+  return true;
+}
+
+} // namespace ratectl
@@ -0,0 +1,50 @@
+#pragma once
+// RateControl: JPEG-Qualität so nachführen, dass die Frames in ein
+// Bytebudget pro Frame passen.
+//
+// Beobachtet je Frame die JPEG-Größe (fb->len) und die Sendedauer auf der
+// seriellen Verbindung. Das Ziel ist entweder eine feste Bytezahl oder das,
+// was die gemessene Verbindung in einem Frameintervall übertragen kann
+// (Ziel-Framerate), bzw. das Minimum aus beiden. Außerhalb eines
+// Hysteresebands wird die Sensorqualität (0..63, kleiner = besser) um eine
+// Stufe, bei großer Abweichung um mehrere Stufen verstellt; danach ruht die
+// Regelung einige Frames, bis der gleitende Mittelwert nachgezogen hat.
+//
+// Keine Arduino-Abhängigkeit; set_quality ruft der Aufrufer.
+
+#include <stdint.h>
+
+namespace ratectl {
+
+struct RateConfig {
+  uint32_t target_bytes;       // Bytes pro Frame (0 = nur aus Framerate)
+  uint32_t frame_interval_ms;  // Ziel-Frameabstand (0 = keine Framerate-Vorgabe)
+  uint8_t  q_min, q_max;       // erlaubter Qualitätsbereich (q_min = beste)
+  uint8_t  hyst_up_pct;        // Mittel > Ziel + x % -> gröber
+  uint8_t  hyst_down_pct;      // Mittel < Ziel - x % -> feiner
+  uint8_t  hold_frames;        // Frames ohne Eingriff nach einer Änderung
+};
+
+class RateController {
+public:
+  void begin(const RateConfig &cfg, uint8_t quality);
+
+  // Nach jedem gesendeten Frame: JPEG-Größe, tatsächlich gesendete Bytes
+  // (inkl. Köpfe) und deren Sendedauer. true = quality() hat sich geändert.
+  bool update(uint32_t jpeg_bytes, uint32_t sent_bytes, uint32_t drain_us);
+
+  uint8_t quality() const { return _q; }
+  uint8_t previousQuality() const { return _prevQ; }
+  uint32_t avgBytes() const { return _avg; }
+  uint32_t targetBytes() const;  // aktuelles Ziel (0 = noch keins)
+  uint32_t linkBytesPerSec() const { return _linkBps; }
+
+private:
+  RateConfig _cfg = {};
+  uint8_t _q = 0, _prevQ = 0;
+  uint8_t _hold = 0;
+  uint32_t _avg = 0;      // gleitendes Mittel der JPEG-Größe (1/4)
+  uint32_t _linkBps = 0;  // gleitendes Mittel des Durchsatzes (1/4)
+};
+
+} // namespace ratectl
@@ -0,0 +1,249 @@
+#include "SdBurst.h"
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace sdburst {
+
+const char *resultName(Result r) {
+  switch (r) {
+  case OK:
+    return "OK";
+  case NOT_READY:
+    return "NOT_READY";
+  case BAD_CONFIG:
+    return "BAD_CONFIG";
+  case NO_DIR:
+    return "NO_DIR";
+  case NO_SPARE:
+    return "NO_SPARE";
+  case TOO_LARGE:
+    return "TOO_LARGE";
+  case WRITE_FAILED:
+    return "WRITE_FAILED";
+  case VERIFY_FAILED:
+    return "VERIFY_FAILED";
+  }
+  return "?";
+}
+
+// "D00012" bzw. "F0001234.JPG" -> Nummer; false bei fremden Namen
+static bool parseNumber(const char *name, char prefix, uint8_t digits,
+                        const char *ext, uint32_t *out) {
+  if (name[0] != prefix)
+    return false;
+  uint32_t v = 0;
+  for (uint8_t i = 1; i <= digits; i++) {
+    if (name[i] < '0' || name[i] > '9')
+      return false;
+    v = v * 10 + (uint32_t)(name[i] - '0');
+  }
+  if (ext ? strcmp(&name[digits + 1], ext) != 0 : name[digits + 1] != '\0')
+    return false;
+  *out = v;
+  return true;
+}
+
+void BurstWriter::path(char *out, size_t cap, uint32_t index,
+                       const char *ext) const {
+  snprintf(out, cap, "%s/D%05lu/F%07lu.%s", _cfg.root,
+           (unsigned long)dirOf(index), (unsigned long)index, ext);
+}
+
+// Höchster Unterordner Dnnnnn unter root
+uint32_t BurstWriter::highestDir(bool *found) {
+  *found = false;
+  uint32_t best = 0;
+  File dir, entry;
+  if (!dir.open(_cfg.root, O_RDONLY))
+    return 0;
+  char name[16];
+  while (entry.openNext(&dir, O_RDONLY)) {
+    uint32_t n;
+    if (entry.isDir() && entry.getName(name, sizeof(name)) &&
+        parseNumber(name, 'D', 5, nullptr, &n) && (!*found || n > best)) {
+      best = n;
+      *found = true;
+    }
+    entry.close();
+  }
+  dir.close();
+  return best;
+}
+
+// Höchste Bildnummer im Ordner nach *next (+1), *.TMP löschen
+bool BurstWriter::scanDir(uint32_t d, uint32_t *next) {
+  char dir_path[32];
+  snprintf(dir_path, sizeof(dir_path), "%s/D%05lu", _cfg.root, (unsigned long)d);
+  File dir, entry;
+  if (!dir.open(dir_path, O_RDONLY))
+    return false;
+  char name[16], tmp[48];
+  while (entry.openNext(&dir, O_RDONLY)) {
+    uint32_t n;
+    const bool named = entry.getName(name, sizeof(name));
+    entry.close();
+    if (!named)
+      continue;
+    if (parseNumber(name, 'F', 7, ".JPG", &n)) {
+      if (n + 1 > *next)
+        *next = n + 1;
+    } else if (parseNumber(name, 'F', 7, ".TMP", &n)) {
+      snprintf(tmp, sizeof(tmp), "%s/%s", dir_path, name);
+      _sd->remove(tmp);
+    }
+  }
+  dir.close();
+  return true;
+}
+
+Result BurstWriter::begin(SdFat *sd, const Config &cfg) {
+  end();
+  if (!sd || !cfg.root || !cfg.file_bytes || !cfg.spare_files ||
+      cfg.spare_files > MAX_SPARE || cfg.files_per_dir < cfg.spare_files)
+    return BAD_CONFIG;
+  _cfg = cfg;
+  _stats = {};
+  if (!sd->exists(cfg.root) && !sd->mkdir(cfg.root))
+    return NO_DIR;
+  _sd = sd;
+
+  // Ersatzdateien reichen höchstens in den nächsten Ordner: die beiden
+  // jüngsten genügen für Zähler und Aufräumen
+  bool found;
+  const uint32_t top = highestDir(&found);
+  uint32_t next = 0;
+  if (found) {
+    next = (top > 0 ? top - 1 : 0) * cfg.files_per_dir;
+    if (top > 0)
+      scanDir(top - 1, &next);
+    scanDir(top, &next);
+    _dirMade = top;
+  }
+  _stats.next_index = next;
+  _nextSpare = next;
+  while (_count < _cfg.spare_files && service()) {
+  }
+  if (!_count) {
+    end();
+    return NO_SPARE;
+  }
+  return OK;
+}
+
+void BurstWriter::end() {
+  // Offene Ersatzdateien bleiben als *.TMP liegen; begin() löscht sie
+  for (uint8_t i = 0; i < _count; i++)
+    _spare[(_head + i) % MAX_SPARE].file.close();
+  _head = 0;
+  _count = 0;
+  _dirMade = 0xFFFFFFFF;
+  _sd = nullptr;
+}
+
+bool BurstWriter::service() {
+  if (!_sd || _count >= _cfg.spare_files)
+    return false;
+  const uint32_t t0 = micros();
+  const uint32_t index = _nextSpare;
+  const uint32_t d = dirOf(index);
+  if (d != _dirMade) {
+    char dir_path[32];
+    snprintf(dir_path, sizeof(dir_path), "%s/D%05lu", _cfg.root, (unsigned long)d);
+    if (!_sd->exists(dir_path) && !_sd->mkdir(dir_path))
+      return false;
+    _dirMade = d;
+  }
+  char name[48];
+  path(name, sizeof(name), index, "TMP");
+  Spare &s = _spare[(_head + _count) % MAX_SPARE];
+  if (!s.file.open(name, O_RDWR | O_CREAT | O_TRUNC))
+    return false;
+  // Zusammenhängende Cluster; die Dateilänge bleibt 0 bis zum Schreiben
+  if (!s.file.preAllocate(_cfg.file_bytes)) {
+    s.file.close();
+    _sd->remove(name);
+    return false;
+  }
+  s.index = index;
+  _nextSpare++;
+  _count++;
+  _stats.spare = _count;
+  const uint32_t dt = micros() - t0;
+  if (dt > _stats.max_prealloc_us)
+    _stats.max_prealloc_us = dt;
+  return true;
+}
+
+Result BurstWriter::fail(Result r) {
+  _stats.failures++;
+  _stats.last_error = r;
+  return r;
+}
+
+Result BurstWriter::write(const uint8_t *jpg, size_t len, uint32_t *index) {
+  if (!_sd)
+    return fail(NOT_READY);
+  if (len > _cfg.file_bytes)
+    return fail(TOO_LARGE);
+  if (!_count)
+    return fail(NO_SPARE);
+
+  const uint32_t t0 = micros();
+  Spare &s = _spare[_head];
+  _head = (uint8_t)((_head + 1) % MAX_SPARE);
+  _count--;
+  _stats.spare = _count;
+
+  char name[48];
+  path(name, sizeof(name), s.index, "JPG");
+  // Ein Aufruf für das ganze Bild: nur der Rest hinter dem letzten vollen
+  // Sektor geht über den Cache
+  bool ok = s.file.write(jpg, len) == len;
+  ok = ok && s.file.truncate(len);
+  ok = ok && s.file.rename(name);
+  ok = s.file.close() && ok;
+  if (!ok)
+    return fail(WRITE_FAILED);
+
+  const uint32_t dt = micros() - t0;
+  if (index)
+    *index = s.index;
+  _stats.files++;
+  _stats.bytes += len;
+  _stats.busy_us += dt;
+  _stats.last_write_us = dt;
+  if (dt > _stats.max_write_us)
+    _stats.max_write_us = dt;
+  _stats.next_index = s.index + 1;
+  return OK;
+}
+
+Result BurstWriter::selfTest(const uint8_t *buf, size_t len) {
+  if (!_sd)
+    return NOT_READY;
+  if (!_count)
+    return NO_SPARE;
+  if (len > _cfg.file_bytes)
+    return TOO_LARGE;
+  File &f = _spare[_head].file;
+  if (!f.seekSet(0) || f.write(buf, len) != len || !f.sync() || !f.seekSet(0))
+    return WRITE_FAILED;
+  uint8_t sector[512];
+  Result r = OK;
+  for (size_t pos = 0; pos < len && r == OK;) {
+    const size_t n = len - pos < sizeof(sector) ? len - pos : sizeof(sector);
+    if (f.read(sector, n) != (int)n)
+      r = WRITE_FAILED;
+    else if (memcmp(sector, buf + pos, n) != 0)
+      r = VERIFY_FAILED;
+    pos += n;
+  }
+  // Die nächste write() beginnt vorne, überschreibt und kürzt
+  if (!f.seekSet(0))
+    r = WRITE_FAILED;
+  return r;
+}
+
+} // namespace sdburst
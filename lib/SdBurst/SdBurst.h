@@ -0,0 +1,108 @@
+#pragma once
+// SdBurst: schnelle Bildserie auf die SD-Karte in voller Aufnahmeauflösung.
+//
+// takePhoto() aus Adafruit_PyCamera sucht für jedes Bild mit sd.exists einen
+// freien Namen (bis zu 1000 Zugriffe), legt die Datei neu an (jeder Cluster
+// ein FAT-Eintrag) und listet danach die ganze Karte. BurstWriter macht
+// dagegen alles Langsame vorab:
+//
+// - Zähler: begin() liest einmal die höchste Bildnummer aus den beiden
+//   jüngsten Unterordnern, danach zählt er im RAM weiter.
+// - Vorab belegte Dateien: service() legt einige Ersatzdateien (*.TMP) mit
+//   preAllocate an; SdFat vergibt dafür zusammenhängende Cluster. Beim
+//   Schreiben ist die Clusterkette schon da, es gibt keine FAT-Zugriffe
+//   zwischen den Daten.
+// - Ein write() je Bild: SdFat schreibt volle Sektoren am Cache vorbei als
+//   Mehrblock-Kommando (je Cluster eines). Danach kürzen (gibt den Rest der
+//   Kette frei), in *.JPG umbenennen, schließen.
+//
+// Ablage: <root>/Dnnnnn/Fnnnnnnn.JPG (8.3-Namen), files_per_dir Bilder je
+// Ordner, damit Umbenennen und Anlegen nur kurze Verzeichnisse durchsuchen.
+// Reste eines Absturzes (*.TMP) räumt begin() weg.
+//
+// Nicht threadsicher: write() und service() aus demselben Task.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <SdFat.h>
+
+namespace sdburst {
+
+enum Result : uint8_t {
+  OK = 0,
+  NOT_READY,     // begin() fehlt oder schlug fehl
+  BAD_CONFIG,    // Dateigröße 0, zu viele Ersatzdateien
+  NO_DIR,        // Ordner lässt sich nicht anlegen/öffnen
+  NO_SPARE,      // keine vorab belegte Datei (service() kommt nicht nach)
+  TOO_LARGE,     // Bild größer als file_bytes
+  WRITE_FAILED,  // Schreiben, Kürzen, Umbenennen oder Schließen
+  VERIFY_FAILED, // selfTest: gelesene Daten weichen ab
+};
+
+const char *resultName(Result r);
+
+struct Config {
+  const char *root;        // Wurzelordner, z. B. "/BURST"
+  uint32_t file_bytes;     // je Datei vorab belegt, größer als jedes JPEG
+  uint8_t spare_files;     // Ersatzdateien (höchstens MAX_SPARE)
+  uint16_t files_per_dir;  // Bilder je Unterordner
+};
+
+struct BurstStats {
+  uint32_t files;            // geschriebene Bilder
+  uint32_t failures;         // abgelehnte oder fehlgeschlagene write()
+  uint64_t bytes;            // Nutzdaten
+  uint64_t busy_us;          // Summe der write()-Dauern
+  uint32_t last_write_us;    // letztes write()
+  uint32_t max_write_us;     // längstes write()
+  uint32_t max_prealloc_us;  // längstes Anlegen einer Ersatzdatei
+  uint32_t next_index;       // Nummer des nächsten Bildes
+  uint8_t spare;             // bereitliegende Ersatzdateien
+  uint8_t last_error;        // Result des letzten Fehlers
+};
+
+class BurstWriter {
+public:
+  static const uint8_t MAX_SPARE = 8;
+
+  // Zähler lesen, Reste löschen, Ersatzdateien anlegen
+  Result begin(SdFat *sd, const Config &cfg);
+  void end();
+  bool ready() const { return _sd != nullptr; }
+
+  // Schreibt len Byte aus buf in die nächste Ersatzdatei, liest sie zurück
+  // und vergleicht (Takttest); die Datei bleibt danach Ersatzdatei
+  Result selfTest(const uint8_t *buf, size_t len);
+
+  // Ein Bild speichern; *index = vergebene Nummer
+  Result write(const uint8_t *jpg, size_t len, uint32_t *index = nullptr);
+
+  // Höchstens eine Ersatzdatei nachlegen; true, wenn eine angelegt wurde
+  bool service();
+
+  const BurstStats &stats() const { return _stats; }
+
+private:
+  struct Spare {
+    File file;
+    uint32_t index;
+  };
+
+  void path(char *out, size_t cap, uint32_t index, const char *ext) const;
+  uint32_t dirOf(uint32_t index) const { return index / _cfg.files_per_dir; }
+  bool scanDir(uint32_t dir, uint32_t *next);
+  uint32_t highestDir(bool *found);
+  Result fail(Result r);
+
+  SdFat *_sd = nullptr;
+  Config _cfg = {};
+  Spare _spare[MAX_SPARE];
+  uint8_t _head = 0;         // älteste Ersatzdatei
+  uint8_t _count = 0;
+  uint32_t _nextSpare = 0;   // Nummer der nächsten anzulegenden Ersatzdatei
+  uint32_t _dirMade = 0xFFFFFFFF;  // zuletzt angelegter Unterordner
+  BurstStats _stats = {};
+};
+
+} // namespace sdburst
@@ -0,0 +1,373 @@
+#include "SdJournal.h"
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace sdjournal {
+
+const char *resultName(Result r) {
+  switch (r) {
+  case OK:
+    return "OK";
+  case NOT_READY:
+    return "NOT_READY";
+  case BAD_CONFIG:
+    return "BAD_CONFIG";
+  case NO_DIR:
+    return "NO_DIR";
+  case EMPTY:
+    return "EMPTY";
+  case FULL:
+    return "FULL";
+  case TOO_LARGE:
+    return "TOO_LARGE";
+  case IO_FAILED:
+    return "IO_FAILED";
+  case CORRUPT:
+    return "CORRUPT";
+  }
+  return "?";
+}
+
+// Tabelle für das reflektierte Polynom 0xEDB88320, beim ersten Aufruf
+static uint32_t crc_table[256];
+
+uint32_t crc32(uint32_t crc, const uint8_t *data, size_t len) {
+  if (!crc_table[1]) {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t c = i;
+      for (uint8_t k = 0; k < 8; k++)
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      crc_table[i] = c;
+    }
+  }
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++)
+    crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+static inline void putU32(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+static inline uint32_t getU32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+// "S0000012.LOG" -> 12
+static bool parseSegment(const char *name, uint32_t *out) {
+  if (name[0] != 'S')
+    return false;
+  uint32_t v = 0;
+  for (uint8_t i = 1; i <= 7; i++) {
+    if (name[i] < '0' || name[i] > '9')
+      return false;
+    v = v * 10 + (uint32_t)(name[i] - '0');
+  }
+  if (strcmp(&name[8], ".LOG") != 0)
+    return false;
+  *out = v;
+  return true;
+}
+
+void Journal::segmentPath(char *out, size_t cap, uint32_t seg) const {
+  snprintf(out, cap, "%s/S%07lu.LOG", _cfg.root, (unsigned long)seg);
+}
+
+Result Journal::begin(SdFat *sd, const Config &cfg, uint8_t *buf, size_t buf_bytes) {
+  end();
+  if (!sd || !cfg.root || cfg.segment_bytes < 4096 || cfg.max_segments < 2 || !buf ||
+      buf_bytes <= ENTRY_HEADER)
+    return BAD_CONFIG;
+  _cfg = cfg;
+  _buf = buf;
+  _bufBytes = buf_bytes;
+  _stats = {};
+  if (!sd->exists(cfg.root) && !sd->mkdir(cfg.root))
+    return NO_DIR;
+  _sd = sd;
+
+  // Vorhandene Segmente: ältestes und jüngstes
+  uint32_t lo = 0, hi = 0;
+  bool found = false;
+  File dir, entry;
+  if (dir.open(cfg.root, O_RDONLY)) {
+    char name[16];
+    while (entry.openNext(&dir, O_RDONLY)) {
+      uint32_t n;
+      if (!entry.isDir() && entry.getName(name, sizeof(name)) && parseSegment(name, &n)) {
+        lo = found && lo < n ? lo : n;
+        hi = found && hi > n ? hi : n;
+        found = true;
+      }
+      entry.close();
+    }
+    dir.close();
+  }
+
+  char path[40];
+  snprintf(path, sizeof(path), "%s/TAIL.DAT", cfg.root);
+  if (!_tail.open(path, O_RDWR | O_CREAT)) {
+    end();
+    return IO_FAILED;
+  }
+  uint32_t seg, off;
+  if (found && loadTail(&seg, &off) && seg >= lo && seg <= hi) {
+    _rseg = seg;
+    _roff = off;
+  } else {
+    _rseg = lo;
+    _roff = 0;
+  }
+  // Reste vor der Leseposition (Ausfall zwischen pop und Löschen)
+  for (uint32_t s = lo; s < _rseg; s++) {
+    segmentPath(path, sizeof(path), s);
+    _sd->remove(path);
+  }
+
+  Result r = openWriteSegment(hi, !found);
+  // Endet das letzte Segment doch mit einem angerissenen Eintrag (Länge vor
+  // den Daten geschrieben, Host-Simulation), gingen neue Einträge dahinter
+  // beim Überspringen des Rests mit verloren: neues Segment, solange Platz ist
+  if (r == OK && _woff > 0 && hi + 1 - _rseg < cfg.max_segments &&
+      openWriteSegment(hi + 1, true) != OK)
+    r = openWriteSegment(hi, false);
+  if (r != OK) {
+    end();
+    return r;
+  }
+  _stats.segments = (uint16_t)(_wseg - _rseg + 1);
+  if (_rseg < _wseg) {
+    openReadSegment();
+    _stats.backlog_bytes = _rsize > _roff ? _rsize - _roff : 0;
+    for (uint32_t s = _rseg + 1; s < _wseg; s++) {
+      File f;
+      segmentPath(path, sizeof(path), s);
+      if (f.open(path, O_RDONLY)) {
+        _stats.backlog_bytes += f.fileSize();
+        f.close();
+      }
+    }
+    _stats.backlog_bytes += _woff;
+  } else {
+    if (_roff > _woff)
+      _roff = _woff;
+    _stats.backlog_bytes = _woff - _roff;
+  }
+  return OK;
+}
+
+void Journal::end() {
+  _wfile.close();
+  _rfile.close();
+  _tail.close();
+  _wseg = _woff = _rseg = _roff = _rsize = _peeked = 0;
+  _sd = nullptr;
+}
+
+Result Journal::openWriteSegment(uint32_t seg, bool create) {
+  char path[40];
+  segmentPath(path, sizeof(path), seg);
+  _wfile.close();
+  if (create) {
+    if (!_wfile.open(path, O_RDWR | O_CREAT | O_TRUNC))
+      return IO_FAILED;
+    // Zusammenhängende Cluster; angehängt wird ohne FAT-Zugriffe
+    if (!_wfile.preAllocate(_cfg.segment_bytes)) {
+      _wfile.close();
+      _sd->remove(path);
+      return IO_FAILED;
+    }
+  } else if (!_wfile.open(path, O_RDWR)) {
+    return IO_FAILED;
+  }
+  _wseg = seg;
+  // Die Dateilänge ist das Ende der synchronisierten Einträge
+  _woff = (uint32_t)_wfile.fileSize();
+  return _wfile.seekSet(_woff) ? OK : IO_FAILED;
+}
+
+Result Journal::openReadSegment() {
+  char path[40];
+  segmentPath(path, sizeof(path), _rseg);
+  _rfile.close();
+  _rsize = 0;
+  if (!_rfile.open(path, O_RDONLY))
+    return IO_FAILED;
+  _rsize = (uint32_t)_rfile.fileSize();
+  return OK;
+}
+
+bool Journal::loadTail(uint32_t *seg, uint32_t *off) {
+  uint8_t b[12];
+  if (!_tail.seekSet(0) || _tail.read(b, sizeof(b)) != (int)sizeof(b) ||
+      crc32(0, b, 8) != getU32(&b[8]))
+    return false;
+  *seg = getU32(b);
+  *off = getU32(&b[4]);
+  return true;
+}
+
+bool Journal::saveTail() {
+  uint8_t b[12];
+  putU32(b, _rseg);
+  putU32(&b[4], _roff);
+  putU32(&b[8], crc32(0, b, 8));
+  return _tail.seekSet(0) && _tail.write(b, sizeof(b)) == sizeof(b) && _tail.sync();
+}
+
+// Lesesegment ist ganz abgeholt: löschen, nächstes öffnen
+void Journal::advanceReadSegment() {
+  char path[40];
+  _rfile.close();
+  segmentPath(path, sizeof(path), _rseg);
+  _sd->remove(path);
+  _rseg++;
+  _roff = 0;
+  _rsize = 0;
+  _stats.segments = (uint16_t)(_wseg - _rseg + 1);
+  if (_rseg < _wseg)
+    openReadSegment();
+  saveTail();
+}
+
+// Ohne gültigen Kopf lässt sich der nächste Eintrag nicht finden
+void Journal::skipSegmentRest() {
+  const uint32_t end = _rseg == _wseg ? _woff : _rsize;
+  _stats.corrupt++;
+  _stats.backlog_bytes -= end > _roff ? end - _roff : 0;
+  _roff = end;
+  if (_rseg < _wseg)
+    advanceReadSegment();
+  else
+    saveTail();
+}
+
+Result Journal::append(uint32_t seq, uint32_t t_ms, const uint8_t *const *parts,
+                       const uint32_t *lens, uint8_t n) {
+  if (!_sd) {
+    _stats.dropped++;
+    return NOT_READY;
+  }
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < n; i++)
+    total += lens[i];
+  const uint32_t size = ENTRY_HEADER + total;
+  if (size > _cfg.segment_bytes || size > _bufBytes) {
+    _stats.dropped++;
+    return TOO_LARGE;
+  }
+  const uint32_t t0 = micros();
+
+  if (_woff + size > _cfg.segment_bytes) {
+    if (_wseg + 1 - _rseg >= _cfg.max_segments) {
+      _stats.dropped++;
+      return FULL;
+    }
+    const uint32_t old = _wseg;
+    if (openWriteSegment(_wseg + 1, true) != OK) {
+      // Altes Segment weiter benutzen (nächster Versuch beim nächsten Eintrag)
+      openWriteSegment(old, false);
+      _stats.dropped++;
+      return IO_FAILED;
+    }
+    _stats.segments = (uint16_t)(_wseg - _rseg + 1);
+    if (_rseg == old)
+      openReadSegment();
+  }
+
+  uint8_t hdr[ENTRY_HEADER];
+  putU32(hdr, MAGIC);
+  putU32(&hdr[4], seq);
+  putU32(&hdr[8], t_ms);
+  putU32(&hdr[12], total);
+  uint32_t crc = crc32(0, hdr, 16);
+  for (uint8_t i = 0; i < n; i++)
+    crc = crc32(crc, parts[i], lens[i]);
+  putU32(&hdr[16], crc);
+
+  bool ok = _wfile.write(hdr, sizeof(hdr)) == sizeof(hdr);
+  for (uint8_t i = 0; i < n && ok; i++)
+    ok = _wfile.write(parts[i], lens[i]) == lens[i];
+  ok = ok && _wfile.sync();
+  if (!ok) {
+    // Das Ende bleibt beim letzten sync; der nächste Eintrag überschreibt
+    _wfile.seekSet(_woff);
+    _stats.dropped++;
+    return IO_FAILED;
+  }
+  _woff += size;
+  _stats.backlog_bytes += size;
+  _stats.appended++;
+  const uint32_t dt = micros() - t0;
+  if (dt > _stats.max_append_us)
+    _stats.max_append_us = dt;
+  return OK;
+}
+
+Result Journal::peek(uint32_t *seq, uint32_t *t_ms, const uint8_t **data, uint32_t *len) {
+  if (!_sd)
+    return NOT_READY;
+  _peeked = 0;
+  while (_rseg < _wseg && _roff >= _rsize)
+    advanceReadSegment();
+  if (empty())
+    return EMPTY;
+
+  const bool live = _rseg == _wseg;
+  File &f = live ? _wfile : _rfile;
+  const uint32_t end = live ? _woff : _rsize;
+  Result r = OK;
+  uint32_t n = 0;
+  if (end - _roff < ENTRY_HEADER || !f.seekSet(_roff) ||
+      f.read(_buf, ENTRY_HEADER) != (int)ENTRY_HEADER) {
+    r = CORRUPT;
+  } else {
+    n = getU32(&_buf[12]);
+    if (getU32(_buf) != MAGIC || n > _bufBytes - ENTRY_HEADER ||
+        n > end - _roff - ENTRY_HEADER)
+      r = CORRUPT;
+    else if (f.read(_buf + ENTRY_HEADER, n) != (int)n)
+      r = IO_FAILED;
+    else if (crc32(crc32(0, _buf, 16), _buf + ENTRY_HEADER, n) != getU32(&_buf[16]))
+      r = CORRUPT;
+  }
+  // Schreibposition des Segments wiederherstellen
+  if (live)
+    _wfile.seekSet(_woff);
+  if (r == CORRUPT)
+    skipSegmentRest();
+  if (r != OK)
+    return r;
+
+  *seq = getU32(&_buf[4]);
+  *t_ms = getU32(&_buf[8]);
+  *data = _buf + ENTRY_HEADER;
+  *len = n;
+  _peeked = ENTRY_HEADER + n;
+  return OK;
+}
+
+Result Journal::pop() {
+  if (!_sd)
+    return NOT_READY;
+  if (!_peeked)
+    return EMPTY;
+  _roff += _peeked;
+  _stats.backlog_bytes -= _peeked;
+  _stats.popped++;
+  _peeked = 0;
+  if (_rseg < _wseg && _roff >= _rsize)
+    advanceReadSegment();
+  else
+    saveTail();
+  return OK;
+}
+
+} // namespace sdjournal
@@ -0,0 +1,113 @@
+#pragma once
+// SdJournal: Zwischenlager auf der SD-Karte, solange die Verbindung zum PC
+// steht oder zu langsam ist (store and forward).
+//
+// Nur anhängendes Protokoll in Segmentdateien <root>/Snnnnnnn.LOG, jede mit
+// preAllocate belegt. Ein Eintrag ist ein Frame: Kopf (20 Byte, LE) und die
+// Nutzdaten, die der Aufrufer in Teilen übergibt (bei der Firmware die
+// CamLink-Datensätze samt Köpfen, so wie sie live gesendet würden):
+//
+//   u32 Kennung 'JRNL' | u32 seq | u32 t_ms | u32 Länge | u32 CRC-32
+//
+// Die CRC deckt die ersten 16 Byte des Kopfes und die Nutzdaten ab.
+// append() synchronisiert nach jedem Eintrag: SdFat schreibt erst die Daten,
+// dann die Dateilänge im Verzeichnis. Die Länge ist damit das Ende der
+// sicher geschriebenen Einträge; ein Abbruch mitten im Eintrag hinterlässt
+// nur Daten hinter dem Ende, die begin() ignoriert. begin() schreibt in ein
+// neues Segment weiter, ein angerissenes Ende trifft so keine neuen Einträge.
+//
+// Gelesen wird vom ältesten Eintrag an (peek, nach dem Senden pop). Die
+// Leseposition steht in <root>/TAIL.DAT (mit CRC), ganz gelesene Segmente
+// werden gelöscht. Fällt das Gerät zwischen Senden und pop aus, kommt der
+// Eintrag nach dem Neustart noch einmal (höchstens doppelt, nie verloren).
+//
+// Nicht threadsicher: alle Aufrufe aus demselben Task.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <SdFat.h>
+
+namespace sdjournal {
+
+enum Result : uint8_t {
+  OK = 0,
+  NOT_READY,     // begin() fehlt oder schlug fehl
+  BAD_CONFIG,    // Segmentgröße / Segmentzahl / Lesepuffer
+  NO_DIR,        // Ordner lässt sich nicht anlegen/öffnen
+  EMPTY,         // nichts zu lesen
+  FULL,          // max_segments erreicht, Eintrag verworfen
+  TOO_LARGE,     // Eintrag größer als Segment bzw. Lesepuffer
+  IO_FAILED,     // Schreiben, Lesen, Anlegen
+  CORRUPT,       // Kopf oder CRC falsch; Rest des Segments übersprungen
+};
+
+const char *resultName(Result r);
+
+// CRC-32 (IEEE 802.3, wie zlib); crc = Ergebnis des vorigen Teils, 0 am Anfang
+uint32_t crc32(uint32_t crc, const uint8_t *data, size_t len);
+
+struct Config {
+  const char *root;          // z. B. "/JOURNAL"
+  uint32_t segment_bytes;    // je Segmentdatei vorab belegt
+  uint16_t max_segments;     // höchstens so viele Segmente auf der Karte
+};
+
+struct JournalStats {
+  uint32_t appended;         // geschriebene Einträge (seit begin)
+  uint32_t popped;           // abgeholte Einträge
+  uint32_t dropped;          // nicht geschrieben (voll, zu groß, Fehler)
+  uint32_t corrupt;          // beim Lesen verworfen
+  uint64_t backlog_bytes;    // noch nicht abgeholt (Köpfe eingeschlossen)
+  uint32_t max_append_us;    // längstes append()
+  uint16_t segments;         // Segmente auf der Karte
+};
+
+class Journal {
+public:
+  static const uint32_t ENTRY_HEADER = 20;
+  static const uint32_t MAGIC = 0x4C4E524Au;  // "JRNL"
+
+  // buf nimmt beim Lesen einen ganzen Eintrag auf (Kopf + Nutzdaten)
+  Result begin(SdFat *sd, const Config &cfg, uint8_t *buf, size_t buf_bytes);
+  void end();
+  bool ready() const { return _sd != nullptr; }
+  bool empty() const { return _rseg == _wseg && _roff >= _woff; }
+
+  // Einen Eintrag aus n Teilen anhängen; nach OK dauerhaft auf der Karte
+  Result append(uint32_t seq, uint32_t t_ms, const uint8_t *const *parts,
+                const uint32_t *lens, uint8_t n);
+
+  // Ältesten Eintrag lesen, ohne ihn zu entfernen; *data zeigt in den
+  // Lesepuffer und bleibt bis zum nächsten Aufruf gültig
+  Result peek(uint32_t *seq, uint32_t *t_ms, const uint8_t **data, uint32_t *len);
+  // Gelesenen Eintrag als abgeholt vermerken
+  Result pop();
+
+  const JournalStats &stats() const { return _stats; }
+
+private:
+  void segmentPath(char *out, size_t cap, uint32_t seg) const;
+  Result openWriteSegment(uint32_t seg, bool create);
+  Result openReadSegment();
+  bool saveTail();
+  bool loadTail(uint32_t *seg, uint32_t *off);
+  void skipSegmentRest();
+  void advanceReadSegment();
+
+  SdFat *_sd = nullptr;
+  Config _cfg = {};
+  uint8_t *_buf = nullptr;
+  size_t _bufBytes = 0;
+
+  File _wfile;                 // Schreibsegment (O_RDWR, liest auch)
+  uint32_t _wseg = 0, _woff = 0;
+  File _rfile;                 // älteres Lesesegment, sonst geschlossen
+  uint32_t _rseg = 0, _roff = 0;
+  uint32_t _rsize = 0;         // Länge des Lesesegments
+  uint32_t _peeked = 0;        // Größe des gelesenen Eintrags, 0 = keiner
+  File _tail;
+  JournalStats _stats = {};
+};
+
+} // namespace sdjournal
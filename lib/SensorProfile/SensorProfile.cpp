@@ -0,0 +1,227 @@
+#include "SensorProfile.h"
+
+#include <Arduino.h>
+
+namespace sensorprof {
+
+const char *fieldName(Field f) {
+  switch (f) {
+  case PIXFORMAT:      return "pixformat";
+  case FRAMESIZE:      return "framesize";
+  case QUALITY:        return "quality";
+  case DENOISE:        return "denoise";
+  case BPC:            return "bpc";
+  case WPC:            return "wpc";
+  case LENC:           return "lenc";
+  case RAW_GMA:        return "raw_gma";
+  case DCW:            return "dcw";
+  case SHARPNESS:      return "sharpness";
+  case SATURATION:     return "saturation";
+  case CONTRAST:       return "contrast";
+  case BRIGHTNESS:     return "brightness";
+  case SPECIAL_EFFECT: return "special_effect";
+  case HMIRROR:        return "hmirror";
+  case VFLIP:          return "vflip";
+  case COLORBAR:       return "colorbar";
+  case AWB:            return "awb";
+  case AWB_GAIN:       return "awb_gain";
+  case WB_MODE:        return "wb_mode";
+  case AEC:            return "aec";
+  case AEC2:           return "aec2";
+  case AEC_VALUE:      return "aec_value";
+  case AE_LEVEL:       return "ae_level";
+  case AGC:            return "agc";
+  case AGC_GAIN:       return "agc_gain";
+  case GAINCEILING:    return "gainceiling";
+  case FIELD_COUNT:    break;
+  }
+  return "?";
+}
+
+void capture(const sensor_t *s, Profile *out) {
+  const camera_status_t &st = s->status;
+  int16_t *v = out->value;
+  v[PIXFORMAT]      = s->pixformat;
+  v[FRAMESIZE]      = st.framesize;
+  v[QUALITY]        = st.quality;
+  v[DENOISE]        = st.denoise;
+  v[BPC]            = st.bpc;
+  v[WPC]            = st.wpc;
+  v[LENC]           = st.lenc;
+  v[RAW_GMA]        = st.raw_gma;
+  v[DCW]            = st.dcw;
+  v[SHARPNESS]      = st.sharpness;
+  v[SATURATION]     = st.saturation;
+  v[CONTRAST]       = st.contrast;
+  v[BRIGHTNESS]     = st.brightness;
+  v[SPECIAL_EFFECT] = st.special_effect;
+  v[HMIRROR]        = st.hmirror;
+  v[VFLIP]          = st.vflip;
+  v[COLORBAR]       = st.colorbar;
+  v[AWB]            = st.awb;
+  v[AWB_GAIN]       = st.awb_gain;
+  v[WB_MODE]        = st.wb_mode;
+  v[AEC]            = st.aec;
+  v[AEC2]           = st.aec2;
+  v[AEC_VALUE]      = (int16_t)st.aec_value;
+  v[AE_LEVEL]       = st.ae_level;
+  v[AGC]            = st.agc;
+  v[AGC_GAIN]       = st.agc_gain;
+  v[GAINCEILING]    = st.gainceiling;
+}
+
+uint32_t diff(const Profile &a, const Profile &b) {
+  uint32_t mask = 0;
+  for (uint8_t f = 0; f < FIELD_COUNT; f++)
+    if (a.value[f] != b.value[f])
+      mask |= 1u << f;
+  return mask;
+}
+
+// Setter des Feldes; -1, wenn der Sensor ihn nicht hat
+static int write(sensor_t *s, Field f, int v) {
+  int (*set)(sensor_t *, int) = nullptr;
+  switch (f) {
+  case PIXFORMAT:
+    return s->set_pixformat ? s->set_pixformat(s, (pixformat_t)v) : -1;
+  case FRAMESIZE:
+    return s->set_framesize ? s->set_framesize(s, (framesize_t)v) : -1;
+  case GAINCEILING:
+    return s->set_gainceiling ? s->set_gainceiling(s, (gainceiling_t)v) : -1;
+  case QUALITY:        set = s->set_quality; break;
+  case DENOISE:        set = s->set_denoise; break;
+  case BPC:            set = s->set_bpc; break;
+  case WPC:            set = s->set_wpc; break;
+  case LENC:           set = s->set_lenc; break;
+  case RAW_GMA:        set = s->set_raw_gma; break;
+  case DCW:            set = s->set_dcw; break;
+  case SHARPNESS:      set = s->set_sharpness; break;
+  case SATURATION:     set = s->set_saturation; break;
+  case CONTRAST:       set = s->set_contrast; break;
+  case BRIGHTNESS:     set = s->set_brightness; break;
+  case SPECIAL_EFFECT: set = s->set_special_effect; break;
+  case HMIRROR:        set = s->set_hmirror; break;
+  case VFLIP:          set = s->set_vflip; break;
+  case COLORBAR:       set = s->set_colorbar; break;
+  case AWB:            set = s->set_whitebal; break;
+  case AWB_GAIN:       set = s->set_awb_gain; break;
+  case WB_MODE:        set = s->set_wb_mode; break;
+  case AEC:            set = s->set_exposure_ctrl; break;
+  case AEC2:           set = s->set_aec2; break;
+  case AEC_VALUE:      set = s->set_aec_value; break;
+  case AE_LEVEL:       set = s->set_ae_level; break;
+  case AGC:            set = s->set_gain_ctrl; break;
+  case AGC_GAIN:       set = s->set_agc_gain; break;
+  case FIELD_COUNT:    break;
+  }
+  return set ? set(s, v) : -1;
+}
+
+SwitchReport apply(sensor_t *s, const Profile &target) {
+  SwitchReport r = {};
+  const uint32_t t0 = micros();
+  Profile now;
+  capture(s, &now);
+  const uint32_t mask = diff(now, target);
+  for (uint8_t f = 0; f < FIELD_COUNT; f++) {
+    if (!(mask & (1u << f)))
+      continue;
+    r.writes++;
+    if (write(s, (Field)f, target.value[f]) != 0)
+      r.failed++;
+  }
+  r.resized = (mask & ((1u << PIXFORMAT) | (1u << FRAMESIZE))) != 0;
+  r.us = micros() - t0;
+  return r;
+}
+
+// CRC-32 (IEEE, bitweise; nur beim Start und beim Ablegen)
+static uint32_t crc32(uint32_t crc, const uint8_t *data, size_t len) {
+  crc = ~crc;
+  while (len--) {
+    crc ^= *data++;
+    for (uint8_t b = 0; b < 8; b++)
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+  }
+  return ~crc;
+}
+
+static void putU32(uint8_t *o, uint32_t v) {
+  for (uint8_t i = 0; i < 4; i++)
+    o[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint32_t getU32(const uint8_t *i) {
+  return i[0] | (i[1] << 8) | (i[2] << 16) | ((uint32_t)i[3] << 24);
+}
+
+uint32_t checksum(const Profile &p) {
+  uint8_t buf[2 * FIELD_COUNT];
+  for (uint8_t f = 0; f < FIELD_COUNT; f++) {
+    buf[2 * f] = (uint8_t)p.value[f];
+    buf[2 * f + 1] = (uint8_t)((uint16_t)p.value[f] >> 8);
+  }
+  return crc32(0, buf, sizeof(buf));
+}
+
+size_t encode(uint8_t out[STORE_SIZE], const Profile &p, uint32_t basis) {
+  uint8_t *o = out;
+  *o++ = STORE_VERSION;
+  *o++ = FIELD_COUNT;
+  for (uint8_t f = 0; f < FIELD_COUNT; f++) {
+    *o++ = (uint8_t)p.value[f];
+    *o++ = (uint8_t)((uint16_t)p.value[f] >> 8);
+  }
+  putU32(o, basis);
+  o += 4;
+  putU32(o, crc32(0, out, (size_t)(o - out)));
+  o += 4;
+  return (size_t)(o - out);
+}
+
+bool decode(const uint8_t *in, size_t len, Profile *p, uint32_t *basis) {
+  if (len != STORE_SIZE || in[0] != STORE_VERSION || in[1] != FIELD_COUNT)
+    return false;
+  if (getU32(in + STORE_SIZE - 4) != crc32(0, in, STORE_SIZE - 4))
+    return false;
+  const uint8_t *i = in + 2;
+  for (uint8_t f = 0; f < FIELD_COUNT; f++, i += 2)
+    p->value[f] = (int16_t)(i[0] | (i[1] << 8));
+  *basis = getU32(i);
+  return true;
+}
+
+bool ProfileStore::begin(const char *ns) {
+  end();
+  _open = _prefs.begin(ns, false);
+  return _open;
+}
+
+void ProfileStore::end() {
+  if (_open)
+    _prefs.end();
+  _open = false;
+}
+
+bool ProfileStore::load(const char *name, Profile *p, uint32_t *basis) {
+  uint8_t buf[STORE_SIZE];
+  if (!_open || _prefs.getBytesLength(name) != STORE_SIZE ||
+      _prefs.getBytes(name, buf, sizeof(buf)) != STORE_SIZE)
+    return false;
+  return decode(buf, sizeof(buf), p, basis);
+}
+
+bool ProfileStore::save(const char *name, const Profile &p, uint32_t basis) {
+  if (!_open)
+    return false;
+  // Flash schonen: gleicher Inhalt wird nicht neu geschrieben
+  Profile old;
+  uint32_t old_basis;
+  if (load(name, &old, &old_basis) && old_basis == basis && !diff(old, p))
+    return true;
+  uint8_t buf[STORE_SIZE];
+  encode(buf, p, basis);
+  return _prefs.putBytes(name, buf, sizeof(buf)) == sizeof(buf);
+}
+
+} // namespace sensorprof
@@ -0,0 +1,116 @@
+#pragma once
+// SensorProfile: benannte Sensor-Einstellungen (Vorschau, Action, Kalibrierung)
+// mit Wechsel, der nur Abweichungen schreibt.
+//
+// applyActionPhotoProfile rief jeden Setter auf, auch wenn der Wert schon
+// stimmte; jeder Aufruf ist beim OV5640 eine oder mehrere SCCB-Transaktionen,
+// set_framesize sogar ein ganzer Registersatz. Ein Profil hält dagegen den
+// vollständigen Stand, den der Treiber in sensor_t::status (plus pixformat)
+// führt. apply() vergleicht Feld für Feld mit diesem Stand und ruft nur die
+// Setter der abweichenden Felder auf, direkt hintereinander in fester
+// Reihenfolge (Format und Auflösung zuerst, Belichtungswert nach dem
+// Abschalten der Automatik). esp32-camera bietet keinen Mehrregister-Schreib-
+// befehl über SCCB; enger als so lässt sich der Wechsel nicht bündeln.
+//
+// Direkte Registerzugriffe (set_reg) sieht status nicht; wer sie nutzt, muss
+// danach capture() neu aufrufen.
+//
+// ProfileStore legt Profile im NVS-Flash ab (Preferences, feste
+// little-endian-Form mit Version und CRC), geschrieben wird nur bei Änderung.
+// Mit jedem Profil steht die Prüfsumme des eingebauten Profils, aus dem es
+// hervorging (basis): ändern sich die Konstanten der Firmware, passt sie
+// nicht mehr und der Aufrufer nimmt wieder das eingebaute.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <Preferences.h>
+
+#include "esp_camera.h"
+
+namespace sensorprof {
+
+// Felder in Schreibreihenfolge
+enum Field : uint8_t {
+  PIXFORMAT = 0,
+  FRAMESIZE,
+  QUALITY,
+  DENOISE,
+  BPC,
+  WPC,
+  LENC,
+  RAW_GMA,
+  DCW,
+  SHARPNESS,
+  SATURATION,
+  CONTRAST,
+  BRIGHTNESS,
+  SPECIAL_EFFECT,
+  HMIRROR,
+  VFLIP,
+  COLORBAR,
+  AWB,
+  AWB_GAIN,
+  WB_MODE,
+  AEC,
+  AEC2,
+  AEC_VALUE,
+  AE_LEVEL,
+  AGC,
+  AGC_GAIN,
+  GAINCEILING,
+  FIELD_COUNT
+};
+
+const char *fieldName(Field f);
+
+struct Profile {
+  int16_t value[FIELD_COUNT];
+
+  int16_t get(Field f) const { return value[f]; }
+  void set(Field f, int v) { value[f] = (int16_t)v; }
+};
+
+// Aktueller Stand laut Treiber
+void capture(const sensor_t *s, Profile *out);
+
+// Abweichende Felder von a nach b (Bit f = Feld f)
+uint32_t diff(const Profile &a, const Profile &b);
+
+struct SwitchReport {
+  uint8_t writes;   // aufgerufene Setter
+  uint8_t failed;   // davon mit Fehler (oder Setter fehlt)
+  bool resized;     // Format/Auflösung geändert: nächste Frames verwerfen
+  uint32_t us;      // Dauer des Wechsels
+};
+
+// Nur abweichende Felder schreiben; Aufrufer sperrt den Sensor
+SwitchReport apply(sensor_t *s, const Profile &target);
+
+// CRC-32 über die Werte (Kennung eines eingebauten Profils als basis)
+uint32_t checksum(const Profile &p);
+
+// Feste Größe im Flash: Version, Feldzahl, je Feld int16 LE, basis, CRC-32
+static const uint8_t STORE_VERSION = 2;
+static const size_t STORE_SIZE = 2 + 2 * FIELD_COUNT + 4 + 4;
+
+size_t encode(uint8_t out[STORE_SIZE], const Profile &p, uint32_t basis);
+// false bei falscher Länge, Version, Feldzahl oder CRC
+bool decode(const uint8_t *in, size_t len, Profile *p, uint32_t *basis);
+
+class ProfileStore {
+public:
+  // ns: NVS-Namensraum (höchstens 15 Zeichen), ebenso die Profilnamen
+  bool begin(const char *ns);
+  void end();
+  // false, wenn das Profil fehlt oder beschädigt ist
+  bool load(const char *name, Profile *p, uint32_t *basis);
+  // true, wenn der Flash danach p enthält (auch ohne Schreiben)
+  bool save(const char *name, const Profile &p, uint32_t basis);
+
+private:
+  Preferences _prefs;
+  bool _open = false;
+};
+
+} // namespace sensorprof
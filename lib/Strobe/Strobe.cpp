@@ -0,0 +1,130 @@
+#include "Strobe.h"
+
+#include "esp_timer.h"
+
+namespace strobe {
+
+// Frameabstände, die vor dem Blitz gemessen sein müssen (die ersten Frames
+// können aus vollen Puffern stammen und sind dann älter)
+static const uint8_t MIN_SYNC_PERIODS = 2;
+// Frames, die nach dem Blitz höchstens bis zum Zielframe geholt werden
+static const uint8_t MAX_TARGET_FRAMES = 4;
+
+void Strobe::begin(LightMode mode, Adafruit_NeoPixel *ring, int pin) {
+  _mode = mode;
+  _ring = ring;
+  _pin = pin;
+  if (_mode == LIGHT_STROBE_DRIVER) {
+    pinMode(_pin, OUTPUT);
+    digitalWrite(_pin, LOW);
+  } else if (_mode == LIGHT_STROBE_RING && _ring) {
+    _ring->setBrightness(255);
+    _ring->clear();
+    _ring->show();
+  }
+}
+
+void Strobe::setExposure(uint32_t exposure_us, uint32_t readout_us) {
+  _exposureUs = exposure_us;
+  _readoutUs = readout_us;
+}
+
+int64_t Strobe::frameUs(const camera_fb_t *fb) {
+  return (int64_t)fb->timestamp.tv_sec * 1000000 + fb->timestamp.tv_usec;
+}
+
+void Strobe::waitUntil(int64_t t_us) {
+  int64_t now = esp_timer_get_time();
+  if (t_us - now > 2000) delay((uint32_t)((t_us - now - 1000) / 1000));
+  while (esp_timer_get_time() < t_us) {}
+}
+
+// Ring: die LEDs übernehmen die Farbe am Ende von show()
+int64_t Strobe::lightOn() {
+  if (_mode == LIGHT_STROBE_DRIVER) {
+    digitalWrite(_pin, HIGH);
+    return esp_timer_get_time();
+  }
+  const int64_t t0 = esp_timer_get_time();
+  _ring->fill(Adafruit_NeoPixel::Color(255, 255, 255));
+  _ring->show();
+  const int64_t t1 = esp_timer_get_time();
+  _showUs = (_showUs * 3 + (uint32_t)(t1 - t0)) / 4;
+  return t1;
+}
+
+int64_t Strobe::lightOff() {
+  if (_mode == LIGHT_STROBE_DRIVER) {
+    digitalWrite(_pin, LOW);
+    return esp_timer_get_time();
+  }
+  _ring->clear();
+  _ring->show();
+  return esp_timer_get_time();
+}
+
+camera_fb_t *Strobe::capture(int64_t target_us, uint32_t pulse_us,
+                             uint32_t guard_us) {
+  _t = {};
+  // Synchronisieren: Frames holen und sofort zurückgeben, bis der übernächste
+  // VSYNC (für ihn ist dann ein Puffer frei) am Ziel liegt. Periode = kleinster
+  // Abstand; Lücken durch volle Puffer sind länger
+  int64_t last = 0;
+  uint32_t period = 0;
+  uint8_t periods = 0;
+  for (;;) {
+    camera_fb_t *fb = esp_camera_fb_get();
+    if (!fb)
+      return nullptr;
+    const int64_t ts = frameUs(fb);
+    esp_camera_fb_return(fb);
+    if (last && ts > last) {
+      const uint32_t d = (uint32_t)(ts - last);
+      if (!period || d < period)
+        period = d;
+      if (periods < MIN_SYNC_PERIODS)
+        periods++;
+    }
+    last = ts;
+    if (periods >= MIN_SYNC_PERIODS &&
+        last + 2 * (int64_t)period >= target_us - (int64_t)period / 2)
+      break;
+  }
+
+  // Zu spät für diesen VSYNC (Ziel lag in der Vergangenheit): nächster Frame
+  const uint32_t lead = _mode == LIGHT_STROBE_RING ? _showUs : 0;
+  int64_t vsync = last + 2 * (int64_t)period;
+  while (esp_timer_get_time() > vsync - guard_us - pulse_us - lead)
+    vsync += period;
+
+  const int64_t t_off = vsync - guard_us;
+  waitUntil(t_off - pulse_us - lead);
+  const int64_t on = lightOn();
+  waitUntil(t_off - lead);
+  const int64_t off = lightOff();
+
+  // Zielframe holen; ältere Frames zurückgeben
+  camera_fb_t *fb = nullptr;
+  for (uint8_t i = 0; i < MAX_TARGET_FRAMES; i++) {
+    fb = esp_camera_fb_get();
+    if (!fb || frameUs(fb) >= vsync - (int64_t)period / 2)
+      break;
+    esp_camera_fb_return(fb);
+    fb = nullptr;
+  }
+  if (!fb)
+    return nullptr;
+
+  _t.vsync_us = frameUs(fb);
+  _t.on_us = (int32_t)(on - _t.vsync_us);
+  _t.off_us = (int32_t)(off - _t.vsync_us);
+  _t.window_start_us = (int32_t)_readoutUs - (int32_t)_exposureUs;
+  _t.period_us = period;
+  _t.vsync_error_us = (int32_t)(_t.vsync_us - vsync);
+  _t.aligned = _t.on_us >= _t.window_start_us && _t.off_us <= 0 &&
+               _t.vsync_error_us < (int32_t)period / 4 &&
+               _t.vsync_error_us > -(int32_t)period / 4;
+  return fb;
+}
+
+} // namespace strobe
@@ -0,0 +1,71 @@
+#pragma once
+// Strobe: Beleuchtung nur während der Belichtung des aufgenommenen Frames.
+//
+// Der Sensor hat einen Rolling Shutter: Zeile r wird im Intervall
+// [V + r·t_line - t_exp, V + r·t_line] belichtet (V = VSYNC des Frames, ab dem
+// ausgelesen wird). Alle Zeilen belichten gleichzeitig nur im Fenster
+// [V + t_readout - t_exp, V], das es nur bei t_exp > t_readout gibt. Ein Blitz
+// in diesem Fenster belichtet das ganze Bild gleich; die wirksame
+// Belichtungszeit ist dann die Blitzdauer, nicht mehr t_exp.
+//
+// VSYNC-Zeitpunkte stammen aus fb->timestamp (esp_timer, Beginn des Frames).
+// capture() holt Frames (und gibt sie gleich zurück), bis der übernächste
+// VSYNC am Zielzeitpunkt liegt, blitzt davor und liefert genau diesen Frame. Die tatsächlichen Ein-/Aus-
+// Zeiten relativ zu seinem VSYNC stehen in timing() (Nachweis der Lage).
+//
+// Lichtquellen: NeoPixel-Ring (ein show() dauert einige 100 µs und wird
+// vorgehalten) oder ein Treiber (MOSFET) am selben Pin als GPIO.
+
+#include <Arduino.h>
+#include <Adafruit_NeoPixel.h>
+#include "esp_camera.h"
+
+namespace strobe {
+
+enum LightMode : uint8_t {
+  LIGHT_CONSTANT = 0,  // Dauerlicht (bisheriges Verhalten)
+  LIGHT_STROBE_RING,   // Ring nur während des Blitzes, volle Helligkeit
+  LIGHT_STROBE_DRIVER, // GPIO-Puls für einen LED-Treiber am selben Pin
+};
+
+struct StrobeTiming {
+  int64_t  vsync_us;         // VSYNC des gelieferten Frames (fb->timestamp)
+  int32_t  on_us, off_us;    // Licht an/aus relativ zu vsync_us
+  int32_t  window_start_us;  // gemeinsames Belichtungsfenster [start, 0]
+  uint32_t period_us;        // gemessener Frameabstand
+  int32_t  vsync_error_us;   // gelieferter - vorhergesagter VSYNC
+  bool     aligned;          // Blitz vollständig im Fenster, richtiger Frame
+};
+
+class Strobe {
+public:
+  // ring nur für LIGHT_STROBE_RING; pin = Lichtpin (Treiber)
+  void begin(LightMode mode, Adafruit_NeoPixel *ring, int pin);
+
+  // Belichtungsparameter des Sensors (für das gemeinsame Fenster)
+  void setExposure(uint32_t exposure_us, uint32_t readout_us);
+
+  // Frame mit Blitz kurz vor dem VSYNC, der target_us (esp_timer) am nächsten
+  // liegt. pulse_us = Blitzdauer, guard_us = Abstand zum VSYNC. nullptr, wenn
+  // die Kamera keine Frames liefert. Freigabe mit esp_camera_fb_return.
+  camera_fb_t *capture(int64_t target_us, uint32_t pulse_us,
+                       uint32_t guard_us);
+
+  const StrobeTiming &timing() const { return _t; }
+  LightMode mode() const { return _mode; }
+
+private:
+  static int64_t frameUs(const camera_fb_t *fb);
+  int64_t lightOn();   // liefert den Zeitpunkt, ab dem das Licht an ist
+  int64_t lightOff();
+  static void waitUntil(int64_t t_us);
+
+  LightMode _mode = LIGHT_CONSTANT;
+  Adafruit_NeoPixel *_ring = nullptr;
+  int _pin = -1;
+  uint32_t _exposureUs = 0, _readoutUs = 0;
+  uint32_t _showUs = 400;   // Dauer eines Ring-show() (gleitend gemessen)
+  StrobeTiming _t = {};
+};
+
+} // namespace strobe
@@ -784,7 +784,11 @@ static void block_idct(int32_t *src, /* Input block data (de-quantized and
 /* Load all blocks in an MCU into working buffer                         */
 /*-----------------------------------------------------------------------*/
 
-static JRESULT mcu_load(JDEC *jd /* Pointer to the decompressor object */
+static JRESULT mcu_load(JDEC *jd,     /* Pointer to the decompressor object */
+                        unsigned int skip, /* 1: only advance the stream (MCU
+                                              outside the decode window) */
+                        int16_t *coef /* Quantized coefficients out (zigzag
+                                         order, absolute DC) or NULL */
 ) {
   int32_t *tmp =
       (int32_t *)
@@ -803,8 +807,12 @@ static JRESULT mcu_load(JDEC *jd /* Pointer to the decompressor object */
 
     if (cmp &&
         jd->ncomp != 3) { /* Clear C blocks if not exist (monochrome image) */
-      for (i = 0; i < 64; bp[i++] = 128)
-        ;
+      if (coef) {
+        memset(&coef[blk * 64], 0, 64 * sizeof(int16_t));
+      } else if (!skip) {
+        for (i = 0; i < 64; bp[i++] = 128)
+          ;
+      }
 
     } else {            /* Load Y/C blocks from input stream */
       id = cmp ? 1 : 0; /* Huffman table ID of this component */
@@ -829,9 +837,15 @@ static JRESULT mcu_load(JDEC *jd /* Pointer to the decompressor object */
                                          component */
       tmp[0] = d * dqf[0] >> 8;       /* De-quantize, apply scale factor of Arai
                                          algorithm and descale 8 bits */
+      if (coef) {
+        memset(&coef[blk * 64 + 1], 0, 63 * sizeof(int16_t));
+        coef[blk * 64] = (int16_t)d; /* Absolute (predicted) DC value */
+      }
 
       /* Extract following 63 AC elements from input stream */
-      memset(&tmp[1], 0, 63 * sizeof(int32_t)); /* Initialize all AC elements */
+      if (!skip)
+        memset(&tmp[1], 0,
+               63 * sizeof(int32_t)); /* Initialize all AC elements */
       z = 1; /* Top of the AC elements (in zigzag-order) */
       do {
         d = huffext(
@@ -855,11 +869,14 @@ static JRESULT mcu_load(JDEC *jd /* Pointer to the decompressor object */
           i = Zig[z];               /* Get raster-order index */
           tmp[i] = d * dqf[i] >> 8; /* De-quantize, apply scale factor of Arai
                                        algorithm and descale 8 bits */
+          if (coef)
+            coef[blk * 64 + z] = (int16_t)d; /* Quantized, zigzag order */
         }
       } while (++z < 64); /* Next AC element */
 
-      if (JD_FORMAT != 2 ||
-          !cmp) { /* C components may not be processed if in grayscale output */
+      if (!skip && (JD_FORMAT != 2 ||
+                    !cmp)) { /* C components may not be processed if in
+                                grayscale output or outside the window */
         if (z == 1 ||
             (JD_USE_SCALE &&
              jd->scale ==
@@ -1254,6 +1271,11 @@ JRESULT jd_prepare(
       }
       jd->dptr = seg + ofs - (JD_FASTDECODE ? 0 : 1);
 
+      jd->window.left = 0; /* Decode the whole image unless restricted */
+      jd->window.top = 0;
+      jd->window.right = jd->width - 1;
+      jd->window.bottom = jd->height - 1;
+
       return JDR_OK; /* Initialization succeeded. Ready to decompress the JPEG
                         image. */
 
@@ -1290,7 +1312,7 @@ JRESULT jd_decomp(JDEC *jd, /* Initialized decompression object */
                                  JRECT *), /* RGB output function */
                   uint8_t scale /* Output de-scaling factor (0 to 3) */
 ) {
-  unsigned int x, y, mx, my;
+  unsigned int x, y, mx, my, skip;
   uint16_t rst, rsc;
   JRESULT rc;
 
@@ -1305,8 +1327,11 @@ JRESULT jd_decomp(JDEC *jd, /* Initialized decompression object */
   rst = rsc = 0;
 
   rc = JDR_OK;
-  for (y = 0; y < jd->height; y += my) {  /* Vertical loop of MCUs */
+  for (y = 0; y < jd->height && y <= jd->window.bottom;
+       y += my) {                         /* Vertical loop of MCUs */
     for (x = 0; x < jd->width; x += mx) { /* Horizontal loop of MCUs */
+      skip = (y + my <= jd->window.top || x + mx <= jd->window.left ||
+              x > jd->window.right); /* MCU outside the decode window */
       if (jd->nrst &&
           rst++ == jd->nrst) { /* Process restart interval if enabled */
         rc = restart(jd, rsc++);
@@ -1314,10 +1339,12 @@ JRESULT jd_decomp(JDEC *jd, /* Initialized decompression object */
           return rc;
         rst = 1;
       }
-      rc = mcu_load(jd); /* Load an MCU (decompress huffman coded stream,
-                            dequantize and apply IDCT) */
+      rc = mcu_load(jd, skip, 0); /* Load an MCU (decompress huffman coded
+                                  stream, dequantize and apply IDCT) */
       if (rc != JDR_OK)
         return rc;
+      if (skip)
+        continue;
       rc =
           mcu_output(jd, outfunc, x,
                      y); /* Output the MCU (YCbCr to RGB, scaling and output) */
@@ -1328,3 +1355,46 @@ JRESULT jd_decomp(JDEC *jd, /* Initialized decompression object */
 
   return rc;
 }
+
+/*-----------------------------------------------------------------------*/
+/* Scan the entropy-coded data without decompressing                     */
+/*-----------------------------------------------------------------------*/
+
+JRESULT jd_scan(JDEC *jd, /* Initialized decompression object */
+                int (*coeffunc)(JDEC *, const int16_t *, unsigned int,
+                                unsigned int), /* Coefficient output function */
+                int16_t *coef /* Buffer for (msx * msy + 2) * 64 coefficients */
+) {
+  unsigned int x, y, mx, my;
+  uint16_t rst, rsc;
+  JRESULT rc;
+
+  if (!coef)
+    return JDR_PAR;
+  mx = jd->msx * 8;
+  my = jd->msy * 8; /* Size of the MCU (pixel) */
+
+  jd->dcv[2] = jd->dcv[1] = jd->dcv[0] = 0; /* Initialize DC values */
+  rst = rsc = 0;
+
+  for (y = 0; y < jd->height && y <= jd->window.bottom;
+       y += my) {                         /* Vertical loop of MCUs */
+    for (x = 0; x < jd->width; x += mx) { /* Horizontal loop of MCUs */
+      if (jd->nrst &&
+          rst++ == jd->nrst) { /* Process restart interval if enabled */
+        rc = restart(jd, rsc++);
+        if (rc != JDR_OK)
+          return rc;
+        rst = 1;
+      }
+      rc = mcu_load(jd, 1, coef); /* Huffman decode only, keep the quantized
+                                     coefficients */
+      if (rc != JDR_OK)
+        return rc;
+      if (!coeffunc(jd, coef, x, y))
+        return JDR_INTR; /* Interrupted by the application */
+    }
+  }
+
+  return JDR_OK;
+}
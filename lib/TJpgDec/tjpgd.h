@@ -97,6 +97,9 @@ typedef struct JDEC {
                    size_t); /**< Pointer to jpeg stream input function */
   void *device; /**< Pointer to I/O device identifier for the session */
   uint8_t swap; /**< Byte swap flag added by Bodmer to control byte swapping */
+  JRECT window; /**< Decode window in input pixels, set to the whole image by
+                     jd_prepare(). MCUs outside are entropy-decoded only (no
+                     IDCT, no output); decoding ends after the last window row */
 } JDEC;
 
 /* TJpgDec API functions */
@@ -105,6 +108,18 @@ JRESULT jd_prepare(JDEC *jd, size_t (*infunc)(JDEC *, uint8_t *, size_t),
 JRESULT jd_decomp(JDEC *jd, int (*outfunc)(JDEC *, void *, JRECT *),
                   uint8_t scale);
 
+/**
+ * Entropy-decode the image without dequantization or IDCT. For every MCU
+ * coeffunc receives the quantized coefficients of all its blocks (Y blocks,
+ * then Cb, Cr; 64 each in zigzag order, DC as absolute value) and the MCU
+ * position in pixels. Returning 0 stops the scan with JDR_INTR. Used for
+ * lossless transcoding (crop) and coefficient-domain analysis.
+ */
+JRESULT jd_scan(JDEC *jd,
+                int (*coeffunc)(JDEC *, const int16_t *, unsigned int,
+                                unsigned int),
+                int16_t *coef);
+
 #ifdef __cplusplus
 }
 #endif
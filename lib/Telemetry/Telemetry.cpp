@@ -0,0 +1,108 @@
+#include "Telemetry.h"
+
+namespace telemetry {
+
+// 0..3 direkt, darüber je Oktave 4 Fächer nach den zwei Bits unter dem MSB
+uint8_t Histogram::bucket(uint32_t v) {
+  if (v < 4)
+    return (uint8_t)v;
+  uint8_t msb = 31;
+  while (!(v >> msb))
+    msb--;
+  return (uint8_t)(4 * (msb - 1) + ((v >> (msb - 2)) & 3));
+}
+
+uint32_t Histogram::lowerBound(uint8_t b) {
+  if (b < 4)
+    return b;
+  const uint8_t msb = b / 4 + 1;
+  return (uint32_t)(4 + b % 4) << (msb - 2);
+}
+
+uint32_t Histogram::upperBound(uint8_t b) {
+  return b + 1 < BUCKETS ? lowerBound(b + 1) - 1 : 0xFFFFFFFFu;
+}
+
+void Histogram::record(uint32_t v) {
+  _n[bucket(v)]++;
+  _count++;
+  if (v > _max)
+    _max = v;
+}
+
+void Histogram::merge(const Histogram &other) {
+  for (uint8_t i = 0; i < BUCKETS; i++)
+    _n[i] += other._n[i];
+  _count += other._count;
+  if (other._max > _max)
+    _max = other._max;
+}
+
+void Histogram::reset() {
+  for (uint8_t i = 0; i < BUCKETS; i++)
+    _n[i] = 0;
+  _count = 0;
+  _max = 0;
+}
+
+uint32_t Histogram::percentile(uint8_t pct) const {
+  if (!_count)
+    return 0;
+  // Rang des gesuchten Werts (1-basiert, aufgerundet)
+  const uint64_t rank = ((uint64_t)_count * pct + 99) / 100;
+  uint64_t seen = 0;
+  for (uint8_t i = 0; i < BUCKETS; i++) {
+    seen += _n[i];
+    if (seen >= rank && _n[i]) {
+      const uint32_t hi = upperBound(i);
+      return hi < _max ? hi : _max;
+    }
+  }
+  return _max;
+}
+
+void Histogram::toWire(camlink::TelemetryHistogram *out) const {
+  out->max = _max;
+  out->used = 0;
+  for (uint8_t i = 0; i < BUCKETS; i++) {
+    if (!_n[i])
+      continue;
+    out->index[out->used] = i;
+    out->count[out->used] = _n[i] > 0xFFFF ? 0xFFFF : (uint16_t)_n[i];
+    out->used++;
+  }
+}
+
+void Histogram::addWire(const camlink::TelemetryHistogram &in) {
+  for (uint8_t i = 0; i < in.used; i++) {
+    if (in.index[i] >= BUCKETS)
+      continue;
+    _n[in.index[i]] += in.count[i];
+    _count += in.count[i];
+  }
+  if (in.max > _max)
+    _max = in.max;
+}
+
+void Collector::depth(uint8_t frames_in_flight) {
+  _depthSum += frames_in_flight;
+  _depthSamples++;
+  if (frames_in_flight > _depthMax)
+    _depthMax = frames_in_flight;
+}
+
+void Collector::take(camlink::TelemetryRecord *rec) {
+  for (uint8_t m = 0; m < camlink::TELEMETRY_METRICS; m++) {
+    _hist[m].toWire(&rec->hist[m]);
+    _hist[m].reset();
+  }
+  rec->depth_max = _depthMax;
+  const uint32_t mean16 =
+      _depthSamples ? (_depthSum * 16 + _depthSamples / 2) / _depthSamples : 0;
+  rec->depth_mean_x16 = (uint8_t)(mean16 > 255 ? 255 : mean16);
+  _depthSum = 0;
+  _depthSamples = 0;
+  _depthMax = 0;
+}
+
+} // namespace telemetry
@@ -0,0 +1,66 @@
+#pragma once
+// Telemetry: Latenz- und Größenverteilungen ohne Einzelwerte zu speichern.
+//
+// Histogram zählt Werte in logarithmische Fächer (4 je Oktave, relativer
+// Fehler ≤ 25 %, exakt bis 7); Perzentile sind die Obergrenze des Fachs,
+// höchstens das Maximum. Histogramme lassen sich addieren: der Empfänger
+// fasst so Meldeintervalle und Kameras zusammen, was mit fertigen Perzentilen
+// nicht ginge.
+//
+// Collector sammelt je Frame die Messgrößen aus CamLink::TelemetryMetric und
+// die Zahl der Frames in Arbeit; take() füllt einen TelemetryRecord und
+// beginnt ein neues Intervall. Nicht threadsicher: nur aus dem sendenden Task.
+//
+// Keine Arduino-Abhängigkeit.
+
+#include <stdint.h>
+
+#include "CamLink.h"
+
+namespace telemetry {
+
+static const uint8_t BUCKETS = camlink::TELEMETRY_BUCKETS;
+
+class Histogram {
+public:
+  static uint8_t bucket(uint32_t v);
+  static uint32_t lowerBound(uint8_t bucket);
+  static uint32_t upperBound(uint8_t bucket);
+
+  void record(uint32_t v);
+  void merge(const Histogram &other);
+  void reset();
+
+  uint32_t count() const { return _count; }
+  uint32_t max() const { return _max; }
+  uint32_t percentile(uint8_t pct) const;  // 0 ohne Werte
+
+  void toWire(camlink::TelemetryHistogram *out) const;
+  void addWire(const camlink::TelemetryHistogram &in);
+
+private:
+  uint32_t _n[BUCKETS] = {};
+  uint32_t _count = 0;
+  uint32_t _max = 0;
+};
+
+class Collector {
+public:
+  void record(camlink::TelemetryMetric m, uint32_t v) {
+    if (m < camlink::TELEMETRY_METRICS)
+      _hist[m].record(v);
+  }
+  void depth(uint8_t frames_in_flight);
+
+  // Histogramme und Tiefe nach rec, danach neues Intervall; Zähler und
+  // Kopf setzt der Aufrufer
+  void take(camlink::TelemetryRecord *rec);
+
+private:
+  Histogram _hist[camlink::TELEMETRY_METRICS];
+  uint32_t _depthSum = 0;
+  uint32_t _depthSamples = 0;
+  uint8_t _depthMax = 0;
+};
+
+} // namespace telemetry
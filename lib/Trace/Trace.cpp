@@ -0,0 +1,138 @@
+#include "Trace.h"
+
+#include "CamLink.h"
+
+#if defined(ESP_PLATFORM) || defined(HOST_SIM)
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#else
+#include <chrono>
+#endif
+
+namespace trace {
+
+static TraceRing rings[MAX_CORES];
+static std::atomic<bool> trace_on{false};
+
+const char *eventName(EventId id) {
+  switch (id) {
+  case EV_MARK:     return "mark";
+  case EV_TRIGGER:  return "trigger";
+  case EV_WAIT:     return "wait";
+  case EV_VSYNC:    return "vsync";
+  case EV_FB_GET:   return "fb_get";
+  case EV_STROBE:   return "strobe";
+  case EV_PRESENCE: return "presence";
+  case EV_MEASURE:  return "measure";
+  case EV_CROP:     return "crop";
+  case EV_DECODE:   return "decode";
+  case EV_BLIT:     return "blit";
+  case EV_SEND:     return "send";
+  case EV_FLUSH:    return "flush";
+  case EV_SD_WRITE: return "sd_write";
+  case EV_PROFILE:  return "profile";
+  case EV_COUNT:    break;
+  }
+  return "?";
+}
+
+bool TraceRing::put(const Event &e) {
+  uint32_t head = _head.load(std::memory_order_relaxed);
+  do {
+    if (head - _tail.load(std::memory_order_acquire) >= EVENTS) {
+      _dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+  } while (!_head.compare_exchange_weak(head, head + 1,
+                                        std::memory_order_relaxed));
+  Slot &s = _slot[head & (EVENTS - 1)];
+  s.ev = e;
+  s.seq.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+// Stoppt an der ersten Marke, deren Schreiber noch nicht fertig ist
+uint16_t TraceRing::take(Event *out, uint16_t max) {
+  uint32_t tail = _tail.load(std::memory_order_relaxed);
+  uint16_t n = 0;
+  while (n < max) {
+    const Slot &s = _slot[tail & (EVENTS - 1)];
+    if (s.seq.load(std::memory_order_acquire) != tail + 1)
+      break;
+    out[n++] = s.ev;
+    tail++;
+  }
+  _tail.store(tail, std::memory_order_release);
+  return n;
+}
+
+void setEnabled(bool enable) { trace_on.store(enable, std::memory_order_relaxed); }
+
+bool enabled() { return trace_on.load(std::memory_order_relaxed); }
+
+#if defined(ESP_PLATFORM) || defined(HOST_SIM)
+uint32_t nowUs() { return (uint32_t)esp_timer_get_time(); }
+
+uint8_t coreId() { return (uint8_t)xPortGetCoreID(); }
+#else
+uint32_t nowUs() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+uint8_t coreId() { return 0; }
+#endif
+
+void emitAt(EventId id, Phase phase, uint32_t t_us, uint16_t arg) {
+  if (!enabled())
+    return;
+  const Event e = {t_us, arg, (uint8_t)id, (uint8_t)phase};
+  rings[coreId() % MAX_CORES].put(e);
+}
+
+void emit(EventId id, Phase phase, uint16_t arg) {
+  if (enabled())
+    emitAt(id, phase, nowUs(), arg);
+}
+
+uint16_t drain(uint8_t core, Event *out, uint16_t max) {
+  return core < MAX_CORES ? rings[core].take(out, max) : 0;
+}
+
+size_t drainRecord(uint8_t core, uint32_t seq, uint8_t *out, size_t cap) {
+  if (core >= MAX_CORES || cap < camlink::TRACE_HEADER_SIZE)
+    return 0;
+  size_t max = (cap - camlink::TRACE_HEADER_SIZE) / camlink::TRACE_EVENT_SIZE;
+  if (max > camlink::TRACE_MAX_EVENTS)
+    max = camlink::TRACE_MAX_EVENTS;
+
+  // In kleinen Stücken abholen (wenig Stack im Sende-Task)
+  size_t n = 0;
+  size_t len = camlink::TRACE_HEADER_SIZE;
+  Event ev[16];
+  while (n < max) {
+    const uint16_t want = (uint16_t)(max - n < 16 ? max - n : 16);
+    const uint16_t got = rings[core].take(ev, want);
+    for (uint16_t i = 0; i < got; i++) {
+      const camlink::TraceEvent te = {ev[i].t_us, ev[i].arg, ev[i].id,
+                                      ev[i].phase};
+      len += camlink::encodeTraceEvent(out + len, te);
+    }
+    n += got;
+    if (got < want)
+      break;
+  }
+  if (!n)
+    return 0;
+
+  camlink::TraceHeader hdr = {};
+  hdr.seq = seq;
+  hdr.core = core;
+  hdr.count = (uint8_t)n;
+  hdr.dropped = rings[core].takeDropped();
+  camlink::encodeTraceHeader(out, hdr);
+  return len;
+}
+
+} // namespace trace
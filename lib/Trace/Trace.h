@@ -0,0 +1,116 @@
+#pragma once
+// Trace: Zeitmarken im heißen Pfad, ohne Serial.printf und ohne Sperren
+//
+// Jede Marke (Beginn/Ende eines Abschnitts oder Zeitpunkt) ist 8 Byte groß und
+// landet im Ring des Kerns, auf dem sie entsteht. Mehrere Tasks eines Kerns
+// dürfen gleichzeitig schreiben (Platz per CAS reservieren, dann freigeben);
+// ein Leser pro Ring holt die Marken ab. Ist ein Ring voll, wird verworfen und
+// gezählt statt zu warten.
+//
+// Uhr: Gerät esp_timer_get_time() (64-bit-Systemzähler, auf beiden Kernen
+// gleich; der Zykluszähler ccount läuft je Kern getrennt und nach 18 s über),
+// Host steady_clock, Host-Simulation (HOST_SIM) deren Ersatz für esp_timer und
+// Kern-Etikett; alles in µs, gespeichert werden die unteren 32 Bit.
+//
+// drainRecord() verpackt die Marken eines Kerns als CamLink-Datensatz
+// REC_TRACE; so laufen sie zwischen den Frames über dieselbe Verbindung, ohne
+// den Bildstrom zu stören. Host-Werkzeug trace_export -> Chrome-Trace-JSON.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+namespace trace {
+
+enum EventId : uint8_t {
+  EV_MARK = 0,   // freie Marke (Adafruit_PyCamera::timestampPrint)
+  EV_TRIGGER,    // Trigger-Impuls
+  EV_WAIT,       // Wartezeit bis zur Ankunft des Labels
+  EV_VSYNC,      // Beginn des Auslesens (fb->timestamp)
+  EV_FB_GET,     // esp_camera_fb_get
+  EV_STROBE,     // Blitzaufnahme (VSYNC-Synchronisation bis Frame)
+  EV_PRESENCE,   // DC-Vorschau (PresenceDetector)
+  EV_MEASURE,    // Kantenmessung (LabelMeter)
+  EV_CROP,       // JPEG-Zuschnitt
+  EV_DECODE,     // JPEG -> Display-Vorschau (captureFrame)
+  EV_BLIT,       // Vorschau aufs Display
+  EV_SEND,       // Datensätze auf die serielle Verbindung
+  EV_FLUSH,      // warten, bis die Daten draußen sind
+  EV_SD_WRITE,   // Bild auf die SD-Karte (SdBurst)
+  EV_PROFILE,    // Wechsel des Sensorprofils
+  EV_COUNT
+};
+
+enum Phase : uint8_t {
+  PH_BEGIN   = 'B',
+  PH_END     = 'E',
+  PH_INSTANT = 'i',
+};
+
+const char *eventName(EventId id);
+
+struct Event {
+  uint32_t t_us;  // untere 32 Bit der Uhr
+  uint16_t arg;   // meist Frame-Nummer (untere 16 Bit)
+  uint8_t id;     // EventId
+  uint8_t phase;  // Phase
+};
+
+// Begrenzter Ring: viele Schreiber eines Kerns, ein Leser
+class TraceRing {
+public:
+  static const uint16_t EVENTS = 256;  // Zweierpotenz
+
+  bool put(const Event &e);
+  uint16_t take(Event *out, uint16_t max);
+  uint32_t takeDropped() { return _dropped.exchange(0, std::memory_order_relaxed); }
+
+private:
+  struct Slot {
+    Event ev;
+    std::atomic<uint32_t> seq;  // Position + 1, sobald fertig geschrieben
+  };
+  Slot _slot[EVENTS] = {};
+  std::atomic<uint32_t> _head{0};
+  std::atomic<uint32_t> _tail{0};
+  std::atomic<uint32_t> _dropped{0};
+};
+
+static const uint8_t MAX_CORES = 2;
+
+void setEnabled(bool on);
+bool enabled();
+
+uint32_t nowUs();
+uint8_t coreId();
+
+// Marke mit der aktuellen Zeit bzw. mit einer Zeit derselben Uhr (t_us)
+void emit(EventId id, Phase phase, uint16_t arg = 0);
+void emitAt(EventId id, Phase phase, uint32_t t_us, uint16_t arg = 0);
+
+inline void begin(EventId id, uint16_t arg = 0) { emit(id, PH_BEGIN, arg); }
+inline void end(EventId id, uint16_t arg = 0) { emit(id, PH_END, arg); }
+inline void instant(EventId id, uint16_t arg = 0) { emit(id, PH_INSTANT, arg); }
+
+// Abschnitt für die Lebensdauer des Objekts
+class Span {
+public:
+  explicit Span(EventId id, uint16_t arg = 0) : _id(id), _arg(arg) {
+    begin(id, arg);
+  }
+  ~Span() { end(_id, _arg); }
+
+private:
+  EventId _id;
+  uint16_t _arg;
+};
+
+// Marken eines Kerns abholen (nur ein Leser je Kern)
+uint16_t drain(uint8_t core, Event *out, uint16_t max);
+
+// Bis zu max_events Marken eines Kerns als REC_TRACE-Nutzlast nach out;
+// 0 = nichts abzuholen. seq = laufender Frame (Zuordnung im Empfänger)
+size_t drainRecord(uint8_t core, uint32_t seq, uint8_t *out, size_t cap);
+
+} // namespace trace
@@ -0,0 +1,72 @@
+#include "Vibration.h"
+
+#include <math.h>
+
+namespace vibration {
+
+static const uint8_t MEAN_SHIFT = 6;         // Zeitkonstante 2^6 Samples
+static const uint16_t WARMUP_SAMPLES = 256;  // ~4 Zeitkonstanten
+
+void Monitor::begin(uint16_t window, uint16_t mg_per_lsb_x1000) {
+  *this = Monitor();
+  if (window < 1)
+    window = 1;
+  if (window > MAX_WINDOW)
+    window = MAX_WINDOW;
+  _window = window;
+  _scale = mg_per_lsb_x1000;
+}
+
+void Monitor::gap() {
+  _sum = 0;
+  _pos = 0;
+  _filled = 0;
+}
+
+void Monitor::push(const int16_t *xyz, size_t n) {
+  for (size_t i = 0; i < n; i++, xyz += 3) {
+    if (!_primed) {
+      for (uint8_t a = 0; a < 3; a++)
+        _mean[a] = (int32_t)xyz[a] * 256;
+      _primed = true;
+    }
+    uint64_t e = 0;
+    for (uint8_t a = 0; a < 3; a++) {
+      const int32_t v = (int32_t)xyz[a] * 256;
+      _mean[a] += (v - _mean[a]) >> MEAN_SHIFT;
+      // Abweichung in mg (höchstens ~50 g bei ±16 g)
+      const int64_t d_mg = ((int64_t)(v - _mean[a]) * _scale) / (256 * 1000);
+      e += (uint64_t)(d_mg * d_mg);
+    }
+    const uint32_t e32 = e > 0xFFFFFFFFu ? 0xFFFFFFFFu : (uint32_t)e;
+    if (_filled == _window)
+      _sum -= _e[_pos];
+    else
+      _filled++;
+    _e[_pos] = e32;
+    _sum += e32;
+    if (++_pos == _window)
+      _pos = 0;
+    _samples++;
+    if (!_settled && ++_warmup >= WARMUP_SAMPLES)
+      _settled = true;
+  }
+}
+
+uint16_t Monitor::rmsMg() const {
+  if (!_filled)
+    return 0;
+  const double rms = sqrt((double)_sum / _filled);
+  return rms > 65535.0 ? 65535 : (uint16_t)lround(rms);
+}
+
+uint16_t Monitor::peakMg() const {
+  uint32_t peak = 0;
+  for (uint16_t i = 0; i < _filled; i++)
+    if (_e[i] > peak)
+      peak = _e[i];
+  const double p = sqrt((double)peak);
+  return p > 65535.0 ? 65535 : (uint16_t)lround(p);
+}
+
+} // namespace vibration
@@ -0,0 +1,50 @@
+#pragma once
+// Vibration: Erschütterung des Kamerahalters aus den Rohwerten des LIS3DH.
+//
+// Nimmt die Samples des FIFO stapelweise (x, y, z je Sample, linksbündig wie
+// in OUT_X_L..OUT_Z_H). Die Schwerkraft und eine schräge Montage zieht je
+// Achse ein langsamer gleitender Mittelwert ab (Zeitkonstante 64 Samples,
+// bei 400 Hz 160 ms); vom Rest bildet der Monitor den Betrag je Sample und
+// daraus den Effektivwert (RMS) und die Spitze über die letzten window
+// Samples. Nach begin() braucht der Mittelwert einige Samples, bis er steht;
+// solange meldet settled() false.
+//
+// Keine Arduino-Abhängigkeit; lesen und Ergebnisse verteilen muss der Aufrufer.
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace vibration {
+
+static const uint16_t MAX_WINDOW = 128;  // Samples
+
+class Monitor {
+public:
+  // window: Samples für RMS/Spitze (1..MAX_WINDOW); mg_per_lsb_x1000:
+  // Skala der linksbündigen Rohwerte (±16 g: 750, ±2 g: 62)
+  void begin(uint16_t window, uint16_t mg_per_lsb_x1000);
+
+  // n Samples aus dem FIFO, xyz[3 * n]
+  void push(const int16_t *xyz, size_t n);
+  // Lücke im Datenstrom (FIFO übergelaufen): Fenster neu füllen lassen
+  void gap();
+
+  bool settled() const { return _settled; }
+  uint16_t rmsMg() const;   // Effektivwert über das Fenster [mg]
+  uint16_t peakMg() const;  // größter Betrag im Fenster [mg]
+  uint16_t filled() const { return _filled; }
+  uint32_t samples() const { return _samples; }
+
+private:
+  uint16_t _window = 1;
+  uint32_t _scale = 750;        // mg/LSB × 1000
+  int32_t _mean[3] = {};        // je Achse, LSB × 256
+  uint32_t _e[MAX_WINDOW] = {}; // Betrag² je Sample [mg²]
+  uint64_t _sum = 0;            // Summe über das Fenster
+  uint16_t _pos = 0, _filled = 0;
+  uint32_t _samples = 0;
+  uint16_t _warmup = 0;
+  bool _primed = false, _settled = false;
+};
+
+} // namespace vibration
@@ -0,0 +1,370 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""Ende-zu-Ende-Benchmark: Host-Simulation -> pty -> Empfänger -> Kantenerkennung.
+
+Startet host_sim (src/host/sim) in Echtzeit mit einem pty als Serial, das auf
+den Durchsatz der CDC-Verbindung gedrosselt ist (Standard 5 Mbaud = 500000
+Byte/s), empfängt dort mit image_receiver.receive_images und wertet jedes
+empfangene Bild mit image_compare.detect_reference_line aus. Zuordnung:
+das k-te empfangene Bild gehört zum k-ten abgeholten Frame (Ereignisprotokoll
+der Simulation, --events); Frames ohne Label erzeugen kein Bild und
+verschieben die Zuordnung, daher Aufnahmen mit Label verwenden (--synth).
+
+Ergebnis als JSON (benchmark.json im Ausgabeordner oder --json): Labels/min,
+Latenz-Perzentile je Abschnitt, Auslastung je Stufe und die erste gesättigte
+Stufe. Dazu frames.csv mit den Zeitpunkten je Frame. --compare alt.json
+stellt die Kennzahlen einem früheren Lauf gegenüber.
+
+    python pipeline_benchmark.py --synth 200
+    python pipeline_benchmark.py --frames 2025-09-29 --loops 3 --json - > lauf.json
+    python pipeline_benchmark.py --synth 200 --compare lauf_vorher.json
+"""
+
+import argparse
+import contextlib
+import json
+import os
+import queue
+import re
+import subprocess
+import sys
+import threading
+import time
+from datetime import datetime
+
+# Stufen in Reihenfolge des Datenflusses
+STAGES = ("sensor", "geraet", "link", "empfaenger", "analyse")
+# Latenzabschnitte: (Name, Zeitpunkt von, Zeitpunkt bis)
+SEGMENTS = (
+    ("sensor", "vsync", "fb"),            # Auslesen + Warten im Treiberpuffer
+    ("geraet", "fb", "rx_kopf"),          # Auswertung auf dem Gerät bis zum ersten Byte
+    ("link", "rx_kopf", "rx_daten"),      # Übertragung des Bildes
+    ("empfaenger", "rx_daten", "gespeichert"),
+    ("warteschlange", "gespeichert", "analyse_start"),
+    ("analyse", "analyse_start", "analyse_ende"),
+    ("gesamt", "vsync", "analyse_ende"),
+)
+TIME_COLUMNS = ("vsync", "fb", "rueckgabe", "rx_kopf", "rx_daten", "gespeichert",
+                "analyse_start", "analyse_ende")
+CSV_COLUMNS = ("nr", "vsync", "fb", "rueckgabe", "rx_kopf", "rx_daten", "gespeichert",
+               "analyse_start", "analyse_ende", "bytes", "erkannt", "winkel_deg")
+
+SERIAL_RE = re.compile(r"sim: Serial auf (\S+),")
+
+
+def percentiles(values):
+    """p50/p90/p99/max (Rangverfahren wie telemetry_report) in ms."""
+    if not values:
+        return None
+    v = sorted(values)
+    n = len(v)
+
+    def rank(p):
+        return v[min(n - 1, max(0, (n * p + 99) // 100 - 1))]
+
+    return {"p50": round(rank(50) * 1e3, 2), "p90": round(rank(90) * 1e3, 2),
+            "p99": round(rank(99) * 1e3, 2), "max": round(v[-1] * 1e3, 2), "n": n}
+
+
+def read_events(path):
+    """Ereignisprotokoll der Simulation -> (frames je Nummer, gesendete Bytes).
+
+    Zeitpunkte als Unix-Zeit [s] wie time.time().
+    """
+    epoch, frames, sent = 0.0, {}, 0
+    with open(path, encoding="utf-8") as f:
+        for line in f:
+            parts = line.split()
+            if not parts:
+                continue
+            if parts[0] == "epoch_us":
+                epoch = int(parts[1]) / 1e6
+            elif parts[0] == "frame":
+                frames[int(parts[1])] = {"vsync": int(parts[2]) / 1e6,
+                                         "fb": int(parts[3]) / 1e6}
+            elif parts[0] == "return" and int(parts[1]) in frames:
+                frames[int(parts[1])]["rueckgabe"] = int(parts[2]) / 1e6
+            elif parts[0] == "end":
+                sent = int(parts[2])
+    for fr in frames.values():
+        for k in ("vsync", "fb", "rueckgabe"):
+            if k in fr:
+                fr[k] += epoch
+    return frames, sent
+
+
+def git_commit():
+    """Kurzer Commit-Hash, '+' bei lokalen Änderungen; None ohne git."""
+    here = os.path.dirname(os.path.abspath(__file__))
+    try:
+        rev = subprocess.run(["git", "rev-parse", "--short", "HEAD"], cwd=here,
+                             capture_output=True, text=True, check=True).stdout.strip()
+        dirty = subprocess.run(["git", "status", "--porcelain", "--untracked-files=no"],
+                               cwd=here, capture_output=True, text=True).stdout.strip()
+        return rev + ("+" if dirty else "")
+    except (OSError, subprocess.CalledProcessError):
+        return None
+
+
+def synthesize(tool, count, folder):
+    """Frames mit Label und leichter Streuung über frame_synth erzeugen."""
+    subprocess.run([tool, "--count", str(count), "--rot", "-3:3", "--offset", "-5:5",
+                    "--blur", "0:1", "--glare", "0:80", "--seed", "1", "--out", folder],
+                   check=True)
+    return [folder]
+
+
+def run(args):
+    out_dir = os.path.abspath(args.out)
+    os.makedirs(out_dir, exist_ok=True)
+    sim_path = os.path.abspath(args.sim)
+    frames = [os.path.abspath(p) for p in args.frames]
+    if args.synth:
+        frames = synthesize(os.path.abspath(args.synth_tool), args.synth,
+                            os.path.join(out_dir, "frames"))
+    if not frames:
+        sys.exit("Keine Frames: --frames oder --synth angeben")
+
+    events_path = os.path.join(out_dir, "ereignisse.txt")
+    cmd = [sim_path, "--frames", *frames, "--fps", str(args.fps), "--loops", str(args.loops),
+           "--serial", "pty", "--link", str(args.link), "--realtime", "--events", events_path]
+    if args.duration:
+        cmd += ["--duration", str(args.duration)]
+    sim = subprocess.Popen(cmd, stderr=subprocess.PIPE, text=True)
+
+    # pty-Name aus stderr, danach stderr weiter mitschreiben
+    port, sim_log = None, []
+    for line in sim.stderr:
+        sim_log.append(line.rstrip())
+        m = SERIAL_RE.search(line)
+        if m:
+            port = m.group(1)
+            break
+    if port is None:
+        sim.wait()
+        sys.exit("host_sim ohne pty:\n" + "\n".join(sim_log))
+    drain = threading.Thread(target=lambda: sim_log.extend(l.rstrip() for l in sim.stderr),
+                             daemon=True)
+    drain.start()
+
+    # Empfänger und Analyse legen wie im Betrieb im aktuellen Ordner ab
+    os.chdir(out_dir)
+    sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+    import cv2 as cv
+    import image_compare
+    import image_receiver
+
+    received = []              # je Bild: Zeitpunkte, Größe
+    pending = queue.Queue()    # gespeichert, Analyse steht aus
+    queue_max = [0]
+
+    def on_image(filename, img_data, crop, t_header, t_data):
+        rec = {"rx_kopf": t_header, "rx_daten": t_data, "gespeichert": time.time(),
+               "bytes": len(img_data), "datei": filename}
+        received.append(rec)
+        pending.put(rec)
+        queue_max[0] = max(queue_max[0], pending.qsize())
+
+    def analyze():
+        while True:
+            rec = pending.get()
+            if rec is None:
+                return
+            rec["analyse_start"] = time.time()
+            try:
+                res = image_compare.detect_reference_line(cv.imread(rec["datei"]))
+                rec["erkannt"], rec["winkel_deg"] = 1, round(res["angle_deg"], 4)
+            except Exception:
+                rec["erkannt"], rec["winkel_deg"] = 0, ""
+            rec["analyse_ende"] = time.time()
+
+    sim_done = [None]
+
+    def stop():
+        if sim.poll() is None:
+            return False
+        if sim_done[0] is None:
+            sim_done[0] = time.time()
+        # alle zurückgegebenen Frames da oder Nachlauf vorbei
+        with open(events_path, encoding="utf-8") as f:
+            returned = sum(1 for line in f if line.startswith("return "))
+        return len(received) >= returned or time.time() - sim_done[0] > args.grace
+
+    analyzer = threading.Thread(target=analyze)
+    analyzer.start()
+    with open(os.path.join(out_dir, "empfaenger.log"), "w", encoding="utf-8") as log, \
+            contextlib.redirect_stdout(log):
+        image_receiver.receive_images(port, on_image=on_image, stop=stop)
+    pending.put(None)
+    analyzer.join()
+    sim.wait()
+    drain.join(timeout=1)
+
+    sim_frames, sent = read_events(events_path)
+    return evaluate(args, frames, sim_frames, received, sent, queue_max[0], sim_log,
+                    sim.returncode, out_dir)
+
+
+def evaluate(args, frames, sim_frames, received, sent, queue_max, sim_log, sim_rc, out_dir):
+    # k-tes Bild <-> k-ter zurückgegebener Frame (loop() sendet in Abholreihenfolge)
+    order = sorted((fr for fr in sim_frames.values() if "rueckgabe" in fr),
+                   key=lambda fr: fr["rueckgabe"])
+    rows = []
+    for nr, (fr, rec) in enumerate(zip(order, received)):
+        row = dict(fr)
+        row.update(rec)
+        row["nr"] = nr
+        rows.append(row)
+
+    done = [r for r in rows if "analyse_ende" in r]
+    ok = [r for r in done if r["erkannt"]]
+    t0 = min((r["vsync"] for r in rows), default=0.0)
+    t1 = max((r["analyse_ende"] for r in done), default=t0)
+    window = max(t1 - t0, 1e-9)
+
+    # Labels/min im Dauerbetrieb: Abstand der erkannten Labels am Ende der Kette
+    ends = sorted(r["analyse_ende"] for r in ok)
+    labels_per_min = (len(ends) - 1) / (ends[-1] - ends[0]) * 60 if len(ends) > 1 else 0.0
+    fetched = sorted(fr["fb"] for fr in sim_frames.values())
+    offered = (len(fetched) - 1) / (fetched[-1] - fetched[0]) * 60 if len(fetched) > 1 else 0.0
+
+    latency = {}
+    for name, a, b in SEGMENTS:
+        latency[name] = percentiles([r[b] - r[a] for r in rows if a in r and b in r])
+
+    busy = {
+        "sensor": len(sim_frames) / args.fps,
+        "geraet": sum(r["rx_kopf"] - r["fb"] for r in rows),
+        "link": sent / args.link if args.link else 0.0,
+        "empfaenger": sum(r["gespeichert"] - r["rx_daten"] for r in rows),
+        "analyse": sum(r["analyse_ende"] - r["analyse_start"] for r in done),
+    }
+    load = {s: round(min(busy[s] / window, 1.0), 4) for s in STAGES}
+    saturated = next((s for s in STAGES if load[s] >= args.saturation), None)
+    # Kapazität: Labels/min, die eine Stufe allein schaffen würde. loop()
+    # arbeitet nacheinander, dort sättigt selten eine Stufe; der Engpass ist
+    # die Stufe mit der kleinsten Kapazität
+    n_items = {"sensor": len(sim_frames), "geraet": len(rows), "link": len(rows),
+               "empfaenger": len(rows), "analyse": len(done)}
+    capacity = {s: round(n_items[s] / busy[s] * 60, 1) if busy[s] > 0 else None
+                for s in STAGES}
+    bottleneck = min((s for s in STAGES if capacity[s]), key=lambda s: capacity[s],
+                     default=None)
+
+    with open(os.path.join(out_dir, "frames.csv"), "w", encoding="utf-8") as f:
+        f.write(";".join(CSV_COLUMNS) + "\n")
+        for r in rows:
+            f.write(";".join(
+                f"{r[c] - t0:.6f}" if c in TIME_COLUMNS and c in r else str(r.get(c, ""))
+                for c in CSV_COLUMNS) + "\n")
+
+    return {
+        "version": 1,
+        "commit": git_commit(),
+        "zeit": datetime.now().isoformat(timespec="seconds"),
+        "einstellungen": {
+            "frames": frames, "fps": args.fps, "loops": args.loops,
+            "link_bytes_per_s": args.link, "duration_s": args.duration,
+            "saettigung_ab": args.saturation,
+        },
+        "frames": {
+            "abgeholt": len(sim_frames), "zurueckgegeben": len(order),
+            "empfangen": len(received), "analysiert": len(done), "erkannt": len(ok),
+        },
+        "labels_pro_min": round(labels_per_min, 2),
+        "angeboten_pro_min": round(offered, 2),
+        "dauer_s": round(window, 3),
+        "bytes_gesendet": sent,
+        "latenz_ms": latency,
+        "auslastung": load,
+        "kapazitaet_pro_min": capacity,
+        "warteschlange_max": queue_max,
+        "erste_gesaettigte_stufe": saturated,
+        "engpass": bottleneck,
+        "sim_rueckgabe": sim_rc,
+        "sim_bericht": next((l for l in reversed(sim_log) if "Frames abgeholt" in l), None),
+    }
+
+
+def summary(res):
+    lines = [
+        f"Commit {res['commit']}: {res['frames']['erkannt']}/{res['frames']['abgeholt']} Labels "
+        f"erkannt in {res['dauer_s']:.1f} s",
+        f"Labels/min {res['labels_pro_min']:.1f} (Gerät holt {res['angeboten_pro_min']:.1f}/min ab)",
+    ]
+    for name, p in res["latenz_ms"].items():
+        if p:
+            lines.append(f"  {name:14s} p50 {p['p50']:9.1f}  p90 {p['p90']:9.1f}  "
+                         f"p99 {p['p99']:9.1f}  max {p['max']:9.1f} ms")
+    lines.append("Auslastung: " + ", ".join(f"{s} {v * 100:.0f} %"
+                                           for s, v in res["auslastung"].items()))
+    lines.append("Kapazität [Labels/min]: " + ", ".join(
+        f"{s} {v:.0f}" for s, v in res["kapazitaet_pro_min"].items() if v))
+    sat = res["erste_gesaettigte_stufe"]
+    lines.append(f"Erste gesättigte Stufe: {sat}" if sat else
+                 f"Keine Stufe gesättigt (Takt von loop() begrenzt), Engpass {res['engpass']}")
+    return "\n".join(lines)
+
+
+def compare(old, new):
+    """Kennzahlen zweier Läufe gegenüberstellen."""
+    def delta(a, b):
+        if a is None or b is None:
+            return "-"
+        return f"{a:.1f} -> {b:.1f} ({(b - a) / a * 100:+.1f} %)" if a else f"{a} -> {b}"
+
+    lines = [f"Vergleich {old.get('commit')} -> {new.get('commit')}",
+             f"  Labels/min      {delta(old['labels_pro_min'], new['labels_pro_min'])}"]
+    for name in ("gesamt", "link", "analyse"):
+        a, b = old["latenz_ms"].get(name), new["latenz_ms"].get(name)
+        if a and b:
+            for p in ("p50", "p99"):
+                lines.append(f"  {name} {p:4s}      {delta(a[p], b[p])} ms")
+    lines.append(f"  gesättigt       {old['erste_gesaettigte_stufe']} -> "
+                 f"{new['erste_gesaettigte_stufe']}")
+    return "\n".join(lines)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    ap.add_argument("--sim", default=".pio/build/host_sim/program", help="host_sim-Programm")
+    ap.add_argument("--frames", nargs="+", default=[], help="JPEG-Ordner oder -Dateien")
+    ap.add_argument("--synth", type=int, default=0, help="N Frames mit frame_synth erzeugen")
+    ap.add_argument("--synth-tool", default=".pio/build/host_synth/program")
+    ap.add_argument("--fps", type=float, default=30.0, help="Sensortakt")
+    ap.add_argument("--loops", type=int, default=1, help="Durchläufe durch die Frames")
+    ap.add_argument("--duration", type=float, default=0, help="Laufzeit [s], 0 = bis Frames aus")
+    ap.add_argument("--link", type=int, default=500000,
+                    help="Durchsatz [Byte/s], Standard 5 Mbaud / 10 Bit")
+    ap.add_argument("--saturation", type=float, default=0.9,
+                    help="Auslastung, ab der eine Stufe als gesättigt gilt")
+    ap.add_argument("--grace", type=float, default=10.0,
+                    help="Nachlauf nach Ende der Simulation [s]")
+    ap.add_argument("--out", default=datetime.now().strftime("benchmark_%Y%m%d_%H%M%S"),
+                    help="Ausgabeordner")
+    ap.add_argument("--json", help="Ergebnis hierhin (- = stdout) statt <out>/benchmark.json")
+    ap.add_argument("--compare", help="früheres Ergebnis (JSON) zum Vergleich")
+    args = ap.parse_args()
+
+    old = None
+    if args.compare:
+        with open(args.compare, encoding="utf-8") as f:
+            old = json.load(f)
+    json_path = args.json if args.json in (None, "-") else os.path.abspath(args.json)
+    res = run(args)
+
+    text = json.dumps(res, indent=2, ensure_ascii=False)
+    if json_path == "-":
+        print(text)
+    else:
+        with open(json_path or "benchmark.json", "w", encoding="utf-8") as f:
+            f.write(text + "\n")
+    report = sys.stderr if json_path == "-" else sys.stdout
+    print(summary(res), file=report)
+    if old is not None:
+        print(compare(old, res), file=report)
+    return 0 if res["frames"]["erkannt"] == res["frames"]["abgeholt"] else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,344 @@
+// frame_synth: Host-Werkzeug (pio run -e host_synth) für synthetische Frames
+//
+// Erzeugt Bandbilder mit weißem Label und bekannter Sollgeometrie
+// (framesynth::FrameSynth) für Genauigkeits- und Lasttests von Dekoder,
+// Kantenerkennung (label_measure, image_compare.py) und Empfänger. Lage,
+// Drehung, Anschnitt, Unschärfe und Glanz werden je Frame gleichverteilt aus
+// den angegebenen Bereichen gezogen (A:B oder ein fester Wert); gleicher
+// --seed ergibt unabhängig von --threads dieselben Bilder.
+//
+//   frame_synth [--count N] [--size BxH] [--quality Q | --dqt aufnahme.jpg]
+//               [--noise SIGMA] [--px-per-mm P] [--label BxH_MM]
+//               [--offset MM] [--shift MM] [--rot DEG] [--crop ANTEIL]
+//               [--blur PX] [--glare GRAUSTUFEN] [--glare-r PX] [--seed S]
+//               [--threads N] [--out ordner] [--camlink datei|-]
+//
+// --out schreibt synth_<nr>.jpg und wahrheit.csv (Sollwerte je Bild, auch
+// als COM-Segment im JPEG), --camlink einen REC_JPEG-Strom wie vom Gerät.
+// Ohne Ausgabe wird nur gemessen. Durchsatz steht am Ende auf stderr.
+//
+// Versatz: obere Kantenmitte gegenüber der Bildmitte-Lage (Label mittig),
+// positiv = nach oben; Verschiebung: entlang des Bandes, positiv = rechts.
+// Anschnitt > 0 setzt das Label so tief, dass dieser Anteil seiner Höhe
+// unter dem Bildrand liegt (statt --offset).
+
+#include <sys/stat.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CamLink.h"
+#include "FrameSynth.h"
+
+using framesynth::FrameSynth;
+
+struct Range {
+  double lo = 0, hi = 0;
+};
+
+struct Options {
+  uint32_t count = 100;
+  framesynth::Config cfg = FrameSynth::DEFAULT_CONFIG;
+  std::string dqt;
+  double px_per_mm = 7.0;         // DEFAULT_PX_PER_MM in main.cpp
+  double label_w_mm = 97.0;       // LABEL_TOP_LENGTH_CM
+  double label_h_mm = 60.0;
+  Range offset, shift, rot, crop, blur, glare;
+  double glare_r = 40.0;
+  uint64_t seed = 1;
+  unsigned threads = 1;
+  std::string out;
+  std::string camlink;
+};
+
+// Parameter eines Frames (für die Sollwert-Tabelle)
+struct Frame {
+  framesynth::Scene scene;
+  framesynth::Truth truth;
+  double offset_mm, shift_mm, crop;
+  std::vector<uint8_t> jpg;
+};
+
+static bool parseRange(const char *s, Range *r) {
+  char *end;
+  r->lo = strtod(s, &end);
+  if (end == s)
+    return false;
+  r->hi = *end == ':' ? strtod(end + 1, &end) : r->lo;
+  return !*end && r->hi >= r->lo;
+}
+
+static bool parseSize(const char *s, double *w, double *h) {
+  return sscanf(s, "%lfx%lf", w, h) == 2 && *w > 0 && *h > 0;
+}
+
+static uint64_t splitmix(uint64_t *x) {
+  uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+static double draw(uint64_t *rng, const Range &r) {
+  const double u = (splitmix(rng) >> 11) * (1.0 / 9007199254740992.0);
+  return r.lo + u * (r.hi - r.lo);
+}
+
+// Szene für Frame i; hängt nur von --seed und i ab
+static void makeScene(const Options &o, uint32_t i, Frame *f) {
+  uint64_t rng = o.seed * 0x100000001B3ull + i;
+  const double w = o.cfg.width, h = o.cfg.height;
+  framesynth::Scene &s = f->scene;
+  s = {};
+  s.w = o.label_w_mm * o.px_per_mm;
+  s.h = o.label_h_mm * o.px_per_mm;
+  s.angle_deg = draw(&rng, o.rot);
+  f->offset_mm = draw(&rng, o.offset);
+  f->shift_mm = draw(&rng, o.shift);
+  f->crop = draw(&rng, o.crop);
+  s.cx = (w - 1) / 2 + f->shift_mm * o.px_per_mm;
+  s.cy = (h - 1) / 2 - f->offset_mm * o.px_per_mm;
+  if (f->crop > 0)
+    s.cy = (h - 1) + f->crop * s.h - s.h / 2;
+  s.blur_px = draw(&rng, o.blur);
+  s.glare = draw(&rng, o.glare);
+  // Glanzpunkt irgendwo auf dem Label
+  const double gu = (draw(&rng, {-0.4, 0.4})) * s.w;
+  const double gv = (draw(&rng, {-0.4, 0.4})) * s.h;
+  const double rad = s.angle_deg * M_PI / 180;
+  s.glare_x = s.cx + gu * cos(rad) - gv * sin(rad);
+  s.glare_y = s.cy + gu * sin(rad) + gv * cos(rad);
+  s.glare_r = o.glare_r;
+  s.seed = (uint32_t)splitmix(&rng);
+}
+
+static const char *CSV_HEADER =
+    "datei;seq;tl_x;tl_y;tr_x;tr_y;angle_deg;sichtbar;angeschnitten;"
+    "mitte_x;mitte_y;px_per_mm;versatz_mm;verschiebung_mm;drehung_deg;"
+    "anschnitt;unschaerfe_px;glanz;bytes";
+
+static std::string fileName(uint32_t i) {
+  char name[32];
+  snprintf(name, sizeof(name), "synth_%06u.jpg", i);
+  return name;
+}
+
+static void printRow(FILE *csv, const Options &o, uint32_t i, const Frame &f) {
+  const framesynth::Truth &t = f.truth;
+  const framesynth::Scene &s = f.scene;
+  fprintf(csv,
+          "%s;%u;%.4f;%.4f;%.4f;%.4f;%.4f;%d;%d;%.4f;%.4f;%.4f;%.4f;%.4f;"
+          "%.4f;%.4f;%.3f;%.1f;%zu\n",
+          fileName(i).c_str(), i, t.tl_x, t.tl_y, t.tr_x, t.tr_y, t.angle_deg,
+          t.visible, t.partial, s.cx, s.cy, o.px_per_mm, f.offset_mm,
+          f.shift_mm, s.angle_deg, f.crop, s.blur_px, s.glare, f.jpg.size());
+}
+
+static bool readFile(const std::string &path, std::vector<uint8_t> *out) {
+  std::ifstream f(path, std::ios::binary);
+  if (!f)
+    return false;
+  out->assign(std::istreambuf_iterator<char>(f),
+              std::istreambuf_iterator<char>());
+  return true;
+}
+
+static void usage() {
+  fprintf(stderr,
+          "Aufruf: frame_synth [--count N] [--size BxH] [--quality Q | --dqt "
+          "aufnahme.jpg] [--noise SIGMA]\n"
+          "                    [--px-per-mm P] [--label BxH_MM] [--offset MM] "
+          "[--shift MM] [--rot DEG]\n"
+          "                    [--crop ANTEIL] [--blur PX] [--glare GRAUSTUFEN] "
+          "[--glare-r PX] [--seed S]\n"
+          "                    [--threads N] [--out ordner] [--camlink "
+          "datei|-]\n"
+          "Bereiche als A:B (gleichverteilt je Frame) oder fester Wert\n");
+}
+
+int main(int argc, char **argv) {
+  Options o;
+  for (int i = 1; i < argc; i++) {
+    const char *a = argv[i];
+    const char *v = i + 1 < argc ? argv[i + 1] : nullptr;
+    bool ok = v != nullptr;
+    if (!strcmp(a, "--count") && v) {
+      o.count = (uint32_t)strtoul(v, nullptr, 10);
+    } else if (!strcmp(a, "--size") && v) {
+      double w, h;
+      ok = parseSize(v, &w, &h) && w <= 65535 && h <= 65535;
+      o.cfg.width = (uint16_t)w;
+      o.cfg.height = (uint16_t)h;
+    } else if (!strcmp(a, "--quality") && v) {
+      o.cfg.quality = (uint8_t)atoi(v);
+    } else if (!strcmp(a, "--dqt") && v) {
+      o.dqt = v;
+    } else if (!strcmp(a, "--noise") && v) {
+      o.cfg.noise = atof(v);
+    } else if (!strcmp(a, "--px-per-mm") && v) {
+      o.px_per_mm = atof(v);
+      ok = o.px_per_mm > 0;
+    } else if (!strcmp(a, "--label") && v) {
+      ok = parseSize(v, &o.label_w_mm, &o.label_h_mm);
+    } else if (!strcmp(a, "--offset") && v) {
+      ok = parseRange(v, &o.offset);
+    } else if (!strcmp(a, "--shift") && v) {
+      ok = parseRange(v, &o.shift);
+    } else if (!strcmp(a, "--rot") && v) {
+      ok = parseRange(v, &o.rot) && o.rot.lo > -45 && o.rot.hi < 45;
+    } else if (!strcmp(a, "--crop") && v) {
+      ok = parseRange(v, &o.crop) && o.crop.lo >= 0 && o.crop.hi < 1;
+    } else if (!strcmp(a, "--blur") && v) {
+      ok = parseRange(v, &o.blur) && o.blur.lo >= 0;
+    } else if (!strcmp(a, "--glare") && v) {
+      ok = parseRange(v, &o.glare) && o.glare.lo >= 0;
+    } else if (!strcmp(a, "--glare-r") && v) {
+      o.glare_r = atof(v);
+      ok = o.glare_r > 0;
+    } else if (!strcmp(a, "--seed") && v) {
+      o.seed = strtoull(v, nullptr, 10);
+    } else if (!strcmp(a, "--threads") && v) {
+      o.threads = (unsigned)atoi(v);
+      ok = o.threads > 0;
+    } else if (!strcmp(a, "--out") && v) {
+      o.out = v;
+    } else if (!strcmp(a, "--camlink") && v) {
+      o.camlink = v;
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      fprintf(stderr, "Ungültige Option %s\n", a);
+      usage();
+      return 2;
+    }
+    i++;
+  }
+
+  std::vector<uint8_t> dqt;
+  if (!o.dqt.empty() && !readFile(o.dqt, &dqt)) {
+    fprintf(stderr, "Kann %s nicht lesen\n", o.dqt.c_str());
+    return 2;
+  }
+  // Ein Generator je Thread (~300 KB, daher auf dem Heap)
+  std::vector<FrameSynth *> synth(o.threads);
+  for (FrameSynth *&s : synth) {
+    s = new FrameSynth();
+    framesynth::Result r = s->begin(o.cfg);
+    if (r == framesynth::OK && !dqt.empty())
+      r = s->useTablesFrom(dqt.data(), dqt.size());
+    if (r != framesynth::OK) {
+      fprintf(stderr, "frame_synth: %s\n", framesynth::resultName(r));
+      return 2;
+    }
+  }
+
+  FILE *csv = nullptr;
+  if (!o.out.empty()) {
+    mkdir(o.out.c_str(), 0755);
+    csv = fopen((o.out + "/wahrheit.csv").c_str(), "w");
+    if (!csv) {
+      perror(o.out.c_str());
+      return 2;
+    }
+    fprintf(csv, "%s\n", CSV_HEADER);
+  }
+  FILE *link = nullptr;
+  if (!o.camlink.empty()) {
+    link = o.camlink == "-" ? stdout : fopen(o.camlink.c_str(), "wb");
+    if (!link) {
+      perror(o.camlink.c_str());
+      return 2;
+    }
+  }
+
+  // In Blöcken rechnen, in Reihenfolge schreiben
+  const uint32_t batch = o.threads * 16;
+  std::vector<Frame> frames(batch);
+  const size_t cap = synth[0]->maxJpegSize();
+  std::vector<std::vector<uint8_t>> bufs(o.threads, std::vector<uint8_t>(cap));
+  uint64_t bytes = 0;
+  const auto t0 = std::chrono::steady_clock::now();
+  bool failed = false;
+  for (uint32_t base = 0; base < o.count && !failed; base += batch) {
+    const uint32_t n = std::min(batch, o.count - base);
+    std::atomic<uint32_t> next{0};
+    std::atomic<bool> error{false};
+    auto work = [&](unsigned t) {
+      FrameSynth *s = synth[t];
+      std::vector<uint8_t> &buf = bufs[t];
+      for (uint32_t k; (k = next.fetch_add(1)) < n;) {
+        Frame &f = frames[k];
+        makeScene(o, base + k, &f);
+        f.truth = s->truth(f.scene);
+        char comment[160];
+        snprintf(comment, sizeof(comment),
+                 "framesynth seq=%u tl=%.4f,%.4f tr=%.4f,%.4f angle=%.4f",
+                 base + k, f.truth.tl_x, f.truth.tl_y, f.truth.tr_x,
+                 f.truth.tr_y, f.truth.angle_deg);
+        size_t len = 0;
+        const framesynth::Result r =
+            s->render(f.scene, comment, buf.data(), cap, &len);
+        if (r != framesynth::OK) {
+          fprintf(stderr, "Frame %u: %s\n", base + k, framesynth::resultName(r));
+          error = true;
+          return;
+        }
+        f.jpg.assign(buf.begin(), buf.begin() + len);
+      }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < o.threads; t++)
+      pool.emplace_back(work, t);
+    work(0);
+    for (std::thread &t : pool)
+      t.join();
+    if (error) {
+      failed = true;
+      break;
+    }
+
+    for (uint32_t k = 0; k < n; k++) {
+      const Frame &f = frames[k];
+      bytes += f.jpg.size();
+      if (csv) {
+        const std::string path = o.out + "/" + fileName(base + k);
+        FILE *img = fopen(path.c_str(), "wb");
+        if (!img || fwrite(f.jpg.data(), 1, f.jpg.size(), img) != f.jpg.size()) {
+          perror(path.c_str());
+          failed = true;
+        }
+        if (img)
+          fclose(img);
+        printRow(csv, o, base + k, f);
+      }
+      if (link) {
+        uint8_t hdr[camlink::HEADER_SIZE];
+        camlink::encodeHeader(hdr, camlink::REC_JPEG, (uint32_t)f.jpg.size());
+        fwrite(hdr, 1, sizeof(hdr), link);
+        fwrite(f.jpg.data(), 1, f.jpg.size(), link);
+      }
+    }
+  }
+  const double dt = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - t0).count();
+  if (csv)
+    fclose(csv);
+  if (link && link != stdout)
+    fclose(link);
+  fprintf(stderr,
+          "frame_synth: %u Frames %ux%u in %.2f s, %.0f Frames/s, %.1f MB/s, "
+          "im Mittel %.1f KB (%u Threads)\n",
+          o.count, o.cfg.width, o.cfg.height, dt, dt > 0 ? o.count / dt : 0.0,
+          dt > 0 ? bytes / dt / 1e6 : 0.0,
+          o.count ? bytes / 1024.0 / o.count : 0.0, o.threads);
+  return failed ? 1 : 0;
+}
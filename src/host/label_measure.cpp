@@ -0,0 +1,300 @@
+// label_measure: Host-Werkzeug (pio run -e host_measure) für den Messmodus
+//
+// Rechnet aufgezeichnete JPEG-Frames mit exakt demselben Code wie die Firmware
+// (LabelMeter, tjpgd, Festkomma) nach.
+//
+//   label_measure [--scale N | --stream] [--track] [--presence] [--len CM]
+//                 [--max-mm MM] [--max-deg DEG] ref.jpg bild1.jpg ...
+//                                             -> CSV wie messungen.csv
+//   label_measure --check <tagesordner>/messungen.csv
+//                                             -> Bitvergleich mit dem Gerät
+//   label_measure --trace trace.bin ...       -> Zeitmarken (Presence, Messung)
+//                                                für trace_export
+//
+// Die Voreinstellungen entsprechen den Konstanten in src/main.cpp.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "LabelMeter.h"
+#include "PresenceDetector.h"
+#include "Trace.h"
+
+using labelgeom::LabelMeter;
+using labelgeom::MeterConfig;
+using labelgeom::q16_t;
+
+static const double DEFAULT_LABEL_TOP_LENGTH_CM = 9.7;
+static const uint8_t DEFAULT_SCALE = 1;
+static const double DEFAULT_ANOMALY_OFFSET_MM = 3.0;
+static const double DEFAULT_ANOMALY_ROTATION_DEG = 1.0;
+
+static q16_t q16(double v) { return (q16_t)(v * 65536.0 + (v < 0 ? -0.5 : 0.5)); }
+
+static bool readFile(const std::string &path, std::vector<uint8_t> *out) {
+  std::ifstream f(path, std::ios::binary);
+  if (!f)
+    return false;
+  out->assign(std::istreambuf_iterator<char>(f),
+              std::istreambuf_iterator<char>());
+  return true;
+}
+
+static const char *CSV_HEADER =
+    "seq;t_ms;flags;scale;status;tl_x;tl_y;tr_x;tr_y;angle_deg;px_per_cm;"
+    "offset_center_px;rotation_delta_deg;left_offset_px;right_offset_px;"
+    "offset_center_mm;rotation_deg;datei;crop_x;crop_y";
+
+static void printRecord(const camlink::MeasurementRecord &r,
+                        const std::string &file) {
+  const double mm =
+      labelgeom::toFloat(labelgeom::pxToMm(r.offset_center_px, r.px_per_cm));
+  printf("%u;%u;%u;%u;%u;%d;%d;%d;%d;%d;%d;%d;%d;%d;%d;%.4f;%.4f;%s;;\n", r.seq,
+         r.t_ms, r.flags, r.scale, r.status, r.tl_x, r.tl_y, r.tr_x, r.tr_y,
+         r.angle_deg, r.px_per_cm, r.offset_center_px, r.rotation_delta_deg,
+         r.left_offset_px, r.right_offset_px, mm,
+         labelgeom::toFloat(r.rotation_delta_deg), file.c_str());
+}
+
+static std::vector<std::string> splitCsv(const std::string &line) {
+  std::vector<std::string> out;
+  std::stringstream ss(line);
+  std::string item;
+  while (std::getline(ss, item, ';'))
+    out.push_back(item);
+  return out;
+}
+
+static bool parseRow(const std::vector<std::string> &c,
+                     camlink::MeasurementRecord *r, std::string *file,
+                     bool *cropped) {
+  if (c.size() < 15)
+    return false;
+  long v[15];
+  for (int i = 0; i < 15; i++)
+    v[i] = strtol(c[i].c_str(), nullptr, 10);
+  r->seq = (uint32_t)v[0];
+  r->t_ms = (uint32_t)v[1];
+  r->flags = (uint16_t)v[2];
+  r->scale = (uint8_t)v[3];
+  r->status = (uint8_t)v[4];
+  r->tl_x = (int32_t)v[5];
+  r->tl_y = (int32_t)v[6];
+  r->tr_x = (int32_t)v[7];
+  r->tr_y = (int32_t)v[8];
+  r->angle_deg = (int32_t)v[9];
+  r->px_per_cm = (int32_t)v[10];
+  r->offset_center_px = (int32_t)v[11];
+  r->rotation_delta_deg = (int32_t)v[12];
+  r->left_offset_px = (int32_t)v[13];
+  r->right_offset_px = (int32_t)v[14];
+  *file = c.size() > 17 ? c[17] : std::string();
+  *cropped = c.size() > 18 && !c[18].empty();
+  return true;
+}
+
+static bool sameMeasurement(const camlink::MeasurementRecord &a,
+                            const camlink::MeasurementRecord &b) {
+  const uint16_t mask = camlink::MEAS_VALID | camlink::MEAS_ANOMALY |
+                        camlink::MEAS_REFERENCE | camlink::MEAS_TRACKED;
+  return (a.flags & mask) == (b.flags & mask) && a.status == b.status &&
+         a.tl_x == b.tl_x && a.tl_y == b.tl_y && a.tr_x == b.tr_x &&
+         a.tr_y == b.tr_y && a.angle_deg == b.angle_deg &&
+         a.px_per_cm == b.px_per_cm &&
+         a.offset_center_px == b.offset_center_px &&
+         a.rotation_delta_deg == b.rotation_delta_deg &&
+         a.left_offset_px == b.left_offset_px &&
+         a.right_offset_px == b.right_offset_px;
+}
+
+static LabelMeter meter;  // enthält den Scratch-Speicher, nicht auf den Stack
+static labelgeom::PresenceDetector presence;
+
+// Gesammelte Zeitmarken als REC_TRACE-Datensätze anhängen
+static void writeTrace(FILE *f, uint32_t seq) {
+  uint8_t buf[camlink::TRACE_HEADER_SIZE +
+              camlink::TRACE_MAX_EVENTS * camlink::TRACE_EVENT_SIZE];
+  size_t len;
+  while ((len = trace::drainRecord(0, seq, buf, sizeof(buf))) != 0) {
+    uint8_t hdr[camlink::HEADER_SIZE];
+    camlink::encodeHeader(hdr, camlink::REC_TRACE, (uint32_t)len);
+    fwrite(hdr, 1, sizeof(hdr), f);
+    fwrite(buf, 1, len, f);
+  }
+}
+
+static int runCheck(const std::string &csvPath, MeterConfig cfg) {
+  std::ifstream f(csvPath);
+  if (!f) {
+    fprintf(stderr, "Kann %s nicht lesen\n", csvPath.c_str());
+    return 2;
+  }
+  const size_t slash = csvPath.find_last_of("/\\");
+  const std::string dir =
+      slash == std::string::npos ? std::string() : csvPath.substr(0, slash + 1);
+
+  struct Row {
+    camlink::MeasurementRecord rec;
+    std::string file;
+    bool cropped;  // nur ein Ausschnitt (REC_JPEG_CROP), nicht nachmessbar
+  };
+  std::vector<Row> rows;
+  std::string line;
+  std::getline(f, line);  // Kopfzeile
+  bool haveRef = false;
+  while (std::getline(f, line)) {
+    Row row;
+    if (!parseRow(splitCsv(line), &row.rec, &row.file, &row.cropped))
+      continue;
+    if (row.rec.flags & camlink::MEAS_REFERENCE) {
+      if (haveRef)
+        rows.clear();  // Gerät neu gestartet: ab der letzten Referenz prüfen
+      haveRef = true;
+      cfg.scale = row.rec.scale;
+      cfg.streaming = (row.rec.flags & camlink::MEAS_STREAMED) != 0;
+    }
+    if (row.rec.flags & camlink::MEAS_TRACKED)
+      cfg.tracking = true;
+    if (haveRef)
+      rows.push_back(row);
+  }
+  if (!haveRef) {
+    fprintf(stderr, "Kein Referenzframe in %s\n", csvPath.c_str());
+    return 2;
+  }
+
+  std::vector<uint8_t> plane(
+      LabelMeter::planeBytes(labelgeom::MAX_WIDTH, labelgeom::MAX_HEIGHT, 0));
+  meter.begin(plane.data(), plane.size(), cfg);
+
+  // Alle Datensätze in Aufnahmereihenfolge: Frames mit JPEG werden neu
+  // gemessen, die übrigen (auch Ausschnitte) schreiben nur Referenz und
+  // Tracker fort
+  unsigned checked = 0, mismatches = 0;
+  for (const Row &r : rows) {
+    std::vector<uint8_t> jpg;
+    if (r.file.empty() || r.cropped || !readFile(dir + r.file, &jpg)) {
+      if (!r.file.empty() && !r.cropped)
+        fprintf(stderr, "Fehlt: %s\n", (dir + r.file).c_str());
+      meter.replay(r.rec);
+      continue;
+    }
+    camlink::MeasurementRecord host;
+    meter.measure(jpg.data(), jpg.size(), r.rec.seq, r.rec.t_ms, &host);
+    checked++;
+    if (!sameMeasurement(host, r.rec)) {
+      mismatches++;
+      printf("ABWEICHUNG seq %u (%s)\n  Gerät: ", r.rec.seq, r.file.c_str());
+      printRecord(r.rec, r.file);
+      printf("  Host:  ");
+      printRecord(host, r.file);
+    }
+  }
+  printf("%u Frames geprüft, %u Abweichungen\n", checked, mismatches);
+  return mismatches ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+  MeterConfig cfg = {};
+  cfg.label_top_length_cm = q16(DEFAULT_LABEL_TOP_LENGTH_CM);
+  cfg.scale = DEFAULT_SCALE;
+  cfg.anomaly_offset_mm = q16(DEFAULT_ANOMALY_OFFSET_MM);
+  cfg.anomaly_rotation_deg = q16(DEFAULT_ANOMALY_ROTATION_DEG);
+
+  std::vector<std::string> files;
+  std::string check;
+  std::string tracePath;
+  bool checkPresence = false;
+  for (int i = 1; i < argc; i++) {
+    const std::string a = argv[i];
+    if (a == "--scale" && i + 1 < argc)
+      cfg.scale = (uint8_t)atoi(argv[++i]);
+    else if (a == "--stream")
+      cfg.streaming = true;
+    else if (a == "--track")
+      cfg.tracking = true;
+    else if (a == "--presence")
+      checkPresence = true;
+    else if (a == "--len" && i + 1 < argc)
+      cfg.label_top_length_cm = q16(atof(argv[++i]));
+    else if (a == "--max-mm" && i + 1 < argc)
+      cfg.anomaly_offset_mm = q16(atof(argv[++i]));
+    else if (a == "--max-deg" && i + 1 < argc)
+      cfg.anomaly_rotation_deg = q16(atof(argv[++i]));
+    else if (a == "--check" && i + 1 < argc)
+      check = argv[++i];
+    else if (a == "--trace" && i + 1 < argc)
+      tracePath = argv[++i];
+    else
+      files.push_back(a);
+  }
+
+  if (!check.empty())
+    return runCheck(check, cfg);
+
+  if (files.empty()) {
+    fprintf(stderr, "Aufruf: label_measure [Optionen] ref.jpg bild.jpg ... | "
+                    "--check messungen.csv\n");
+    return 2;
+  }
+
+  std::vector<uint8_t> plane(
+      LabelMeter::planeBytes(labelgeom::MAX_WIDTH, labelgeom::MAX_HEIGHT, 0));
+  if (!meter.begin(plane.data(), plane.size(), cfg)) {
+    fprintf(stderr, "Ungueltige Skalierung\n");
+    return 2;
+  }
+
+  std::vector<uint8_t> thumb(labelgeom::PresenceDetector::thumbBytes(
+      labelgeom::MAX_WIDTH, labelgeom::MAX_HEIGHT, 8));
+  presence.begin(thumb.data(), thumb.size());
+
+  FILE *traceFile = nullptr;
+  if (!tracePath.empty()) {
+    traceFile = fopen(tracePath.c_str(), "wb");
+    if (!traceFile) {
+      fprintf(stderr, "Kann %s nicht schreiben\n", tracePath.c_str());
+      return 2;
+    }
+    trace::setEnabled(true);
+  }
+
+  printf("%s\n", CSV_HEADER);
+  uint32_t seq = 0;
+  for (const std::string &path : files) {
+    std::vector<uint8_t> jpg;
+    if (!readFile(path, &jpg)) {
+      fprintf(stderr, "Fehlt: %s\n", path.c_str());
+      continue;
+    }
+    // Wie die Firmware mit PRESENCE_CHECK: leere Frames nicht messen
+    labelgeom::Presence seen = labelgeom::LABEL_PRESENT;
+    if (checkPresence) {
+      trace::Span span(trace::EV_PRESENCE, (uint16_t)seq);
+      seen = presence.detect(jpg.data(), jpg.size());
+    }
+    camlink::MeasurementRecord rec = {};
+    if (seen == labelgeom::LABEL_ABSENT) {
+      rec.seq = seq++;
+      rec.flags = camlink::MEAS_EMPTY;
+      rec.status = labelgeom::NO_LABEL;
+      meter.replay(rec);
+    } else {
+      trace::Span span(trace::EV_MEASURE, (uint16_t)seq);
+      meter.measure(jpg.data(), jpg.size(), seq++, 0, &rec);
+      if (seen == labelgeom::LABEL_PARTIAL)
+        rec.flags |= camlink::MEAS_PARTIAL;
+    }
+    printRecord(rec, path);
+    if (traceFile)
+      writeTrace(traceFile, seq);
+  }
+  if (traceFile)
+    fclose(traceFile);
+  return 0;
+}
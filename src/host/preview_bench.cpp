@@ -0,0 +1,102 @@
+// Vorschau-Messung in der Host-Simulation (statt src/main.cpp gebaut)
+// pio run -e host_preview && .pio/build/host_preview/program --frames 2025-09-29 --fps 120 --loops 4
+//
+// Die Vorschauschleife der Adafruit-Beispiele (captureFrame, Statuszeile,
+// blitFrame) in drei Dritteln der Frames: synchron, nach beginAsyncBlit()
+// mit Display-Task, dann zusätzlich mit beginCompositor() und der
+// Statuszeile als Overlay statt im fb. Je Drittel stehen Bildrate, mittlere
+// Zeit für Holen + Dekodieren und für blitFrame() sowie gesendete Kacheln auf
+// stderr. Der ST7789-Ersatz rechnet 40 MHz SPI; --fps über der Vorschaurate
+// wählen, damit nicht der Sensor bremst. Ruhiges Band: ein einzelnes Bild mit
+// --loops wiederholen.
+
+#include <Arduino.h>
+
+#include "Adafruit_PyCamera.h"
+#include "sim.h"
+
+static const uint16_t OVERLAY_KEY = 0xF81F;  // Magenta = durchsichtig
+
+static Adafruit_PyCamera pycamera;
+static GFXcanvas16 status_line(240, 16);
+
+struct Phase {
+  const char *name;
+  uint32_t frames = 0, tiles = 0;
+  int64_t t_start = 0, capture_us = 0, blit_us = 0;
+};
+
+static Phase phases[3] = {{"synchron"}, {"asynchron"}, {"kacheln"}};
+static uint8_t phase = 0;
+
+static void report(const Phase &p) {
+  if (!p.frames)
+    return;
+  const double t = (esp_timer_get_time() - p.t_start) / 1e6;
+  fprintf(stderr,
+          "vorschau %-9s %4u Frames  %5.1f Frames/s  holen+dekodieren %5.2f ms  "
+          "blit %5.2f ms  %5.1f Kacheln/Frame\n",
+          p.name, p.frames, p.frames / t, p.capture_us / 1e3 / p.frames,
+          p.blit_us / 1e3 / p.frames,
+          phase < 2 ? 225.0 : (double)p.tiles / p.frames);
+}
+
+// Statuszeile wie in den Beispielen: ändert sich nur im Zähler
+static void drawStatus(Adafruit_GFX *gfx, int16_t y, uint16_t bg) {
+  const uint32_t n = phases[phase].frames;
+  gfx->fillRect(0, y, 240, 16, bg);
+  gfx->fillRect(0, y + 4, 80, 8, ST77XX_WHITE);
+  gfx->fillRect(160, y + 4, (n / 4) % 80, 8, ST77XX_GREEN);
+}
+
+void setup() {
+  if (!pycamera.begin(PYCAM_DISPLAY, FRAMESIZE_240X240)) {
+    fprintf(stderr, "vorschau: Kamera/Display fehlt\n");
+    sim::stop();
+    return;
+  }
+  phases[0].t_start = esp_timer_get_time();
+}
+
+static void nextPhase() {
+  phase++;
+  if (phase == 1 && !pycamera.beginAsyncBlit(0))
+    fprintf(stderr, "vorschau: keine Display-Task, weiter synchron\n");
+  if (phase == 2) {
+    if (!pycamera.beginCompositor() ||
+        pycamera.addOverlay(&status_line, 0, 224, OVERLAY_KEY) < 0)
+      fprintf(stderr, "vorschau: kein Compositor\n");
+    status_line.fillScreen(OVERLAY_KEY);
+  }
+  phases[phase].t_start = esp_timer_get_time();
+}
+
+void loop() {
+  Phase &p = phases[phase];
+  const int64_t t0 = esp_timer_get_time();
+  if (!pycamera.captureFrame()) {
+    // Frames aufgebraucht: letzte Übertragung abwarten, dann auswerten
+    pycamera.waitBlit();
+    p.tiles = pycamera.tiles_sent;
+    report(p);
+    fprintf(stderr, "vorschau: %u Mal auf das Display gewartet\n", pycamera.blit_stalls);
+    delay(1);
+    return;
+  }
+  const int64_t t1 = esp_timer_get_time();
+  if (phase < 2)
+    drawStatus(pycamera.fb, 224, ST77XX_BLACK);
+  else
+    drawStatus(&status_line, 0, OVERLAY_KEY);
+  pycamera.blitFrame();
+  p.capture_us += t1 - t0;
+  p.blit_us += esp_timer_get_time() - t1;
+  p.frames++;
+
+  if (phase < 2 && p.frames >= sim::framesTotal() / 3) {
+    // Zeitraum endet, wenn das letzte Bild draußen ist
+    pycamera.waitBlit();
+    report(p);
+    nextPhase();
+  }
+}
@@ -0,0 +1,28 @@
+#pragma once
+// AW9523-Ersatz: Ausgänge werden gemerkt, Tasten sind losgelassen (high),
+// SD-Karte nur mit --sd gesteckt
+
+#include <Adafruit_BusIO_Register.h>
+
+#include "sim.h"
+
+class Adafruit_AW9523 {
+public:
+  bool begin(uint8_t addr = 0x58, TwoWire *wire = &Wire) { return true; }
+  void pinMode(uint8_t pin, uint8_t mode) {}
+  void digitalWrite(uint8_t pin, bool val) {
+    _out = val ? _out | (1u << pin) : _out & ~(1u << pin);
+  }
+  bool digitalRead(uint8_t pin) { return (inputGPIO() >> pin) & 1; }
+  uint16_t inputGPIO() {
+    return sim::sdPresent() ? 0xFFFF : (uint16_t)~(1u << AWEXP_SD_DET);
+  }
+  bool interruptEnableGPIO(uint16_t pins) { return true; }
+  bool outputGPIO(uint16_t pins) {
+    _out = pins;
+    return true;
+  }
+
+private:
+  uint16_t _out = 0;
+};
@@ -0,0 +1,40 @@
+#pragma once
+// Adafruit BusIO-Ersatz: Register merken den letzten geschriebenen Wert;
+// WHO_AM_I (0x0F) meldet einen LIS3DH
+
+#include "Adafruit_I2CDevice.h"
+
+class Adafruit_BusIO_Register {
+public:
+  Adafruit_BusIO_Register(Adafruit_I2CDevice *dev, uint16_t reg, uint8_t width = 1)
+      : _reg(reg), _value(reg == 0x0F ? 0x33 : 0) {}
+  bool read(uint8_t *buf, uint8_t len) {
+    memset(buf, 0, len);
+    return true;
+  }
+  uint32_t read() { return _value; }
+  bool write(uint8_t *buf, uint8_t len) { return true; }
+  bool write(uint32_t value, uint8_t len = 0) {
+    _value = value;
+    return true;
+  }
+
+private:
+  uint16_t _reg;
+  uint32_t _value;
+};
+
+class Adafruit_BusIO_RegisterBits {
+public:
+  Adafruit_BusIO_RegisterBits(Adafruit_BusIO_Register *reg, uint8_t bits, uint8_t shift)
+      : _reg(reg), _bits(bits), _shift(shift) {}
+  bool write(uint32_t value) {
+    const uint32_t mask = ((1u << _bits) - 1) << _shift;
+    return _reg->write((_reg->read() & ~mask) | ((value << _shift) & mask));
+  }
+  uint32_t read() { return (_reg->read() >> _shift) & ((1u << _bits) - 1); }
+
+private:
+  Adafruit_BusIO_Register *_reg;
+  uint8_t _bits, _shift;
+};
@@ -0,0 +1,55 @@
+#pragma once
+// Adafruit GFX-Ersatz: Text und Linien ohne Wirkung, Pixel und Rechtecke in
+// GFXcanvas16 mit echtem Puffer
+
+#include <Arduino.h>
+
+class Adafruit_GFX {
+public:
+  Adafruit_GFX(int16_t w, int16_t h) : _width(w), _height(h) {}
+  virtual ~Adafruit_GFX() {}
+  virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+  virtual void fillScreen(uint16_t color) {}
+  void setRotation(uint8_t r) { _rotation = r & 3; }
+  uint8_t getRotation() const { return _rotation; }
+  void drawRGBBitmap(int16_t x, int16_t y, const uint16_t *bitmap, int16_t w, int16_t h) {}
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    for (int16_t j = y; j < y + h; j++)
+      for (int16_t i = x; i < x + w; i++)
+        drawPixel(i, j, color);
+  }
+  void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {}
+  void setCursor(int16_t x, int16_t y) {}
+  void setTextColor(uint16_t c) {}
+  void setTextColor(uint16_t c, uint16_t bg) {}
+  void setTextSize(uint8_t s) {}
+  size_t print(const char *s) { return strlen(s); }
+  size_t println(const char *s = "") { return strlen(s) + 1; }
+  int16_t width() const { return _width; }
+  int16_t height() const { return _height; }
+
+protected:
+  int16_t _width, _height;
+  uint8_t _rotation = 0;
+};
+
+class GFXcanvas16 : public Adafruit_GFX {
+public:
+  GFXcanvas16(uint16_t w, uint16_t h) : Adafruit_GFX(w, h) {
+    buffer = (uint16_t *)calloc((size_t)w * h, sizeof(uint16_t));
+  }
+  ~GFXcanvas16() { free(buffer); }
+  void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+    if (buffer && x >= 0 && y >= 0 && x < _width && y < _height)
+      buffer[(size_t)y * _width + x] = color;
+  }
+  void fillScreen(uint16_t color) override {
+    if (buffer)
+      for (size_t i = 0; i < (size_t)_width * _height; i++)
+        buffer[i] = color;
+  }
+  uint16_t *getBuffer() const { return buffer; }
+
+protected:
+  uint16_t *buffer;
+};
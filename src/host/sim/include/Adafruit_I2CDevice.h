@@ -0,0 +1,32 @@
+#pragma once
+// Adafruit BusIO-Ersatz: I2C-Gerät ohne Bus; Register liefern feste Werte,
+// nur der LIS3DH (0x19) antwortet aus sim_accel.cpp
+
+#include <Wire.h>
+
+#include "sim.h"
+
+class Adafruit_I2CDevice {
+public:
+  Adafruit_I2CDevice(uint8_t addr, TwoWire *wire = &Wire) : _addr(addr) {}
+  bool begin(bool addr_detect = true) { return true; }
+  uint8_t address() const { return _addr; }
+  bool read(uint8_t *buf, size_t len, bool stop = true) {
+    memset(buf, 0, len);
+    return true;
+  }
+  bool write(const uint8_t *buf, size_t len, bool stop = true,
+             const uint8_t *prefix = nullptr, size_t prefix_len = 0) {
+    return _addr == 0x19 && !prefix_len ? sim::accelWrite(buf, len) : true;
+  }
+  bool write_then_read(const uint8_t *wbuf, size_t wlen, uint8_t *rbuf, size_t rlen,
+                       bool stop = false) {
+    if (_addr == 0x19 && wlen)
+      return sim::accelRead(wbuf[0] & 0x7F, rbuf, rlen);  // Bit 7: Auto-Inkrement
+    memset(rbuf, 0, rlen);
+    return true;
+  }
+
+private:
+  uint8_t _addr;
+};
@@ -0,0 +1,51 @@
+#pragma once
+// NeoPixel-Ersatz: Farben werden gemerkt, show() gibt nichts aus
+
+#include <Arduino.h>
+
+#define NEO_GRB ((1 << 6) | (1 << 4) | (0 << 2) | (2))
+#define NEO_GRBW ((3 << 6) | (1 << 4) | (0 << 2) | (2))
+#define NEO_KHZ800 0x0000
+
+class Adafruit_NeoPixel {
+public:
+  Adafruit_NeoPixel(uint16_t n = 0, int16_t pin = -1, uint16_t type = NEO_GRB)
+      : _pin(pin) {
+    updateLength(n);
+  }
+  void begin() {}
+  void show() {}
+  void setPin(int16_t pin) { _pin = pin; }
+  int16_t getPin() const { return _pin; }
+  void updateType(uint16_t type) {}
+  void updateLength(uint16_t n) { _n = n < MAX_PIXELS ? n : MAX_PIXELS; }
+  uint16_t numPixels() const { return _n; }
+  void setBrightness(uint8_t b) { _brightness = b; }
+  uint8_t getBrightness() const { return _brightness; }
+  void setPixelColor(uint16_t i, uint32_t c) {
+    if (i < _n)
+      _px[i] = c;
+  }
+  void setPixelColor(uint16_t i, uint8_t r, uint8_t g, uint8_t b) {
+    setPixelColor(i, Color(r, g, b));
+  }
+  uint32_t getPixelColor(uint16_t i) const { return i < _n ? _px[i] : 0; }
+  void fill(uint32_t c = 0, uint16_t first = 0, uint16_t count = 0) {
+    for (uint16_t i = first; i < _n && (!count || i < first + count); i++)
+      _px[i] = c;
+  }
+  void clear() { fill(0); }
+  static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) {
+    return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+  }
+  static uint32_t Color(uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
+    return ((uint32_t)w << 24) | Color(r, g, b);
+  }
+
+private:
+  static const uint16_t MAX_PIXELS = 64;
+  uint32_t _px[MAX_PIXELS] = {};
+  uint16_t _n = 0;
+  int16_t _pin;
+  uint8_t _brightness = 255;
+};
@@ -0,0 +1,39 @@
+#pragma once
+// ST7789-Ersatz: Display ohne Ausgabe. Pixelübertragungen (writePixels,
+// drawRGBBitmap) kosten die SPI-Zeit bei angenommenen 40 MHz, 16 Bit je
+// Pixel; ein Adressfenster 11 Byte (CASET, RASET, RAMWR samt Daten).
+
+#include <SPI.h>
+
+#include "Adafruit_GFX.h"
+#include "sim.h"
+
+#define ST77XX_BLACK 0x0000
+#define ST77XX_WHITE 0xFFFF
+#define ST77XX_RED 0xF800
+#define ST77XX_GREEN 0x07E0
+#define ST77XX_BLUE 0x001F
+
+class Adafruit_ST7789 : public Adafruit_GFX {
+public:
+  Adafruit_ST7789(int8_t cs, int8_t dc, int8_t rst) : Adafruit_GFX(240, 240) {}
+  void init(uint16_t w, uint16_t h, uint8_t spi_mode = 0) {
+    _width = w;
+    _height = h;
+  }
+  void drawPixel(int16_t x, int16_t y, uint16_t color) override {}
+  void startWrite() {}
+  void endWrite() {}
+  void setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) { sendBytes(11); }
+  void writePixels(uint16_t *colors, uint32_t len, bool block = true, bool big_endian = false) {
+    sendBytes(len * 2);
+  }
+  void dmaWait() {}
+  void drawRGBBitmap(int16_t x, int16_t y, const uint16_t *bitmap, int16_t w, int16_t h) {
+    sendBytes(11 + (uint32_t)w * h * 2);
+  }
+
+private:
+  static const uint32_t SPI_HZ = 40000000;
+  static void sendBytes(uint32_t n) { sim::sleepUs((int64_t)n * 8 * 1000000 / SPI_HZ); }
+};
@@ -0,0 +1,115 @@
+#pragma once
+// Arduino-Ersatz für die Host-Simulation: Zeit auf der Simulationsuhr,
+// GPIO als Speicher, Serial auf pty/Datei (sim_arduino.cpp). Pinbelegung wie
+// variants/adafruit_camera_esp32s3/pins_arduino.h.
+
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+#define DEC 10
+#define HEX 16
+
+#define F(x) x
+#define PROGMEM
+#define memcpy_P memcpy
+#define IRAM_ATTR
+
+#define ESP_LOGE(tag, ...) do {} while (0)
+#define ESP_LOGW(tag, ...) do {} while (0)
+#define ESP_LOGI(tag, ...) do {} while (0)
+#define ESP_LOGD(tag, ...) do {} while (0)
+
+// Adafruit Memento (ESP32-S3)
+#define SPEAKER 46
+#define PIN_NEOPIXEL 1
+#define A1 17
+#define SHUTTER_BUTTON 0
+#define TFT_CS 39
+#define TFT_DC 40
+#define TFT_RESET 38
+#define SD_CS 48
+#define SCK 36
+#define MOSI 35
+#define MISO 37
+#define BATT_MONITOR 4
+#define AWEXP_SPKR_SD 0
+#define AWEXP_BUTTON_SEL 1
+#define AWEXP_SD_PWR 8
+#define AWEXP_SD_DET 9
+#define AWEXP_BUTTON_RIGHT 10
+#define AWEXP_BUTTON_OK 11
+#define AWEXP_BUTTON_DOWN 13
+#define AWEXP_BUTTON_LEFT 14
+#define AWEXP_BUTTON_UP 15
+#define XCLK_GPIO_NUM 8
+#define Y9_GPIO_NUM 7
+#define Y8_GPIO_NUM 9
+#define Y7_GPIO_NUM 10
+#define Y6_GPIO_NUM 12
+#define Y5_GPIO_NUM 14
+#define Y4_GPIO_NUM 16
+#define Y3_GPIO_NUM 15
+#define Y2_GPIO_NUM 13
+#define VSYNC_GPIO_NUM 5
+#define HREF_GPIO_NUM 6
+#define PCLK_GPIO_NUM 11
+
+class HWCDC {
+public:
+  void begin(unsigned long baud);
+  size_t write(const uint8_t *buf, size_t len);
+  size_t write(uint8_t c) { return write(&c, 1); }
+  int printf(const char *fmt, ...);
+  size_t print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+  size_t print(long v, int base = DEC);
+  size_t println(const char *s = "") { return print(s) + print("\r\n"); }
+  size_t println(long v, int base = DEC) { return print(v, base) + print("\r\n"); }
+  int availableForWrite();
+  int available() { return 0; }
+  int read() { return -1; }
+  void flush();  // wartet, bis die Verbindung die Daten übertragen hätte
+  operator bool() const;  // Host verbunden (nicht während --link-down)
+};
+
+extern HWCDC Serial;
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration = 0);
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode);
+void attachInterruptArg(uint8_t pin, void (*isr)(void *), void *arg, int mode);
+static inline int digitalPinToInterrupt(uint8_t pin) { return pin; }
+
+void *ps_malloc(size_t size);
+void *ps_calloc(size_t n, size_t size);
+
+using std::max;
+using std::min;
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
@@ -0,0 +1,48 @@
+#pragma once
+// Preferences-Ersatz (NVS): Schlüssel je Namensraum im Speicher des Prozesses;
+// wie nach dem Löschen des Flashs beginnt jeder Lauf leer
+
+#include <Arduino.h>
+
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+class Preferences {
+public:
+  bool begin(const char *name, bool readOnly = false, const char *partition = nullptr) {
+    _ns = name;
+    _readOnly = readOnly;
+    return true;
+  }
+  void end() { _ns.clear(); }
+  bool isKey(const char *key) { return store().count(_ns + '/' + key) != 0; }
+  bool remove(const char *key) { return !_readOnly && store().erase(_ns + '/' + key) != 0; }
+  size_t putBytes(const char *key, const void *value, size_t len) {
+    if (_readOnly || _ns.empty())
+      return 0;
+    const uint8_t *p = (const uint8_t *)value;
+    store()[_ns + '/' + key].assign(p, p + len);
+    return len;
+  }
+  size_t getBytesLength(const char *key) {
+    auto it = store().find(_ns + '/' + key);
+    return it == store().end() ? 0 : it->second.size();
+  }
+  size_t getBytes(const char *key, void *buf, size_t maxLen) {
+    auto it = store().find(_ns + '/' + key);
+    if (it == store().end() || it->second.size() > maxLen)
+      return 0;
+    memcpy(buf, it->second.data(), it->second.size());
+    return it->second.size();
+  }
+
+private:
+  static std::map<std::string, std::vector<uint8_t>> &store() {
+    static std::map<std::string, std::vector<uint8_t>> s;
+    return s;
+  }
+  std::string _ns;
+  bool _readOnly = false;
+};
@@ -0,0 +1,76 @@
+#pragma once
+// SdFat-Ersatz: ohne --sd keine Karte (begin() und open() schlagen fehl); mit
+// --sd <ordner> steht ein Host-Ordner für das Wurzelverzeichnis der Karte.
+// Pfade wie auf der Karte ("/BURST/..."), Dateien über POSIX-Aufrufe;
+// preAllocate und sync tun nichts, was die Simulation bräuchte.
+
+#include <Arduino.h>
+#include <fcntl.h>
+
+#include <string>
+
+#define SD_SCK_MHZ(mhz) ((mhz) * 1000000UL)
+#define FILE_READ O_RDONLY
+#define FILE_WRITE (O_RDWR | O_CREAT | O_APPEND)
+#define LS_DATE 1
+#define LS_SIZE 2
+#define LS_R 4
+
+class File {
+public:
+  bool open(const char *path, int flags = O_RDONLY);
+  bool isOpen() const { return _fd >= 0 || _dir; }
+  explicit operator bool() const { return isOpen(); }
+  size_t write(const void *buf, size_t len);
+  int read(void *buf, size_t len);
+  bool seekSet(uint64_t pos);
+  uint64_t fileSize() const;
+  uint64_t curPosition() const;
+  bool sync() { return _fd >= 0; }
+  bool truncate(uint64_t len = 0);
+  bool preAllocate(uint64_t len) { return _fd >= 0 && fileSize() == 0; }
+  bool getName(char *name, size_t len);
+  bool isDir() const { return _dir != nullptr; }
+  bool openNext(File *dir, int flags = O_RDONLY);
+  bool remove();
+  bool rename(const char *path);
+  bool close();
+
+private:
+  int _fd = -1;
+  void *_dir = nullptr;  // DIR*
+  std::string _path;     // auf der Karte
+};
+typedef File FsFile;
+typedef File File32;
+
+class SdCard {
+public:
+  uint8_t errorCode() const;  // 0x01 = Timeout beim Kommando (keine Karte)
+  uint32_t errorData() const { return 0; }
+  uint32_t cardSize() const;  // Sektoren des Dateisystems unter --sd
+  uint32_t sectorCount() const { return cardSize(); }
+};
+
+class FsVolume {
+public:
+  uint8_t fatType() const;
+};
+
+class SdFat {
+public:
+  SdCard *card() { return &_card; }
+  FsVolume *vol() { return &_vol; }
+  bool begin(uint8_t cs, uint32_t clock = 0);
+  bool exists(const char *path);
+  bool mkdir(const char *path);
+  bool remove(const char *path);
+  bool rename(const char *from, const char *to);
+  File open(const char *path, int flags = O_RDONLY);
+  void ls(uint8_t flags = 0) {}
+  uint8_t sdErrorCode() const { return _card.errorCode(); }
+
+private:
+  SdCard _card;
+  FsVolume _vol;
+};
@@ -0,0 +1,23 @@
+#pragma once
+// Wire-Ersatz: I2C ohne Bus; antworten nur die Adressen der Memento-Bausteine
+
+#include <Arduino.h>
+
+class TwoWire {
+public:
+  bool begin(int sda = -1, int scl = -1, uint32_t freq = 0) { return true; }
+  void setClock(uint32_t freq) {}
+  void beginTransmission(uint8_t addr) { _addr = addr; }
+  uint8_t endTransmission(bool stop = true) {
+    // Kamera (SCCB), LIS3DH, AW9523
+    return _addr == 0x3C || _addr == 0x19 || _addr == 0x58 ? 0 : 2;
+  }
+  size_t write(uint8_t c) { return 1; }
+  uint8_t requestFrom(uint8_t addr, uint8_t n) { return 0; }
+  int read() { return -1; }
+
+private:
+  uint8_t _addr = 0;
+};
+
+extern TwoWire Wire;
@@ -0,0 +1,6 @@
+#pragma once
+// esp_timer-Ersatz: µs seit Start auf der Simulationsuhr
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time();
@@ -0,0 +1,79 @@
+#pragma once
+// sim: Steuerung der Host-Simulation (pio run -e host_sim)
+//
+// Die Firmware (src/main.cpp, Adafruit_PyCamera, TJpg_Decoder) läuft
+// unverändert gegen die Ersatz-Header in diesem Ordner. Uhr: millis(),
+// micros() und esp_timer_get_time() zählen echte Rechenzeit; Wartezeiten
+// (delay, Warten auf den nächsten Frame, Serial.flush) werden übersprungen und
+// nur auf die Uhr aufgeschlagen. Solange Tasks laufen oder mit realtime
+// wird wirklich gewartet, weil ein gemeinsamer Sprung der Uhr die parallel
+// laufenden Tasks verfälschen würde.
+
+#include <stdint.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sim {
+
+struct Options {
+  std::vector<std::string> frames;  // JPEG-Dateien in Abspielreihenfolge
+  double fps = 30.0;                // Sensortakt
+  uint32_t loops = 1;               // Durchläufe durch die Frames
+  std::string serial;               // "pty", Dateiname oder leer (verwerfen)
+  uint32_t link_bytes_per_s = 0;    // Durchsatz der Verbindung, 0 = unbegrenzt
+  bool realtime = false;            // Wartezeiten wirklich abwarten
+  double duration_s = 0;            // virtuelle Laufzeit, 0 = bis die Frames aus sind
+  std::string events;               // Ereignisprotokoll je Frame, leer = keins
+  std::string sd_dir;               // Host-Ordner als SD-Karte, leer = keine Karte
+  std::vector<std::pair<double, double>> link_down;  // Ausfälle [s, s) der Verbindung
+  std::vector<std::pair<double, double>> shake;      // Erschütterung [s, s) des LIS3DH
+};
+
+const Options &options();
+// Host-Tests (pio test -e host_test) haben keine Kommandozeile: Optionen direkt
+Options &testOptions();
+
+// Uhr (µs seit Start, wie esp_timer_get_time)
+int64_t nowUs();
+// Wartezeit: überspringen oder schlafen (siehe oben)
+void sleepUs(int64_t us);
+// In delay()/vTaskDelay(): nach stop() beendet die Hauptschleife die
+// Simulation, Tasks kehren nicht mehr zurück
+void checkStop();
+// Wirklich warten, solange eine Task läuft (Pipeline-Tasks enden nie,
+// kurze Tasks wie die Start-Task geben beim Beenden mit leaveRealtime ab)
+void enterRealtime();
+void leaveRealtime();
+
+// Ende der Simulation: Frames aufgebraucht oder Laufzeit erreicht
+void stop();
+bool stopped();
+// Tasks melden, wenn sie blockieren, damit das Ende auf laufende Frames wartet
+void taskBusy(int delta);
+// Gesendete Frames zählen, laufende Tasks auslaufen lassen, Bericht, Ende
+[[noreturn]] void finish();
+
+// Ereignisprotokoll (--events): eine Zeile "<art> <werte...>" je Aufruf,
+// beginnt mit "epoch_us <Unix-Zeit in µs bei Uhr 0>"
+bool openEvents(const std::string &path);
+void logEvent(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+// Serial-Ausgabe öffnen (pty / Datei) und Zähler
+bool openSerial(const std::string &target);
+uint64_t serialBytes();
+// Während --link-down: Host nicht verbunden, Schreiben wird verworfen
+bool linkDown();
+uint64_t serialDropped();
+// Karte unter --sd gesteckt (AW9523-Ersatz, SD_DET)
+bool sdPresent();
+// LIS3DH an 0x19 (sim_accel.cpp): Registerzugriffe wie auf dem Bus
+bool accelWrite(const uint8_t *buf, size_t len);
+bool accelRead(uint8_t reg, uint8_t *buf, size_t len);
+// Kamera
+bool loadFrames(const std::vector<std::string> &files);
+uint32_t framesDelivered();
+uint32_t framesTotal();
+
+} // namespace sim
@@ -0,0 +1,89 @@
+// LIS3DH der Host-Simulation (I2C 0x19 über Adafruit_I2CDevice): 400 Hz,
+// ±16 g, linksbündig. Das Gerät liegt ruhig (1 g auf z, etwas Rauschen);
+// während --shake VON:BIS schwingt es mit 400 mg bei 25 Hz (x) und 200 mg
+// bei 40 Hz (y). Im FIFO-Stream-Modus (CTRL5 FIFO_EN, FIFO_CTRL 0x80) liegen
+// die Samples seit dem letzten Lesen bereit, höchstens 32; ältere gehen
+// verloren und FIFO_SRC meldet den Überlauf.
+
+#include <math.h>
+#include <string.h>
+
+#include <mutex>
+
+#include "sim.h"
+
+namespace sim {
+
+static const int64_t SAMPLE_US = 2500;   // 400 Hz
+static const double LSB_PER_MG = 1 / 0.75;
+static const int64_t FIFO_DEPTH = 32;
+
+static std::mutex accel_mutex;
+static uint8_t ctrl5 = 0, fifo_ctrl = 0;
+static int64_t next_sample = 0;  // ältestes ungelesenes Sample im FIFO
+
+static bool shaking(double t) {
+  for (const auto &w : options().shake)
+    if (t >= w.first && t < w.second)
+      return true;
+  return false;
+}
+
+static void sample(int64_t k, uint8_t *out) {
+  const double t = k * SAMPLE_US / 1e6;
+  // Rauschen ±6 mg, reproduzierbar
+  const uint32_t h = (uint32_t)k * 2654435761u;
+  double mg[3] = {(int)(h >> 28) - 8.0, (int)((h >> 24) & 15) - 8.0,
+                  1000 + (int)((h >> 20) & 15) - 8.0};
+  if (shaking(t)) {
+    mg[0] += 400 * sin(2 * M_PI * 25 * t);
+    mg[1] += 200 * sin(2 * M_PI * 40 * t);
+  }
+  for (int a = 0; a < 3; a++) {
+    const int16_t v = (int16_t)lround(mg[a] * LSB_PER_MG);
+    out[2 * a] = (uint8_t)v;
+    out[2 * a + 1] = (uint8_t)((uint16_t)v >> 8);
+  }
+}
+
+static bool fifoStream() { return (ctrl5 & 0x40) && (fifo_ctrl & 0xC0) == 0x80; }
+
+bool accelWrite(const uint8_t *buf, size_t len) {
+  std::lock_guard<std::mutex> lock(accel_mutex);
+  if (len < 2)
+    return true;
+  if (buf[0] == 0x24)
+    ctrl5 = buf[1];
+  if (buf[0] == 0x2E) {
+    fifo_ctrl = buf[1];
+    next_sample = nowUs() / SAMPLE_US;  // Bypass leert den FIFO
+  }
+  return true;
+}
+
+bool accelRead(uint8_t reg, uint8_t *buf, size_t len) {
+  std::lock_guard<std::mutex> lock(accel_mutex);
+  memset(buf, 0, len);
+  const int64_t newest = nowUs() / SAMPLE_US;
+  if (reg == 0x0F) {
+    buf[0] = 0x33;
+  } else if (reg == 0x2F) {
+    int64_t n = fifoStream() ? newest - next_sample : 0;
+    uint8_t src = n ? 0 : 0x20;  // EMPTY
+    if (n >= FIFO_DEPTH) {
+      next_sample = newest - FIFO_DEPTH;
+      n = FIFO_DEPTH - 1;
+      src |= 0x40;  // OVRN_FIFO
+    }
+    buf[0] = src | (uint8_t)n;
+  } else if (reg == 0x28) {
+    for (size_t i = 0; i + 6 <= len; i += 6) {
+      // Ohne FIFO bzw. leer: das aktuelle Sample
+      const bool queued = fifoStream() && next_sample < newest;
+      sample(queued ? next_sample++ : newest, buf + i);
+    }
+  }
+  return true;
+}
+
+} // namespace sim
@@ -0,0 +1,215 @@
+// Arduino-Ersatz der Host-Simulation: Uhr, GPIO, Speicher, Serial
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <mutex>
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "Wire.h"
+#include "sim.h"
+
+HWCDC Serial;
+TwoWire Wire;
+SPIClass SPI;
+
+// ========================== Uhr ==========================
+int64_t esp_timer_get_time() { return sim::nowUs(); }
+
+uint32_t millis() { return (uint32_t)(sim::nowUs() / 1000); }
+
+uint32_t micros() { return (uint32_t)sim::nowUs(); }
+
+void delay(uint32_t ms) {
+  sim::checkStop();
+  sim::sleepUs((int64_t)ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us) { sim::sleepUs(us); }
+
+// ========================== GPIO ==========================
+static const uint8_t PIN_COUNT = 49;
+static uint8_t pin_level[PIN_COUNT];
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin < PIN_COUNT && mode == INPUT_PULLUP)
+    pin_level[pin] = HIGH;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if (pin < PIN_COUNT)
+    pin_level[pin] = val ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin) { return pin < PIN_COUNT ? pin_level[pin] : LOW; }
+
+// Batteriemessung: ~3,9 V hinter dem 1:2-Teiler
+uint16_t analogRead(uint8_t pin) { return pin == BATT_MONITOR ? 2420 : 0; }
+
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration) {}
+
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode) {}
+
+void attachInterruptArg(uint8_t pin, void (*isr)(void *), void *arg, int mode) {}
+
+void *ps_malloc(size_t size) { return malloc(size); }
+
+void *ps_calloc(size_t n, size_t size) { return calloc(n, size); }
+
+// ========================== Serial ==========================
+// Wie HWCDC: write() kehrt zurück, sobald der Rest in den Sendepuffer passt;
+// flush() wartet, bis die Verbindung (--link) alles übertragen hätte
+static const size_t TX_BUFFER = 256;  // Arduino-ESP32 HWCDC-Standard
+
+static std::mutex serial_mutex;
+static int serial_fd = -1;
+static uint64_t serial_bytes = 0;
+static uint64_t serial_dropped = 0;  // während --link-down verworfen
+static int64_t link_free_us = 0;  // bis dahin ist die Verbindung belegt
+
+namespace sim {
+
+static bool openPty() {
+  const int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) || unlockpt(master)) {
+    perror("sim: pty");
+    return false;
+  }
+  const char *name = ptsname(master);
+  // Rohdaten: keine Zeilenumbruch-Umsetzung, kein Echo
+  const int slave = open(name, O_RDWR | O_NOCTTY);
+  if (slave >= 0) {
+    termios t;
+    tcgetattr(slave, &t);
+    cfmakeraw(&t);
+    tcsetattr(slave, TCSANOW, &t);
+    close(slave);
+  }
+  fprintf(stderr, "sim: Serial auf %s, warte auf Empfänger (image_receiver.py %s)\n",
+          name, name);
+  // Ohne geöffnete Gegenseite meldet der Master POLLHUP
+  while (true) {
+    pollfd p = {master, POLLOUT, 0};
+    poll(&p, 1, 100);
+    if (!(p.revents & POLLHUP))
+      break;
+    usleep(100000);
+  }
+  // pyserial leert nach dem Öffnen noch den Eingangspuffer
+  usleep(500000);
+  serial_fd = master;
+  return true;
+}
+
+bool openSerial(const std::string &target) {
+  if (target.empty())
+    return true;
+  if (target == "pty")
+    return openPty();
+  serial_fd = open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (serial_fd < 0) {
+    perror(target.c_str());
+    return false;
+  }
+  return true;
+}
+
+uint64_t serialBytes() {
+  std::lock_guard<std::mutex> lock(serial_mutex);
+  return serial_bytes;
+}
+
+uint64_t serialDropped() {
+  std::lock_guard<std::mutex> lock(serial_mutex);
+  return serial_dropped;
+}
+
+bool linkDown() {
+  const double t = nowUs() / 1e6;
+  for (const auto &w : options().link_down)
+    if (t >= w.first && t < w.second)
+      return true;
+  return false;
+}
+
+} // namespace sim
+
+void HWCDC::begin(unsigned long baud) {}
+
+// Ein Stück von höchstens TX_BUFFER Bytes: warten, bis es in den Puffer passt
+static void writeChunk(const uint8_t *buf, size_t len) {
+  // Host nicht verbunden: der Treiber nimmt nichts an
+  if (sim::linkDown()) {
+    serial_dropped += len;
+    return;
+  }
+  const uint32_t rate = sim::options().link_bytes_per_s;
+  if (rate) {
+    const int64_t now = sim::nowUs();
+    link_free_us = std::max(link_free_us, now) + (int64_t)(len * 1000000ull / rate);
+    sim::sleepUs(link_free_us - (int64_t)(TX_BUFFER * 1000000ull / rate) - now);
+  }
+  size_t done = 0;
+  while (serial_fd >= 0 && done < len) {
+    const ssize_t n = ::write(serial_fd, buf + done, len - done);
+    if (n > 0) {
+      done += (size_t)n;
+    } else if (n < 0 && errno != EINTR) {
+      // Empfänger weg (pty geschlossen): ab jetzt verwerfen
+      fprintf(stderr, "sim: Serial geschlossen, Daten werden verworfen\n");
+      serial_fd = -1;
+    }
+  }
+  serial_bytes += len;
+}
+
+size_t HWCDC::write(const uint8_t *buf, size_t len) {
+  std::lock_guard<std::mutex> lock(serial_mutex);
+  // Stückweise wie der Treiber, damit der Empfänger einen gleichmäßigen Strom sieht
+  for (size_t pos = 0; pos < len; pos += TX_BUFFER)
+    writeChunk(buf + pos, std::min(len - pos, TX_BUFFER));
+  return len;
+}
+
+int HWCDC::printf(const char *fmt, ...) {
+  char buf[256];
+  va_list ap;
+  va_start(ap, fmt);
+  const int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  if (n > 0)
+    write((const uint8_t *)buf, std::min((size_t)n, sizeof(buf) - 1));
+  return n;
+}
+
+size_t HWCDC::print(long v, int base) {
+  char buf[24];
+  snprintf(buf, sizeof(buf), base == HEX ? "%lX" : "%ld", v);
+  return print(buf);
+}
+
+HWCDC::operator bool() const { return !sim::linkDown(); }
+
+int HWCDC::availableForWrite() {
+  std::lock_guard<std::mutex> lock(serial_mutex);
+  if (sim::linkDown())
+    return 0;
+  const uint32_t rate = sim::options().link_bytes_per_s;
+  if (!rate)
+    return (int)TX_BUFFER;
+  const int64_t backlog = (link_free_us - sim::nowUs()) * rate / 1000000;
+  return backlog <= 0 ? (int)TX_BUFFER : (int)std::max<int64_t>(0, TX_BUFFER - backlog);
+}
+
+void HWCDC::flush() {
+  int64_t until;
+  {
+    std::lock_guard<std::mutex> lock(serial_mutex);
+    until = link_free_us;
+  }
+  sim::sleepUs(until - sim::nowUs());
+}
@@ -0,0 +1,275 @@
+// esp32-camera-Ersatz der Host-Simulation
+//
+// Der Sensor läuft im Takt --fps: Frame k beginnt (VSYNC) bei k * Periode und
+// ist eine Periode später ausgelesen. Wie der Treiber:
+//   CAMERA_GRAB_WHEN_EMPTY  freie Puffer füllen sich der Reihe nach, danach
+//                           fallen Frames weg; geliefert wird der älteste
+//   CAMERA_GRAB_LATEST      geliefert wird der neueste fertige Frame
+// Jede Abholung liefert die nächste aufgezeichnete Datei; Zeitstempel und
+// Wartezeiten folgen dem Sensortakt. Qualität, Belichtung usw. wirken nicht
+// auf die Aufnahmen, die Setter merken sich nur den Wert. Ins
+// Ereignisprotokoll gehen je Frame "frame <nr> <vsync_us> <fb_us>" und
+// "return <nr> <t_us>" (nr = Abholung ab 0).
+
+#include <deque>
+#include <fstream>
+#include <mutex>
+
+#include "Arduino.h"
+#include "esp_camera.h"
+#include "sim.h"
+
+static const uint8_t MAX_FB = 4;
+
+struct Slot {
+  camera_fb_t fb;
+  std::vector<uint8_t> data;
+  bool out;
+  uint32_t nr;
+};
+
+static std::vector<std::vector<uint8_t>> corpus;
+static std::mutex cam_mutex;
+static camera_config_t cam_config;
+static bool cam_ready = false;
+static Slot slots[MAX_FB];
+static std::deque<int64_t> queued;  // gefüllte Puffer (WHEN_EMPTY), ältester zuerst
+static int64_t next_frame = 0;      // nächster VSYNC, den der Treiber noch nicht gesehen hat
+static int64_t last_frame = -1;     // zuletzt gelieferter Frame
+static uint32_t delivered = 0;
+static sensor_t sensor;
+
+namespace sim {
+
+bool loadFrames(const std::vector<std::string> &files) {
+  for (const std::string &path : files) {
+    std::ifstream f(path, std::ios::binary);
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(f)),
+                              std::istreambuf_iterator<char>());
+    if (data.size() < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+      fprintf(stderr, "%s: kein JPEG\n", path.c_str());
+      return false;
+    }
+    corpus.push_back(std::move(data));
+  }
+  return true;
+}
+
+uint32_t framesDelivered() {
+  std::lock_guard<std::mutex> lock(cam_mutex);
+  return delivered;
+}
+
+uint32_t framesTotal() { return (uint32_t)corpus.size() * options().loops; }
+
+} // namespace sim
+
+static int64_t periodUs() { return (int64_t)(1e6 / sim::options().fps + 0.5); }
+
+static uint8_t framesOut() {
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < cam_config.fb_count; i++)
+    n += slots[i].out;
+  return n;
+}
+
+// VSYNCs bis now nachholen: ein Frame landet nur in einem Puffer, der bei
+// seinem Beginn frei war
+static void advance(int64_t now) {
+  const int64_t period = periodUs();
+  while (next_frame * period <= now) {
+    if (cam_config.grab_mode == CAMERA_GRAB_WHEN_EMPTY &&
+        framesOut() + queued.size() < cam_config.fb_count)
+      queued.push_back(next_frame);
+    next_frame++;
+  }
+}
+
+// Bildgröße aus dem SOF-Segment
+static void jpegSize(const std::vector<uint8_t> &d, size_t *w, size_t *h) {
+  *w = *h = 0;
+  for (size_t i = 2; i + 9 < d.size();) {
+    if (d[i] != 0xFF) {
+      i++;
+      continue;
+    }
+    const uint8_t m = d[i + 1];
+    if (m == 0xC0 || m == 0xC1 || m == 0xC2) {
+      *h = (d[i + 5] << 8) | d[i + 6];
+      *w = (d[i + 7] << 8) | d[i + 8];
+      return;
+    }
+    if (m == 0xD8 || m == 0x01 || (m >= 0xD0 && m <= 0xD7) || m == 0xFF) {
+      i += m == 0xFF ? 1 : 2;
+      continue;
+    }
+    i += 2 + ((d[i + 2] << 8) | d[i + 3]);
+  }
+}
+
+#define SIM_SETTER(name, field)                                                \
+  static int name(sensor_t *s, int v) {                                        \
+    s->status.field = v;                                                       \
+    return 0;                                                                  \
+  }
+SIM_SETTER(setContrast, contrast)
+SIM_SETTER(setBrightness, brightness)
+SIM_SETTER(setSaturation, saturation)
+SIM_SETTER(setSharpness, sharpness)
+SIM_SETTER(setDenoise, denoise)
+SIM_SETTER(setQuality, quality)
+SIM_SETTER(setColorbar, colorbar)
+SIM_SETTER(setWhitebal, awb)
+SIM_SETTER(setGainCtrl, agc)
+SIM_SETTER(setExposureCtrl, aec)
+SIM_SETTER(setHmirror, hmirror)
+SIM_SETTER(setVflip, vflip)
+SIM_SETTER(setAec2, aec2)
+SIM_SETTER(setAwbGain, awb_gain)
+SIM_SETTER(setAgcGain, agc_gain)
+SIM_SETTER(setAecValue, aec_value)
+SIM_SETTER(setSpecialEffect, special_effect)
+SIM_SETTER(setWbMode, wb_mode)
+SIM_SETTER(setAeLevel, ae_level)
+SIM_SETTER(setDcw, dcw)
+SIM_SETTER(setBpc, bpc)
+SIM_SETTER(setWpc, wpc)
+SIM_SETTER(setRawGma, raw_gma)
+SIM_SETTER(setLenc, lenc)
+#undef SIM_SETTER
+
+static int setPixformat(sensor_t *s, pixformat_t v) {
+  s->pixformat = v;
+  return 0;
+}
+
+static int setFramesize(sensor_t *s, framesize_t v) {
+  s->status.framesize = v;
+  return 0;
+}
+
+static int setGainceiling(sensor_t *s, gainceiling_t v) {
+  s->status.gainceiling = v;
+  return 0;
+}
+
+static int getReg(sensor_t *s, int reg, int mask) { return 0; }
+
+static int setReg(sensor_t *s, int reg, int mask, int value) { return 0; }
+
+esp_err_t esp_camera_init(const camera_config_t *config) {
+  std::lock_guard<std::mutex> lock(cam_mutex);
+  cam_config = *config;
+  if (cam_config.fb_count < 1)
+    cam_config.fb_count = 1;
+  if (cam_config.fb_count > MAX_FB)
+    cam_config.fb_count = MAX_FB;
+  sensor = sensor_t();
+  sensor.id.PID = 0x5640;  // OV5640 wie auf dem Memento
+  sensor.pixformat = config->pixel_format;
+  sensor.status.framesize = config->frame_size;
+  sensor.status.quality = (uint8_t)config->jpeg_quality;
+  sensor.set_pixformat = setPixformat;
+  sensor.set_framesize = setFramesize;
+  sensor.set_contrast = setContrast;
+  sensor.set_brightness = setBrightness;
+  sensor.set_saturation = setSaturation;
+  sensor.set_sharpness = setSharpness;
+  sensor.set_denoise = setDenoise;
+  sensor.set_gainceiling = setGainceiling;
+  sensor.set_quality = setQuality;
+  sensor.set_colorbar = setColorbar;
+  sensor.set_whitebal = setWhitebal;
+  sensor.set_gain_ctrl = setGainCtrl;
+  sensor.set_exposure_ctrl = setExposureCtrl;
+  sensor.set_hmirror = setHmirror;
+  sensor.set_vflip = setVflip;
+  sensor.set_aec2 = setAec2;
+  sensor.set_awb_gain = setAwbGain;
+  sensor.set_agc_gain = setAgcGain;
+  sensor.set_aec_value = setAecValue;
+  sensor.set_special_effect = setSpecialEffect;
+  sensor.set_wb_mode = setWbMode;
+  sensor.set_ae_level = setAeLevel;
+  sensor.set_dcw = setDcw;
+  sensor.set_bpc = setBpc;
+  sensor.set_wpc = setWpc;
+  sensor.set_raw_gma = setRawGma;
+  sensor.set_lenc = setLenc;
+  sensor.get_reg = getReg;
+  sensor.set_reg = setReg;
+  // Der Sensor läuft ab jetzt
+  next_frame = sim::nowUs() / periodUs() + 1;
+  cam_ready = true;
+  return ESP_OK;
+}
+
+esp_err_t esp_camera_deinit() {
+  std::lock_guard<std::mutex> lock(cam_mutex);
+  cam_ready = false;
+  queued.clear();
+  return ESP_OK;
+}
+
+sensor_t *esp_camera_sensor_get() { return cam_ready ? &sensor : nullptr; }
+
+camera_fb_t *esp_camera_fb_get() {
+  std::unique_lock<std::mutex> lock(cam_mutex);
+  if (!cam_ready || corpus.empty())
+    return nullptr;
+  if (delivered >= sim::framesTotal()) {
+    sim::stop();
+    return nullptr;
+  }
+  // Alle Puffer beim Programm: der Treiber liefe in den Timeout
+  if (framesOut() >= cam_config.fb_count)
+    return nullptr;
+
+  const int64_t period = periodUs();
+  const int64_t now = sim::nowUs();
+  advance(now);
+  int64_t k;
+  if (cam_config.grab_mode == CAMERA_GRAB_LATEST) {
+    k = std::max(now / period - 1, last_frame + 1);
+    next_frame = std::max(next_frame, k + 1);
+  } else if (!queued.empty()) {
+    k = queued.front();
+    queued.pop_front();
+  } else {
+    k = next_frame++;
+  }
+  last_frame = k;
+
+  uint8_t i = 0;
+  while (slots[i].out)
+    i++;
+  Slot &slot = slots[i];
+  slot.out = true;
+  slot.nr = delivered;
+  const std::vector<uint8_t> &src = corpus[delivered % corpus.size()];
+  delivered++;
+  lock.unlock();
+
+  // Bis der Frame ausgelesen ist
+  sim::sleepUs((k + 1) * period - now);
+  slot.data.assign(src.begin(), src.end());
+  slot.fb.buf = slot.data.data();
+  slot.fb.len = slot.data.size();
+  slot.fb.format = PIXFORMAT_JPEG;
+  jpegSize(slot.data, &slot.fb.width, &slot.fb.height);
+  const int64_t t_vsync = k * period;
+  slot.fb.timestamp.tv_sec = t_vsync / 1000000;
+  slot.fb.timestamp.tv_usec = t_vsync % 1000000;
+  sim::logEvent("frame %u %lld %lld", slot.nr, (long long)t_vsync, (long long)sim::nowUs());
+  return &slot.fb;
+}
+
+void esp_camera_fb_return(camera_fb_t *fb) {
+  std::lock_guard<std::mutex> lock(cam_mutex);
+  advance(sim::nowUs());
+  for (uint8_t i = 0; i < MAX_FB; i++)
+    if (fb == &slots[i].fb && slots[i].out) {
+      slots[i].out = false;
+      sim::logEvent("return %u %lld", slots[i].nr, (long long)sim::nowUs());
+    }
+}
@@ -0,0 +1,220 @@
+// FreeRTOS-Ersatz der Host-Simulation: jede Task ein std::thread
+//
+// Benachrichtigungen zählen wie xTaskNotifyGive/ulTaskNotifyTake; wer
+// blockiert, meldet sich bei sim::taskBusy ab, damit finish() auf Frames in
+// Arbeit warten kann. Prioritäten und Stackgrößen werden ignoriert.
+
+#include <string.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Arduino.h"
+#include "freertos/queue.h"
+#include "sim.h"
+
+namespace {
+
+struct Task {
+  TaskFunction_t fn;
+  void *arg;
+  BaseType_t core;
+  std::mutex m;
+  std::condition_variable cv;
+  uint32_t notify = 0;
+  bool waiting = false;
+};
+
+struct TaskExit {};
+
+// Mutex (xSemaphoreCreateMutex) oder binäres Semaphor
+struct Semaphore {
+  bool binary;
+  std::timed_mutex mutex;
+  std::mutex m;
+  std::condition_variable cv;
+  bool given = false;
+};
+
+struct Queue {
+  std::mutex m;
+  std::condition_variable cv;
+  std::deque<std::vector<uint8_t>> items;
+  size_t length, item_size;
+};
+
+} // namespace
+
+static thread_local Task *current = nullptr;
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack,
+                                   void *arg, UBaseType_t prio, TaskHandle_t *handle,
+                                   BaseType_t core) {
+  Task *t = new Task();
+  t->fn = fn;
+  t->arg = arg;
+  t->core = core;
+  if (handle)
+    *handle = t;
+  sim::enterRealtime();
+  sim::taskBusy(+1);
+  std::thread([t]() {
+    current = t;
+    try {
+      t->fn(t->arg);
+    } catch (const TaskExit &) {
+    }
+    sim::taskBusy(-1);
+    sim::leaveRealtime();
+  }).detach();
+  return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  if (task && task != current)
+    return;  // fremde Tasks löscht die Firmware nicht
+  if (current)
+    throw TaskExit();
+  // loop() gibt ab: warten, bis die Frames aufgebraucht sind
+  while (!sim::stopped())
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  sim::finish();
+}
+
+void vTaskDelay(TickType_t ticks) { delay(ticks); }
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+  Task *t = current;
+  if (!t)
+    return 0;
+  std::unique_lock<std::mutex> lock(t->m);
+  if (!t->notify) {
+    t->waiting = true;
+    sim::taskBusy(-1);
+    const auto ready = [t]() { return t->notify > 0; };
+    if (ticks == portMAX_DELAY)
+      t->cv.wait(lock, ready);
+    else
+      t->cv.wait_for(lock, std::chrono::milliseconds(ticks), ready);
+    // Bei einer Benachrichtigung hat der Geber uns schon als beschäftigt gemeldet
+    if (t->waiting) {
+      t->waiting = false;
+      sim::taskBusy(+1);
+    }
+  }
+  const uint32_t v = t->notify;
+  t->notify = clear_on_exit ? 0 : (v ? v - 1 : 0);
+  return v;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  Task *t = (Task *)task;
+  if (!t)
+    return pdFAIL;
+  std::lock_guard<std::mutex> lock(t->m);
+  t->notify++;
+  if (t->waiting) {
+    t->waiting = false;
+    sim::taskBusy(+1);
+  }
+  t->cv.notify_one();
+  return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() { return current; }
+
+// Hauptschleife (loop) läuft wie in Arduino-ESP32 auf Kern 1
+BaseType_t xPortGetCoreID() { return current ? current->core : 1; }
+
+// Blockierendes Warten einer Task wie in ulTaskNotifyTake bei taskBusy abmelden
+template <typename Ready>
+static bool waitFor(std::condition_variable &cv, std::unique_lock<std::mutex> &lock,
+                    TickType_t ticks, Ready ready) {
+  if (ready())
+    return true;
+  if (current)
+    sim::taskBusy(-1);
+  bool ok = true;
+  if (ticks == portMAX_DELAY)
+    cv.wait(lock, ready);
+  else
+    ok = cv.wait_for(lock, std::chrono::milliseconds(ticks), ready);
+  if (current)
+    sim::taskBusy(+1);
+  return ok;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  Semaphore *s = new Semaphore();
+  s->binary = false;
+  return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+  Semaphore *s = new Semaphore();
+  s->binary = true;
+  return s;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+  Semaphore *s = (Semaphore *)sem;
+  if (s->binary) {
+    std::unique_lock<std::mutex> lock(s->m);
+    if (!waitFor(s->cv, lock, ticks, [s]() { return s->given; }))
+      return pdFALSE;
+    s->given = false;
+    return pdTRUE;
+  }
+  if (ticks == portMAX_DELAY) {
+    s->mutex.lock();
+    return pdTRUE;
+  }
+  return s->mutex.try_lock_for(std::chrono::milliseconds(ticks)) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+  Semaphore *s = (Semaphore *)sem;
+  if (!s->binary) {
+    s->mutex.unlock();
+    return pdTRUE;
+  }
+  std::lock_guard<std::mutex> lock(s->m);
+  if (s->given)
+    return pdFALSE;
+  s->given = true;
+  s->cv.notify_one();
+  return pdTRUE;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+  Queue *q = new Queue();
+  q->length = length;
+  q->item_size = item_size;
+  return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks) {
+  Queue *q = (Queue *)queue;
+  std::unique_lock<std::mutex> lock(q->m);
+  if (!waitFor(q->cv, lock, ticks, [q]() { return q->items.size() < q->length; }))
+    return pdFALSE;
+  const uint8_t *p = (const uint8_t *)item;
+  q->items.emplace_back(p, p + q->item_size);
+  q->cv.notify_all();
+  return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+  Queue *q = (Queue *)queue;
+  std::unique_lock<std::mutex> lock(q->m);
+  if (!waitFor(q->cv, lock, ticks, [q]() { return !q->items.empty(); }))
+    return pdFALSE;
+  memcpy(item, q->items.front().data(), q->item_size);
+  q->items.pop_front();
+  q->cv.notify_all();
+  return pdTRUE;
+}
@@ -0,0 +1,234 @@
+// Host-Simulation der Firmware (pio run -e host_sim)
+//
+// Baut src/main.cpp mit den Ersatz-Headern aus src/host/sim/include und
+// spielt aufgezeichnete JPEG-Frames im Sensortakt ab. Die Datensätze gehen wie
+// auf dem Gerät über Serial hinaus: auf ein pty (image_receiver.py liest dort
+// mit) oder in eine Datei (trace_export / telemetry_report lesen sie direkt).
+//
+//   host_sim --frames <ordner|bild.jpg> ... [--fps 30] [--loops N]
+//            [--serial pty|datei] [--link BYTES_PRO_S] [--realtime]
+//            [--duration S] [--events datei] [--sd ordner]
+//            [--link-down VON:BIS] ... [--shake VON:BIS] ...
+//
+// Am Ende stehen Frames, virtuelle und echte Laufzeit und gesendete Bytes auf
+// stderr; Rückgabe 0, wenn alle Frames abgeholt wurden. --events protokolliert
+// je Frame VSYNC, Abholung und Rückgabe (pipeline_benchmark.py). --sd macht
+// einen Host-Ordner zur SD-Karte, --link-down trennt den Host zwischen VON und
+// BIS Sekunden (virtuelle Uhr, mehrfach möglich), --shake lässt den
+// Beschleunigungssensor in diesem Fenster Erschütterung messen.
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include "Arduino.h"
+#include "sim.h"
+
+void setup();
+void loop();
+
+namespace sim {
+
+static Options opts;
+static const std::chrono::steady_clock::time_point t_start = std::chrono::steady_clock::now();
+static std::atomic<int64_t> skipped_us{0};
+static std::atomic<int> realtime{0};  // laufende Tasks
+static std::atomic<bool> done{false};
+static std::atomic<int> busy_tasks{0};
+static const std::thread::id main_thread = std::this_thread::get_id();
+static std::mutex events_mutex;
+static FILE *events = nullptr;
+
+const Options &options() { return opts; }
+
+Options &testOptions() { return opts; }
+
+static int64_t realUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - t_start)
+      .count();
+}
+
+int64_t nowUs() { return realUs() + skipped_us.load(std::memory_order_relaxed); }
+
+void enterRealtime() {
+  static std::atomic<bool> told{false};
+  if (realtime.fetch_add(1) == 0 && !opts.realtime && !told.exchange(true))
+    fprintf(stderr, "sim: Tasks laufen, Wartezeiten in Echtzeit\n");
+}
+
+void leaveRealtime() { realtime.fetch_sub(1); }
+
+void sleepUs(int64_t us) {
+  if (us <= 0)
+    return;
+  if (realtime.load() > 0 || opts.realtime)
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+  else
+    skipped_us.fetch_add(us, std::memory_order_relaxed);
+}
+
+void checkStop() {
+  if (opts.duration_s > 0 && nowUs() >= (int64_t)(opts.duration_s * 1e6))
+    stop();
+  if (!stopped())
+    return;
+  // Hauptschleife: auswerten und beenden; Tasks bleiben hier stehen
+  if (std::this_thread::get_id() == main_thread)
+    finish();
+  taskBusy(-1);
+  while (true)
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+}
+
+bool openEvents(const std::string &path) {
+  if (path.empty())
+    return true;
+  events = fopen(path.c_str(), "w");
+  if (!events) {
+    perror(path.c_str());
+    return false;
+  }
+  // Uhr 0 als Unix-Zeit, damit Empfänger ihre Zeitstempel zuordnen können
+  const int64_t epoch_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                               std::chrono::system_clock::now().time_since_epoch())
+                               .count() -
+                           realUs();
+  fprintf(events, "epoch_us %lld\n", (long long)epoch_us);
+  fflush(events);
+  return true;
+}
+
+void logEvent(const char *fmt, ...) {
+  if (!events)
+    return;
+  std::lock_guard<std::mutex> lock(events_mutex);
+  va_list ap;
+  va_start(ap, fmt);
+  vfprintf(events, fmt, ap);
+  va_end(ap);
+  fputc('\n', events);
+  fflush(events);
+}
+
+void stop() { done.store(true); }
+
+bool stopped() { return done.load(); }
+
+void taskBusy(int delta) { busy_tasks.fetch_add(delta); }
+
+void finish() {
+  // Laufende Tasks ihre Frames noch senden lassen (höchstens 5 s)
+  const int64_t t_wait = realUs();
+  while (busy_tasks.load() > 0 && realUs() - t_wait < 5000000)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  const double t_virt = nowUs() / 1e6, t_real = realUs() / 1e6;
+  fprintf(stderr,
+          "sim: %u/%u Frames abgeholt, %.2f s virtuell, %.2f s echt, "
+          "%.1f Frames/s (virtuell), %.2f MB gesendet\n",
+          framesDelivered(), framesTotal(), t_virt, t_real,
+          t_virt > 0 ? framesDelivered() / t_virt : 0.0, serialBytes() / 1e6);
+  if (!opts.link_down.empty())
+    fprintf(stderr, "sim: %.2f MB bei getrennter Verbindung verworfen\n",
+            serialDropped() / 1e6);
+  logEvent("end %lld %llu", (long long)nowUs(), (unsigned long long)serialBytes());
+  fflush(stdout);
+  fflush(stderr);
+  // Tasks hängen noch in Wartezeiten: ohne Destruktoren beenden
+  _exit(framesDelivered() >= framesTotal() ? 0 : 1);
+}
+
+} // namespace sim
+
+static bool endsWith(const std::string &s, const char *suffix) {
+  const size_t n = strlen(suffix);
+  return s.size() >= n && strcasecmp(s.c_str() + s.size() - n, suffix) == 0;
+}
+
+// Ordner: alle .jpg darin, sortiert (Dateinamen tragen den Zeitstempel)
+static void addFrames(const char *path, std::vector<std::string> *files) {
+  DIR *dir = opendir(path);
+  if (!dir) {
+    files->push_back(path);
+    return;
+  }
+  std::vector<std::string> found;
+  while (dirent *e = readdir(dir)) {
+    if (endsWith(e->d_name, ".jpg") || endsWith(e->d_name, ".jpeg"))
+      found.push_back(std::string(path) + "/" + e->d_name);
+  }
+  closedir(dir);
+  std::sort(found.begin(), found.end());
+  files->insert(files->end(), found.begin(), found.end());
+}
+
+// In den Host-Tests bringt jeder Test sein eigenes main() mit
+#ifndef PIO_UNIT_TESTING
+int main(int argc, char **argv) {
+  sim::Options &o = sim::opts;
+  for (int i = 1; i < argc; i++) {
+    const char *a = argv[i];
+    const bool more = i + 1 < argc;
+    if (!strcmp(a, "--frames") && more) {
+      while (i + 1 < argc && strncmp(argv[i + 1], "--", 2))
+        addFrames(argv[++i], &o.frames);
+    } else if (!strcmp(a, "--fps") && more) {
+      o.fps = atof(argv[++i]);
+    } else if (!strcmp(a, "--loops") && more) {
+      o.loops = (uint32_t)atoi(argv[++i]);
+    } else if (!strcmp(a, "--serial") && more) {
+      o.serial = argv[++i];
+    } else if (!strcmp(a, "--link") && more) {
+      o.link_bytes_per_s = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(a, "--realtime")) {
+      o.realtime = true;
+    } else if (!strcmp(a, "--duration") && more) {
+      o.duration_s = atof(argv[++i]);
+    } else if (!strcmp(a, "--events") && more) {
+      o.events = argv[++i];
+    } else if (!strcmp(a, "--sd") && more) {
+      o.sd_dir = argv[++i];
+    } else if (!strcmp(a, "--link-down") && more) {
+      double from, to;
+      if (sscanf(argv[++i], "%lf:%lf", &from, &to) != 2 || to <= from) {
+        fprintf(stderr, "--link-down erwartet VON:BIS in Sekunden\n");
+        return 2;
+      }
+      o.link_down.push_back({from, to});
+    } else if (!strcmp(a, "--shake") && more) {
+      double from, to;
+      if (sscanf(argv[++i], "%lf:%lf", &from, &to) != 2 || to <= from) {
+        fprintf(stderr, "--shake erwartet VON:BIS in Sekunden\n");
+        return 2;
+      }
+      o.shake.push_back({from, to});
+    } else {
+      fprintf(stderr, "Unbekannte Option %s\n", a);
+      return 2;
+    }
+  }
+  if (o.frames.empty() || o.fps <= 0 || !o.loops) {
+    fprintf(stderr, "Aufruf: host_sim --frames <ordner|bild.jpg> ... [--fps 30] "
+                    "[--loops N] [--serial pty|datei] [--link BYTES_PRO_S] "
+                    "[--realtime] [--duration S] [--events datei] [--sd ordner] "
+                    "[--link-down VON:BIS] [--shake VON:BIS]\n");
+    return 2;
+  }
+  if (!sim::loadFrames(o.frames) || !sim::openEvents(o.events) || !sim::openSerial(o.serial))
+    return 2;
+
+  setup();
+  while (!sim::stopped())
+    loop();
+  sim::finish();
+}
+#endif
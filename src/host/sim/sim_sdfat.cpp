@@ -0,0 +1,178 @@
+// SD-Karte der Host-Simulation: --sd <ordner> ist das Wurzelverzeichnis
+//
+// Pfade der Firmware ("/BURST/D00000/F0000000.JPG") werden an den Ordner
+// gehängt. Ohne --sd schlägt alles fehl wie ohne gesteckte Karte.
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include "SdFat.h"
+#include "sim.h"
+
+namespace sim {
+
+bool sdPresent() { return !options().sd_dir.empty(); }
+
+} // namespace sim
+
+static std::string hostPath(const std::string &path) {
+  std::string p = sim::options().sd_dir;
+  if (path.empty() || path[0] != '/')
+    p += '/';
+  return p + path;
+}
+
+bool File::open(const char *path, int flags) {
+  close();
+  if (!sim::sdPresent())
+    return false;
+  const std::string host = hostPath(path);
+  struct stat st;
+  if (stat(host.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+    _dir = opendir(host.c_str());
+  } else {
+    _fd = ::open(host.c_str(), flags, 0644);
+    if (_fd >= 0 && (flags & O_APPEND))
+      lseek(_fd, 0, SEEK_END);
+  }
+  if (isOpen())
+    _path = path;
+  return isOpen();
+}
+
+size_t File::write(const void *buf, size_t len) {
+  if (_fd < 0)
+    return 0;
+  size_t done = 0;
+  while (done < len) {
+    const ssize_t n = ::write(_fd, (const uint8_t *)buf + done, len - done);
+    if (n <= 0)
+      break;
+    done += (size_t)n;
+  }
+  return done;
+}
+
+int File::read(void *buf, size_t len) {
+  if (_fd < 0)
+    return -1;
+  size_t done = 0;
+  while (done < len) {
+    const ssize_t n = ::read(_fd, (uint8_t *)buf + done, len - done);
+    if (n < 0)
+      return -1;
+    if (n == 0)
+      break;
+    done += (size_t)n;
+  }
+  return (int)done;
+}
+
+bool File::seekSet(uint64_t pos) {
+  return _fd >= 0 && lseek(_fd, (off_t)pos, SEEK_SET) == (off_t)pos;
+}
+
+uint64_t File::fileSize() const {
+  struct stat st;
+  return _fd >= 0 && fstat(_fd, &st) == 0 ? (uint64_t)st.st_size : 0;
+}
+
+uint64_t File::curPosition() const {
+  return _fd >= 0 ? (uint64_t)lseek(_fd, 0, SEEK_CUR) : 0;
+}
+
+bool File::truncate(uint64_t len) {
+  return _fd >= 0 && ftruncate(_fd, (off_t)len) == 0 && seekSet(len);
+}
+
+bool File::getName(char *name, size_t len) {
+  if (!isOpen())
+    return false;
+  const size_t slash = _path.rfind('/');
+  snprintf(name, len, "%s", _path.c_str() + (slash == std::string::npos ? 0 : slash + 1));
+  return true;
+}
+
+bool File::openNext(File *dir, int flags) {
+  close();
+  if (!dir || !dir->_dir)
+    return false;
+  while (dirent *e = readdir((DIR *)dir->_dir)) {
+    if (!strcmp(e->d_name, ".") || !strcmp(e->d_name, ".."))
+      continue;
+    const std::string child = dir->_path + (dir->_path == "/" ? "" : "/") + e->d_name;
+    return open(child.c_str(), flags);
+  }
+  return false;
+}
+
+bool File::remove() {
+  if (_fd < 0)
+    return false;
+  const std::string path = _path;
+  close();
+  return ::unlink(hostPath(path).c_str()) == 0;
+}
+
+bool File::rename(const char *path) {
+  if (_fd < 0 || ::rename(hostPath(_path).c_str(), hostPath(path).c_str()) != 0)
+    return false;
+  _path = path;
+  return true;
+}
+
+bool File::close() {
+  const bool was_open = isOpen();
+  if (_fd >= 0)
+    ::close(_fd);
+  if (_dir)
+    closedir((DIR *)_dir);
+  _fd = -1;
+  _dir = nullptr;
+  return was_open;
+}
+
+uint8_t SdCard::errorCode() const { return sim::sdPresent() ? 0 : 0x01; }
+
+uint32_t SdCard::cardSize() const {
+  struct statvfs fs;
+  if (!sim::sdPresent() || statvfs(sim::options().sd_dir.c_str(), &fs) != 0)
+    return 0;
+  return (uint32_t)std::min<uint64_t>((uint64_t)fs.f_blocks * fs.f_frsize / 512, 0xFFFFFFFFu);
+}
+
+uint8_t FsVolume::fatType() const { return sim::sdPresent() ? 32 : 0; }
+
+bool SdFat::begin(uint8_t cs, uint32_t clock) {
+  struct stat st;
+  return sim::sdPresent() && stat(sim::options().sd_dir.c_str(), &st) == 0 &&
+         S_ISDIR(st.st_mode);
+}
+
+bool SdFat::exists(const char *path) {
+  struct stat st;
+  return sim::sdPresent() && stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool SdFat::mkdir(const char *path) {
+  return sim::sdPresent() && ::mkdir(hostPath(path).c_str(), 0755) == 0;
+}
+
+bool SdFat::remove(const char *path) {
+  return sim::sdPresent() && ::unlink(hostPath(path).c_str()) == 0;
+}
+
+bool SdFat::rename(const char *from, const char *to) {
+  return sim::sdPresent() && ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+
+File SdFat::open(const char *path, int flags) {
+  File f;
+  f.open(path, flags);
+  return f;
+}
@@ -0,0 +1,182 @@
+// telemetry_report: Host-Werkzeug (pio run -e host_telemetry) für Telemetrie
+//
+// Liest REC_TELEMETRY-Datensätze (CamLink-Kopf + Nutzlast), wie sie
+// image_receiver.py nach <tagesordner>/telemetry.bin schreibt (oder die
+// Host-Simulation mit --serial datei), fasst die Histogramme je Kamera
+// zusammen und gibt p50/p99/max je Messgröße sowie die Zählerzuwächse aus.
+// Mit --slo wird ein Perzentil gegen eine Grenze geprüft, gesamt und je
+// Meldeintervall; Rückgabe 1, wenn eine Grenze gesamt verletzt ist (für
+// Nachtläufe/CI).
+//
+//   telemetry_report [--slo messgröße:perzentil:grenze ...] telemetry.bin ...
+//   telemetry_report --slo senden:99:20000 --slo trigger_belichtung:99:150000
+//                    2025-09-29/telemetry.bin
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "CamLink.h"
+#include "Telemetry.h"
+
+struct Slo {
+  camlink::TelemetryMetric metric;
+  uint8_t pct;
+  uint32_t limit;
+};
+
+// Zähler seit dem Start des Geräts; ein kleinerer Wert heißt Neustart. Der
+// erste Wert zählt ganz (Aufzeichnung beginnt mit dem Gerät)
+struct Counter {
+  bool seen = false;
+  uint32_t last = 0;
+  uint64_t sum = 0;
+
+  void add(uint32_t v) {
+    sum += seen && v >= last ? v - last : v;
+    seen = true;
+    last = v;
+  }
+};
+
+struct Camera {
+  telemetry::Histogram hist[camlink::TELEMETRY_METRICS];
+  Counter frames, failures, empty, misses, full, bytes;
+  uint32_t records = 0;
+  uint64_t interval_ms = 0;
+  uint8_t depthMax = 0;
+  uint64_t depthMean16 = 0;
+  std::vector<uint32_t> sloHits;  // Intervalle über der Grenze, je --slo
+};
+
+static bool parseSlo(const char *arg, Slo *slo) {
+  const char *c1 = strchr(arg, ':');
+  const char *c2 = c1 ? strchr(c1 + 1, ':') : nullptr;
+  if (!c2)
+    return false;
+  const std::string name(arg, c1 - arg);
+  for (uint8_t m = 0; m < camlink::TELEMETRY_METRICS; m++) {
+    if (name == camlink::telemetryMetricName((camlink::TelemetryMetric)m)) {
+      slo->metric = (camlink::TelemetryMetric)m;
+      slo->pct = (uint8_t)atoi(c1 + 1);
+      slo->limit = (uint32_t)strtoul(c2 + 1, nullptr, 10);
+      return slo->pct >= 1 && slo->pct <= 100;
+    }
+  }
+  return false;
+}
+
+static bool readFile(const char *path, std::map<uint8_t, Camera> &cams,
+                     const std::vector<Slo> &slos, uint32_t *records) {
+  std::ifstream f(path, std::ios::binary);
+  if (!f) {
+    fprintf(stderr, "Kann %s nicht lesen\n", path);
+    return false;
+  }
+  std::vector<uint8_t> data((std::istreambuf_iterator<char>(f)),
+                            std::istreambuf_iterator<char>());
+  static camlink::TelemetryRecord rec;
+  size_t pos = 0;
+  camlink::RecordType type;
+  uint32_t len;
+  const uint8_t *p;
+  while (camlink::nextRecord(data.data(), data.size(), &pos, &type, &len, &p)) {
+    if (type != camlink::REC_TELEMETRY || !camlink::decodeTelemetry(p, len, &rec))
+      continue;
+    (*records)++;
+    Camera &cam = cams[rec.camera];
+    if (cam.sloHits.size() != slos.size())
+      cam.sloHits.assign(slos.size(), 0);
+    cam.records++;
+    cam.interval_ms += rec.interval_ms;
+    cam.frames.add(rec.frames);
+    cam.failures.add(rec.capture_failures);
+    cam.empty.add(rec.empty_frames);
+    cam.misses.add(rec.ring_misses);
+    cam.full.add(rec.queue_full);
+    cam.bytes.add(rec.bytes_sent);
+    if (rec.depth_max > cam.depthMax)
+      cam.depthMax = rec.depth_max;
+    cam.depthMean16 += rec.depth_mean_x16;
+
+    telemetry::Histogram interval[camlink::TELEMETRY_METRICS];
+    for (uint8_t m = 0; m < camlink::TELEMETRY_METRICS; m++) {
+      interval[m].addWire(rec.hist[m]);
+      cam.hist[m].merge(interval[m]);
+    }
+    for (size_t i = 0; i < slos.size(); i++) {
+      const telemetry::Histogram &h = interval[slos[i].metric];
+      if (h.count() && h.percentile(slos[i].pct) > slos[i].limit)
+        cam.sloHits[i]++;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  std::vector<Slo> slos;
+  std::vector<const char *> files;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--slo") && i + 1 < argc) {
+      Slo slo;
+      if (!parseSlo(argv[++i], &slo)) {
+        fprintf(stderr, "Ungültige Grenze %s (messgröße:perzentil:grenze)\n", argv[i]);
+        return 2;
+      }
+      slos.push_back(slo);
+    } else {
+      files.push_back(argv[i]);
+    }
+  }
+  if (files.empty()) {
+    fprintf(stderr, "Aufruf: telemetry_report [--slo messgröße:perzentil:grenze ...] "
+                    "telemetry.bin ...\n");
+    return 2;
+  }
+
+  std::map<uint8_t, Camera> cams;
+  uint32_t records = 0;
+  for (const char *path : files)
+    if (!readFile(path, cams, slos, &records))
+      return 2;
+  if (!records) {
+    fprintf(stderr, "Keine Telemetrie-Datensätze\n");
+    return 1;
+  }
+
+  bool violated = false;
+  for (const auto &kv : cams) {
+    const Camera &cam = kv.second;
+    const double s = cam.interval_ms / 1000.0;
+    printf("Kamera %u: %u Intervalle, %.0f s, %llu Frames (%.1f/s), %.1f MB\n", kv.first,
+           cam.records, s, (unsigned long long)cam.frames.sum,
+           s > 0 ? cam.frames.sum / s : 0.0, cam.bytes.sum / 1e6);
+    printf("  %-20s %8s %10s %10s %10s\n", "messgröße", "n", "p50", "p99", "max");
+    for (uint8_t m = 0; m < camlink::TELEMETRY_METRICS; m++) {
+      const telemetry::Histogram &h = cam.hist[m];
+      printf("  %-20s %8u %10u %10u %10u\n",
+             camlink::telemetryMetricName((camlink::TelemetryMetric)m), h.count(),
+             h.percentile(50), h.percentile(99), h.max());
+    }
+    printf("  Fehlaufnahmen %llu, leer %llu, Ring verfehlt %llu, Ringe voll %llu, "
+           "in Arbeit max %u / Mittel %.1f\n",
+           (unsigned long long)cam.failures.sum, (unsigned long long)cam.empty.sum,
+           (unsigned long long)cam.misses.sum, (unsigned long long)cam.full.sum,
+           cam.depthMax, cam.depthMean16 / 16.0 / cam.records);
+    for (size_t i = 0; i < slos.size(); i++) {
+      const Slo &slo = slos[i];
+      const telemetry::Histogram &h = cam.hist[slo.metric];
+      const uint32_t v = h.percentile(slo.pct);
+      const bool bad = h.count() && v > slo.limit;
+      violated |= bad;
+      printf("  SLO %s p%u <= %u: %u %s (%u/%u Intervalle darüber)\n",
+             camlink::telemetryMetricName(slo.metric), slo.pct, slo.limit, v,
+             bad ? "VERLETZT" : "ok", cam.sloHits[i], cam.records);
+    }
+  }
+  return violated ? 1 : 0;
+}
@@ -0,0 +1,142 @@
+// trace_export: Host-Werkzeug (pio run -e host_trace) für Zeitmarken
+//
+// Liest REC_TRACE-Datensätze (CamLink-Kopf + Nutzlast), wie sie
+// image_receiver.py nach <tagesordner>/trace.bin schreibt, label_measure
+// --trace oder die Host-Simulation (--serial datei) erzeugt, und schreibt
+// Chrome-Trace-JSON (chrome://tracing, ui.perfetto.dev). Ein Thread je Kern;
+// Beginn/Ende mit gleicher Marke und Frame-Nummer werden zu einem Abschnitt
+// ("X"), so dürfen sich Tasks eines Kerns überlappen.
+//
+//   trace_export <tagesordner>/trace.bin [> trace.json]
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "CamLink.h"
+#include "Trace.h"
+
+struct Open {
+  uint8_t id;
+  uint16_t arg;
+  uint64_t t_us;
+};
+
+struct CoreState {
+  bool seen = false;
+  uint32_t last = 0;     // letzter Rohwert (32 bit)
+  uint64_t high = 0;     // Überläufe << 32
+  std::vector<Open> open;
+};
+
+// Zeit je Kern über den 32-bit-Überlauf (~71 min) fortschreiben
+static uint64_t unwrap(CoreState &c, uint32_t t) {
+  if (c.seen && t < c.last && c.last - t > 0x80000000u)
+    c.high += 1ull << 32;
+  c.seen = true;
+  c.last = t;
+  return c.high | t;
+}
+
+static const char *name(uint8_t id) {
+  return id < trace::EV_COUNT ? trace::eventName((trace::EventId)id) : "?";
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "Aufruf: trace_export trace.bin > trace.json\n");
+    return 2;
+  }
+  std::ifstream f(argv[1], std::ios::binary);
+  if (!f) {
+    fprintf(stderr, "Kann %s nicht lesen\n", argv[1]);
+    return 2;
+  }
+  std::vector<uint8_t> data((std::istreambuf_iterator<char>(f)),
+                            std::istreambuf_iterator<char>());
+
+  CoreState cores[256];
+  bool used[256] = {};
+  uint64_t t0 = 0;
+  bool haveT0 = false;
+  uint32_t records = 0, events = 0, unmatched = 0, dropped = 0;
+  bool first = true;
+  printf("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  auto sep = [&first]() {
+    if (!first)
+      printf(",\n");
+    first = false;
+  };
+
+  size_t pos = 0;
+  camlink::RecordType type;
+  uint32_t len;
+  const uint8_t *p;
+  while (camlink::nextRecord(data.data(), data.size(), &pos, &type, &len, &p)) {
+    camlink::TraceHeader hdr;
+    if (type != camlink::REC_TRACE || !camlink::decodeTraceHeader(p, len, &hdr))
+      continue;
+    records++;
+    CoreState &c = cores[hdr.core];
+    used[hdr.core] = true;
+    for (uint8_t i = 0; i < hdr.count; i++) {
+      camlink::TraceEvent ev;
+      camlink::decodeTraceEvent(p + camlink::TRACE_HEADER_SIZE +
+                                    i * camlink::TRACE_EVENT_SIZE,
+                                camlink::TRACE_EVENT_SIZE, &ev);
+      const uint64_t t = unwrap(c, ev.t_us);
+      if (!haveT0) {
+        t0 = t;
+        haveT0 = true;
+      }
+      const double ts = (double)(int64_t)(t - t0);
+      events++;
+      if (ev.phase == trace::PH_BEGIN) {
+        c.open.push_back({ev.id, ev.arg, t});
+      } else if (ev.phase == trace::PH_END) {
+        // Jüngsten offenen Abschnitt mit gleicher Marke und Nummer schließen
+        size_t k = c.open.size();
+        while (k && !(c.open[k - 1].id == ev.id && c.open[k - 1].arg == ev.arg))
+          k--;
+        if (!k) {
+          unmatched++;
+          continue;
+        }
+        const Open o = c.open[k - 1];
+        c.open.erase(c.open.begin() + (k - 1));
+        sep();
+        printf("{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+               "\"ts\":%.0f,\"dur\":%llu,\"args\":{\"seq\":%u}}",
+               name(ev.id), hdr.core, (double)(int64_t)(o.t_us - t0),
+               (unsigned long long)(t - o.t_us), ev.arg);
+      } else {
+        sep();
+        printf("{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,"
+               "\"tid\":%u,\"ts\":%.0f,\"args\":{\"seq\":%u}}",
+               name(ev.id), hdr.core, ts, ev.arg);
+      }
+    }
+    if (hdr.dropped) {
+      dropped += hdr.dropped;
+      sep();
+      printf("{\"name\":\"verworfen\",\"ph\":\"C\",\"pid\":1,\"ts\":%.0f,"
+             "\"args\":{\"kern%u\":%u}}",
+             c.seen ? (double)(int64_t)((c.high | c.last) - t0) : 0.0,
+             hdr.core, hdr.dropped);
+    }
+  }
+  for (unsigned k = 0; k < 256; k++) {
+    if (!used[k])
+      continue;
+    unmatched += (uint32_t)cores[k].open.size();
+    sep();
+    printf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+           "\"args\":{\"name\":\"Kern %u\"}}",
+           k, k);
+  }
+  printf("\n]}\n");
+  fprintf(stderr, "%u Datensätze, %u Marken, %u ohne Gegenstück, %u verworfen\n",
+          records, events, unmatched, dropped);
+  return records ? 0 : 1;
+}
@@ -1,7 +1,27 @@
 #include <Arduino.h>
 #include "Adafruit_PyCamera.h"
 #include "esp_camera.h"
+#include "esp_timer.h"
+#include "esp_system.h"
 #include <Adafruit_NeoPixel.h>
+#include "CamLink.h"
+#include "JpegCrop.h"
+#include "LabelMeter.h"
+#include "PresenceDetector.h"
+#include "RateControl.h"
+#include "ExposureControl.h"
+#include "Strobe.h"
+#include "FrameRing.h"
+#include "SpscQueue.h"
+#include "StageStats.h"
+#include "FramePool.h"
+#include "Trace.h"
+#include "Telemetry.h"
+#include "SdBurst.h"
+#include "SdJournal.h"
+#include "SensorProfile.h"
+#include "I2cBus.h"
+#include "Vibration.h"
 
 // ========================== LED-Ring ==========================
 #define LED_PIN    18
@@ -45,93 +65,1575 @@ static const bool ENABLE_LIMITED_AGC = false;            // Auto-Gain aus (true
 static const gainceiling_t GAIN_CEILING = (gainceiling_t)2; // ~2x Gain, vllt auf 4 aber dann oben an
 static const bool ENABLE_AWB = true;
 static const int JPEG_QUALITY = 15;                      // niedriger Wert = bessere Qualität (größere Datei)
+static const framesize_t CAMERA_FRAMESIZE = FRAMESIZE_SXGA; // 1280x1024, Action und Kalibrierung
+
+// Sensor-Einstellungen als Profile (lib/SensorProfile): ein Wechsel schreibt
+// nur die Werte, die vom aktuellen Stand abweichen, und meldet seine Dauer
+// (REC_PROFILE). Vorschau = Stand nach dem Start, in 240x240
+enum ProfileId : uint8_t { PROFILE_PREVIEW, PROFILE_ACTION, PROFILE_CALIB, PROFILE_COUNT };
+static const ProfileId START_PROFILE = PROFILE_ACTION;  // PROFILE_CALIB: Automatik zum Einmessen
+static const bool PREVIEW_BETWEEN_LABELS = true;         // Wartezeit nach dem Trigger als Display-Vorschau (nur ohne Ring/Pipeline)
+static const uint32_t PREVIEW_LEAD_MS = 250;             // so lange vor der Aufnahme zurück ins Aufnahmeprofil
+static const uint8_t PREVIEW_STALE_MAX = 4;              // höchstens so viele Vorschau-Frames danach verwerfen
+static const bool PROFILE_STORE = true;                  // Profile im NVS-Flash, beim Start geladen
+static const uint32_t PROFILE_SAVE_PERIOD_MS = 600000;   // aktives Profil samt Regelwerten ablegen (nur bei Änderung, 0 = nie)
+
+// ========================== Start ==========================
+// Nach Watchdog-Reset oder Brownout am Band zählt jede Sekunde bis zum ersten
+// Frame: schneller Start nur mit Expander und Kamera, diese direkt in
+// CAMERA_FRAMESIZE (statt UXGA und zwei Auflösungswechseln), ohne I2C-Scan.
+// Display und Beschleunigungssensor braucht der Bandbetrieb nicht; sie kommen
+// danach in einer Hintergrund-Task. Die SD-Karte richten SD-Serie und Journal
+// selbst ein. Zeiten bis zum ersten gültigen Frame gehen als REC_BOOT an den Host
+static const bool FAST_BOOT = true;                // false = pycamera.begin(): alles, UXGA, Vorschau
+static const uint8_t BOOT_PARTS = 0;               // zusätzlich sofort (PyCameraPart)
+static const uint8_t BOOT_DEFERRED = PYCAM_DISPLAY | PYCAM_ACCEL; // in der Start-Task (0 = nie)
+static const BaseType_t BOOT_TASK_CORE = 0;        // Loop und Analyse laufen auf Kern 1
+
+// ========================== Messmodus ==========================
+// true = Kante auf dem Board messen und pro Label nur einen Messdatensatz
+// (~56 Byte statt ~100 KB JPEG) senden; Auswertung wie image_compare.py
+static const bool MEASUREMENT_MODE = false;
+static const uint32_t JPEG_EVERY_N = 50;          // zusätzlich jedes N-te JPEG senden (0 = nie)
+static const bool MEASURE_STREAMING = true;       // volle Auflösung im Durchlauf (~40 KB RAM statt Vollbild)
+static const bool MEASURE_TRACKING = true;        // nur das vorhergesagte Kantenfenster dekodieren/durchsuchen
+static const uint8_t MEASURE_SCALE = 1;           // nur ohne Streaming: 1/2^n, 1 -> 640x512 Luma (320 KB PSRAM)
+static const double LABEL_TOP_LENGTH_CM = 9.7;    // reale obere Kantenlänge (wie image_compare.py)
+static const double ANOMALY_OFFSET_MM = 3.0;      // |Abstand| darüber -> Anomalie + JPEG
+static const double ANOMALY_ROTATION_DEG = 1.0;   // |Rotation| darüber -> Anomalie + JPEG
+// Statt des Vollbilds nur den Labelbereich senden (verlustfreier Zuschnitt
+// im DCT-Bereich); Referenz und Frames ohne Kante immer als Vollbild
+static const bool JPEG_CROP = true;
+static const uint16_t CROP_SIDE_PX = 48;          // Reserve links/rechts der Kante
+static const uint16_t CROP_ABOVE_PX = 48;         // Reserve oberhalb der Kante
+static const uint16_t CROP_BELOW_PX = 240;        // Labelfläche unterhalb der Kante
+static const size_t CROP_BUF_BYTES = 128 * 1024;  // je Ausschnitt aus dem PSRAM-Pool; zu klein -> Vollbild
+
+// ========================== Belichtungsregelung ==========================
+// AEC_VALUE_ACTION / Gain sind nur Startwerte: das 98-%-Perzentil der
+// DC-Vorschau (weißes Label, braucht PRESENCE_CHECK) wird auf den Sollwert
+// geregelt, ohne die Unschärfe-Grenze aus Bandgeschwindigkeit und px/mm zu
+// überschreiten; reicht die Belichtung nicht, steigt der Gain
+static const bool EXPOSURE_CONTROL = true;
+static const uint8_t EXPO_TARGET_LEVEL = 215;      // Sollhelligkeit Label (0..255)
+static const uint8_t EXPO_PERCENTILE = 98;         // geregeltes Perzentil
+static const double MAX_BLUR_PX = 2.0;             // erlaubte Bewegungsunschärfe
+static const double AEC_LINE_US = 25.0;            // Belichtungszeit je AEC-Schritt (einmessen!)
+static const double DEFAULT_PX_PER_MM = 7.0;       // bis eine Referenz gemessen ist
+static const uint8_t EXPO_GAIN_MAX = 4;            // höchste Gain-Stufe (Rauschen)
+
+// ========================== Beleuchtung / Blitz ==========================
+// LIGHT_CONSTANT = Ring als Dauerlicht. Strobe: Licht mit voller Leistung nur
+// im Fenster, in dem alle Zeilen gleichzeitig belichten (lange Belichtung,
+// Phase aus den VSYNC-Zeitstempeln); wirksame Belichtung = Blitzdauer, aus
+// der Unschärfe-Grenze MAX_BLUR_PX. Braucht ein abgedunkeltes Gehäuse.
+// Die Belichtungsregelung ist im Strobe-Betrieb aus
+static const strobe::LightMode LIGHT_MODE = strobe::LIGHT_CONSTANT;
+static const int STROBE_AEC_VALUE = 1200;          // Belichtung im Strobe-Betrieb (> Auslesedauer)
+static const double SENSOR_READOUT_US = 1024 * AEC_LINE_US; // alle Zeilen auslesen (einmessen!)
+static const uint32_t STROBE_PULSE_MAX_US = 2000;  // längster Blitz
+static const uint32_t STROBE_GUARD_US = 100;       // Blitzende vor dem VSYNC
+static const bool SEND_STROBE_TIMING = true;       // StrobeRecord je Frame
+
+// ========================== Vorlauf-Ringpuffer ==========================
+// Kamera läuft durch, jeder Frame landet mit Belichtungszeitpunkt im PSRAM-
+// Ring; je Trigger wird der Frame gewählt, dessen Belichtung der berechneten
+// Ankunft des Labels am nächsten liegt. Trigger im festen Raster, mehrere
+// Labels gleichzeitig unterwegs. Nur mit Dauerlicht
+static const bool PRE_TRIGGER_RING = false;
+static const size_t RING_BYTES = 1024 * 1024;      // PSRAM; ~10 Frames à 90 KB
+static const uint8_t RING_MAX_FRAMES = 16;
+static const uint8_t RING_NEIGHBOURS = 0;          // zusätzlich je Seite senden
+static const uint32_t RING_TRIGGER_PERIOD_MS = 700; // Abstand der Trigger
+static const uint32_t RING_STATS_EVERY_N = 50;     // RingStatsRecord alle N Labels
+static const uint8_t RING_MAX_PENDING = 8;         // Labels gleichzeitig unterwegs
+
+// ========================== Task-Pipeline ==========================
+// Aufnahme (Trigger, Warten, fb_get), Analyse (Presence, Messung, Ausschnitt)
+// und Senden laufen als eigene Tasks auf beiden Kernen; übergeben werden nur
+// Slot-Indizes über wartefreie SPSC-Ringe. Nicht zusammen mit dem Vorlauf-Ring
+static const bool PIPELINE_TASKS = false;
+static const uint8_t PIPE_SLOTS = 2;               // Frames in Arbeit (= fb_count des Treibers, Zweierpotenz)
+static const BaseType_t PIPE_CAPTURE_CORE = 0;     // nahe am Kameratreiber, meist blockiert
+static const BaseType_t PIPE_ANALYSIS_CORE = 1;    // rechenintensiv, eigener Kern
+static const BaseType_t PIPE_SEND_CORE = 0;        // wartet meist auf USB
+static const uint32_t PIPE_STATS_EVERY_N = 100;    // PipelineRecord alle N Frames
+
+// ========================== Bildspeicher-Pools ==========================
+// Vorschau, Messebene und Ausschnitte kommen aus zwei festen Arenen (intern /
+// PSRAM) statt vom Heap. Ausschnitte werden je Frame angefordert, nach dem
+// Zuschnitt auf ihre Größe gekürzt und nach dem Senden freigegeben; so passen
+// mehrere Frames in Arbeit in einen Pool. Belegung -> PoolStatsRecord
+static const size_t POOL_INTERNAL_BYTES = 104 * 1024; // Vorschau (60 KB), Streaming-Messpuffer (40 KB)
+static const uint32_t POOL_INTERNAL_BLOCK = 1024;
+static const size_t POOL_PSRAM_BYTES = 768 * 1024;    // Messebene ohne Streaming, Ausschnitte, Display-Vorschau (116 KB)
+static const uint32_t POOL_PSRAM_BLOCK = 4096;
+static const uint32_t POOL_STATS_EVERY_N = 100;      // PoolStatsRecord alle N Frames (0 = nie)
+
+// ========================== Tracing ==========================
+// Zeitmarken (trace::) für Trigger, Warten, VSYNC, fb_get, Auswertung und
+// Senden in einem Ring je Kern; nach jedem Frame als REC_TRACE-Datensätze
+// gesendet. trace_export macht daraus eine Chrome-Trace-Datei
+static const bool TRACE_ENABLE = false;
+static const uint8_t TRACE_RECORDS_PER_FRAME = 2;  // je Kern höchstens (à 128 Marken)
+
+// ========================== Telemetrie ==========================
+// Verteilungen je Frame (Trigger -> Belichtung -> Puffer -> erstes Byte ->
+// Daten draußen, JPEG-Größe) als Histogramme, dazu Frames in Arbeit und
+// Verlustzähler; alle TELEMETRY_PERIOD_MS ein TelemetryRecord. Zielwerte
+// prüft telemetry_report auf dem PC
+static const bool TELEMETRY = true;
+static const uint32_t TELEMETRY_PERIOD_MS = 10000;
+static const uint8_t CAMERA_ID = 0;                // unterscheidet mehrere Kameras
+
+// ========================== Ratenregelung ==========================
+// JPEG_QUALITY ist nur der Startwert: die Regelung hält das gleitende Mittel
+// der JPEG-Größe im Budget (feste Bytezahl und/oder was die gemessene
+// Verbindung im Frameabstand schafft). Jede Änderung -> QualityRecord
+static const bool RATE_CONTROL = true;
+static const uint32_t RATE_TARGET_BYTES = 90000;   // pro Frame (0 = nur Frameabstand)
+static const uint32_t RATE_FRAME_INTERVAL_MS = 0;  // Ziel-Frameabstand (0 = aus)
+static const uint8_t RATE_Q_MIN = 8;               // beste erlaubte Qualität
+static const uint8_t RATE_Q_MAX = 40;              // gröbste erlaubte Qualität
+static const uint8_t RATE_HYST_UP_PCT = 10;        // über Ziel + 10 % -> gröber
+static const uint8_t RATE_HYST_DOWN_PCT = 25;      // unter Ziel - 25 % -> feiner
+static const uint8_t RATE_HOLD_FRAMES = 3;         // Frames Ruhe nach einer Änderung
+
+// ========================== Leere Frames ==========================
+// DC-Vorschau (nur Huffman-Daten, keine IDCT) entscheidet, ob ein weißes Label
+// im Bild liegt. Leere Frames (Lücke, Fehlauslösung) -> kurzer Statusdatensatz
+// (MEAS_EMPTY) statt JPEG; funktioniert auch ohne Messmodus
+static const bool PRESENCE_CHECK = true;
+static const bool SEND_EMPTY_STATUS = true;       // false = leere Frames ganz verwerfen
+
+// ========================== SD-Serie ==========================
+// Verarbeitete Frames in Aufnahmeauflösung auf die SD-Karte (lib/SdBurst):
+// vorab belegte Dateien, Bildnummer im RAM, ein Schreibaufruf je Bild. Der
+// SPI-Takt wird beim Start von oben eingemessen (Testmuster schreiben und
+// zurücklesen). Ersetzt takePhoto (Auflösungswechsel, Namenssuche, 4 MHz)
+static const bool SD_BURST = false;
+static const uint32_t SD_EVERY_N = 1;              // jeden N-ten Frame speichern
+static const uint8_t SD_SCK_STEPS_MHZ[] = {40, 27, 20, 16, 10, 4}; // von oben probiert (80 MHz / n)
+static const uint32_t SD_FILE_BYTES = 256 * 1024;  // je Datei vorab belegt, > größtes JPEG
+static const uint8_t SD_SPARE_FILES = 4;           // Dateien im Voraus (höchstens 8)
+static const uint16_t SD_FILES_PER_DIR = 100;      // kurze Verzeichnisse: schnelles Umbenennen
+static const size_t SD_TEST_BYTES = 64 * 1024;     // Testmuster je Taktstufe (PSRAM)
+static const uint32_t SD_STATS_EVERY_N = 100;      // SdStatsRecord alle N Bilder (0 = nie)
+
+// ========================== SD-Journal ==========================
+// Fehlt der Host oder kommt er nicht nach, gehen die Datensätze eines Frames
+// (Messwerte, JPEG bzw. Ausschnitt, Blitz) unverändert ins Journal auf der
+// SD-Karte (lib/SdJournal) statt verloren. Steht die Verbindung wieder, holt
+// finishFrame je Frame einige Einträge nach, jeweils mit REC_REPLAY davor
+static const bool SD_JOURNAL = false;
+static const uint8_t JOURNAL_SCK_MHZ = 20;          // nur ohne SD-Serie (sonst deren Takt)
+static const uint32_t JOURNAL_SEGMENT_BYTES = 4 * 1024 * 1024; // je Segmentdatei vorab belegt
+static const uint16_t JOURNAL_MAX_SEGMENTS = 256;   // ~1 GB, danach neue Frames verwerfen
+static const size_t JOURNAL_BUF_BYTES = 260 * 1024; // Lesepuffer (PSRAM), > größter Frame
+static const int JOURNAL_MIN_TX_FREE = 64;          // weniger freier Sendepuffer -> Stau
+static const uint32_t JOURNAL_SLOW_FLUSH_MS = 250;  // längeres flush() -> Host zu langsam
+static const uint32_t JOURNAL_HOLD_MS = 2000;       // danach so lange ins Journal
+static const uint8_t JOURNAL_DRAIN_PER_FRAME = 1;   // nachgeholte Einträge je Frame
+
+// ========================== I2C-Bus ==========================
+// Kamera, AW9523 und LIS3DH teilen einen Bus. Der Arbiter (lib/I2cBus) lässt
+// Sensorregister vor Beschleunigungssensor vor Tasten/SD-Erkennung fahren; die
+// Eingänge des AW9523 liest die Kamera nur nach einem Flankeninterrupt bzw.
+// wenn der Zwischenwert zu alt ist
+static const int8_t AW_INT_PIN = -1;                // INT des AW9523 (-1 = nicht verdrahtet)
+static const uint32_t AW_INPUT_MAX_AGE_MS = 50;     // Eingänge spätestens so oft lesen (0 = nur INT)
+
+// ========================== Erschütterung ==========================
+// Der LIS3DH sammelt mit 400 Hz im FIFO; eine Task leert ihn stapelweise und
+// hält RMS und Spitze ohne Schwerkraft bereit (lib/Vibration). Liegt die
+// Aufnahme in einer Erschütterung, wartet captureLabel höchstens
+// VIB_MAX_SHIFT_MM Bandweg, ob sie abklingt, und nimmt sonst trotzdem auf.
+// Jeder Frame bekommt REC_VIBRATION, Messungen ggf. MEAS_VIBRATION
+static const bool VIBRATION = false;
+static const uint16_t VIB_WINDOW_SAMPLES = 16;      // RMS-Fenster (16 = 40 ms)
+static const uint16_t VIB_LIMIT_MG = 150;           // RMS darüber = Erschütterung
+static const double VIB_MAX_SHIFT_MM = 30.0;        // höchstens so viel Bandweg warten (0 = nur markieren)
+static const uint32_t VIB_DRAIN_MS = 10;            // FIFO leeren (voll nach 80 ms)
+static const BaseType_t VIB_TASK_CORE = 0;
 
 Adafruit_PyCamera pycamera;
+static labelgeom::LabelMeter meter;
+static bool measure_ready = false;
+static ratectl::RateController rate;
+static expoctl::ExposureController expo;
+static bool expo_ready = false;
+static uint32_t tx_bytes = 0;  // im aktuellen Frame gesendet (inkl. Köpfe), nur vom tx_task
+static TaskHandle_t tx_task = nullptr;  // Sende-Task der Pipeline; nullptr = loop() zählt alles
+static labelgeom::PresenceDetector presence;
+static bool presence_ready = false;
+static jpegcrop::JpegCropper cropper;
+static strobe::Strobe flash;
+static framering::FrameRing frame_ring;
+static bool ring_ready = false;
+static int64_t pending_us[RING_MAX_PENDING];  // Ankunftszeiten, älteste zuerst
+static int64_t pending_trigger_us[RING_MAX_PENDING];
+static uint8_t pending_count = 0;
+static uint32_t ring_labels = 0;
+static framepool::FramePool pool_internal, pool_psram;
+static uint8_t pool_internal_arena[POOL_INTERNAL_BYTES] __attribute__((aligned(4)));
+static bool pools_ready = false;
+static SemaphoreHandle_t pool_mutex = nullptr;   // nur mit Pipeline
+static uint32_t frame_seq = 0;
+static i2cbus::Arbiter i2c_bus;
+static telemetry::Collector telem;                // nur im sendenden Task
+static uint32_t telem_frames = 0;
+static uint32_t telem_bytes = 0;
+static volatile uint32_t capture_failures = 0;    // Aufnahme-Task
+static volatile uint32_t empty_frames = 0;        // Analyse-Task
+static sdburst::BurstWriter sd_burst;             // nur im sendenden Task
+static bool sd_ready = false;
+static uint8_t sd_sck_mhz = 0;
+static sdjournal::Journal journal;                // nur im sendenden Task
+static bool journal_ready = false;
+static uint32_t link_slow_until_ms = 0;           // bis dahin gilt der Host als zu langsam
+static sensorprof::Profile profiles[PROFILE_COUNT];
+static ProfileId active_profile = PROFILE_PREVIEW; // zuletzt angewendet
+static const char* const PROFILE_NAMES[PROFILE_COUNT] = {"preview", "action", "calib"};
+static uint32_t profile_basis[PROFILE_COUNT];     // Prüfsumme des eingebauten Profils
+static uint8_t profiles_stored = 0;               // Bit je Profil: aus dem Flash geladen
+static uint32_t profiles_saved_ms = 0;
+static SemaphoreHandle_t serial_mutex = nullptr;  // nur mit Start-Task oder Pipeline
+static camlink::BootRecord boot_rec = {};         // Zeiten aus setup()
+static volatile uint32_t boot_first_frame_us = 0; // Aufnahme
+static volatile uint32_t boot_deferred_us = 0;    // Start-Task
+static volatile bool boot_deferred_failed = false;
+static bool boot_sent = false;
+static vibration::Monitor vib;                    // nur in der Erschütterungs-Task
+static volatile bool vib_ready = false;
+static volatile uint32_t vib_level = 0;           // RMS | Spitze << 16 [mg]
+static volatile uint32_t vib_ms = 0;              // millis() der letzten Werte
+static volatile bool vib_overrun = false;
+
+static inline labelgeom::q16_t toQ16(double v) {
+  return (labelgeom::q16_t)lround(v * 65536.0);
+}
+
+// Textausgaben der Start-Task nur zwischen, nicht in Datensätzen
+static void lockSerial() {
+  if (serial_mutex) xSemaphoreTake(serial_mutex, portMAX_DELAY);
+}
+
+static void unlockSerial() {
+  if (serial_mutex) xSemaphoreGive(serial_mutex);
+}
+
+// Datensatz mit CamLink-Kopf senden (Typ JPEG entspricht dem alten [Länge][Bild]);
+// follow: fertige Datensätze, die ohne Lücke dahinter gehören (REC_REPLAY)
+static void sendRecord(camlink::RecordType type, const uint8_t* data, uint32_t len,
+                       const uint8_t* follow = nullptr, uint32_t follow_len = 0) {
+  uint8_t hdr[camlink::HEADER_SIZE];
+  camlink::encodeHeader(hdr, type, len);
+  lockSerial();
+  Serial.write(hdr, sizeof(hdr));
+  Serial.write(data, len);
+  if (follow_len) Serial.write(follow, follow_len);
+  // Datensätze anderer Tasks (etwa REC_PROFILE aus der Aufnahme) gehören
+  // nicht zum Frame, den der Sende-Task gerade misst
+  if (!tx_task || xTaskGetCurrentTaskHandle() == tx_task) tx_bytes += sizeof(hdr) + len + follow_len;
+  unlockSerial();
+}
+
+// Zeitpunkte eines Frames (esp_timer_get_time, 0 = unbekannt) für die Telemetrie
+struct FrameTiming {
+  int64_t trigger_us;
+  int64_t exposure_us;    // Belichtungsmitte
+  int64_t fb_us;          // Puffer beim Programm
+  int64_t first_byte_us;  // erster Datensatz an Serial
+  uint8_t depth;          // Frames in Arbeit
+};
+
+// Datensätze eines Frames in Sendereihenfolge. Die Nutzdaten liegen im Frame,
+// im Ausschnitt (Pool) oder hier und bleiben bis releaseOutbox() gültig
+struct Outbox {
+  static const uint8_t MAX_RECORDS = 4;
+  uint8_t count;
+  camlink::RecordType type[MAX_RECORDS];
+  const uint8_t* data[MAX_RECORDS];
+  uint32_t len[MAX_RECORDS];
+  uint8_t meas[camlink::MEASUREMENT_SIZE];
+  uint8_t strobe[camlink::STROBE_SIZE];
+  uint8_t vib[camlink::VIBRATION_SIZE];
+  uint8_t vib_flags;            // camlink::VibrationFlags dieses Frames
+  framepool::BytesHandle crop;  // gehört bis releaseOutbox() hierher
+  FrameTiming timing;
+};
+
+static void outAdd(Outbox& out, camlink::RecordType type, const uint8_t* data, uint32_t len) {
+  if (out.count == Outbox::MAX_RECORDS) return;
+  out.type[out.count] = type;
+  out.data[out.count] = data;
+  out.len[out.count] = len;
+  out.count++;
+}
+
+static void sendOutbox(Outbox& out, uint32_t seq) {
+  trace::begin(trace::EV_SEND, seq);
+  out.timing.first_byte_us = esp_timer_get_time();
+  for (uint8_t i = 0; i < out.count; i++) sendRecord(out.type[i], out.data[i], out.len[i]);
+  trace::end(trace::EV_SEND, seq);
+}
+
+// Nach dem Senden: Ausschnitt an den Pool zurück
+static void releaseOutbox(Outbox& out) {
+  if (out.crop.valid()) pool_psram.release(out.crop);
+  out.crop = {0, 0};
+  out.count = 0;
+  out.vib_flags = 0;
+}
+
+static void lockPool(void* m) {
+  xSemaphoreTake((SemaphoreHandle_t)m, portMAX_DELAY);
+}
+
+static void unlockPool(void* m) {
+  xSemaphoreGive((SemaphoreHandle_t)m);
+}
+
+// Interne Arena statisch, PSRAM-Arena einmal beim Start; ohne PSRAM-Pool
+// laufen Messung und Vorschau über den internen, Ausschnitte entfallen
+static bool beginPools() {
+  const bool internal = pool_internal.begin(pool_internal_arena, POOL_INTERNAL_BYTES,
+                                            POOL_INTERNAL_BLOCK);
+  uint8_t* arena = (uint8_t*)ps_malloc(POOL_PSRAM_BYTES);
+  if (arena) pool_psram.begin(arena, POOL_PSRAM_BYTES, POOL_PSRAM_BLOCK);
+  return internal;
+}
+
+// Dauerhafte Ebene samt Handle und Pool, aus dem sie stammt
+template <framepool::PlaneType T>
+struct PoolPlane {
+  framepool::FramePool* pool = nullptr;
+  framepool::Handle<T> handle = {0, 0};
+
+  typename framepool::PlaneTraits<T>::pixel* data() const {
+    return pool ? pool->data(handle) : nullptr;
+  }
+  void release() {
+    if (pool) pool->release(handle);
+    pool = nullptr;
+  }
+};
+
+static PoolPlane<framepool::PLANE_BYTES> presence_thumb;  // Luma + Chroma der DC-Vorschau
+static PoolPlane<framepool::PLANE_BYTES> meter_stream;    // Streaming-Messpuffer
+static PoolPlane<framepool::PLANE_GRAY8> meter_plane;     // Messebene ohne Streaming
+
+// Ebene vom Typ T anfordern (Vorschau, Messung); bevorzugt aus dem internen Pool
+template <framepool::PlaneType T>
+static bool poolPlane(PoolPlane<T>* p, size_t bytes, bool internal_first,
+                      uint16_t width = 0, uint16_t height = 0) {
+  framepool::FramePool* order[2] = {&pool_internal, &pool_psram};
+  for (uint8_t i = internal_first ? 0 : 1; i < 2; i++) {
+    p->handle = order[i]->alloc<T>(bytes, width, height);
+    if (p->handle.valid()) {
+      p->pool = order[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+static camlink::PoolInfo poolInfo(const framepool::FramePool& pool) {
+  const framepool::PoolStats st = pool.stats();
+  camlink::PoolInfo info = {};
+  info.capacity_bytes     = st.capacity_bytes;
+  info.used_bytes         = st.used_bytes;
+  info.high_water_bytes   = st.high_water_bytes;
+  info.largest_free_bytes = st.largest_free_bytes;
+  info.allocs             = st.allocs;
+  info.failures           = st.failures;
+  info.planes             = st.planes;
+  info.fragmentation_pct  = pool.fragmentationPct();
+  return info;
+}
+
+static void sendPoolStats(uint32_t seq) {
+  camlink::PoolStatsRecord rec = {};
+  rec.seq     = seq + 1;
+  rec.t_ms    = millis();
+  rec.pool[0] = poolInfo(pool_internal);
+  rec.pool[1] = poolInfo(pool_psram);
+  uint8_t buf[camlink::POOL_STATS_SIZE];
+  camlink::encodePoolStats(buf, rec);
+  sendRecord(camlink::REC_POOL_STATS, buf, sizeof(buf));
+}
+
+// Zeitmarken beider Kerne abholen; Rest folgt nach dem nächsten Frame.
+// Nur aus dem sendenden Task (loop bzw. sendTask)
+static void sendTrace(uint32_t seq) {
+  static uint8_t buf[camlink::TRACE_HEADER_SIZE + camlink::TRACE_MAX_EVENTS * camlink::TRACE_EVENT_SIZE];
+  for (uint8_t core = 0; core < trace::MAX_CORES; core++) {
+    for (uint8_t i = 0; i < TRACE_RECORDS_PER_FRAME; i++) {
+      const size_t len = trace::drainRecord(core, seq, buf, sizeof(buf));
+      if (!len) break;
+      sendRecord(camlink::REC_TRACE, buf, len);
+    }
+  }
+}
+
+// Sensorzugriffe aus Analyse- (Belichtung) und Sende-Task (Qualität) nicht
+// verschränken und vor Tasten/Beschleunigungssensor auf den Bus lassen
+static void lockSensor() {
+  i2c_bus.acquire(i2cbus::PRIO_CAMERA);
+}
+
+static void unlockSensor() {
+  i2c_bus.release(i2cbus::PRIO_CAMERA);
+}
+
+static void beginExposureControl() {
+  expoctl::ExposureConfig cfg = {};
+  cfg.target_level  = EXPO_TARGET_LEVEL;
+  cfg.percentile    = EXPO_PERCENTILE;
+  cfg.deadband_pct  = 5;
+  cfg.dark_level    = labelgeom::PresenceDetector::DEFAULT_CONFIG.min_luma;
+  cfg.aec_min       = 1;
+  cfg.aec_max       = 1200;
+  cfg.gain_min      = 0;
+  cfg.gain_max      = EXPO_GAIN_MAX;
+  cfg.settle_frames = 1;  // neue Werte greifen erst im übernächsten Frame
+  const sensorprof::Profile& p = profiles[START_PROFILE];
+  expo.begin(cfg, p.get(sensorprof::AEC_VALUE),
+             ENABLE_LIMITED_AGC ? p.get(sensorprof::GAINCEILING) : 0);
+}
+
+// Längste Belichtung [µs], bei der ein Punkt auf dem Band höchstens MAX_BLUR_PX wandert
+static double blurLimitUs() {
+  double px_per_mm = DEFAULT_PX_PER_MM;
+  if (measure_ready && meter.hasReference())
+    px_per_mm = meter.reference().px_per_cm / 65536.0 / 10.0;
+  const double belt_mm_per_s = clampSpeed((double)BAND_SPEED) * 1000.0 / 60.0;
+  return MAX_BLUR_PX / (belt_mm_per_s * px_per_mm) * 1e6;
+}
+
+static uint16_t blurCapAec() {
+  return (uint16_t)constrain(blurLimitUs() / AEC_LINE_US, 1.0, 1200.0);
+}
+
+// Blitzdauer: Unschärfe-Grenze, höchstens das gemeinsame Belichtungsfenster
+static uint32_t strobePulseUs() {
+  const double window_us = STROBE_AEC_VALUE * AEC_LINE_US - SENSOR_READOUT_US
+                           - STROBE_GUARD_US;
+  const double t_us = min(blurLimitUs(), min(window_us, (double)STROBE_PULSE_MAX_US));
+  return (uint32_t)max(t_us, 1.0);
+}
+
+// Lage des Blitzes zum Frame melden (Nachweis: im Fenster, richtiger Frame)
+static void strobeTiming(Outbox& out, uint32_t seq, uint32_t t_capture) {
+  const strobe::StrobeTiming& t = flash.timing();
+  camlink::StrobeRecord rec = {};
+  rec.seq            = seq;
+  rec.t_ms           = t_capture;
+  rec.on_us          = t.on_us;
+  rec.off_us         = t.off_us;
+  rec.exposure_us    = (uint32_t)lround(STROBE_AEC_VALUE * AEC_LINE_US);
+  rec.readout_us     = (uint32_t)lround(SENSOR_READOUT_US);
+  rec.period_us      = t.period_us;
+  rec.vsync_error_us = t.vsync_error_us;
+  rec.mode           = LIGHT_MODE;
+  rec.aligned        = t.aligned ? 1 : 0;
+  camlink::encodeStrobe(out.strobe, rec);
+  outAdd(out, camlink::REC_STROBE, out.strobe, camlink::STROBE_SIZE);
+}
+
+// FIFO im Raster leeren; die Werte gelten erst, wenn der Schwerkraftanteil steht
+static void vibTask(void*) {
+  static int16_t xyz[3 * LIS3DH_FIFO_DEPTH];
+  for (;;) {
+    bool overrun = false;
+    const int n = pycamera.readAccelFifo(xyz, LIS3DH_FIFO_DEPTH, &overrun);
+    if (n > 0) {
+      if (overrun) {
+        vib.gap();
+        vib_overrun = true;
+      }
+      vib.push(xyz, (size_t)n);
+      if (vib.settled()) {
+        vib_level = vib.rmsMg() | (uint32_t)vib.peakMg() << 16;
+        vib_ms = millis();
+      }
+    }
+    vTaskDelay(pdMS_TO_TICKS(VIB_DRAIN_MS));
+  }
+}
+
+// Braucht den initialisierten LIS3DH (beim Start oder in der Start-Task)
+static bool beginVibration() {
+  if (!pycamera.beginAccelFifo()) return false;
+  vib.begin(VIB_WINDOW_SAMPLES, 750);  // ±16 g, 0,75 mg je LSB (linksbündig)
+  return xTaskCreatePinnedToCore(vibTask, "vib", 3072, nullptr, 2, nullptr, VIB_TASK_CORE) ==
+         pdPASS;
+}
+
+static inline bool vibFresh() {
+  return vib_ms && millis() - vib_ms <= 5 * VIB_DRAIN_MS;
+}
+
+// Vor der Aufnahme: solange der RMS über der Grenze liegt, bis zu
+// VIB_MAX_SHIFT_MM Bandweg warten; Rückgabe = gewartet [ms]
+static uint16_t waitVibration() {
+  if (!vib_ready || VIB_MAX_SHIFT_MM <= 0) return 0;
+  // BAND_SPEED m/min = BAND_SPEED / 60 mm/ms
+  const uint32_t max_ms = (uint32_t)(VIB_MAX_SHIFT_MM * 60.0 / clampSpeed((double)BAND_SPEED));
+  const uint32_t t0 = millis();
+  while (vibFresh() && (vib_level & 0xFFFF) > VIB_LIMIT_MG && millis() - t0 < max_ms)
+    delay(min(VIB_DRAIN_MS, max_ms - (millis() - t0)));
+  return (uint16_t)min(millis() - t0, (uint32_t)0xFFFF);
+}
+
+// Erschütterung bei der Aufnahme melden und den Frame über out.vib_flags markieren
+static void vibrationRecord(Outbox& out, uint32_t seq, uint32_t t_capture, uint16_t delay_ms) {
+  const uint32_t level = vib_level;
+  const uint32_t age = millis() - vib_ms;
+  camlink::VibrationRecord rec = {};
+  rec.seq      = seq;
+  rec.t_ms     = t_capture;
+  rec.rms_mg   = (uint16_t)level;
+  rec.peak_mg  = (uint16_t)(level >> 16);
+  rec.limit_mg = VIB_LIMIT_MG;
+  rec.delay_ms = delay_ms;
+  rec.age_ms   = (uint16_t)min(age, (uint32_t)0xFFFF);
+  rec.window   = (uint8_t)VIB_WINDOW_SAMPLES;
+  if (!vibFresh()) rec.flags |= camlink::VIB_STALE;
+  else if (rec.rms_mg > VIB_LIMIT_MG) rec.flags |= camlink::VIB_SPIKE;
+  if (delay_ms) rec.flags |= camlink::VIB_DELAYED;
+  if (vib_overrun) {
+    rec.flags |= camlink::VIB_OVERRUN;
+    vib_overrun = false;
+  }
+  out.vib_flags = rec.flags;
+  camlink::encodeVibration(out.vib, rec);
+  outAdd(out, camlink::REC_VIBRATION, out.vib, camlink::VIBRATION_SIZE);
+}
+
+// Gain-Stufe: mit AGC als Obergrenze (2x..128x), sonst fester Gain 1x, 2x, 4x ...
+static void applyExposure() {
+  sensor_t* s = esp_camera_sensor_get();
+  if (!s) return;
+  lockSensor();
+  if (s->set_aec_value) s->set_aec_value(s, expo.aec());
+  if (ENABLE_LIMITED_AGC) {
+    if (s->set_gainceiling) s->set_gainceiling(s, (gainceiling_t)expo.gain());
+  } else if (s->set_agc_gain) {
+    s->set_agc_gain(s, min(30, (1 << expo.gain()) - 1));
+  }
+  unlockSensor();
+}
+
+// Aus dem Histogramm der Presence-Vorschau, also ohne eigene Dekodierung
+static void updateExposureControl(labelgeom::Presence seen) {
+  const uint16_t aec = expo.aec();
+  const uint8_t gain = expo.gain();
+  expo.setExposureCap(blurCapAec());
+  expo.update(presence.histogram(), seen != labelgeom::LABEL_ABSENT);
+  if (expo.aec() != aec || expo.gain() != gain) applyExposure();
+}
+
+static void beginRateControl() {
+  ratectl::RateConfig cfg = {};
+  cfg.target_bytes      = RATE_TARGET_BYTES;
+  cfg.frame_interval_ms = RATE_FRAME_INTERVAL_MS;
+  cfg.q_min             = RATE_Q_MIN;
+  cfg.q_max             = RATE_Q_MAX;
+  cfg.hyst_up_pct       = RATE_HYST_UP_PCT;
+  cfg.hyst_down_pct     = RATE_HYST_DOWN_PCT;
+  cfg.hold_frames       = RATE_HOLD_FRAMES;
+  // Startwert aus dem Profil: mit PROFILE_STORE die zuletzt geregelte Qualität
+  rate.begin(cfg, profiles[START_PROFILE].get(sensorprof::QUALITY));
+}
+
+// Nach dem Senden: Regelung nachführen, neue Qualität setzen und melden
+static void updateRateControl(uint32_t jpeg_bytes, uint32_t drain_us, uint32_t seq) {
+  if (!rate.update(jpeg_bytes, tx_bytes, drain_us)) return;
+  sensor_t* s = esp_camera_sensor_get();
+  lockSensor();
+  if (s && s->set_quality) s->set_quality(s, rate.quality());
+  unlockSensor();
+
+  camlink::QualityRecord q = {};
+  q.seq              = seq + 1;
+  q.t_ms             = millis();
+  q.quality          = rate.quality();
+  q.prev_quality     = rate.previousQuality();
+  q.avg_bytes        = rate.avgBytes();
+  q.target_bytes     = rate.targetBytes();
+  q.link_bytes_per_s = rate.linkBytesPerSec();
+  uint8_t buf[camlink::QUALITY_SIZE];
+  camlink::encodeQuality(buf, q);
+  sendRecord(camlink::REC_QUALITY, buf, sizeof(buf));
+}
+
+static bool beginPresence() {
+  // Für 8×8-MCUs (4:4:4) bemessen: mit dem 4:2:0-Standard passte ein 4:2:2-
+  // oder 4:4:4-Strom nicht, und jeder Frame gälte als "Label vorhanden"
+  const size_t bytes = labelgeom::PresenceDetector::thumbBytes(1280, 1024, 8);
+  if (!poolPlane(&presence_thumb, bytes, true)) return false;
+  if (presence.begin(presence_thumb.data(), bytes)) return true;
+  presence_thumb.release();
+  return false;
+}
+
+// Leerer Frame: Statusdatensatz ohne Geometrie; der Tracker des Messmodus
+// zählt ihn wie --check als Fehlschlag
+static void emptyStatus(Outbox& out, uint32_t seq, uint32_t t_capture) {
+  camlink::MeasurementRecord rec = {};
+  rec.seq = seq;
+  rec.t_ms = t_capture;
+  rec.flags = camlink::MEAS_EMPTY;
+  rec.status = labelgeom::NO_LABEL;
+  empty_frames++;
+  if (measure_ready) meter.replay(rec);
+  if (!SEND_EMPTY_STATUS) return;
+
+  camlink::encodeMeasurement(out.meas, rec);
+  outAdd(out, camlink::REC_MEASUREMENT, out.meas, camlink::MEASUREMENT_SIZE);
+}
+
+static bool beginMeasurement() {
+  // Streaming: kleiner Puffer im internen RAM (schneller als PSRAM); sonst
+  // eine Luma-Ebene in 1/2^MEASURE_SCALE
+  const uint16_t w = (1280 + (1 << MEASURE_SCALE) - 1) >> MEASURE_SCALE;
+  const uint16_t h = (1024 + (1 << MEASURE_SCALE) - 1) >> MEASURE_SCALE;
+  size_t bytes;
+  uint8_t* plane;
+  if (MEASURE_STREAMING) {
+    bytes = labelgeom::LabelMeter::streamBytes(1280, 1024);
+    plane = poolPlane(&meter_stream, bytes, true) ? meter_stream.data() : nullptr;
+  } else {
+    bytes = labelgeom::LabelMeter::planeBytes(1280, 1024, MEASURE_SCALE);
+    plane = poolPlane(&meter_plane, bytes, false, w, h) ? meter_plane.data() : nullptr;
+  }
+  if (!plane) return false;
+
+  labelgeom::MeterConfig cfg = {};
+  cfg.label_top_length_cm  = toQ16(LABEL_TOP_LENGTH_CM);
+  cfg.scale                = MEASURE_SCALE;
+  cfg.anomaly_offset_mm    = toQ16(ANOMALY_OFFSET_MM);
+  cfg.anomaly_rotation_deg = toQ16(ANOMALY_ROTATION_DEG);
+  cfg.streaming            = MEASURE_STREAMING;
+  cfg.tracking             = MEASURE_TRACKING;
+  if (meter.begin(plane, bytes, cfg)) return true;
+  meter_stream.release();
+  meter_plane.release();
+  return false;
+}
+
+static inline uint16_t clampPx(int32_t v) {
+  return (uint16_t)(v < 0 ? 0 : (v > 0xFFFF ? 0xFFFF : v));
+}
+
+// Ausschnitt um die gemessene Kante in eine neue Pool-Ebene (höchstens
+// CROP_BUF_BYTES, danach gekürzt); false -> Vollbild
+static bool cropFrame(const uint8_t* jpg, size_t jpg_len, const camlink::MeasurementRecord& rec,
+                      Outbox& out) {
+  if (!JPEG_CROP || !(rec.flags & camlink::MEAS_VALID) ||
+      (rec.flags & camlink::MEAS_REFERENCE))
+    return false;
+  const framepool::BytesHandle h = pool_psram.alloc<framepool::PLANE_BYTES>(CROP_BUF_BYTES);
+  uint8_t* crop = pool_psram.data(h);
+  if (!crop) return false;
+
+  const int32_t top = min(rec.tl_y, rec.tr_y) >> 16;
+  const int32_t bottom = max(rec.tl_y, rec.tr_y) >> 16;
+  jpegcrop::Rect want;
+  want.x0 = clampPx((min(rec.tl_x, rec.tr_x) >> 16) - CROP_SIDE_PX);
+  want.x1 = clampPx((max(rec.tl_x, rec.tr_x) >> 16) + CROP_SIDE_PX);
+  want.y0 = clampPx(top - CROP_ABOVE_PX);
+  want.y1 = clampPx(bottom + CROP_BELOW_PX);
+
+  // Platz für CropInfo vor den JPEG-Daten lassen (ein Datensatz)
+  size_t len = 0;
+  jpegcrop::Rect got;
+  camlink::CropInfo info;
+  trace::begin(trace::EV_CROP, rec.seq);
+  const jpegcrop::Result res = cropper.crop(jpg, jpg_len, want, crop + camlink::CROP_INFO_SIZE,
+                                            CROP_BUF_BYTES - camlink::CROP_INFO_SIZE, &len, &got,
+                                            &info.full_w, &info.full_h);
+  trace::end(trace::EV_CROP, rec.seq);
+  if (res != jpegcrop::OK) {
+    pool_psram.release(h);
+    return false;
+  }
+  info.x0 = got.x0;
+  info.y0 = got.y0;
+  camlink::encodeCropInfo(crop, info);
+  pool_psram.trim(h, camlink::CROP_INFO_SIZE + len);
+  out.crop = h;
+  outAdd(out, camlink::REC_JPEG_CROP, crop, camlink::CROP_INFO_SIZE + len);
+  return true;
+}
+
+static bool beginRing() {
+  uint8_t* arena = (uint8_t*)ps_malloc(RING_BYTES);
+  return arena && frame_ring.begin(arena, RING_BYTES, RING_MAX_FRAMES);
+}
+
+// Beginn des Auslesens (VSYNC); der Treiber stempelt mit esp_timer_get_time()
+static int64_t frameStartUs(const camera_fb_t* fb) {
+  return (int64_t)fb->timestamp.tv_sec * 1000000 + fb->timestamp.tv_usec;
+}
+
+// Belichtungsmitte der mittleren Bildzeile
+static int64_t frameExposureUs(const camera_fb_t* fb) {
+  const uint16_t aec = expo_ready ? expo.aec() : AEC_VALUE_ACTION;
+  return frameStartUs(fb) + (int64_t)lround((SENSOR_READOUT_US - aec * AEC_LINE_US) / 2);
+}
+
+// Erster vollständiger JPEG-Frame nach dem Start (Boot-Metrik)
+static void noteFirstFrame(const camera_fb_t* fb) {
+  if (boot_first_frame_us || fb->len < 2 || fb->buf[0] != 0xFF || fb->buf[1] != 0xD8) return;
+  boot_first_frame_us = (uint32_t)esp_timer_get_time();
+}
+
+static void sendRingStats() {
+  const framering::RingStats& st = frame_ring.stats();
+  camlink::RingStatsRecord rec = {};
+  rec.seq              = frame_seq;
+  rec.t_ms             = millis();
+  rec.capacity_bytes   = st.capacity_bytes;
+  rec.used_bytes       = st.used_bytes;
+  rec.high_water_bytes = st.high_water_bytes;
+  rec.frames           = st.frames;
+  rec.max_frames       = st.max_frames;
+  rec.pushed           = st.pushed;
+  rec.overwritten      = st.overwritten;
+  rec.oversize         = st.oversize;
+  rec.sensor_gaps      = st.sensor_gaps;
+  rec.hits             = st.hits;
+  rec.misses           = st.misses;
+  rec.period_us        = frame_ring.periodUs();
+  rec.last_error_us    = st.last_error_us;
+  uint8_t buf[camlink::RING_STATS_SIZE];
+  camlink::encodeRingStats(buf, rec);
+  sendRecord(camlink::REC_RING_STATS, buf, sizeof(buf));
+}
+
+// Takt von oben probieren: je Stufe Karte neu initialisieren, Ersatzdateien
+// anlegen, Testmuster schreiben und vergleichen. SdFat prüft ohne CRC, zu
+// hoher Takt fiele sonst erst als kaputte Bilder auf
+static bool beginSdBurst() {
+  if (!pycamera.SDdetected()) return false;
+  uint8_t* pattern = (uint8_t*)ps_malloc(SD_TEST_BYTES);
+  if (!pattern) return false;
+  uint32_t x = 0x2545F491;
+  for (size_t i = 0; i < SD_TEST_BYTES; i++) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    pattern[i] = (uint8_t)x;
+  }
+  const sdburst::Config cfg = {"/BURST", SD_FILE_BYTES, SD_SPARE_FILES, SD_FILES_PER_DIR};
+  for (uint8_t mhz : SD_SCK_STEPS_MHZ) {
+    if (!pycamera.initSD(mhz)) continue;
+    if (sd_burst.begin(&pycamera.sd, cfg) == sdburst::OK &&
+        sd_burst.selfTest(pattern, SD_TEST_BYTES) == sdburst::OK) {
+      sd_sck_mhz = mhz;
+      break;
+    }
+    sd_burst.end();
+  }
+  free(pattern);
+  return sd_sck_mhz != 0;
+}
+
+static void sendSdStats(uint32_t seq) {
+  const sdburst::BurstStats& st = sd_burst.stats();
+  camlink::SdStatsRecord rec = {};
+  rec.seq             = seq + 1;
+  rec.t_ms            = millis();
+  rec.files           = st.files;
+  rec.failures        = st.failures;
+  rec.kbytes          = (uint32_t)(st.bytes >> 10);
+  rec.busy_ms         = (uint32_t)(st.busy_us / 1000);
+  rec.last_write_us   = st.last_write_us;
+  rec.max_write_us    = st.max_write_us;
+  rec.max_prealloc_us = st.max_prealloc_us;
+  rec.next_index      = st.next_index;
+  rec.spare           = st.spare;
+  rec.sck_mhz         = sd_sck_mhz;
+  rec.last_error      = st.last_error;
+  uint8_t buf[camlink::SD_STATS_SIZE];
+  camlink::encodeSdStats(buf, rec);
+  sendRecord(camlink::REC_SD_STATS, buf, sizeof(buf));
+}
 
-static void applyActionPhotoProfile(sensor_t* s) {
+// Aus dem sendenden Task, solange der Frame noch gehalten wird; Ersatzdateien
+// legt finishFrame nach
+static void saveBurst(const uint8_t* jpg, size_t len, uint32_t seq) {
+  if (!sd_ready || seq % SD_EVERY_N) return;
+  trace::begin(trace::EV_SD_WRITE, seq);
+  sd_burst.write(jpg, len);
+  trace::end(trace::EV_SD_WRITE, seq);
+  const sdburst::BurstStats& st = sd_burst.stats();
+  if (SD_STATS_EVERY_N && (st.files + st.failures) % SD_STATS_EVERY_N == 0) sendSdStats(seq);
+}
+
+// Karte wie die SD-Serie (deren Takt) oder allein mit JOURNAL_SCK_MHZ
+static bool beginJournal() {
+  if (!pycamera.SDdetected()) return false;
+  if (!sd_ready && !pycamera.initSD(JOURNAL_SCK_MHZ)) return false;
+  uint8_t* buf = (uint8_t*)ps_malloc(JOURNAL_BUF_BYTES);
+  if (!buf) return false;
+  const sdjournal::Config cfg = {"/JOURNAL", JOURNAL_SEGMENT_BYTES, JOURNAL_MAX_SEGMENTS};
+  if (journal.begin(&pycamera.sd, cfg, buf, JOURNAL_BUF_BYTES) == sdjournal::OK) return true;
+  free(buf);
+  return false;
+}
+
+// Host fehlt, Sendepuffer voll oder zuletzt zu langsames flush()
+static bool linkBackedUp() {
+  if (!Serial || Serial.availableForWrite() < JOURNAL_MIN_TX_FREE) return true;
+  return (int32_t)(millis() - link_slow_until_ms) < 0;
+}
+
+// Dauer eines flush() bewerten (finishFrame, drainJournal)
+static void noteFlush(uint32_t flush_ms) {
+  if (flush_ms > JOURNAL_SLOW_FLUSH_MS) link_slow_until_ms = millis() + JOURNAL_HOLD_MS;
+}
+
+// Frame live senden oder bei Stau samt CamLink-Köpfen ins Journal; dann
+// bleibt timing.first_byte_us 0. Geht auch das Journal nicht, wird wie
+// bisher gesendet (der Treiber verwirft, was er nicht annimmt)
+static void deliverOutbox(Outbox& out, uint32_t seq) {
+  if (journal_ready && linkBackedUp()) {
+    uint8_t hdr[Outbox::MAX_RECORDS][camlink::HEADER_SIZE];
+    const uint8_t* parts[2 * Outbox::MAX_RECORDS];
+    uint32_t lens[2 * Outbox::MAX_RECORDS];
+    for (uint8_t i = 0; i < out.count; i++) {
+      camlink::encodeHeader(hdr[i], out.type[i], out.len[i]);
+      parts[2 * i] = hdr[i];
+      lens[2 * i] = camlink::HEADER_SIZE;
+      parts[2 * i + 1] = out.data[i];
+      lens[2 * i + 1] = out.len[i];
+    }
+    trace::begin(trace::EV_SD_WRITE, seq);
+    const sdjournal::Result r = journal.append(seq, millis(), parts, lens, 2 * out.count);
+    trace::end(trace::EV_SD_WRITE, seq);
+    if (r == sdjournal::OK) return;
+  }
+  sendOutbox(out, seq);
+}
+
+// Ältere Frames nachholen, solange der Host mitkommt. Erst nach dem flush()
+// und nur bei weiter stehender Verbindung gilt ein Eintrag als abgeholt
+static void drainJournal() {
+  for (uint8_t i = 0; i < JOURNAL_DRAIN_PER_FRAME && !journal.empty() && !linkBackedUp(); i++) {
+    uint32_t seq, t_ms, len;
+    const uint8_t* data;
+    const sdjournal::Result r = journal.peek(&seq, &t_ms, &data, &len);
+    if (r == sdjournal::CORRUPT) continue;  // Rest des Segments übersprungen
+    if (r != sdjournal::OK) break;
+    const sdjournal::JournalStats& st = journal.stats();
+    const uint64_t backlog = st.backlog_bytes - sdjournal::Journal::ENTRY_HEADER - len;
+    camlink::ReplayRecord rec = {};
+    rec.seq            = seq;
+    rec.t_ms           = t_ms;
+    rec.len            = len;
+    rec.backlog_kbytes = (uint32_t)(backlog >> 10);
+    rec.spilled        = st.appended;
+    rec.drained        = st.popped;
+    rec.dropped        = st.dropped;
+    rec.corrupt        = st.corrupt;
+    uint8_t buf[camlink::REPLAY_SIZE];
+    camlink::encodeReplay(buf, rec);
+    trace::begin(trace::EV_SEND, seq);
+    // Unter einer Sperre: Text der Start-Task darf nicht zwischen REPLAY und Eintrag
+    sendRecord(camlink::REC_REPLAY, buf, sizeof(buf), data, len);
+    if (TELEMETRY) telem_bytes += camlink::HEADER_SIZE + sizeof(buf) + len;
+    const uint32_t t0 = millis();
+    Serial.flush();
+    noteFlush(millis() - t0);
+    trace::end(trace::EV_SEND, seq);
+    if (!Serial) break;  // Verbindung weg: beim nächsten Mal noch einmal
+    journal.pop();
+  }
+}
+
+// Auswerten: Presence, ggf. Messung und Ausschnitt; Ergebnis in out
+static void processFrame(const uint8_t* jpg, size_t len, uint32_t seq, uint32_t t_capture,
+                         Outbox& out) {
+  labelgeom::Presence seen = labelgeom::LABEL_PRESENT;
+  if (presence_ready) {
+    trace::begin(trace::EV_PRESENCE, seq);
+    seen = presence.detect(jpg, len);
+    trace::end(trace::EV_PRESENCE, seq);
+  }
+  if (expo_ready) updateExposureControl(seen);
+  if (seen == labelgeom::LABEL_ABSENT) {
+    emptyStatus(out, seq, t_capture);
+  } else if (measure_ready) {
+    camlink::MeasurementRecord rec;
+    trace::begin(trace::EV_MEASURE, seq);
+    meter.measure(jpg, len, seq, t_capture, &rec);
+    trace::end(trace::EV_MEASURE, seq);
+    if (seen == labelgeom::LABEL_PARTIAL) rec.flags |= camlink::MEAS_PARTIAL;
+    if (out.vib_flags & camlink::VIB_SPIKE) rec.flags |= camlink::MEAS_VIBRATION;
+
+    // JPEG nur für Referenz, Anomalien und jedes N-te Bild
+    const bool send_jpeg =
+        (rec.flags & (camlink::MEAS_ANOMALY | camlink::MEAS_REFERENCE)) ||
+        (JPEG_EVERY_N && (seq % JPEG_EVERY_N) == 0);
+    if (send_jpeg) rec.flags |= camlink::MEAS_JPEG_FOLLOWS;
+
+    camlink::encodeMeasurement(out.meas, rec);
+    outAdd(out, camlink::REC_MEASUREMENT, out.meas, camlink::MEASUREMENT_SIZE);
+    if (send_jpeg && !cropFrame(jpg, len, rec, out))
+      outAdd(out, camlink::REC_JPEG, jpg, len);
+  } else {
+    outAdd(out, camlink::REC_JPEG, jpg, len);
+  }
+}
+
+static uint32_t pipelineQueueFull();
+
+static inline uint32_t spanUs(int64_t from, int64_t to) {
+  return to > from ? (uint32_t)min(to - from, (int64_t)0xFFFFFFFF) : 0;
+}
+
+static void recordTelemetry(const FrameTiming& tm, uint32_t jpeg_bytes, int64_t t_done) {
+  if (tm.trigger_us && tm.exposure_us)
+    telem.record(camlink::TM_TRIGGER_TO_EXPOSURE, spanUs(tm.trigger_us, tm.exposure_us));
+  if (tm.exposure_us && tm.fb_us)
+    telem.record(camlink::TM_EXPOSURE_TO_FB, spanUs(tm.exposure_us, tm.fb_us));
+  if (tm.fb_us && tm.first_byte_us)
+    telem.record(camlink::TM_FB_TO_FIRST_BYTE, spanUs(tm.fb_us, tm.first_byte_us));
+  if (tm.first_byte_us)
+    telem.record(camlink::TM_TRANSMIT, spanUs(tm.first_byte_us, t_done));
+  telem.record(camlink::TM_FRAME_BYTES, jpeg_bytes);
+  telem.record(camlink::TM_I2C_WAIT, i2c_bus.takeMaxWaitUs(i2cbus::PRIO_CAMERA));
+  telem.depth(tm.depth);
+  telem_frames++;
+  telem_bytes += tx_bytes;
+}
+
+static void sendTelemetry(uint32_t seq, uint32_t interval_ms) {
+  static camlink::TelemetryRecord rec;
+  static uint8_t buf[camlink::TELEMETRY_MAX_SIZE];
+  rec.seq              = seq + 1;
+  rec.t_ms             = millis();
+  rec.interval_ms      = interval_ms;
+  rec.camera           = CAMERA_ID;
+  rec.frames           = telem_frames;
+  rec.capture_failures = capture_failures;
+  rec.empty_frames     = empty_frames;
+  rec.ring_misses      = ring_ready ? frame_ring.stats().misses : 0;
+  rec.queue_full       = pipelineQueueFull();
+  rec.bytes_sent       = telem_bytes;
+  telem.take(&rec);
+  const size_t len = camlink::encodeTelemetry(buf, sizeof(buf), rec);
+  if (len) sendRecord(camlink::REC_TELEMETRY, buf, len);
+}
+
+// Einmal je Start, wenn auch die Start-Task fertig ist und ein Host zuhört
+static void sendBoot(uint32_t seq) {
+  camlink::BootRecord rec = boot_rec;
+  rec.seq            = seq;
+  rec.first_frame_us = boot_first_frame_us;
+  rec.deferred_us    = boot_deferred_us;
+  if (boot_deferred_failed) rec.flags |= camlink::BOOT_DEFERRED_FAILED;
+  uint8_t buf[camlink::BOOT_SIZE];
+  camlink::encodeBoot(buf, rec);
+  sendRecord(camlink::REC_BOOT, buf, sizeof(buf));
+  boot_sent = true;
+}
+
+// Nach dem Senden: Sendedauer = bis die Daten die Schnittstelle verlassen haben
+static void finishFrame(uint32_t jpeg_bytes, uint32_t t_send, uint32_t seq,
+                        const FrameTiming& timing) {
+  // Ins Journal gelegte Frames haben keine Sendedauer
+  const bool sent = timing.first_byte_us != 0;
+  if (sent && (RATE_CONTROL || TELEMETRY || journal_ready)) {
+    const uint32_t t0 = millis();
+    trace::begin(trace::EV_FLUSH, seq);
+    Serial.flush();
+    trace::end(trace::EV_FLUSH, seq);
+    noteFlush(millis() - t0);
+  }
+  if (RATE_CONTROL && sent) updateRateControl(jpeg_bytes, micros() - t_send, seq);
+  if (!boot_sent && boot_first_frame_us && (boot_deferred_us || !boot_rec.deferred) && Serial)
+    sendBoot(seq);
+  if (TELEMETRY) {
+    static uint32_t t_last = 0;
+    recordTelemetry(timing, jpeg_bytes, esp_timer_get_time());
+    const uint32_t now = millis();
+    if (now - t_last >= TELEMETRY_PERIOD_MS) {
+      sendTelemetry(seq, now - t_last);
+      t_last = now;
+    }
+  }
+  if (pools_ready && POOL_STATS_EVERY_N && (seq + 1) % POOL_STATS_EVERY_N == 0) sendPoolStats(seq);
+  if (TRACE_ENABLE) sendTrace(seq);
+  if (sd_ready) sd_burst.service();  // höchstens eine Ersatzdatei je Frame
+  if (journal_ready) drainJournal();
+}
+
+// Action-Profil aus den Konstanten oben; Felder ohne Vorgabe wie in base
+static sensorprof::Profile actionProfile(const sensorprof::Profile& base) {
+  sensorprof::Profile p = base;
   // --- Pixelformat / Auflösung ---
-  if (s->set_pixformat) s->set_pixformat(s, PIXFORMAT_JPEG);
-  if (s->set_framesize) s->set_framesize(s, FRAMESIZE_SXGA);  // 1280x1024
+  p.set(sensorprof::PIXFORMAT, PIXFORMAT_JPEG);
+  p.set(sensorprof::FRAMESIZE, CAMERA_FRAMESIZE);
 
   // --- Kompression / Rauschen ---
-  if (s->set_quality)  s->set_quality(s, JPEG_QUALITY);
-  if (s->set_denoise)  s->set_denoise(s, 6);
-  if (s->set_bpc)      s->set_bpc(s, true);
-  if (s->set_wpc)      s->set_wpc(s, true);
-  if (s->set_lenc)     s->set_lenc(s, true);
+  p.set(sensorprof::QUALITY, JPEG_QUALITY);
+  p.set(sensorprof::DENOISE, 6);
+  p.set(sensorprof::BPC, true);
+  p.set(sensorprof::WPC, true);
+  p.set(sensorprof::LENC, true);
 
   // --- Bildlook leicht justieren ---
-  if (s->set_sharpness)  s->set_sharpness(s, 2);
-  if (s->set_saturation) s->set_saturation(s, 0);
-  if (s->set_contrast)   s->set_contrast(s, 0);
-  if (s->set_brightness) s->set_brightness(s, 0);
+  p.set(sensorprof::SHARPNESS, 2);
+  p.set(sensorprof::SATURATION, 0);
+  p.set(sensorprof::CONTRAST, 0);
+  p.set(sensorprof::BRIGHTNESS, 0);
 
   // --- Weißabgleich ---
-  if (s->set_whitebal) s->set_whitebal(s, ENABLE_AWB ? 1 : 0);
-  if (s->set_awb_gain) s->set_awb_gain(s, ENABLE_AWB ? 1 : 0);
+  p.set(sensorprof::AWB, ENABLE_AWB ? 1 : 0);
+  p.set(sensorprof::AWB_GAIN, ENABLE_AWB ? 1 : 0);
 
   // --- Belichtung manuell kurz ---
-  if (s->set_exposure_ctrl) s->set_exposure_ctrl(s, 0);   // AEC AUS
-  if (s->set_aec2)          s->set_aec2(s, 0);
-  if (s->set_aec_value)     s->set_aec_value(s, AEC_VALUE_ACTION);
-  if (s->set_ae_level)      s->set_ae_level(s, -2);       // lieber etwas dunkler statt länger belichten
+  p.set(sensorprof::AEC, 0);   // AEC AUS
+  p.set(sensorprof::AEC2, 0);
+  p.set(sensorprof::AEC_VALUE,
+        LIGHT_MODE == strobe::LIGHT_CONSTANT ? AEC_VALUE_ACTION : STROBE_AEC_VALUE);
+  p.set(sensorprof::AE_LEVEL, -2);  // lieber etwas dunkler statt länger belichten
 
-  // --- Gain/ISO: nur set_gain_ctrl verwenden 
-  if (s->set_gain_ctrl)     s->set_gain_ctrl(s, ENABLE_LIMITED_AGC ? 1 : 0);
-  if (s->set_gainceiling)   s->set_gainceiling(s, GAIN_CEILING);
+  // --- Gain/ISO: nur gain_ctrl verwenden
+  p.set(sensorprof::AGC, ENABLE_LIMITED_AGC ? 1 : 0);
+  p.set(sensorprof::GAINCEILING, GAIN_CEILING);
+  return p;
+}
 
+// Einmessen (AEC_LINE_US, Referenzbild): wie Action, Belichtung, Gain und
+// Weißabgleich automatisch
+static sensorprof::Profile calibProfile(const sensorprof::Profile& action) {
+  sensorprof::Profile p = action;
+  p.set(sensorprof::AWB, 1);
+  p.set(sensorprof::AWB_GAIN, 1);
+  p.set(sensorprof::AEC, 1);
+  p.set(sensorprof::AEC2, 1);
+  p.set(sensorprof::AE_LEVEL, 0);
+  p.set(sensorprof::AGC, 1);
+  return p;
 }
 
-// ========================== Setup ==========================
-void setup() {
-  Serial.begin(5000000);
-  if (!pycamera.begin()) {
-    while (true) { delay(100); }
+// Profile vom Stand nach dem Start ableiten; der schnelle Start lässt die
+// Kamera schon in CAMERA_FRAMESIZE. Mit PROFILE_STORE gilt stattdessen das
+// Profil im Flash, wenn es unbeschädigt ist und aus demselben eingebauten
+// Profil hervorging (sonst haben sich die Konstanten geändert); fehlt es,
+// wird das eingebaute abgelegt
+static void beginProfiles(sensor_t* s) {
+  sensorprof::capture(s, &profiles[PROFILE_PREVIEW]);
+  profiles[PROFILE_PREVIEW].set(sensorprof::FRAMESIZE, FRAMESIZE_240X240);
+  profiles[PROFILE_ACTION] = actionProfile(profiles[PROFILE_PREVIEW]);
+  profiles[PROFILE_CALIB] = calibProfile(profiles[PROFILE_ACTION]);
+  if (!PROFILE_STORE) return;
+  sensorprof::ProfileStore store;
+  if (!store.begin("sensorprof")) return;
+  for (uint8_t i = 0; i < PROFILE_COUNT; i++) {
+    profile_basis[i] = sensorprof::checksum(profiles[i]);
+    sensorprof::Profile stored;
+    uint32_t basis;
+    if (store.load(PROFILE_NAMES[i], &stored, &basis) && basis == profile_basis[i]) {
+      profiles[i] = stored;
+      profiles_stored |= 1 << i;
+    } else {
+      store.save(PROFILE_NAMES[i], profiles[i], profile_basis[i]);
+    }
   }
-  // LED-Ring
-  ring.begin();
-  ring.setBrightness(200);
-  for (uint16_t i = 0; i < LED_COUNT; i++) ring.setPixelColor(i, ring.Color(255, 255, 255));
-  ring.show();
+  store.end();
+  profiles_saved_ms = millis();
+}
 
-  // Kamera
-  sensor_t *sensor = esp_camera_sensor_get();
-  applyActionPhotoProfile(sensor);
+// Alle PROFILE_SAVE_PERIOD_MS den Stand samt Werten von Belichtungs- und
+// Ratenregelung ins aktive Profil übernehmen und ablegen; der nächste Start
+// beginnt damit. Nur aus loop(): der Flash-Zugriff hält beide Kerne an
+static void saveProfile() {
+  if (!PROFILE_STORE || !PROFILE_SAVE_PERIOD_MS ||
+      millis() - profiles_saved_ms < PROFILE_SAVE_PERIOD_MS) return;
+  profiles_saved_ms = millis();
+  lockSensor();
+  sensorprof::capture(esp_camera_sensor_get(), &profiles[active_profile]);
+  unlockSensor();
+  sensorprof::ProfileStore store;
+  if (!store.begin("sensorprof")) return;
+  store.save(PROFILE_NAMES[active_profile], profiles[active_profile],
+             profile_basis[active_profile]);
+  store.end();
+}
 
-  // Trigger
-  pinMode(TRIG_PIN, OUTPUT);
-  digitalWrite(TRIG_PIN, LOW);
+// Zwischen zwei Labels aufrufen: nach einem Auflösungswechsel liefert der
+// Treiber noch Frames im alten Format (takePhoto verwirft zwei)
+static sensorprof::SwitchReport switchProfile(ProfileId id, uint32_t seq) {
+  trace::begin(trace::EV_PROFILE, seq);
+  lockSensor();
+  const sensorprof::SwitchReport r = sensorprof::apply(esp_camera_sensor_get(), profiles[id]);
+  unlockSensor();
+  active_profile = id;
+  trace::end(trace::EV_PROFILE, seq);
+  camlink::ProfileRecord rec = {};
+  rec.seq       = seq;
+  rec.t_ms      = millis();
+  rec.switch_us = r.us;
+  rec.profile   = id;
+  rec.writes    = r.writes;
+  rec.failed    = r.failed;
+  rec.flags     = (r.resized ? camlink::PROFILE_RESIZED : 0) |
+                  (profiles_stored & (1 << id) ? camlink::PROFILE_STORED : 0);
+  uint8_t buf[camlink::PROFILE_SIZE];
+  camlink::encodeProfile(buf, rec);
+  sendRecord(camlink::REC_PROFILE, buf, sizeof(buf));
+  return r;
+}
 
+// Das Display kann in der Start-Task noch initialisiert werden
+static bool displayReady() {
+  if (!FAST_BOOT || (BOOT_PARTS & PYCAM_DISPLAY)) return true;
+  return (BOOT_DEFERRED & PYCAM_DISPLAY) && boot_deferred_us && !boot_deferred_failed;
 }
 
-// ========================== Loop ==========================
-void loop() {
+// Zwischen zwei Labels: Vorschauprofil und Frames aufs Display bis until_ms,
+// dann zurück. Der Stand davor mit den Werten von Belichtungs- und
+// Ratenregelung wird vorher ins aktive Profil übernommen, sonst setzte die
+// Rückkehr die Konstanten. Nach dem Auflösungswechsel liefert der Treiber
+// noch Vorschau-Frames; die gehen zurück, bis ein größerer kommt
+static void showPreview(uint32_t until_ms, uint32_t seq) {
+  if (!displayReady() || (int32_t)(until_ms - millis()) <= 0) return;
+  const ProfileId resume = active_profile;
+  lockSensor();
+  sensorprof::capture(esp_camera_sensor_get(), &profiles[resume]);
+  unlockSensor();
+  switchProfile(PROFILE_PREVIEW, seq);
+  while ((int32_t)(until_ms - millis()) > 0 && pycamera.captureFrame())
+    pycamera.blitFrame();
+  if (!switchProfile(resume, seq).resized) return;
+  for (uint8_t i = 0; i < PREVIEW_STALE_MAX; i++) {
+    camera_fb_t* fb = esp_camera_fb_get();
+    if (!fb) break;
+    const bool stale = fb->width <= 240;
+    esp_camera_fb_return(fb);
+    if (!stale) break;
+  }
+}
+
+// ========================== Aufnahme je Trigger ==========================
+// t_trigger_us: Zeitpunkt des Trigger-Impulses (Telemetrie). preview nur aus
+// loop(): in der Pipeline stellen Analyse und Senden den Sensor parallel nach
+// und brauchen die Kamerapuffer selbst
+static camera_fb_t* captureLabel(int64_t* t_trigger_us, uint16_t* vib_delay_ms, bool preview) {
   const uint32_t t0 = millis();
 
   // Geplante Wartezeit (nur aus Abstand, Bandgeschwindigkeit, Offset)
   const int32_t planned_wait_ms = computeWaitMs(ABSTAND_M, (double)BAND_SPEED, OFFSET_CM);
 
   // ===================== Trigger zuerst (Lichtschranke) =====================
+  trace::instant(trace::EV_TRIGGER, frame_seq);
+  *t_trigger_us = esp_timer_get_time();
   digitalWrite(TRIG_PIN, HIGH);
   delay(100);
   digitalWrite(TRIG_PIN, LOW);
-  delay(600);
+  const uint32_t t_low = millis();
+  // Bis kurz vor der Aufnahme braucht niemand den Sensor
+  if (preview) {
+    const uint32_t t_shot = t0 + (uint32_t)max(planned_wait_ms, (int32_t)(t_low - t0 + 600));
+    showPreview(t_shot - PREVIEW_LEAD_MS, frame_seq);
+  }
+  const uint32_t dt_low = millis() - t_low;
+  if (dt_low < 600) delay(600 - dt_low);
 
   // Bisher verstrichene Zeit seit Loop-Beginn (inkl. Trigger-Delays)
   const uint32_t dt_after_trigger = millis() - t0;
 
   // Verbleibende Wartezeit bis zum Aufnahmezeitpunkt (nicht negativ werden lassen)
   int32_t remaining_ms = (int32_t)planned_wait_ms - (int32_t)dt_after_trigger;
-  if (remaining_ms > 0) {
+  const bool strobe_mode = LIGHT_MODE != strobe::LIGHT_CONSTANT;
+  if (remaining_ms > 0 && !strobe_mode) {
+    trace::begin(trace::EV_WAIT, frame_seq);
     delay((uint32_t)remaining_ms);
+    trace::end(trace::EV_WAIT, frame_seq);
   }
+  // Mit Dauerlicht darf die Aufnahme einer Erschütterung ausweichen
+  *vib_delay_ms = strobe_mode ? 0 : waitVibration();
 
   // ===================== Aufnahme =====================
-  camera_fb_t *fb = esp_camera_fb_get();
+  // Strobe: Frames bis zum Zielzeitpunkt durchlaufen lassen, dann blitzen
+  const trace::EventId ev = strobe_mode ? trace::EV_STROBE : trace::EV_FB_GET;
+  trace::begin(ev, frame_seq);
+  camera_fb_t* fb = strobe_mode
+      ? flash.capture(esp_timer_get_time() + (int64_t)max(remaining_ms, (int32_t)0) * 1000,
+                      strobePulseUs(), STROBE_GUARD_US)
+      : esp_camera_fb_get();
+  trace::end(ev, frame_seq);
   if (fb) {
-    uint32_t len = fb->len;
-    Serial.write(reinterpret_cast<uint8_t*>(&len), sizeof(len));
-    Serial.write(fb->buf, fb->len);
+    trace::emitAt(trace::EV_VSYNC, trace::PH_INSTANT, (uint32_t)frameStartUs(fb), frame_seq);
+    noteFirstFrame(fb);
+  }
+  return fb;
+}
+
+// ========================== Task-Pipeline ==========================
+// Slots laufen im Kreis: frei -> Aufnahme -> Analyse -> Senden -> frei. Jeder
+// Ring hat genau einen Erzeuger- und einen Verbraucher-Task; da es nur
+// PIPE_SLOTS Slots gibt, läuft kein Ring über
+struct PipeJob {
+  camera_fb_t* fb;
+  uint32_t seq;
+  uint32_t t_capture;
+  Outbox out;
+};
+
+static PipeJob pipe_jobs[PIPE_SLOTS];
+static pipeline::SpscQueue<uint8_t, PIPE_SLOTS> q_free, q_analyze, q_send;
+static pipeline::StageStats st_capture, st_analyze, st_send;
+static TaskHandle_t task_capture = nullptr, task_analyze = nullptr, task_send = nullptr;
+static bool pipeline_ready = false;
+
+// Nächsten Slot holen; schläft, bis der Erzeuger benachrichtigt
+static uint8_t pipeTake(pipeline::SpscQueue<uint8_t, PIPE_SLOTS>& q) {
+  uint8_t slot;
+  while (!q.pop(&slot)) ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  return slot;
+}
+
+static void pipePut(pipeline::SpscQueue<uint8_t, PIPE_SLOTS>& q, uint8_t slot,
+                    TaskHandle_t consumer) {
+  q.push(slot);
+  xTaskNotifyGive(consumer);
+}
+
+static void sendPipelineStats(uint32_t seq) {
+  static uint32_t t_last = 0;
+  const uint32_t now = micros();
+  camlink::PipelineRecord rec = {};
+  rec.seq         = seq + 1;
+  rec.t_ms        = millis();
+  rec.interval_us = now - t_last;
+  t_last = now;
+  pipeline::StageStats* stages[] = {&st_capture, &st_analyze, &st_send};
+  for (uint8_t i = 0; i < camlink::PIPELINE_STAGES; i++) {
+    const pipeline::StageSnapshot st = stages[i]->take();
+    rec.stage[i] = {st.frames, st.busy_us, st.stall_us};
+  }
+  const pipeline::SpscQueue<uint8_t, PIPE_SLOTS>* queues[] = {&q_free, &q_analyze, &q_send};
+  for (uint8_t i = 0; i < camlink::PIPELINE_STAGES; i++) {
+    rec.queue[i] = {queues[i]->capacity(), queues[i]->depth(), queues[i]->highWater(),
+                    queues[i]->fullCount()};
+  }
+  uint8_t buf[camlink::PIPELINE_SIZE];
+  camlink::encodePipeline(buf, rec);
+  sendRecord(camlink::REC_PIPELINE, buf, sizeof(buf));
+}
+
+// Aufnahme: wartet auf einen freien Slot (= Rückstau, stall), dann ein Label
+static void captureTask(void*) {
+  for (;;) {
+    const uint32_t t_wait = micros();
+    const uint8_t slot = pipeTake(q_free);
+    const uint32_t t_start = micros();
+    st_capture.addStall(t_start - t_wait);
+
+    int64_t t_trigger = 0;
+    uint16_t vib_delay = 0;
+    camera_fb_t* fb = captureLabel(&t_trigger, &vib_delay, false);
+    if (!fb) {
+      capture_failures++;
+      q_free.push(slot);
+      continue;
+    }
+    PipeJob& job = pipe_jobs[slot];
+    job.fb = fb;
+    job.seq = frame_seq++;
+    job.t_capture = millis();
+    job.out.count = 0;
+    job.out.timing = {t_trigger, frameExposureUs(fb), esp_timer_get_time(), 0, 0};
+    if (LIGHT_MODE != strobe::LIGHT_CONSTANT && SEND_STROBE_TIMING)
+      strobeTiming(job.out, job.seq, job.t_capture);
+    if (vib_ready) vibrationRecord(job.out, job.seq, job.t_capture, vib_delay);
+    st_capture.addBusy(micros() - t_start);
+    st_capture.addFrame();
+    pipePut(q_analyze, slot, task_analyze);
+  }
+}
+
+static void analyzeTask(void*) {
+  for (;;) {
+    const uint8_t slot = pipeTake(q_analyze);
+    const uint32_t t_start = micros();
+    PipeJob& job = pipe_jobs[slot];
+    processFrame(job.fb->buf, job.fb->len, job.seq, job.t_capture, job.out);
+    st_analyze.addBusy(micros() - t_start);
+    st_analyze.addFrame();
+    pipePut(q_send, slot, task_send);
+  }
+}
+
+// Senden: Puffer sofort zurückgeben, dann auf das Ende der Übertragung warten
+static void sendTask(void*) {
+  for (;;) {
+    const uint8_t slot = pipeTake(q_send);
+    const uint32_t t_start = micros();
+    PipeJob& job = pipe_jobs[slot];
+    lockSerial();
+    tx_bytes = 0;
+    unlockSerial();
+    deliverOutbox(job.out, job.seq);
+    releaseOutbox(job.out);
+    saveBurst(job.fb->buf, job.fb->len, job.seq);
+    const uint32_t jpeg_bytes = job.fb->len;
+    const uint32_t seq = job.seq;
+    FrameTiming timing = job.out.timing;  // Slot gehört gleich wieder der Aufnahme
+    timing.depth = 1 + q_analyze.depth() + q_send.depth();
+    esp_camera_fb_return(job.fb);
+    job.fb = nullptr;
+    pipePut(q_free, slot, task_capture);
+    finishFrame(jpeg_bytes, t_start, seq, timing);
+    st_send.addBusy(micros() - t_start);
+    st_send.addFrame();
+    if (PIPE_STATS_EVERY_N && (seq + 1) % PIPE_STATS_EVERY_N == 0) sendPipelineStats(seq);
+  }
+}
+
+static uint32_t pipelineQueueFull() {
+  return q_free.fullCount() + q_analyze.fullCount() + q_send.fullCount();
+}
+
+static bool beginPipeline() {
+  for (uint8_t i = 0; i < PIPE_SLOTS; i++) q_free.push(i);
+  // Ausschnitte entstehen in der Analyse und gehen im Sende-Task zurück
+  pool_mutex = xSemaphoreCreateMutex();
+  if (!pool_mutex) return false;
+  pool_internal.setLock(lockPool, unlockPool, pool_mutex);
+  pool_psram.setLock(lockPool, unlockPool, pool_mutex);
+  // Datensätze kommen aus mehreren Tasks; die Start-Task legt die Sperre sonst erst später an
+  if (!serial_mutex) serial_mutex = xSemaphoreCreateMutex();
+  if (!serial_mutex) return false;
+  // Verbraucher zuerst, damit die Handles beim ersten Benachrichtigen stehen
+  if (xTaskCreatePinnedToCore(sendTask, "send", 4096, nullptr, 2, &task_send,
+                              PIPE_SEND_CORE) != pdPASS)
+    return false;
+  // Ab hier zählt nur der Sende-Task tx_bytes; Frames kommen erst mit der Aufnahme
+  tx_task = task_send;
+  if (xTaskCreatePinnedToCore(analyzeTask, "analyze", 8192, nullptr, 1, &task_analyze,
+                              PIPE_ANALYSIS_CORE) == pdPASS &&
+      xTaskCreatePinnedToCore(captureTask, "capture", 4096, nullptr, 3, &task_capture,
+                              PIPE_CAPTURE_CORE) == pdPASS)
+    return true;
+  tx_task = nullptr;
+  return false;
+}
+
+// ========================== Start-Task ==========================
+// Zurückgestellte Teile im Hintergrund, während die ersten Frames laufen. Ihre
+// Textausgaben halten die Serial-Sperre, damit sie keinen Datensatz zerteilen;
+// SPI (Display) sperrt der Treiber je Transaktion, I2C (Sensor) der Arbiter
+static void bootTask(void*) {
+  lockSerial();
+  const bool ok = pycamera.beginDeferred(BOOT_DEFERRED);
+  unlockSerial();
+  if (VIBRATION && !vib_ready) vib_ready = beginVibration();
+  boot_deferred_failed = !ok;
+  boot_deferred_us = (uint32_t)esp_timer_get_time();
+  vTaskDelete(nullptr);
+}
+
+static void beginBootTask() {
+  if (!serial_mutex) serial_mutex = xSemaphoreCreateMutex();
+  if (serial_mutex &&
+      xTaskCreatePinnedToCore(bootTask, "boot", 4096, nullptr, 1, nullptr, BOOT_TASK_CORE) ==
+          pdPASS)
+    return;
+  boot_deferred_failed = true;
+  boot_deferred_us = (uint32_t)esp_timer_get_time();
+}
+
+// ========================== Setup ==========================
+void setup() {
+  boot_rec.setup_us = (uint32_t)esp_timer_get_time();
+  Serial.begin(5000000);
+  trace::setEnabled(TRACE_ENABLE);
+  if (!(FAST_BOOT ? pycamera.begin(BOOT_PARTS, CAMERA_FRAMESIZE) : pycamera.begin())) {
+    while (true) { delay(100); }
+  }
+  boot_rec.camera_us = (uint32_t)esp_timer_get_time();
+  // Ab hier können Tasks den Bus teilen (Start-Task, Pipeline)
+  if (i2c_bus.begin()) pycamera.setBusArbiter(&i2c_bus);
+  pycamera.beginInputCache(AW_INT_PIN, AW_INPUT_MAX_AGE_MS);
+  // LED-Ring (Dauerlicht) bzw. Blitz; ein Treiber am LED_PIN braucht den Ring nicht
+  if (LIGHT_MODE != strobe::LIGHT_STROBE_DRIVER) ring.begin();
+  if (LIGHT_MODE == strobe::LIGHT_CONSTANT) {
+    ring.setBrightness(200);
+    for (uint16_t i = 0; i < LED_COUNT; i++) ring.setPixelColor(i, ring.Color(255, 255, 255));
+    ring.show();
+  } else {
+    flash.begin(LIGHT_MODE, &ring, LED_PIN);
+    flash.setExposure((uint32_t)lround(STROBE_AEC_VALUE * AEC_LINE_US),
+                      (uint32_t)lround(SENSOR_READOUT_US));
+  }
+
+  // Kamera
+  beginProfiles(esp_camera_sensor_get());
+  switchProfile(START_PROFILE, 0);
+
+  // Trigger
+  pinMode(TRIG_PIN, OUTPUT);
+  digitalWrite(TRIG_PIN, LOW);
+
+  // Bildspeicher vor allen Stufen, die daraus Ebenen anfordern
+  pools_ready = beginPools();
+  // Bild der Display-Vorschau (240x240 RGB565) aus dem PSRAM-Pool statt vom Heap
+  if (pool_psram.stats().capacity_bytes) pycamera.setFramePool(&pool_psram);
+
+  // Messmodus (ohne Pool-Ebene weiter als reiner JPEG-Sender)
+  if (MEASUREMENT_MODE) {
+    measure_ready = beginMeasurement();
+  }
+  if (PRESENCE_CHECK) {
+    presence_ready = beginPresence();
+  }
+  if (RATE_CONTROL) {
+    beginRateControl();
+  }
+  if (EXPOSURE_CONTROL && presence_ready && LIGHT_MODE == strobe::LIGHT_CONSTANT &&
+      START_PROFILE != PROFILE_CALIB) {
+    beginExposureControl();
+    expo_ready = true;
+  }
+  // Ohne PSRAM-Arena wie bisher eine Aufnahme je Trigger
+  if (PRE_TRIGGER_RING && LIGHT_MODE == strobe::LIGHT_CONSTANT) {
+    ring_ready = beginRing();
+  }
+  // initSD (SD-Serie, Journal) startet den SPI-Bus des Displays neu, deshalb
+  // vor der Start-Task, die das Display erst danach initialisiert.
+  // Ohne Karte oder bei Fehlern ohne SD-Serie weiter
+  if (SD_BURST) {
+    sd_ready = beginSdBurst();
+  }
+  // Ohne Karte gehen Frames bei fehlendem Host wie bisher verloren
+  if (SD_JOURNAL) {
+    journal_ready = beginJournal();
+  }
+  // Schlägt das Anlegen fehl, läuft alles wie bisher in loop()
+  if (PIPELINE_TASKS && !ring_ready) {
+    pipeline_ready = beginPipeline();
+  }
+  boot_rec.reset_reason = (uint8_t)esp_reset_reason();
+  boot_rec.flags        = FAST_BOOT ? camlink::BOOT_FAST : 0;
+  boot_rec.parts        = FAST_BOOT ? BOOT_PARTS : PYCAM_ALL;
+  boot_rec.deferred     = pycamera.deferredParts() & BOOT_DEFERRED;
+  // Wird der LIS3DH erst in der Start-Task initialisiert, startet sie auch die Messung
+  if (VIBRATION && !(boot_rec.deferred & PYCAM_ACCEL)) vib_ready = beginVibration();
+  if (boot_rec.deferred) beginBootTask();
+  boot_rec.ready_us = (uint32_t)esp_timer_get_time();
+}
+
+// ========================== Loop mit Vorlauf-Ring ==========================
+// Trigger im festen Raster ohne Warten; jeder Durchlauf legt einen Frame im
+// Ring ab und bedient alle Labels, deren Ankunftsframe feststeht
+static void loopRing() {
+  static uint32_t next_trigger_ms = 0;
+  static uint32_t trigger_ms = 0;
+  static bool trigger_high = false;
+
+  const uint32_t now = millis();
+  if ((int32_t)(now - next_trigger_ms) >= 0) {
+    digitalWrite(TRIG_PIN, HIGH);
+    trigger_high = true;
+    trigger_ms = now;
+    next_trigger_ms = now + RING_TRIGGER_PERIOD_MS;
+    // Ankunft des Labels an der Zielposition (ältestes zuerst)
+    const int32_t wait_ms = computeWaitMs(ABSTAND_M, (double)BAND_SPEED, OFFSET_CM);
+    if (pending_count < RING_MAX_PENDING) {
+      const int64_t now = esp_timer_get_time();
+      pending_trigger_us[pending_count] = now;
+      pending_us[pending_count++] = now + (int64_t)max(wait_ms, (int32_t)0) * 1000;
+    }
+  }
+  if (trigger_high && now - trigger_ms >= 100) {
+    digitalWrite(TRIG_PIN, LOW);
+    trigger_high = false;
+  }
+
+  trace::begin(trace::EV_FB_GET);
+  camera_fb_t *fb = esp_camera_fb_get();
+  trace::end(trace::EV_FB_GET);
+  if (!fb) {
+    capture_failures++;
+    return;
+  }
+  trace::emitAt(trace::EV_VSYNC, trace::PH_INSTANT, (uint32_t)frameStartUs(fb));
+  noteFirstFrame(fb);
+  const int64_t t_exposure = frameExposureUs(fb);
+  frame_ring.push(fb->buf, fb->len, t_exposure);
+  esp_camera_fb_return(fb);
+  // Ausgewählte Frames kennen ihren Abholzeitpunkt nicht mehr: hier messen
+  if (TELEMETRY) telem.record(camlink::TM_EXPOSURE_TO_FB, spanUs(t_exposure, esp_timer_get_time()));
+
+  while (pending_count && frame_ring.ready(pending_us[0], RING_NEIGHBOURS)) {
+    framering::FrameRef refs[2 * RING_NEIGHBOURS + 1];
+    const uint8_t n = frame_ring.select(pending_us[0], RING_NEIGHBOURS, refs,
+                                        sizeof(refs) / sizeof(refs[0]));
+    for (uint8_t i = 0; i < n; i++) {
+      tx_bytes = 0;
+      Outbox out = {};
+      out.timing = {pending_trigger_us[0], refs[i].t_us, 0, 0, pending_count};
+      // Stand bei der Auswahl, nicht bei der Belichtung
+      if (vib_ready) vibrationRecord(out, frame_seq, (uint32_t)(refs[i].t_us / 1000), 0);
+      processFrame(refs[i].data, refs[i].len, frame_seq, (uint32_t)(refs[i].t_us / 1000),
+                   out);
+      // Sendedauer ab hier: Auswertung zählt nicht zur Verbindung
+      const uint32_t t_send = micros();
+      deliverOutbox(out, frame_seq);
+      releaseOutbox(out);
+      saveBurst(refs[i].data, refs[i].len, frame_seq);
+      finishFrame(refs[i].len, t_send, frame_seq, out.timing);
+      frame_seq++;
+    }
+    pending_count--;
+    for (uint8_t i = 0; i < pending_count; i++) {
+      pending_us[i] = pending_us[i + 1];
+      pending_trigger_us[i] = pending_trigger_us[i + 1];
+    }
+    if (RING_STATS_EVERY_N && ++ring_labels % RING_STATS_EVERY_N == 0) sendRingStats();
+  }
+}
+
+// ========================== Loop ==========================
+void loop() {
+  if (pipeline_ready) {
+    vTaskDelete(nullptr);  // Arbeit liegt in den Pipeline-Tasks
+  }
+  saveProfile();
+  if (ring_ready) {
+    loopRing();
+    return;
+  }
+  int64_t t_trigger = 0;
+  uint16_t vib_delay = 0;
+  camera_fb_t *fb = captureLabel(&t_trigger, &vib_delay, PREVIEW_BETWEEN_LABELS);
+  if (!fb) {
+    capture_failures++;
+  } else {
+    const uint32_t t_capture = millis();
+    const uint32_t jpeg_bytes = fb->len;
+    tx_bytes = 0;
+    Outbox out = {};
+    out.timing = {t_trigger, frameExposureUs(fb), esp_timer_get_time(), 0, 1};
+    if (LIGHT_MODE != strobe::LIGHT_CONSTANT && SEND_STROBE_TIMING)
+      strobeTiming(out, frame_seq, t_capture);
+    if (vib_ready) vibrationRecord(out, frame_seq, t_capture, vib_delay);
+    processFrame(fb->buf, fb->len, frame_seq, t_capture, out);
+    // Sendedauer ab hier: Auswertung zählt nicht zur Verbindung
+    const uint32_t t_send = micros();
+    deliverOutbox(out, frame_seq);
+    releaseOutbox(out);
+    saveBurst(fb->buf, fb->len, frame_seq);
     esp_camera_fb_return(fb);
+    finishFrame(jpeg_bytes, t_send, frame_seq, out.timing);
+    frame_seq++;
   }
 }
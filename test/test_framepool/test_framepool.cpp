@@ -0,0 +1,183 @@
+// FramePool: Blockvergabe (erster passender Bereich), Handles mit
+// Generationszähler und Typ, Referenzzähler, trim(), Fragmentierung und
+// Fehlschläge bei vollem Pool.
+// pio test -e host_test -f test_framepool
+
+#include <string.h>
+
+#include <FramePool.h>
+#include <unity.h>
+
+using namespace framepool;
+
+static const uint32_t BLOCK = 64;
+static const uint32_t BLOCKS = 16;
+
+static FramePool pool;
+static uint8_t arena[BLOCK * BLOCKS + 40];  // Rest unter einem Block fällt weg
+
+void setUp() { TEST_ASSERT_TRUE(pool.begin(arena, sizeof(arena), BLOCK)); }
+
+void tearDown() {}
+
+static void test_begin_rejects_bad_block_size() {
+  FramePool p;
+  TEST_ASSERT_FALSE(p.begin(arena, sizeof(arena), 0));
+  TEST_ASSERT_FALSE(p.begin(arena, sizeof(arena), 30));
+  TEST_ASSERT_FALSE(p.begin(arena, 16, BLOCK));
+  TEST_ASSERT_FALSE(p.begin(nullptr, sizeof(arena), BLOCK));
+}
+
+// Ebenen liegen in aufgerundeten Blöcken hintereinander
+static void test_alloc_rounds_to_blocks_first_fit() {
+  const BytesHandle a = pool.alloc<PLANE_BYTES>(100);
+  const GrayHandle b = pool.alloc<PLANE_GRAY8>(64, 8, 8);
+  const Rgb565Handle c = pool.alloc<PLANE_RGB565>(128, 8, 8);
+  TEST_ASSERT_TRUE(a.valid() && b.valid() && c.valid());
+  TEST_ASSERT_EQUAL_PTR(arena, pool.data(a));
+  TEST_ASSERT_EQUAL_PTR(arena + 2 * BLOCK, pool.data(b));
+  TEST_ASSERT_EQUAL_PTR(arena + 3 * BLOCK, pool.data(c));
+  TEST_ASSERT_EQUAL_UINT32(100, pool.size(a));
+
+  const PoolStats s = pool.stats();
+  TEST_ASSERT_EQUAL_UINT32(BLOCK * BLOCKS, s.capacity_bytes);
+  TEST_ASSERT_EQUAL_UINT32(5 * BLOCK, s.used_bytes);
+  TEST_ASSERT_EQUAL_UINT32(11 * BLOCK, s.largest_free_bytes);
+  TEST_ASSERT_EQUAL_UINT16(3, s.planes);
+  TEST_ASSERT_EQUAL_UINT32(3, s.allocs);
+}
+
+// Nach der Freigabe liefert das alte Handle nichts mehr, auch wenn Slot und
+// Blöcke schon wieder vergeben sind
+static void test_stale_handle_returns_null() {
+  const BytesHandle a = pool.alloc<PLANE_BYTES>(BLOCK);
+  pool.release(a);
+  TEST_ASSERT_NULL(pool.data(a));
+  TEST_ASSERT_EQUAL_UINT32(0, pool.size(a));
+  TEST_ASSERT_FALSE(pool.retain(a));
+
+  const BytesHandle b = pool.alloc<PLANE_BYTES>(BLOCK);
+  TEST_ASSERT_EQUAL_UINT8(a.slot, b.slot);
+  TEST_ASSERT_EQUAL_PTR(arena, pool.data(b));
+  TEST_ASSERT_NULL(pool.data(a));
+  // Doppelte Freigabe über das alte Handle lässt die neue Ebene stehen
+  pool.release(a);
+  TEST_ASSERT_EQUAL_PTR(arena, pool.data(b));
+}
+
+static void test_handle_of_other_type_returns_null() {
+  const GrayHandle g = pool.alloc<PLANE_GRAY8>(BLOCK, 8, 8);
+  const Rgb565Handle wrong = {g.slot, g.gen};
+  TEST_ASSERT_NULL(pool.data(wrong));
+  TEST_ASSERT_FALSE(pool.retain(wrong));
+  pool.release(wrong);
+  TEST_ASSERT_NOT_NULL(pool.data(g));
+  TEST_ASSERT_NULL(pool.data(GrayHandle{0, 0}));
+}
+
+// Zweiter Besitzer: die Blöcke kommen erst mit der letzten Freigabe zurück
+static void test_retain_keeps_blocks_until_last_release() {
+  const BytesHandle a = pool.alloc<PLANE_BYTES>(3 * BLOCK);
+  TEST_ASSERT_TRUE(pool.retain(a));
+  pool.release(a);
+  TEST_ASSERT_NOT_NULL(pool.data(a));
+  TEST_ASSERT_EQUAL_UINT32(3 * BLOCK, pool.stats().used_bytes);
+  pool.release(a);
+  TEST_ASSERT_NULL(pool.data(a));
+  const PoolStats s = pool.stats();
+  TEST_ASSERT_EQUAL_UINT32(0, s.used_bytes);
+  TEST_ASSERT_EQUAL_UINT32(3 * BLOCK, s.high_water_bytes);
+  TEST_ASSERT_EQUAL_UINT16(0, s.planes);
+}
+
+// Gekürzte Ebene gibt die Endblöcke frei, die nächste Ebene schließt an
+static void test_trim_frees_tail_blocks() {
+  const BytesHandle a = pool.alloc<PLANE_BYTES>(8 * BLOCK);
+  memset(pool.data(a), 0xAB, 8 * BLOCK);
+  TEST_ASSERT_FALSE(pool.trim(a, 9 * BLOCK));
+  TEST_ASSERT_FALSE(pool.trim(a, 0));
+  TEST_ASSERT_TRUE(pool.trim(a, BLOCK + 1));
+  TEST_ASSERT_EQUAL_UINT32(BLOCK + 1, pool.size(a));
+  TEST_ASSERT_EQUAL_UINT32(2 * BLOCK, pool.stats().used_bytes);
+  TEST_ASSERT_EQUAL_UINT8(0xAB, pool.data(a)[BLOCK]);
+
+  const BytesHandle b = pool.alloc<PLANE_BYTES>(BLOCK);
+  TEST_ASSERT_EQUAL_PTR(arena + 2 * BLOCK, pool.data(b));
+  pool.release(a);
+  TEST_ASSERT_EQUAL_UINT32(BLOCK, pool.stats().used_bytes);
+}
+
+// Lücke in der Mitte: genug frei, aber nicht am Stück
+static void test_fragmentation_blocks_large_alloc() {
+  const BytesHandle a = pool.alloc<PLANE_BYTES>(4 * BLOCK);
+  const BytesHandle b = pool.alloc<PLANE_BYTES>(4 * BLOCK);
+  const BytesHandle c = pool.alloc<PLANE_BYTES>(4 * BLOCK);
+  TEST_ASSERT_TRUE(a.valid() && b.valid() && c.valid());
+  pool.release(b);
+  // frei: 4 + 4 Blöcke, größter Bereich 4
+  TEST_ASSERT_EQUAL_UINT32(4 * BLOCK, pool.stats().largest_free_bytes);
+  TEST_ASSERT_EQUAL_UINT8(50, pool.fragmentationPct());
+
+  TEST_ASSERT_FALSE(pool.alloc<PLANE_BYTES>(5 * BLOCK).valid());
+  TEST_ASSERT_EQUAL_UINT32(1, pool.stats().failures);
+  // Erster passender Bereich ist die Lücke
+  const BytesHandle d = pool.alloc<PLANE_BYTES>(2 * BLOCK);
+  TEST_ASSERT_EQUAL_PTR(arena + 4 * BLOCK, pool.data(d));
+}
+
+static void test_failures_for_empty_oversize_and_slots() {
+  TEST_ASSERT_FALSE(pool.alloc<PLANE_BYTES>(0).valid());
+  TEST_ASSERT_FALSE(pool.alloc<PLANE_BYTES>(BLOCK * BLOCKS + 1).valid());
+  TEST_ASSERT_EQUAL_UINT32(2, pool.stats().failures);
+
+  // Mehr Ebenen als Slots: kleine Blöcke, damit der Platz reicht
+  static uint8_t big[4 * 64 * FramePool::MAX_PLANES];
+  FramePool p;
+  TEST_ASSERT_TRUE(p.begin(big, sizeof(big), 4));
+  for (uint8_t i = 0; i < FramePool::MAX_PLANES; i++)
+    TEST_ASSERT_TRUE(p.alloc<PLANE_BYTES>(4).valid());
+  TEST_ASSERT_FALSE(p.alloc<PLANE_BYTES>(4).valid());
+  TEST_ASSERT_EQUAL_UINT32(1, p.stats().failures);
+  TEST_ASSERT_EQUAL_UINT16(FramePool::MAX_PLANES, p.stats().planes);
+}
+
+static int lock_depth = 0, lock_calls = 0;
+
+static void testLock(void *ctx) {
+  TEST_ASSERT_EQUAL_PTR(&lock_depth, ctx);
+  TEST_ASSERT_EQUAL(0, lock_depth);
+  lock_depth++;
+  lock_calls++;
+}
+
+static void testUnlock(void *) {
+  TEST_ASSERT_EQUAL(1, lock_depth);
+  lock_depth--;
+}
+
+// Jede Änderung und jede Statistik läuft unter der Sperre, ohne Verschachtelung
+static void test_lock_wraps_changes() {
+  pool.setLock(testLock, testUnlock, &lock_depth);
+  const BytesHandle a = pool.alloc<PLANE_BYTES>(2 * BLOCK);
+  pool.trim(a, BLOCK);
+  pool.fragmentationPct();
+  pool.release(a);
+  TEST_ASSERT_FALSE(pool.alloc<PLANE_BYTES>(BLOCK * BLOCKS + 1).valid());
+  TEST_ASSERT_EQUAL(0, lock_depth);
+  TEST_ASSERT_EQUAL(5, lock_calls);
+  pool.setLock(nullptr, nullptr, nullptr);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_begin_rejects_bad_block_size);
+  RUN_TEST(test_alloc_rounds_to_blocks_first_fit);
+  RUN_TEST(test_stale_handle_returns_null);
+  RUN_TEST(test_handle_of_other_type_returns_null);
+  RUN_TEST(test_retain_keeps_blocks_until_last_release);
+  RUN_TEST(test_trim_frees_tail_blocks);
+  RUN_TEST(test_fragmentation_blocks_large_alloc);
+  RUN_TEST(test_failures_for_empty_oversize_and_slots);
+  RUN_TEST(test_lock_wraps_changes);
+  return UNITY_END();
+}
@@ -0,0 +1,152 @@
+// FrameRing: Auswahl des nächsten Frames, Umbruch und Verdrängen in der
+// Arena, Lücken im Sensortakt, Bereitschaft und Fehlgriffe.
+// pio test -e host_test -f test_framering
+
+#include <string.h>
+
+#include <FrameRing.h>
+#include <unity.h>
+
+using namespace framering;
+
+static const int64_t PERIOD = 33333;  // 30 fps
+
+static FrameRing ring;
+static uint8_t arena[4096];
+
+// Inhalt aus der Nummer, damit überschriebene Daten auffallen
+static void fill(uint8_t *buf, size_t len, uint32_t n) {
+  for (size_t i = 0; i < len; i++)
+    buf[i] = (uint8_t)(n * 31 + i);
+}
+
+static void pushFrame(uint32_t n, size_t len, int64_t t_us) {
+  uint8_t buf[1024];
+  fill(buf, len, n);
+  TEST_ASSERT_TRUE(ring.push(buf, len, t_us));
+}
+
+static void assertContent(const FrameRef &ref, uint32_t n) {
+  uint8_t buf[1024];
+  fill(buf, ref.len, n);
+  TEST_ASSERT_EQUAL_MEMORY(buf, ref.data, ref.len);
+}
+
+void setUp() { TEST_ASSERT_TRUE(ring.begin(arena, sizeof(arena), 8)); }
+
+void tearDown() {}
+
+static void test_select_nearest_with_neighbours() {
+  for (uint32_t n = 0; n < 6; n++)
+    pushFrame(n, 200, 1000000 + n * PERIOD);
+  TEST_ASSERT_EQUAL_UINT32(PERIOD, ring.periodUs());
+
+  FrameRef out[3];
+  uint8_t nearest = 0xFF;
+  // Zwischen Frame 2 und 3, näher an 3
+  const int64_t t = 1000000 + 2 * PERIOD + PERIOD * 2 / 3;
+  TEST_ASSERT_EQUAL_UINT8(3, ring.select(t, 1, out, 3, &nearest));
+  TEST_ASSERT_EQUAL_UINT8(1, nearest);
+  TEST_ASSERT_EQUAL_UINT32(2, out[0].index);
+  TEST_ASSERT_EQUAL_UINT32(3, out[1].index);
+  TEST_ASSERT_EQUAL_UINT32(4, out[2].index);
+  TEST_ASSERT_TRUE(out[0].t_us < out[1].t_us && out[1].t_us < out[2].t_us);
+  assertContent(out[1], 3);
+  TEST_ASSERT_EQUAL_INT32(out[1].t_us - t, ring.stats().last_error_us);
+  TEST_ASSERT_EQUAL_UINT32(1, ring.stats().hits);
+
+  // Am Rand gibt es nur Nachbarn auf einer Seite
+  TEST_ASSERT_EQUAL_UINT8(2, ring.select(1000000, 1, out, 3, &nearest));
+  TEST_ASSERT_EQUAL_UINT8(0, nearest);
+  TEST_ASSERT_EQUAL_UINT32(0, out[0].index);
+}
+
+// 1000 Byte je Frame: vier passen, der fünfte bricht nach vorne um und
+// verdrängt nur den ältesten; die übrigen bleiben unverändert lesbar
+static void test_wrap_evicts_oldest_and_keeps_others_intact() {
+  for (uint32_t n = 0; n < 4; n++)
+    pushFrame(n, 1000, n * PERIOD);
+  TEST_ASSERT_EQUAL_UINT8(4, ring.frames());
+  pushFrame(4, 1000, 4 * PERIOD);
+  TEST_ASSERT_EQUAL_UINT8(4, ring.frames());
+  TEST_ASSERT_EQUAL(1 * PERIOD, ring.oldestUs());
+  TEST_ASSERT_EQUAL(4 * PERIOD, ring.newestUs());
+
+  const RingStats &st = ring.stats();
+  TEST_ASSERT_EQUAL_UINT32(1, st.overwritten);
+  TEST_ASSERT_EQUAL_UINT32(4000, st.used_bytes);
+  TEST_ASSERT_EQUAL_UINT32(4000, st.high_water_bytes);
+  TEST_ASSERT_EQUAL_UINT32(5, st.pushed);
+
+  for (uint32_t n = 1; n <= 4; n++) {
+    FrameRef ref;
+    TEST_ASSERT_EQUAL_UINT8(1, ring.select(n * PERIOD, 0, &ref, 1));
+    TEST_ASSERT_EQUAL_UINT32(n, ref.index);
+    assertContent(ref, n);
+  }
+}
+
+// Ausgewählte Frames zählen beim Verdrängen nicht als überschrieben
+static void test_selected_frames_not_counted_as_overwritten() {
+  for (uint32_t n = 0; n < 8; n++)
+    pushFrame(n, 100, n * PERIOD);
+  FrameRef ref;
+  TEST_ASSERT_EQUAL_UINT8(1, ring.select(0, 0, &ref, 1));
+  pushFrame(8, 100, 8 * PERIOD);
+  pushFrame(9, 100, 9 * PERIOD);
+  TEST_ASSERT_EQUAL_UINT8(8, ring.frames());
+  TEST_ASSERT_EQUAL_UINT32(1, ring.stats().overwritten);
+}
+
+static void test_oversize_rejected() {
+  static uint8_t big[sizeof(arena) + 1];
+  TEST_ASSERT_FALSE(ring.push(big, sizeof(big), 0));
+  TEST_ASSERT_EQUAL_UINT32(1, ring.stats().oversize);
+  TEST_ASSERT_EQUAL_UINT8(0, ring.frames());
+}
+
+// Deutlich längerer Abstand: ausgelassene Frames zählen, die Periode bleibt
+static void test_sensor_gap_counted_period_kept() {
+  pushFrame(0, 100, 0);
+  pushFrame(1, 100, PERIOD);
+  pushFrame(2, 100, 4 * PERIOD);  // 2 und 3 fehlen
+  TEST_ASSERT_EQUAL_UINT32(2, ring.stats().sensor_gaps);
+  TEST_ASSERT_EQUAL_UINT32(PERIOD, ring.periodUs());
+}
+
+// Bereit erst, wenn ein Frame mehr als eine halbe Periode nach dem Ziel
+// (bzw. dem letzten Nachbarn) liegt
+static void test_ready_waits_for_later_frame() {
+  TEST_ASSERT_FALSE(ring.ready(0));
+  for (uint32_t n = 0; n < 3; n++)
+    pushFrame(n, 100, n * PERIOD);
+  const int64_t t = 2 * PERIOD - PERIOD / 2;
+  TEST_ASSERT_TRUE(ring.ready(t));
+  TEST_ASSERT_FALSE(ring.ready(t + 1));
+  TEST_ASSERT_FALSE(ring.ready(t, 1));
+  pushFrame(3, 100, 3 * PERIOD);
+  TEST_ASSERT_TRUE(ring.ready(t, 1));
+}
+
+static void test_select_too_old_is_miss() {
+  for (uint32_t n = 0; n < 3; n++)
+    pushFrame(n, 100, 1000000 + n * PERIOD);
+  FrameRef ref;
+  TEST_ASSERT_EQUAL_UINT8(0, ring.select(1000000 - PERIOD, 0, &ref, 1));
+  TEST_ASSERT_EQUAL_UINT32(1, ring.stats().misses);
+  // Eine knappe halbe Periode vor dem ältesten gilt noch als Treffer
+  TEST_ASSERT_EQUAL_UINT8(1, ring.select(1000000 - PERIOD / 2 + 1, 0, &ref, 1));
+  TEST_ASSERT_EQUAL_UINT32(0, ref.index);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_select_nearest_with_neighbours);
+  RUN_TEST(test_wrap_evicts_oldest_and_keeps_others_intact);
+  RUN_TEST(test_selected_frames_not_counted_as_overwritten);
+  RUN_TEST(test_oversize_rejected);
+  RUN_TEST(test_sensor_gap_counted_period_kept);
+  RUN_TEST(test_ready_waits_for_later_frame);
+  RUN_TEST(test_select_too_old_is_miss);
+  return UNITY_END();
+}
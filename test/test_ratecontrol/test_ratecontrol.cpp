@@ -0,0 +1,118 @@
+// RateController: Stufen je nach Abweichung vom Ziel, Hystereseband,
+// Ruhezeit nach einer Änderung, Grenzen des Qualitätsbereichs und das Ziel
+// aus dem gemessenen Durchsatz der Verbindung.
+// pio test -e host_test -f test_ratecontrol
+
+#include <RateControl.h>
+#include <unity.h>
+
+using namespace ratectl;
+
+// 10 KB je Frame, Band 9000..11000, zwei Frames Ruhe
+static const RateConfig CFG = {10000, 0, 4, 40, 10, 10, 2};
+static const uint8_t Q0 = 12;
+
+static RateController rate;
+
+void setUp() { rate.begin(CFG, Q0); }
+
+void tearDown() {}
+
+// Erster Frame setzt das Mittel direkt; daraus die Stufe
+static void assertStep(uint32_t jpeg_bytes, int step) {
+  rate.begin(CFG, Q0);
+  TEST_ASSERT_EQUAL(step != 0, rate.update(jpeg_bytes, 0, 0));
+  TEST_ASSERT_EQUAL_UINT8(Q0 + step, rate.quality());
+}
+
+static void test_steps_grow_with_overshoot() {
+  assertStep(11000, 0);   // genau am Rand des Bands
+  assertStep(11001, 1);
+  assertStep(16500, 1);
+  assertStep(16501, 2);
+  assertStep(22000, 2);
+  assertStep(22001, 4);
+  assertStep(100000, 4);
+}
+
+static void test_finer_only_one_step() {
+  assertStep(9000, 0);
+  assertStep(8999, -1);
+  assertStep(1000, -1);
+}
+
+// Nach einer Änderung ruht die Regelung hold_frames Frames lang
+static void test_hold_after_change() {
+  TEST_ASSERT_TRUE(rate.update(30000, 0, 0));
+  TEST_ASSERT_EQUAL_UINT8(Q0 + 4, rate.quality());
+  TEST_ASSERT_EQUAL_UINT8(Q0, rate.previousQuality());
+  TEST_ASSERT_FALSE(rate.update(30000, 0, 0));
+  TEST_ASSERT_FALSE(rate.update(30000, 0, 0));
+  TEST_ASSERT_TRUE(rate.update(30000, 0, 0));
+  TEST_ASSERT_EQUAL_UINT8(Q0 + 8, rate.quality());
+  TEST_ASSERT_EQUAL_UINT8(Q0 + 4, rate.previousQuality());
+}
+
+// Gleitendes Mittel (1/4): ein einzelner großer Frame zieht es nur anteilig
+static void test_average_smooths_single_frame() {
+  TEST_ASSERT_FALSE(rate.update(10000, 0, 0));
+  TEST_ASSERT_FALSE(rate.update(14000, 0, 0));
+  TEST_ASSERT_EQUAL_UINT32(11000, rate.avgBytes());
+  TEST_ASSERT_TRUE(rate.update(14000, 0, 0));
+  TEST_ASSERT_EQUAL_UINT32(11750, rate.avgBytes());
+  TEST_ASSERT_EQUAL_UINT8(Q0 + 1, rate.quality());
+}
+
+// Am Rand des Bereichs bleibt die Qualität stehen und meldet keine Änderung
+static void test_clamped_to_range() {
+  rate.begin(CFG, 38);
+  TEST_ASSERT_TRUE(rate.update(50000, 0, 0));
+  TEST_ASSERT_EQUAL_UINT8(40, rate.quality());
+  for (int i = 0; i < 5; i++)
+    TEST_ASSERT_FALSE(rate.update(50000, 0, 0));
+  TEST_ASSERT_EQUAL_UINT8(40, rate.quality());
+
+  rate.begin(CFG, 4);
+  TEST_ASSERT_FALSE(rate.update(100, 0, 0));
+  TEST_ASSERT_EQUAL_UINT8(4, rate.quality());
+
+  rate.begin(CFG, 60);
+  TEST_ASSERT_EQUAL_UINT8(40, rate.quality());
+  const RateConfig swapped = {10000, 0, 20, 10, 10, 10, 0};
+  rate.begin(swapped, 5);
+  TEST_ASSERT_EQUAL_UINT8(20, rate.quality());
+}
+
+// Mit Framerate: Ziel = 90 % dessen, was die Verbindung je Intervall schafft,
+// höchstens target_bytes; kurze Übertragungen zählen nicht
+static void test_target_from_link() {
+  const RateConfig cfg = {0, 100, 4, 40, 10, 10, 0};
+  rate.begin(cfg, Q0);
+  TEST_ASSERT_EQUAL_UINT32(0, rate.targetBytes());
+  TEST_ASSERT_FALSE(rate.update(9000, 4095, 1000));
+  TEST_ASSERT_EQUAL_UINT32(0, rate.linkBytesPerSec());
+
+  TEST_ASSERT_FALSE(rate.update(9000, 100000, 1000000));  // 100 KB/s, im Band
+  TEST_ASSERT_EQUAL_UINT32(100000, rate.linkBytesPerSec());
+  TEST_ASSERT_EQUAL_UINT32(9000, rate.targetBytes());
+
+  const RateConfig both = {6000, 100, 4, 40, 10, 10, 0};
+  rate.begin(both, Q0);
+  rate.update(5000, 100000, 1000000);
+  TEST_ASSERT_EQUAL_UINT32(6000, rate.targetBytes());
+  rate.update(5000, 20000, 1000000);  // Mittel 80 KB/s
+  TEST_ASSERT_EQUAL_UINT32(80000, rate.linkBytesPerSec());
+  rate.update(5000, 20000, 1000000);  // 65 KB/s -> 5850 Byte
+  TEST_ASSERT_EQUAL_UINT32(5850, rate.targetBytes());
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_steps_grow_with_overshoot);
+  RUN_TEST(test_finer_only_one_step);
+  RUN_TEST(test_hold_after_change);
+  RUN_TEST(test_average_smooths_single_frame);
+  RUN_TEST(test_clamped_to_range);
+  RUN_TEST(test_target_from_link);
+  return UNITY_END();
+}
@@ -0,0 +1,197 @@
+// SdJournal gegen die SD-Karte der Host-Simulation (ein temporärer Ordner):
+// Neustart mit und ohne pop, angerissenes Segmentende, CRC-Fehler, kaputte
+// TAIL.DAT. Nach jedem Neustart gilt: Einträge höchstens doppelt, nie verloren.
+// pio test -e host_test -f test_sdjournal
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include <SdJournal.h>
+#include <unity.h>
+
+#include "sim.h"
+
+using namespace sdjournal;
+
+static const uint32_t PAYLOAD = 1000;  // 4 Einträge je 4-KB-Segment
+static const Config CFG = {"/JOURNAL", 4096, 8};
+
+static SdFat sd;
+static Journal journal;
+static uint8_t buf[2048];
+static std::string root;
+
+static std::string hostPath(const char *name) { return root + "/JOURNAL/" + name; }
+
+static void open() { TEST_ASSERT_EQUAL(OK, journal.begin(&sd, CFG, buf, sizeof(buf))); }
+
+static void reopen() {
+  journal.end();
+  open();
+}
+
+// Nutzdaten aus der Sequenznummer, damit falsche Zuordnung auffällt
+static void append(uint32_t seq) {
+  uint8_t data[PAYLOAD];
+  for (uint32_t i = 0; i < PAYLOAD; i++)
+    data[i] = (uint8_t)(seq * 7 + i);
+  const uint8_t *parts[] = {data};
+  const uint32_t lens[] = {PAYLOAD};
+  TEST_ASSERT_EQUAL(OK, journal.append(seq, 1000 + seq, parts, lens, 1));
+}
+
+// Alles abholen; CORRUPT überspringt und liest weiter
+static std::vector<uint32_t> drain() {
+  std::vector<uint32_t> seqs;
+  for (;;) {
+    uint32_t seq, t_ms, len;
+    const uint8_t *data;
+    const Result r = journal.peek(&seq, &t_ms, &data, &len);
+    if (r == EMPTY)
+      break;
+    if (r == CORRUPT)
+      continue;
+    TEST_ASSERT_EQUAL(OK, r);
+    TEST_ASSERT_EQUAL_UINT32(PAYLOAD, len);
+    TEST_ASSERT_EQUAL_UINT32(1000 + seq, t_ms);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)(seq * 7 + 123), data[123]);
+    TEST_ASSERT_EQUAL(OK, journal.pop());
+    seqs.push_back(seq);
+  }
+  return seqs;
+}
+
+static void assertSeqs(const std::vector<uint32_t> &want, const std::vector<uint32_t> &got) {
+  TEST_ASSERT_EQUAL(want.size(), got.size());
+  for (size_t i = 0; i < want.size(); i++)
+    TEST_ASSERT_EQUAL_UINT32(want[i], got[i]);
+}
+
+static void truncateFile(const char *name, long len) {
+  TEST_ASSERT_EQUAL(0, truncate(hostPath(name).c_str(), len));
+}
+
+static void flipByte(const char *name, long pos) {
+  FILE *f = fopen(hostPath(name).c_str(), "r+b");
+  TEST_ASSERT_NOT_NULL(f);
+  fseek(f, pos, SEEK_SET);
+  const int c = fgetc(f);
+  fseek(f, pos, SEEK_SET);
+  fputc(c ^ 0x5A, f);
+  fclose(f);
+}
+
+void setUp() {
+  char dir[] = "/tmp/sdjournal_XXXXXX";
+  TEST_ASSERT_NOT_NULL(mkdtemp(dir));
+  root = dir;
+  sim::testOptions().sd_dir = root;
+  TEST_ASSERT_TRUE(sd.begin(0));
+  open();
+}
+
+void tearDown() {
+  journal.end();
+  system(("rm -rf " + root).c_str());
+}
+
+static void test_reopen_continues_after_last_pop() {
+  for (uint32_t s = 0; s < 10; s++)
+    append(s);
+  for (uint32_t s = 0; s < 5; s++) {
+    uint32_t seq, t_ms, len;
+    const uint8_t *data;
+    TEST_ASSERT_EQUAL(OK, journal.peek(&seq, &t_ms, &data, &len));
+    TEST_ASSERT_EQUAL_UINT32(s, seq);
+    TEST_ASSERT_EQUAL(OK, journal.pop());
+  }
+  reopen();
+  TEST_ASSERT_EQUAL(5 * (PAYLOAD + Journal::ENTRY_HEADER), journal.stats().backlog_bytes);
+  assertSeqs({5, 6, 7, 8, 9}, drain());
+  TEST_ASSERT_TRUE(journal.empty());
+}
+
+// Ausfall zwischen Senden und pop: derselbe Eintrag kommt noch einmal
+static void test_peek_without_pop_repeats_after_reopen() {
+  for (uint32_t s = 0; s < 3; s++)
+    append(s);
+  uint32_t seq, t_ms, len;
+  const uint8_t *data;
+  TEST_ASSERT_EQUAL(OK, journal.peek(&seq, &t_ms, &data, &len));
+  TEST_ASSERT_EQUAL_UINT32(0, seq);
+  reopen();
+  assertSeqs({0, 1, 2}, drain());
+}
+
+// Dateilänge mitten im dritten Eintrag: die ersten beiden gelten, der Rest
+// wird übersprungen; nach dem Neustart angehängte Einträge gehen nicht verloren
+static void test_torn_tail_skipped_new_entries_kept() {
+  for (uint32_t s = 0; s < 3; s++)
+    append(s);
+  journal.end();
+  truncateFile("S0000000.LOG", 2 * (PAYLOAD + Journal::ENTRY_HEADER) + 30);
+  open();
+  append(3);
+  append(4);
+  assertSeqs({0, 1, 3, 4}, drain());
+  TEST_ASSERT_EQUAL_UINT32(1, journal.stats().corrupt);
+}
+
+// CRC-Fehler in den Nutzdaten: ohne verlässliche Länge ist der Rest des
+// Segments verloren, das nächste Segment wird normal gelesen
+static void test_crc_error_skips_rest_of_segment() {
+  for (uint32_t s = 0; s < 8; s++)
+    append(s);
+  journal.end();
+  flipByte("S0000000.LOG", (PAYLOAD + Journal::ENTRY_HEADER) + Journal::ENTRY_HEADER + 500);
+  open();
+  assertSeqs({0, 4, 5, 6, 7}, drain());
+  TEST_ASSERT_EQUAL_UINT32(1, journal.stats().corrupt);
+}
+
+// Kaputte TAIL.DAT: Lesen beginnt wieder am ältesten Segment, bereits
+// abgeholte Einträge kommen doppelt, keiner fehlt
+static void test_tail_crc_fallback_duplicates_only() {
+  for (uint32_t s = 0; s < 8; s++)
+    append(s);
+  for (uint32_t s = 0; s < 6; s++) {
+    uint32_t seq, t_ms, len;
+    const uint8_t *data;
+    TEST_ASSERT_EQUAL(OK, journal.peek(&seq, &t_ms, &data, &len));
+    TEST_ASSERT_EQUAL(OK, journal.pop());
+  }
+  journal.end();
+  TEST_ASSERT_TRUE(access(hostPath("S0000000.LOG").c_str(), F_OK) != 0);
+  flipByte("TAIL.DAT", 5);
+  open();
+  assertSeqs({4, 5, 6, 7}, drain());
+}
+
+// Ohne TAIL.DAT gilt dasselbe
+static void test_missing_tail_reads_from_oldest_segment() {
+  for (uint32_t s = 0; s < 3; s++)
+    append(s);
+  uint32_t seq, t_ms, len;
+  const uint8_t *data;
+  TEST_ASSERT_EQUAL(OK, journal.peek(&seq, &t_ms, &data, &len));
+  TEST_ASSERT_EQUAL(OK, journal.pop());
+  journal.end();
+  truncateFile("TAIL.DAT", 0);
+  open();
+  assertSeqs({0, 1, 2}, drain());
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_reopen_continues_after_last_pop);
+  RUN_TEST(test_peek_without_pop_repeats_after_reopen);
+  RUN_TEST(test_torn_tail_skipped_new_entries_kept);
+  RUN_TEST(test_crc_error_skips_rest_of_segment);
+  RUN_TEST(test_tail_crc_fallback_duplicates_only);
+  RUN_TEST(test_missing_tail_reads_from_oldest_segment);
+  return UNITY_END();
+}
@@ -0,0 +1,108 @@
+// SensorProfile: Ablage im Flash (Preferences-Ersatz der Host-Simulation),
+// feste Form mit CRC, Rückfall bei fehlendem oder beschädigtem Profil.
+// pio test -e host_test -f test_sensorprofile
+
+#include <SensorProfile.h>
+#include <unity.h>
+
+using namespace sensorprof;
+
+static Profile sample(int16_t base) {
+  Profile p;
+  for (uint8_t f = 0; f < FIELD_COUNT; f++)
+    p.value[f] = (int16_t)(base + f * 37 - 400);
+  return p;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_encode_decode_round_trip() {
+  const Profile p = sample(3);
+  uint8_t buf[STORE_SIZE];
+  TEST_ASSERT_EQUAL_size_t(STORE_SIZE, encode(buf, p, 0xA5A5F00Du));
+  Profile back;
+  uint32_t basis = 0;
+  TEST_ASSERT_TRUE(decode(buf, sizeof(buf), &back, &basis));
+  TEST_ASSERT_EQUAL_UINT32(0xA5A5F00Du, basis);
+  TEST_ASSERT_EQUAL_UINT32(0, diff(p, back));
+}
+
+// Jedes gekippte Byte, falsche Länge oder Version: kein Profil
+static void test_decode_rejects_damage() {
+  uint8_t buf[STORE_SIZE];
+  encode(buf, sample(7), 1);
+  Profile back;
+  uint32_t basis;
+  for (size_t i = 0; i < STORE_SIZE; i++) {
+    buf[i] ^= 0x10;
+    TEST_ASSERT_FALSE(decode(buf, sizeof(buf), &back, &basis));
+    buf[i] ^= 0x10;
+  }
+  TEST_ASSERT_FALSE(decode(buf, sizeof(buf) - 1, &back, &basis));
+  TEST_ASSERT_TRUE(decode(buf, sizeof(buf), &back, &basis));
+}
+
+// Die Prüfsumme unterscheidet eingebaute Profile
+static void test_checksum_follows_values() {
+  Profile a = sample(0), b = sample(0);
+  TEST_ASSERT_EQUAL_UINT32(checksum(a), checksum(b));
+  b.set(AEC_VALUE, b.get(AEC_VALUE) + 1);
+  TEST_ASSERT_TRUE(checksum(a) != checksum(b));
+}
+
+static void test_store_save_load() {
+  ProfileStore store;
+  TEST_ASSERT_TRUE(store.begin("sp_test"));
+  Profile p;
+  uint32_t basis;
+  TEST_ASSERT_FALSE(store.load("action", &p, &basis));
+
+  const Profile saved = sample(11);
+  TEST_ASSERT_TRUE(store.save("action", saved, 42));
+  TEST_ASSERT_TRUE(store.save("action", saved, 42));  // unverändert
+  store.end();
+  TEST_ASSERT_FALSE(store.load("action", &p, &basis));  // geschlossen
+
+  TEST_ASSERT_TRUE(store.begin("sp_test"));
+  TEST_ASSERT_TRUE(store.load("action", &p, &basis));
+  TEST_ASSERT_EQUAL_UINT32(42, basis);
+  TEST_ASSERT_EQUAL_UINT32(0, diff(saved, p));
+
+  // Neue basis wird auch bei gleichen Werten geschrieben
+  TEST_ASSERT_TRUE(store.save("action", saved, 43));
+  TEST_ASSERT_TRUE(store.load("action", &p, &basis));
+  TEST_ASSERT_EQUAL_UINT32(43, basis);
+  store.end();
+}
+
+// Beschädigter Eintrag im Flash wird nicht geladen
+static void test_store_rejects_bad_crc() {
+  Preferences prefs;
+  prefs.begin("sp_bad");
+  uint8_t buf[STORE_SIZE];
+  encode(buf, sample(5), 9);
+  buf[5] ^= 1;
+  prefs.putBytes("calib", buf, sizeof(buf));
+  prefs.putBytes("short", buf, sizeof(buf) - 2);
+  prefs.end();
+
+  ProfileStore store;
+  TEST_ASSERT_TRUE(store.begin("sp_bad"));
+  Profile p;
+  uint32_t basis;
+  TEST_ASSERT_FALSE(store.load("calib", &p, &basis));
+  TEST_ASSERT_FALSE(store.load("short", &p, &basis));
+  store.end();
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_encode_decode_round_trip);
+  RUN_TEST(test_decode_rejects_damage);
+  RUN_TEST(test_checksum_follows_values);
+  RUN_TEST(test_store_save_load);
+  RUN_TEST(test_store_rejects_bad_crc);
+  return UNITY_END();
+}
@@ -0,0 +1,154 @@
+// Telemetry: Fachgrenzen des logarithmischen Histogramms über den ganzen
+// 32-bit-Bereich, Perzentile, Zusammenfassen über den Draht (REC_TELEMETRY)
+// und die Tiefe im Collector.
+// pio test -e host_test -f test_telemetry
+
+#include <CamLink.h>
+#include <Telemetry.h>
+#include <unity.h>
+
+using namespace telemetry;
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_small_values_exact() {
+  for (uint32_t v = 0; v < 8; v++) {
+    TEST_ASSERT_EQUAL_UINT8(v, Histogram::bucket(v));
+    TEST_ASSERT_EQUAL_UINT32(v, Histogram::lowerBound(v));
+    TEST_ASSERT_EQUAL_UINT32(v, Histogram::upperBound(v));
+  }
+  TEST_ASSERT_EQUAL_UINT8(8, Histogram::bucket(8));
+  TEST_ASSERT_EQUAL_UINT8(8, Histogram::bucket(9));
+  TEST_ASSERT_EQUAL_UINT8(9, Histogram::bucket(10));
+}
+
+// Fächer schließen lückenlos aneinander, jede Grenze fällt in ihr eigenes
+// Fach, das letzte reicht bis 2^32 - 1; Breite höchstens 25 % der Untergrenze
+static void test_bounds_contiguous_over_full_range() {
+  TEST_ASSERT_EQUAL_UINT8(BUCKETS - 1, Histogram::bucket(0xFFFFFFFFu));
+  TEST_ASSERT_EQUAL_UINT32(0xFFFFFFFFu, Histogram::upperBound(BUCKETS - 1));
+  for (uint8_t b = 0; b < BUCKETS; b++) {
+    const uint32_t lo = Histogram::lowerBound(b), hi = Histogram::upperBound(b);
+    TEST_ASSERT_TRUE(lo <= hi);
+    TEST_ASSERT_EQUAL_UINT8(b, Histogram::bucket(lo));
+    TEST_ASSERT_EQUAL_UINT8(b, Histogram::bucket(hi));
+    if (b + 1 < BUCKETS)
+      TEST_ASSERT_EQUAL_UINT32(hi + 1, Histogram::lowerBound(b + 1));
+    if (b >= 4)
+      TEST_ASSERT_TRUE((uint64_t)(hi - lo + 1) * 4 <= lo);
+  }
+}
+
+// Stichproben über alle Größenordnungen liegen in den Grenzen ihres Fachs
+static void test_values_within_bucket_bounds() {
+  uint32_t x = 12345;
+  for (int i = 0; i < 100000; i++) {
+    x = x * 1664525u + 1013904223u;
+    const uint32_t v = x >> (x % 32);
+    const uint8_t b = Histogram::bucket(v);
+    TEST_ASSERT_TRUE(b < BUCKETS);
+    TEST_ASSERT_TRUE(Histogram::lowerBound(b) <= v && v <= Histogram::upperBound(b));
+  }
+}
+
+// Perzentil = Obergrenze des Fachs, höchstens das Maximum
+static void test_percentile_upper_bound_capped_by_max() {
+  Histogram h;
+  TEST_ASSERT_EQUAL_UINT32(0, h.percentile(50));
+  for (uint32_t v = 1; v <= 100; v++)
+    h.record(v);
+  TEST_ASSERT_EQUAL_UINT32(100, h.count());
+  // 50. Wert liegt in [48, 55]
+  TEST_ASSERT_EQUAL_UINT32(55, h.percentile(50));
+  TEST_ASSERT_EQUAL_UINT32(1, h.percentile(1));
+  TEST_ASSERT_EQUAL_UINT32(100, h.percentile(99));  // Fach [96, 111]
+  TEST_ASSERT_EQUAL_UINT32(100, h.percentile(100));
+
+  Histogram one;
+  one.record(1000);
+  TEST_ASSERT_EQUAL_UINT32(1000, one.percentile(0));
+  TEST_ASSERT_EQUAL_UINT32(1000, one.percentile(100));
+}
+
+// Über den Draht zusammengefasst = direkt zusammengefasst
+static void test_wire_merge_equals_merge() {
+  Histogram a, b, merged, wired;
+  for (uint32_t v = 0; v < 5000; v += 7)
+    a.record(v);
+  for (uint32_t v = 3; v < 900000; v = v * 3 + 1)
+    b.record(v);
+  merged.merge(a);
+  merged.merge(b);
+
+  camlink::TelemetryRecord rec = {};
+  a.toWire(&rec.hist[0]);
+  b.toWire(&rec.hist[1]);
+  uint8_t buf[camlink::TELEMETRY_MAX_SIZE];
+  const size_t len = camlink::encodeTelemetry(buf, sizeof(buf), rec);
+  TEST_ASSERT_TRUE(len > 0);
+  camlink::TelemetryRecord back = {};
+  TEST_ASSERT_TRUE(camlink::decodeTelemetry(buf, len, &back));
+  wired.addWire(back.hist[0]);
+  wired.addWire(back.hist[1]);
+
+  TEST_ASSERT_EQUAL_UINT32(merged.count(), wired.count());
+  TEST_ASSERT_EQUAL_UINT32(merged.max(), wired.max());
+  for (uint8_t p = 0; p <= 100; p += 5)
+    TEST_ASSERT_EQUAL_UINT32(merged.percentile(p), wired.percentile(p));
+}
+
+// Zähler sättigen auf dem Draht, fremde Fachnummern werden übergangen
+static void test_wire_saturates_and_ignores_bad_index() {
+  Histogram h;
+  for (uint32_t i = 0; i < 70000; i++)
+    h.record(5);
+  camlink::TelemetryHistogram w = {};
+  h.toWire(&w);
+  TEST_ASSERT_EQUAL_UINT8(1, w.used);
+  TEST_ASSERT_EQUAL_UINT8(5, w.index[0]);
+  TEST_ASSERT_EQUAL_UINT16(0xFFFF, w.count[0]);
+
+  w.index[w.used] = BUCKETS;
+  w.count[w.used] = 10;
+  w.used++;
+  Histogram back;
+  back.addWire(w);
+  TEST_ASSERT_EQUAL_UINT32(0xFFFF, back.count());
+}
+
+// take() liefert Tiefe (Mittel × 16, gerundet) und beginnt neu
+static void test_collector_take_resets() {
+  Collector c;
+  c.record(camlink::TelemetryMetric(0), 100);
+  c.record(camlink::TELEMETRY_METRICS, 100);  // ungültig, übergangen
+  c.depth(1);
+  c.depth(2);
+  c.depth(2);
+  camlink::TelemetryRecord rec = {};
+  c.take(&rec);
+  TEST_ASSERT_EQUAL_UINT8(2, rec.depth_max);
+  TEST_ASSERT_EQUAL_UINT8(27, rec.depth_mean_x16);  // 5/3 × 16 = 26,7
+  TEST_ASSERT_EQUAL_UINT8(1, rec.hist[0].used);
+  TEST_ASSERT_EQUAL_UINT32(100, rec.hist[0].max);
+  for (uint8_t m = 1; m < camlink::TELEMETRY_METRICS; m++)
+    TEST_ASSERT_EQUAL_UINT8(0, rec.hist[m].used);
+
+  c.take(&rec);
+  TEST_ASSERT_EQUAL_UINT8(0, rec.depth_max);
+  TEST_ASSERT_EQUAL_UINT8(0, rec.depth_mean_x16);
+  TEST_ASSERT_EQUAL_UINT8(0, rec.hist[0].used);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_small_values_exact);
+  RUN_TEST(test_bounds_contiguous_over_full_range);
+  RUN_TEST(test_values_within_bucket_bounds);
+  RUN_TEST(test_percentile_upper_bound_capped_by_max);
+  RUN_TEST(test_wire_merge_equals_merge);
+  RUN_TEST(test_wire_saturates_and_ignores_bad_index);
+  RUN_TEST(test_collector_take_resets);
+  return UNITY_END();
+}